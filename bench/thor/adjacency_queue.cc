@@ -0,0 +1,206 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "baldr/double_bucket_queue.h"
+#include "loki/worker.h"
+#include "midgard/logging.h"
+#include "thor/worker.h"
+
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+const char* policy_name(const baldr::QueuePolicy policy) {
+  return policy == baldr::QueuePolicy::kRadixHeap ? "radix_heap" : "double_bucket";
+}
+
+struct sort_label {
+  float cost;
+  float sortcost() const {
+    return cost;
+  }
+};
+
+// Simulates the adjacency list of a search: every label popped adds a few labels costing up to
+// range(0) more. Cost spreads beyond the bucket range of the double bucket queue (the default
+// kBucketCount of the path algorithms) make it go through its overflow bucket.
+template <baldr::QueuePolicy policy> void BM_QueueSimulation(benchmark::State& state) {
+  const float spread = state.range(0);
+  constexpr size_t kLabelCount = 1000000;
+  std::vector<sort_label> labels;
+  labels.reserve(kLabelCount + 4);
+  baldr::DoubleBucketQueue<sort_label> queue;
+
+  for (auto _ : state) {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    labels.clear();
+    queue.clear();
+    queue.reuse(0.f, thor::kBucketCount, 1, &labels, policy);
+
+    labels.push_back({0.f});
+    queue.add(0);
+    uint32_t label;
+    while ((label = queue.pop()) != baldr::kInvalidLabel) {
+      if (labels.size() < kLabelCount) {
+        const float cost = labels[label].cost;
+        for (int i = 0; i < 3; ++i) {
+          labels.push_back({cost + 1.f + dist(gen) * spread});
+          queue.add(labels.size() - 1);
+        }
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * labels.size());
+}
+
+BENCHMARK_TEMPLATE(BM_QueueSimulation, baldr::QueuePolicy::kDoubleBucket)
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(10)
+    ->Range(100, 1000000);
+BENCHMARK_TEMPLATE(BM_QueueSimulation, baldr::QueuePolicy::kRadixHeap)
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(10)
+    ->Range(100, 1000000);
+
+// Runs a request through loki and then repeatedly through thor with the given queue policy
+void RunRequest(benchmark::State& state,
+                const boost::property_tree::ptree& config,
+                const std::string& request_json,
+                const Options::Action action) {
+  loki::loki_worker_t loki_worker(config);
+  thor::thor_worker_t thor_worker(config);
+
+  Api request;
+  ParseApi(request_json, action, request);
+  switch (action) {
+    case Options::route:
+      loki_worker.route(request);
+      break;
+    case Options::isochrone:
+      loki_worker.isochrones(request);
+      break;
+    case Options::sources_to_targets:
+      loki_worker.matrix(request);
+      break;
+    default:
+      state.SkipWithError("Unsupported action");
+      return;
+  }
+
+  for (auto _ : state) {
+    Api api(request);
+    switch (action) {
+      case Options::route:
+        thor_worker.route(api);
+        break;
+      case Options::isochrone:
+        thor_worker.isochrones(api);
+        break;
+      default:
+        thor_worker.matrix(api);
+        break;
+    }
+    thor_worker.cleanup();
+  }
+}
+
+boost::property_tree::ptree utrecht_config(const baldr::QueuePolicy policy) {
+  const std::string policy_str = policy_name(policy);
+  return test::make_config("test/data/utrecht_tiles",
+                           {{"thor.queue_policy.route", policy_str},
+                            {"thor.queue_policy.isochrone", policy_str},
+                            {"thor.queue_policy.sources_to_targets", policy_str}},
+                           {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+}
+
+template <baldr::QueuePolicy policy> void BM_UtrechtTruckRoute(benchmark::State& state) {
+  RunRequest(state, utrecht_config(policy),
+             R"({"locations":[{"lat":52.150690,"lon":5.003020},{"lat":52.016080,"lon":5.191730}],
+                 "costing":"truck"})",
+             Options::route);
+}
+
+template <baldr::QueuePolicy policy> void BM_UtrechtIsochrone(benchmark::State& state) {
+  RunRequest(state, utrecht_config(policy),
+             R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"auto",
+                 "contours":[{"time":)" +
+                 std::to_string(state.range(0)) + R"(}],"polygons":false})",
+             Options::isochrone);
+}
+
+template <baldr::QueuePolicy policy> void BM_UtrechtMatrix(benchmark::State& state) {
+  RunRequest(state, utrecht_config(policy),
+             R"({"sources":[{"lat":52.104,"lon":5.105},{"lat":52.090,"lon":5.115},
+                            {"lat":52.075,"lon":5.085}],
+                 "targets":[{"lat":52.120,"lon":5.070},{"lat":52.060,"lon":5.150},
+                            {"lat":52.095,"lon":5.030}],
+                 "costing":"auto"})",
+             Options::sources_to_targets);
+}
+
+BENCHMARK_TEMPLATE(BM_UtrechtTruckRoute, baldr::QueuePolicy::kDoubleBucket)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UtrechtTruckRoute, baldr::QueuePolicy::kRadixHeap)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UtrechtIsochrone, baldr::QueuePolicy::kDoubleBucket)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(15)
+    ->Arg(60);
+BENCHMARK_TEMPLATE(BM_UtrechtIsochrone, baldr::QueuePolicy::kRadixHeap)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(15)
+    ->Arg(60);
+BENCHMARK_TEMPLATE(BM_UtrechtMatrix, baldr::QueuePolicy::kDoubleBucket)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UtrechtMatrix, baldr::QueuePolicy::kRadixHeap)
+    ->Unit(benchmark::kMillisecond);
+
+// Runs a route request read from a file on a larger tile extract
+void BM_ExtractRoute(benchmark::State& state,
+                     const baldr::QueuePolicy policy,
+                     const std::string& tile_extract,
+                     const std::string& request_json) {
+  auto config = utrecht_config(policy);
+  config.put("mjolnir.tile_extract", tile_extract);
+  RunRequest(state, config, request_json, Options::route);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  logging::Configure({{"type", ""}});
+
+  // A larger graph can be benchmarked with --tile-extract=X --request=Y where Y is a file with
+  // the json of a route request within the extract
+  std::string tile_extract, request_file;
+  for (int i = 0; i < argc; i++) {
+    if (std::strncmp(argv[i], "--tile-extract=", strlen("--tile-extract=")) == 0) {
+      tile_extract = argv[i] + strlen("--tile-extract=");
+    } else if (std::strncmp(argv[i], "--request=", strlen("--request=")) == 0) {
+      request_file = argv[i] + strlen("--request=");
+    }
+  }
+
+  if (!tile_extract.empty() && !request_file.empty()) {
+    std::ifstream file(request_file);
+    std::stringstream request_json;
+    request_json << file.rdbuf();
+    for (auto policy : {baldr::QueuePolicy::kDoubleBucket, baldr::QueuePolicy::kRadixHeap}) {
+      ::benchmark::RegisterBenchmark((std::string("BM_ExtractRoute/") + policy_name(policy)).c_str(),
+                                     BM_ExtractRoute, policy, tile_extract, request_json.str())
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+
+  ::benchmark::Initialize(&argc, argv);
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <array>
 #include <benchmark/benchmark.h>
 #include <iostream>
 #include <random>
 #include <string>
+#include <thread>
 
 #include "baldr/graphreader.h"
 #include "loki/search.h"
@@ -60,8 +62,8 @@ const auto config = json_to_pt(R"({
 
 constexpr float kMaxRange = 256;
 
-static void BM_UtrechtCostMatrix(benchmark::State& state) {
-  const int size = state.range(0);
+// Runs a size x size matrix with the searches spread over the given number of threads
+static void UtrechtCostMatrix(benchmark::State& state, const int size, const uint32_t concurrency) {
   baldr::GraphReader reader(config.get_child("mjolnir"));
 
   // Generate N random locations within the Utrect bounding box;
@@ -102,7 +104,9 @@ static void BM_UtrechtCostMatrix(benchmark::State& state) {
 
   std::size_t result_size = 0;
 
-  thor::CostMatrix matrix;
+  boost::property_tree::ptree thor_config;
+  thor_config.put("costmatrix_concurrency", concurrency);
+  thor::CostMatrix matrix(thor_config);
   for (auto _ : state) {
     auto result = matrix.SourceToTarget(sources, sources, reader, costs, mode, 100000.);
     matrix.clear();
@@ -111,11 +115,33 @@ static void BM_UtrechtCostMatrix(benchmark::State& state) {
   state.counters["Routes"] = benchmark::Counter(size, benchmark::Counter::kIsIterationInvariantRate);
 }
 
+static void BM_UtrechtCostMatrix(benchmark::State& state) {
+  UtrechtCostMatrix(state, state.range(0), 1);
+}
+
 BENCHMARK(BM_UtrechtCostMatrix)
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(2)
     ->Range(1, kMaxRange);
 
+// Scaling of a large matrix with the number of threads, from 1 up to the number of cores
+static void BM_UtrechtCostMatrixConcurrency(benchmark::State& state) {
+  UtrechtCostMatrix(state, state.range(0), state.range(1));
+}
+
+static void ConcurrencyArguments(benchmark::internal::Benchmark* b) {
+  const int cores = std::max(std::thread::hardware_concurrency(), 1u);
+  for (int threads = 1; threads < cores; threads *= 2) {
+    b->Args({static_cast<int>(kMaxRange), threads});
+  }
+  b->Args({static_cast<int>(kMaxRange), cores});
+}
+
+BENCHMARK(BM_UtrechtCostMatrixConcurrency)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Apply(ConcurrencyArguments);
+
 } // namespace
 
 BENCHMARK_MAIN();
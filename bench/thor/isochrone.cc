@@ -8,6 +8,9 @@
 //#include <valhalla/proto/options.pb.h>
 
 #include "loki/worker.h"
+#include "midgard/gridded_data.h"
+#include "sif/costfactory.h"
+#include "thor/isochrone.h"
 #include "thor/worker.h"
 
 #include "test.h"
@@ -53,6 +56,61 @@ BENCHMARK(BM_IsochroneUtrecht)
     ->Range(1, kMaxDurationMinutes)
     ->Repetitions(10);
 
+// Test the contouring of the isochrone grid on its own, the expansion is done once up front
+void BM_IsochroneContoursUtrecht(benchmark::State& state) {
+  const int size = state.range(0);
+  const uint32_t concurrency = state.range(1);
+
+  const auto config =
+      test::make_config("test/data/utrecht_tiles", {},
+                        {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+  valhalla::loki::loki_worker_t loki_worker(config);
+  baldr::GraphReader reader(config.get_child("mjolnir"));
+
+  // four contours spread over the range, like a typical request
+  std::string contours;
+  for (int i = 1; i <= 4; ++i) {
+    contours += (i > 1 ? "," : "") + std::string(R"({"time":)") +
+                std::to_string(std::max(1, size * i / 4)) + "}";
+  }
+  const auto request_json =
+      R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"auto","contours":[)" +
+      contours + R"(],"polygons":true,"denoise":0.2,"generalize":20})";
+
+  valhalla::Api request;
+  valhalla::ParseApi(request_json, Options::isochrone, request);
+  loki_worker.isochrones(request);
+
+  sif::TravelMode mode;
+  auto costs = sif::CostFactory().CreateModeCosting(request.options(), mode);
+  thor::Isochrone isochrone(config.get_child("thor"));
+  const auto grid = isochrone.Expand(thor::ExpansionType::forward, request, reader, costs, mode);
+
+  std::vector<midgard::GriddedData<2>::contour_interval_t> intervals;
+  for (const auto& contour : request.options().contours()) {
+    intervals.emplace_back(0, contour.time(), "time", contour.color());
+  }
+
+  for (auto _ : state) {
+    auto isolines = grid->GenerateContours(intervals, true, 0.2f, 20.f, concurrency);
+    benchmark::DoNotOptimize(isolines);
+  }
+}
+
+// Every range on one thread and on one thread per contour
+void ContourArguments(benchmark::internal::Benchmark* b) {
+  for (int minutes = 15; minutes <= kMaxDurationMinutes; minutes *= 2) {
+    b->Args({minutes, 1});
+    b->Args({minutes, 4});
+  }
+}
+
+BENCHMARK(BM_IsochroneContoursUtrecht)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Apply(ContourArguments)
+    ->Repetitions(10);
+
 } // namespace
 
 BENCHMARK_MAIN();
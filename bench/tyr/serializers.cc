@@ -0,0 +1,139 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
+#include "proto_conversions.h"
+#include "thor/costmatrix.h"
+#include "tyr/serializers.h"
+
+using namespace valhalla;
+
+namespace {
+
+// Matrix of size x size locations spread over Utrecht with some unreachable pairs
+struct Matrix {
+  Api api;
+  std::vector<thor::TimeDistance> time_distances;
+
+  Matrix(int size, Options::Format format) {
+    std::mt19937 gen(0); // Seed with the same value for consistent benchmarking
+    std::uniform_real_distribution<> lng_distribution(5.0163, 5.1622);
+    std::uniform_real_distribution<> lat_distribution(52.0469999, 52.1411);
+    std::uniform_int_distribution<uint32_t> time_distribution(0, 7200);
+
+    auto& options = *api.mutable_options();
+    options.set_format(format);
+    for (auto* locations : {options.mutable_sources(), options.mutable_targets()}) {
+      for (int i = 0; i < size; ++i) {
+        auto* location = locations->Add();
+        location->mutable_ll()->set_lng(lng_distribution(gen));
+        location->mutable_ll()->set_lat(lat_distribution(gen));
+        auto* edge = location->mutable_correlation()->add_edges();
+        edge->mutable_ll()->set_lng(location->ll().lng() + 0.0001);
+        edge->mutable_ll()->set_lat(location->ll().lat() - 0.0001);
+        edge->add_names("Oudegracht");
+      }
+    }
+
+    time_distances.reserve(size * size);
+    for (int i = 0; i < size * size; ++i) {
+      auto time = time_distribution(gen);
+      if (time % 97 == 0) {
+        time_distances.emplace_back(thor::kMaxCost, 0);
+      } else {
+        time_distances.emplace_back(time, time * 13 + 7);
+      }
+    }
+  }
+};
+
+// The OSRM matrix serializer as it was before it streamed, building a json DOM first
+std::string serialize_dom(const Api& request,
+                          const std::vector<thor::TimeDistance>& time_distances,
+                          double distance_scale) {
+  using namespace baldr;
+  const auto& options = request.options();
+  auto waypoints = [](const google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
+    auto waypoints = json::array({});
+    for (const auto& location : locations) {
+      const auto& ll = location.correlation().edges(0).ll();
+      waypoints->emplace_back(json::map({
+          {"location", json::array({json::fixed_t{ll.lng(), 6}, json::fixed_t{ll.lat(), 6}})},
+          {"name", location.correlation().edges(0).names(0)},
+          {"distance", json::fixed_t{to_ll(location.ll()).Distance(to_ll(ll)), 3}},
+      }));
+    }
+    return waypoints;
+  };
+
+  auto json = json::map({});
+  json->emplace("code", std::string("Ok"));
+  json->emplace("sources", waypoints(options.sources()));
+  json->emplace("destinations", waypoints(options.targets()));
+  auto durations = json::array({});
+  auto distances = json::array({});
+  for (int source = 0; source < options.sources_size(); ++source) {
+    auto time = json::array({});
+    auto distance = json::array({});
+    for (int target = 0; target < options.targets_size(); ++target) {
+      const auto& td = time_distances[source * options.targets_size() + target];
+      if (td.time != thor::kMaxCost) {
+        time->emplace_back(static_cast<uint64_t>(td.time));
+        distance->emplace_back(json::fixed_t{td.dist * distance_scale, 3});
+      } else {
+        time->emplace_back(nullptr);
+        distance->emplace_back(nullptr);
+      }
+    }
+    durations->emplace_back(time);
+    distances->emplace_back(distance);
+  }
+  json->emplace("durations", durations);
+  json->emplace("distances", distances);
+
+  std::stringstream ss;
+  ss << *json;
+  return ss.str();
+}
+
+void BM_MatrixDom(benchmark::State& state) {
+  Matrix matrix(state.range(0), Options::osrm);
+  size_t bytes = 0;
+  for (auto _ : state) {
+    auto json = serialize_dom(matrix.api, matrix.time_distances, 1.0);
+    bytes += json.size();
+    benchmark::DoNotOptimize(json);
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+void BM_MatrixStreaming(benchmark::State& state) {
+  Matrix matrix(state.range(0), Options::osrm);
+  // both paths have to produce the same document for the comparison to be meaningful
+  rapidjson::Document dom, streamed;
+  dom.Parse(serialize_dom(matrix.api, matrix.time_distances, 1.0));
+  streamed.Parse(tyr::serializeMatrix(matrix.api, matrix.time_distances, 1.0));
+  if (dom != streamed) {
+    state.SkipWithError("Streaming and DOM serializers disagree");
+    return;
+  }
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    auto json = tyr::serializeMatrix(matrix.api, matrix.time_distances, 1.0);
+    bytes += json.size();
+    benchmark::DoNotOptimize(json);
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_MatrixDom)->Unit(benchmark::kMillisecond)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK(BM_MatrixStreaming)->Unit(benchmark::kMillisecond)->RangeMultiplier(4)->Range(4, 256);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include <lz4hc.h>
+
+#include "baldr/compressedextract.h"
+#include "baldr/graphtile.h"
+#include "midgard/logging.h"
+
+namespace {
+
+// Tiles the dictionary is sampled from and pieces taken from each of them
+constexpr size_t kDictionarySamples = 64;
+constexpr size_t kPiecesPerSample = 4;
+
+// Samples pieces spread over the tiles, so the dictionary holds the structures which are
+// repeated from tile to tile rather than the contents of a single one
+std::vector<char> sample_dictionary(const std::vector<std::vector<char>>& samples,
+                                    const size_t dictionary_size) {
+  std::vector<char> dictionary;
+  if (samples.empty() || dictionary_size == 0) {
+    return dictionary;
+  }
+  const size_t piece_size =
+      std::max<size_t>(1, dictionary_size / (samples.size() * kPiecesPerSample));
+  dictionary.reserve(dictionary_size);
+  for (const auto& sample : samples) {
+    for (size_t i = 0; i < kPiecesPerSample && dictionary.size() < dictionary_size; ++i) {
+      const size_t begin = sample.size() * i / kPiecesPerSample;
+      const size_t end =
+          std::min(sample.size(), std::min(begin + piece_size,
+                                           begin + dictionary_size - dictionary.size()));
+      dictionary.insert(dictionary.end(), sample.begin() + begin, sample.begin() + end);
+    }
+  }
+  return dictionary;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+CompressedExtract::CompressedExtract(const std::string& file_name) : file_name_(file_name) {
+  struct stat s;
+  if (stat(file_name.c_str(), &s) || static_cast<size_t>(s.st_size) <
+                                         sizeof(compressed_extract_header_t)) {
+    throw std::runtime_error("Compressed extract " + file_name + " is missing or too small");
+  }
+  memmap_.map(file_name, s.st_size, POSIX_MADV_RANDOM, true);
+
+  header_ = reinterpret_cast<const compressed_extract_header_t*>(memmap_.get());
+  if (memcmp(header_->magic, kCompressedExtractMagic, sizeof(kCompressedExtractMagic)) != 0) {
+    throw std::runtime_error(file_name + " is not a compressed extract");
+  }
+  if (header_->version != kCompressedExtractVersion) {
+    throw std::runtime_error("Compressed extract " + file_name + " has unsupported version " +
+                             std::to_string(header_->version));
+  }
+  const size_t index_end = sizeof(compressed_extract_header_t) +
+                           header_->tile_count * sizeof(compressed_tile_entry_t) +
+                           header_->dictionary_size;
+  if (index_end > memmap_.size()) {
+    throw std::runtime_error("Compressed extract " + file_name + " is truncated");
+  }
+  entries_ = reinterpret_cast<const compressed_tile_entry_t*>(memmap_.get() +
+                                                              sizeof(compressed_extract_header_t));
+  dictionary_ = reinterpret_cast<const char*>(end());
+  for (const auto& entry : *this) {
+    if (entry.offset < index_end || entry.offset + entry.compressed_size > memmap_.size()) {
+      throw std::runtime_error("Compressed extract " + file_name + " is truncated");
+    }
+  }
+}
+
+bool CompressedExtract::IsCompressedExtract(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  char magic[sizeof(kCompressedExtractMagic)];
+  return file.read(magic, sizeof(magic)) &&
+         memcmp(magic, kCompressedExtractMagic, sizeof(magic)) == 0;
+}
+
+size_t CompressedExtract::Build(const std::string& tile_dir,
+                                const std::unordered_set<GraphId>& tiles,
+                                const std::string& file_name,
+                                const uint32_t dictionary_size,
+                                const int level) {
+  // Sorted so that the index can be binary searched
+  std::vector<GraphId> ids(tiles.begin(), tiles.end());
+  std::sort(ids.begin(), ids.end());
+
+  // Load the tiles to sample the dictionary from
+  std::vector<std::vector<char>> samples;
+  const size_t stride = std::max<size_t>(1, ids.size() / kDictionarySamples);
+  for (size_t i = 0; i < ids.size(); i += stride) {
+    auto tile = GraphTile::Create(tile_dir, ids[i]);
+    if (tile && tile->header()) {
+      const char* data = reinterpret_cast<const char*>(tile->header());
+      samples.emplace_back(data, data + tile->header()->end_offset());
+    }
+  }
+  const auto dictionary =
+      sample_dictionary(samples, std::min(dictionary_size, kMaxCompressedExtractDictionary));
+  samples.clear();
+
+  std::ofstream file(file_name, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open " + file_name + " for writing");
+  }
+
+  // Leave room for the header and the index, they are known once the blocks are written
+  compressed_extract_header_t header{};
+  memcpy(header.magic, kCompressedExtractMagic, sizeof(kCompressedExtractMagic));
+  header.version = kCompressedExtractVersion;
+  header.dictionary_size = dictionary.size();
+  std::vector<compressed_tile_entry_t> entries;
+  entries.reserve(ids.size());
+  uint64_t offset =
+      sizeof(header) + ids.size() * sizeof(compressed_tile_entry_t) + dictionary.size();
+  file.seekp(offset - dictionary.size());
+  file.write(dictionary.data(), dictionary.size());
+
+  // Compress every tile on its own against the dictionary
+  LZ4_streamHC_t* stream = LZ4_createStreamHC();
+  std::vector<char> block;
+  size_t raw_size = 0;
+  for (const auto& id : ids) {
+    auto tile = GraphTile::Create(tile_dir, id);
+    if (!tile || !tile->header()) {
+      LZ4_freeStreamHC(stream);
+      throw std::runtime_error("Could not load tile " + GraphTile::FileSuffix(id));
+    }
+    const char* data = reinterpret_cast<const char*>(tile->header());
+    const int size = tile->header()->end_offset();
+    block.resize(LZ4_compressBound(size));
+    LZ4_resetStreamHC_fast(stream, level);
+    LZ4_loadDictHC(stream, dictionary.data(), dictionary.size());
+    const int compressed_size =
+        LZ4_compress_HC_continue(stream, data, block.data(), size, block.size());
+    if (compressed_size <= 0) {
+      LZ4_freeStreamHC(stream);
+      throw std::runtime_error("Could not compress tile " + GraphTile::FileSuffix(id));
+    }
+    file.write(block.data(), compressed_size);
+    entries.push_back({offset, static_cast<uint32_t>(id.value),
+                       static_cast<uint32_t>(compressed_size), static_cast<uint32_t>(size), 0});
+    offset += compressed_size;
+    raw_size += size;
+  }
+  LZ4_freeStreamHC(stream);
+
+  // Go back and write the header and the index
+  header.tile_count = entries.size();
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             entries.size() * sizeof(compressed_tile_entry_t));
+  if (!file) {
+    throw std::runtime_error("Could not write " + file_name);
+  }
+
+  LOG_INFO("Compressed " + std::to_string(entries.size()) + " tiles from " +
+           std::to_string(raw_size) + " to " + std::to_string(offset) + " bytes");
+  return entries.size();
+}
+
+const compressed_tile_entry_t* CompressedExtract::Find(const GraphId& graphid) const {
+  const uint32_t tile_id = graphid.Tile_Base().value;
+  auto found = std::lower_bound(begin(), end(), tile_id,
+                                [](const compressed_tile_entry_t& entry, const uint32_t id) {
+                                  return entry.tile_id < id;
+                                });
+  return found != end() && found->tile_id == tile_id ? found : nullptr;
+}
+
+std::vector<char> CompressedExtract::Decompress(const GraphId& graphid) const {
+  const auto* entry = Find(graphid);
+  if (!entry) {
+    return {};
+  }
+  std::vector<char> tile(entry->size);
+  const int size = LZ4_decompress_safe_usingDict(block(*entry), tile.data(), entry->compressed_size,
+                                                 entry->size, dictionary_,
+                                                 header_->dictionary_size);
+  if (size < 0 || static_cast<uint32_t>(size) != entry->size) {
+    LOG_ERROR("Corrupt block of tile " + GraphTile::FileSuffix(graphid.Tile_Base()) + " in " +
+              file_name_);
+    return {};
+  }
+  return tile;
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -0,0 +1,92 @@
+#include "baldr/contractiontile.h"
+#include "baldr/graphtile.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace valhalla {
+namespace baldr {
+
+std::shared_ptr<const ContractionTile> ContractionTile::Create(const std::string& dir,
+                                                               const GraphId& graphid) {
+  const std::string file_location =
+      dir + filesystem::path::preferred_separator +
+      GraphTile::FileSuffix(graphid.Tile_Base(), SUFFIX_CONTRACTION);
+  std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+
+  size_t filesize = file.tellg();
+  std::vector<char> data(filesize);
+  file.seekg(0, std::ios::beg);
+  file.read(data.data(), filesize);
+  file.close();
+  try {
+    auto tile = std::make_shared<const ContractionTile>(std::move(data));
+    if (GraphId(tile->header()->graphid) != graphid.Tile_Base()) {
+      throw std::runtime_error("it belongs to another tile");
+    }
+    return tile;
+  } catch (const std::exception& e) {
+    LOG_ERROR("Invalid contraction tile " + file_location + ": " + e.what());
+  }
+  return nullptr;
+}
+
+ContractionTile::ContractionTile(std::vector<char>&& data) : data_(std::move(data)) {
+  if (data_.size() < sizeof(ContractionTileHeader)) {
+    throw std::runtime_error("Contraction tile is too small for its header");
+  }
+  header_ = reinterpret_cast<const ContractionTileHeader*>(data_.data());
+  if (data_.size() != sizeof(ContractionTileHeader) +
+                          header_->edgecount * sizeof(ContractionNode) +
+                          header_->arccount * sizeof(ContractionArc)) {
+    throw std::runtime_error("Contraction tile size does not match its header");
+  }
+  nodes_ = reinterpret_cast<const ContractionNode*>(data_.data() + sizeof(ContractionTileHeader));
+  arcs_ = reinterpret_cast<const ContractionArc*>(nodes_ + header_->edgecount);
+  for (uint32_t i = 0; i < header_->edgecount; ++i) {
+    if (static_cast<uint64_t>(nodes_[i].arc_index) + nodes_[i].up_count + nodes_[i].down_count >
+        header_->arccount) {
+      throw std::runtime_error("Contraction tile arcs out of bounds");
+    }
+  }
+}
+
+ContractionReader::ContractionReader(const std::string& dir, const size_t max_cache_size)
+    : dir_(dir), max_cache_size_(max_cache_size), cache_size_(0) {
+}
+
+std::shared_ptr<const ContractionTile> ContractionReader::GetTile(const GraphId& graphid,
+                                                                  GraphReader& graphreader) {
+  auto base = graphid.Tile_Base();
+  auto cached = cache_.find(base.value);
+  if (cached != cache_.end()) {
+    return cached->second;
+  }
+
+  // Missing and outdated tiles are cached as well so they are only looked for once
+  auto tile = ContractionTile::Create(dir_, base);
+  if (tile) {
+    auto graph_tile = graphreader.GetGraphTile(base);
+    if (!graph_tile || graph_tile->header()->dataset_id() != tile->header()->dataset_id) {
+      LOG_WARN("Contraction tile " + std::to_string(base) + " was built from another dataset");
+      tile = nullptr;
+    }
+  }
+  cache_size_ += tile ? tile->size() : 0;
+  return cache_.emplace(base.value, std::move(tile)).first->second;
+}
+
+void ContractionReader::Trim() {
+  if (cache_size_ > max_cache_size_) {
+    cache_.clear();
+    cache_size_ = 0;
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
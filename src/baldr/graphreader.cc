@@ -1,7 +1,10 @@
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
 #include <utility>
 
 #include "baldr/connectivity_map.h"
@@ -20,6 +23,8 @@ namespace {
 constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; // 1 gig
 constexpr size_t AVERAGE_TILE_SIZE = 2097152;         // 2 megs
 constexpr size_t AVERAGE_MM_TILE_SIZE = 1024;         // 1k
+constexpr size_t MAX_PREFETCHED_TILES = 64;           // queued or loaded but not requested yet
+constexpr size_t MIN_CACHE_SHARD_SIZE = 67108864;     // 64 megs, several of the largest tiles
 
 struct tile_index_entry {
   uint64_t offset;  // byte offset from the beginning of the tar
@@ -81,11 +86,21 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
   // if you really meant to load it
   if (pt.get_optional<std::string>("tile_extract")) {
     try {
-      // load the tar
-      // TODO: use the "scan" to iterate over tar
-      archive.reset(new midgard::tar(pt.get<std::string>("tile_extract"), true, true, index_loader));
+      const auto extract = pt.get<std::string>("tile_extract");
+      if (CompressedExtract::IsCompressedExtract(extract)) {
+        // the blocks are only decompressed once their tiles are asked for
+        compressed.reset(new CompressedExtract(extract));
+        for (const auto& entry : *compressed) {
+          tiles.emplace(std::piecewise_construct, std::forward_as_tuple(entry.tile_id),
+                        std::forward_as_tuple(compressed->block(entry), entry.compressed_size));
+        }
+      } else {
+        // load the tar
+        // TODO: use the "scan" to iterate over tar
+        archive.reset(new midgard::tar(extract, true, true, index_loader));
+      }
       // map files to graph ids
-      if (tiles.empty()) {
+      if (tiles.empty() && archive) {
         for (const auto& c : archive->contents) {
           try {
             auto id = GraphTile::GetTileId(c.first);
@@ -108,10 +123,11 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
       if (tiles.empty()) {
         LOG_WARN("Tile extract contained no usuable tiles");
         archive.reset();
+        compressed.reset();
       } // loaded ok but with possibly bad blocks
       else {
         LOG_INFO("Tile extract successfully loaded with tile count: " + std::to_string(tiles.size()));
-        if (archive->corrupt_blocks) {
+        if (archive && archive->corrupt_blocks) {
           LOG_WARN("Tile extract had " + std::to_string(archive->corrupt_blocks) + " corrupt blocks");
         }
       }
@@ -162,6 +178,19 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
       LOG_WARN("Traffic tile extract could not be loaded");
     }
   }
+
+  if (pt.get_optional<std::string>("traffic_snapshot")) {
+    try {
+      traffic_snapshot.reset(
+          new TrafficSnapshot(pt.get<std::string>("traffic_snapshot"), traffic_readonly));
+      LOG_INFO("Traffic snapshot successfully loaded at generation " +
+               std::to_string(traffic_snapshot->generation()) + " with tile count: " +
+               std::to_string(traffic_snapshot->buffer(0).tiles.size()));
+    } catch (const std::exception& e) {
+      LOG_WARN(e.what());
+      LOG_WARN("Traffic snapshot could not be loaded");
+    }
+  }
 }
 
 // ----------------------------------------------------------------------------
@@ -221,6 +250,17 @@ graph_tile_ptr FlatTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, s
   return cache_.back();
 }
 
+// Replaces a cached tile if it is the expected one
+graph_tile_ptr
+FlatTileCache::Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) {
+  auto index = get_index(graphid);
+  if (index == -1)
+    return nullptr;
+  if (cache_[index] == expected)
+    cache_[index] = std::move(tile);
+  return cache_[index];
+}
+
 void FlatTileCache::Trim() {
   Clear();
 }
@@ -269,6 +309,18 @@ graph_tile_ptr SimpleTileCache::Put(const GraphId& graphid, graph_tile_ptr tile,
   return cache_.emplace(graphid, std::move(tile)).first->second;
 }
 
+// Replaces a cached tile if it is the expected one
+graph_tile_ptr SimpleTileCache::Replace(const GraphId& graphid,
+                                        const graph_tile_ptr& expected,
+                                        graph_tile_ptr tile) {
+  auto cached = cache_.find(graphid);
+  if (cached == cache_.end())
+    return nullptr;
+  if (cached->second == expected)
+    cached->second = std::move(tile);
+  return cached->second;
+}
+
 void SimpleTileCache::Trim() {
   Clear();
 }
@@ -378,6 +430,162 @@ graph_tile_ptr TileCacheLRU::Put(const GraphId& graphid, graph_tile_ptr tile, si
   return key_val_lru_list_.front().tile;
 }
 
+// Replaces a cached tile if it is the expected one, the entry keeps its place in the LRU list
+graph_tile_ptr
+TileCacheLRU::Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) {
+  auto cached = cache_.find(graphid);
+  if (cached == cache_.end()) {
+    return nullptr;
+  }
+  auto& entry = *cached->second;
+  if (entry.tile == expected) {
+    entry.tile = std::move(tile);
+  }
+  return entry.tile;
+}
+
+// ----------------------------------------------------------------------------
+// ShardedTileCache implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+ShardedTileCache::ShardedTileCache(size_t max_size,
+                                   TileCacheLRU::MemoryLimitControl mem_control,
+                                   size_t shard_count)
+    : mem_control_(mem_control), cache_size_(std::make_shared<std::atomic<size_t>>(0)),
+      max_cache_size_(max_size) {
+  // round the shard count up to a power of 2 so we can pick shards with a shift
+  uint32_t bits = 0;
+  while ((size_t(1) << bits) < std::max<size_t>(shard_count, 1) && bits < 16) {
+    ++bits;
+  }
+  shards_ = std::make_shared<std::vector<Shard>>(size_t(1) << bits);
+  shard_mask_ = (uint64_t(1) << bits) - 1;
+  max_shard_size_ = max_cache_size_ >> bits;
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void ShardedTileCache::Reserve(size_t tile_size) {
+  assert(tile_size != 0);
+  for (auto& shard : *shards_) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    shard.cache.reserve(max_shard_size_ / tile_size);
+  }
+}
+
+// Checks if tile exists in the cache.
+bool ShardedTileCache::Contains(const GraphId& graphid) const {
+  const auto& shard = GetShard(graphid);
+  std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+  return shard.cache.find(graphid) != shard.cache.cend();
+}
+
+// Lets you know if the cache is too large.
+bool ShardedTileCache::OverCommitted() const {
+  return cache_size_->load(std::memory_order_relaxed) > max_cache_size_;
+}
+
+// Clears the cache.
+void ShardedTileCache::Clear() {
+  for (auto& shard : *shards_) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    cache_size_->fetch_sub(shard.cache_size, std::memory_order_relaxed);
+    shard.cache_size = 0;
+    shard.cache.clear();
+    shard.clock.clear();
+    shard.hand = shard.clock.end();
+  }
+}
+
+void ShardedTileCache::Trim() {
+  for (auto& shard : *shards_) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    TrimToFit(shard, 0);
+  }
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr ShardedTileCache::Get(const GraphId& graphid) const {
+  const auto& shard = GetShard(graphid);
+  std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+  auto cached = shard.cache.find(graphid);
+  if (cached == shard.cache.cend()) {
+    return nullptr;
+  }
+
+  // only write the flag when it changes so hot tiles dont bounce the cache line between cores
+  if (!cached->second.referenced.load(std::memory_order_relaxed)) {
+    cached->second.referenced.store(true, std::memory_order_relaxed);
+  }
+  return cached->second.tile;
+}
+
+void ShardedTileCache::TrimToFit(Shard& shard, size_t required_size) {
+  while ((shard.cache_size > max_shard_size_ || max_shard_size_ - shard.cache_size < required_size) &&
+         !shard.clock.empty()) {
+    if (shard.hand == shard.clock.end()) {
+      shard.hand = shard.clock.begin();
+    }
+
+    // give recently used entries a second chance, evict the first one that wasnt used since
+    auto entry = shard.cache.find(*shard.hand);
+    if (entry->second.referenced.exchange(false, std::memory_order_relaxed)) {
+      ++shard.hand;
+      continue;
+    }
+
+    shard.cache_size -= entry->second.size;
+    cache_size_->fetch_sub(entry->second.size, std::memory_order_relaxed);
+    shard.hand = shard.clock.erase(shard.hand);
+    shard.cache.erase(entry);
+  }
+}
+
+// Puts a copy of a tile of into the cache.
+graph_tile_ptr ShardedTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  if (mem_control_ == TileCacheLRU::MemoryLimitControl::HARD && size > max_shard_size_) {
+    throw std::runtime_error("ShardedTileCache: tile size is bigger than max shard size");
+  }
+
+  auto& shard = GetShard(graphid);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+  // someone else may have loaded the same tile while we were loading it, share theirs
+  auto cached = shard.cache.find(graphid);
+  if (cached != shard.cache.end()) {
+    cached->second.referenced.store(true, std::memory_order_relaxed);
+    return cached->second.tile;
+  }
+
+  if (mem_control_ == TileCacheLRU::MemoryLimitControl::HARD) {
+    TrimToFit(shard, size);
+  }
+
+  // new entries go right behind the hand so they are the last ones it visits
+  shard.clock.insert(shard.hand, graphid);
+  auto inserted = shard.cache.emplace(std::piecewise_construct, std::forward_as_tuple(graphid),
+                                      std::forward_as_tuple(std::move(tile), size));
+  shard.cache_size += size;
+  cache_size_->fetch_add(size, std::memory_order_relaxed);
+  return inserted.first->second.tile;
+}
+
+// Replaces a cached tile if it is the expected one, another reader may have replaced it already
+graph_tile_ptr ShardedTileCache::Replace(const GraphId& graphid,
+                                         const graph_tile_ptr& expected,
+                                         graph_tile_ptr tile) {
+  auto& shard = GetShard(graphid);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+  auto cached = shard.cache.find(graphid);
+  if (cached == shard.cache.end()) {
+    return nullptr;
+  }
+  if (cached->second.tile == expected) {
+    cached->second.tile = std::move(tile);
+  }
+  return cached->second.tile;
+}
+
 // ----------------------------------------------------------------------------
 // SynchronizedTileCache implementation
 // ----------------------------------------------------------------------------
@@ -428,6 +636,14 @@ graph_tile_ptr SynchronizedTileCache::Put(const GraphId& graphid, graph_tile_ptr
   return cache_.Put(graphid, std::move(tile), size);
 }
 
+// Replaces a cached tile if it is the expected one
+graph_tile_ptr SynchronizedTileCache::Replace(const GraphId& graphid,
+                                              const graph_tile_ptr& expected,
+                                              graph_tile_ptr tile) {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  return cache_.Replace(graphid, expected, std::move(tile));
+}
+
 // Constructs tile cache.
 TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
@@ -439,6 +655,28 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 
   bool use_simple_cache = pt.get<bool>("use_simple_mem_cache", false);
 
+  bool use_sharded_cache = pt.get<bool>("use_sharded_mem_cache", false);
+  size_t sharded_cache_shards =
+      pt.get<size_t>("sharded_mem_cache_shards",
+                     std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4);
+  // each shard only gets its slice of the budget, with too many shards a single dense tile would
+  // no longer fit into one and the hard limit would reject it even though the whole cache has room
+  while (sharded_cache_shards > 1 && max_cache_size / sharded_cache_shards < MIN_CACHE_SHARD_SIZE) {
+    sharded_cache_shards >>= 1;
+  }
+
+  // the sharded cache is thread-safe on its own so every reader just gets a handle to the same one
+  if (use_sharded_cache && pt.get<bool>("global_synchronized_cache", false)) {
+    static std::shared_ptr<ShardedTileCache> globalShardedCache_;
+    static std::mutex factoryMutex;
+    std::lock_guard<std::mutex> lock(factoryMutex);
+    if (!globalShardedCache_) {
+      globalShardedCache_.reset(
+          new ShardedTileCache(max_cache_size, lru_mem_control, sharded_cache_shards));
+    }
+    return new ShardedTileCache(*globalShardedCache_);
+  }
+
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
     // Handle synchronization of cache
@@ -463,6 +701,11 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
     return new TileCacheLRU(max_cache_size, lru_mem_control);
   }
 
+  // a sharded cache can also be used per reader though it only pays off when shared
+  if (use_sharded_cache) {
+    return new ShardedTileCache(max_cache_size, lru_mem_control, sharded_cache_shards);
+  }
+
   // maybe you want a basic hashmap of tiles
   if (use_simple_cache) {
     return new SimpleTileCache(max_cache_size);
@@ -472,6 +715,119 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
   return new FlatTileCache(max_cache_size);
 }
 
+// ----------------------------------------------------------------------------
+// Tile prefetcher implementation
+// ----------------------------------------------------------------------------
+
+// Background threads loading the tiles the reader queues. A tile is handed over to the
+// reader, which puts it in its cache, the first time the reader requests it.
+struct GraphReader::tile_prefetcher_t {
+  tile_prefetcher_t(GraphReader& reader, const size_t thread_count) : stop(false) {
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads.emplace_back(&tile_prefetcher_t::work, this, std::ref(reader));
+    }
+  }
+
+  ~tile_prefetcher_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    queued.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Queues a tile unless it is already queued, loading or loaded. Returns false if it was
+  bool Queue(const GraphId& base) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pending.insert(base).second) {
+      return false;
+    }
+    // The search has moved on the most from the oldest tiles
+    if (queue.size() == MAX_PREFETCHED_TILES) {
+      pending.erase(queue.front());
+      queue.pop_front();
+    }
+    queue.push_back(base);
+    queued.notify_one();
+    return true;
+  }
+
+  // Takes a tile loaded in the background, waiting for it if it is being loaded. Returns
+  // false if the tile was not queued or is still waiting in the queue, in which case it is
+  // quicker to load it on the spot.
+  bool Take(const GraphId& base, graph_tile_ptr& tile, size_t& size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!pending.count(base)) {
+      return false;
+    }
+    auto waiting = std::find(queue.begin(), queue.end(), base);
+    if (waiting != queue.end()) {
+      queue.erase(waiting);
+      pending.erase(base);
+      return false;
+    }
+    loaded.wait(lock, [this, &base]() { return ready.count(base) || !pending.count(base); });
+    auto found = ready.find(base);
+    if (found == ready.end()) {
+      return false;
+    }
+    tile = std::move(found->second.first);
+    size = found->second.second;
+    ready.erase(found);
+    ready_order.erase(std::find(ready_order.begin(), ready_order.end(), base));
+    pending.erase(base);
+    return true;
+  }
+
+  void work(GraphReader& reader) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      queued.wait(lock, [this]() { return stop || !queue.empty(); });
+      if (stop) {
+        return;
+      }
+      const GraphId base = queue.front();
+      queue.pop_front();
+
+      // Load it without holding the lock, a missing tile is handed over as well so that the
+      // reader does not look for it again
+      lock.unlock();
+      size_t size = 0;
+      graph_tile_ptr tile;
+      try {
+        // with the generation which is current now, the reader checks it against its own
+        const auto& snapshot = reader.tile_extract_->traffic_snapshot;
+        tile = reader.LoadGraphTile(base, size, snapshot ? snapshot->generation() : 0);
+      } catch (const std::exception& e) {
+        LOG_WARN(std::string("Tile prefetch failed: ") + e.what());
+      }
+      lock.lock();
+
+      ready.emplace(base, std::make_pair(std::move(tile), size));
+      ready_order.push_back(base);
+      while (ready.size() > MAX_PREFETCHED_TILES) {
+        ready.erase(ready_order.front());
+        pending.erase(ready_order.front());
+        ready_order.pop_front();
+      }
+      loaded.notify_all();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable loaded;
+  std::deque<GraphId> queue;
+  std::unordered_set<GraphId> pending; // queued, loading or loaded
+  std::unordered_map<GraphId, std::pair<graph_tile_ptr, size_t>> ready;
+  std::deque<GraphId> ready_order;
+  std::vector<std::thread> threads;
+  bool stop;
+};
+
 // Constructor using separate tile files
 GraphReader::GraphReader(const boost::property_tree::ptree& pt,
                          std::unique_ptr<tile_getter_t>&& tile_getter,
@@ -480,7 +836,9 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
       tile_dir_(tile_extract_->tiles.empty() ? pt.get<std::string>("tile_dir", "") : ""),
       tile_getter_(std::move(tile_getter)),
       max_concurrent_users_(pt.get<size_t>("max_concurrent_reader_users", 1)),
-      tile_url_(pt.get<std::string>("tile_url", "")), cache_(TileCacheFactory::createTileCache(pt)) {
+      tile_url_(pt.get<std::string>("tile_url", "")),
+      speed_cache_size_(pt.get<uint32_t>("predicted_speed_cache_size", 0)),
+      cache_(TileCacheFactory::createTileCache(pt)) {
 
   // Make a tile fetcher if we havent passed one in from somewhere else
   if (!tile_getter_ && !tile_url_.empty()) {
@@ -495,7 +853,8 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
 
   // Reserve cache (based on whether using individual tile files or shared,
   // mmap'd file
-  cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+  cache_->Reserve(tile_extract_->tiles.empty() || tile_extract_->compressed ? AVERAGE_TILE_SIZE
+                                                                            : AVERAGE_MM_TILE_SIZE);
 
   // Initialize the incident cache singleton if we have any kind of configuration to do so. if the
   // configuration is wrong or any kind of problem occurs this throws. the call below will spawn a
@@ -512,8 +871,16 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
   if (pt.get<bool>("shortcut_caching", false)) {
     shortcut_recovery_t::get_instance(this);
   }
+
+  // Load the tiles the searches are about to need in the background if requested
+  if (auto prefetch_threads = pt.get<size_t>("prefetch_threads", 0)) {
+    prefetcher_.reset(new tile_prefetcher_t(*this, prefetch_threads));
+  }
 }
 
+// Stops the prefetch threads before anything they use goes away
+GraphReader::~GraphReader() = default;
+
 // Method to test if tile exists
 bool GraphReader::DoesTileExist(const GraphId& graphid) const {
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
@@ -548,6 +915,33 @@ private:
   const std::shared_ptr<midgard::tar> archive_;
 };
 
+class DecompressedGraphMemory final : public GraphMemory {
+public:
+  DecompressedGraphMemory(std::vector<char>&& memory) : memory_(std::move(memory)) {
+    data = const_cast<char*>(memory_.data());
+    size = memory_.size();
+  }
+
+private:
+  const std::vector<char> memory_;
+};
+
+// The graph data of another tile, which is kept alive as long as this is. A tile which already
+// shares the data of another one is skipped so that publishing traffic does not chain up tiles
+class SharedTileGraphMemory final : public GraphMemory {
+public:
+  SharedTileGraphMemory(graph_tile_ptr tile) : tile_(std::move(tile)) {
+    if (const auto* shared = dynamic_cast<const SharedTileGraphMemory*>(tile_->memory())) {
+      tile_ = shared->tile_;
+    }
+    data = reinterpret_cast<char*>(const_cast<GraphTileHeader*>(tile_->header()));
+    size = tile_->header()->end_offset();
+  }
+
+private:
+  graph_tile_ptr tile_;
+};
+
 // Get a pointer to a graph tile object given a GraphId. Return nullptr
 // if the tile is not found/empty
 graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
@@ -558,11 +952,99 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
 
   // Check if the level/tileid combination is in the cache
   auto base = graphid.Tile_Base();
+  const uint32_t generation = PinTrafficSnapshot();
   if (const auto& cached = cache_->Get(base)) {
     // LOG_DEBUG("Memory cache hit " + GraphTile::FileSuffix(base));
-    return cached;
+    tile_counters_.cache_hits.fetch_add(1, std::memory_order_relaxed);
+    return generation ? GetPinnedTile(base, cached) : cached;
   }
+  tile_counters_.cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+  // A tile loaded in the background only has to be put in the cache
+  size_t size = 0;
+  graph_tile_ptr tile;
+  if (!prefetcher_ || !prefetcher_->Take(base, tile, size)) {
+    if (prefetcher_) {
+      tile_counters_.prefetch_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    tile = LoadGraphTile(base, size, generation);
+  } else {
+    tile_counters_.prefetch_hits.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (!tile) {
+    return nullptr;
+  }
+
+  // Keep a copy in the cache and return it, another reader may have cached it with another
+  // generation in the meantime
+  tile = cache_->Put(base, std::move(tile), size);
+  return generation ? GetPinnedTile(base, std::move(tile)) : tile;
+}
+
+// Pins the current generation of the traffic snapshot unless one is pinned already
+uint32_t GraphReader::PinTrafficSnapshot() {
+  const auto& snapshot = tile_extract_->traffic_snapshot;
+  if (!snapshot || traffic_pinned_) {
+    return traffic_generation_;
+  }
+  traffic_generation_ = snapshot->generation();
+  traffic_pinned_ = true;
+  return traffic_generation_;
+}
+
+// Pins the given generation, the tiles given the traffic of another one are dropped
+void GraphReader::PinTrafficSnapshot(const uint32_t generation) {
+  if (!tile_extract_->traffic_snapshot) {
+    return;
+  }
+  if (traffic_generation_ != generation) {
+    pinned_tiles_.clear();
+  }
+  traffic_generation_ = generation;
+  traffic_pinned_ = true;
+}
+
+void GraphReader::UnpinTrafficSnapshot() {
+  traffic_pinned_ = false;
+  pinned_tiles_.clear();
+}
+
+// Tiles read with another generation get the traffic of the pinned one attached to their graph
+// data. If the pinned generation is the published one the cached tile is outdated for every
+// reader from now on, so it is replaced in the cache and only reattached once. Requests still
+// pinned to an older generation keep their copy to themselves
+graph_tile_ptr GraphReader::GetPinnedTile(const GraphId& base, graph_tile_ptr tile) {
+  const auto& traffic = tile->get_traffic_tile();
+  if (!traffic() || traffic.header->generation == traffic_generation_) {
+    return tile;
+  }
+  auto pinned = pinned_tiles_.find(base);
+  if (pinned != pinned_tiles_.end()) {
+    return pinned->second;
+  }
+  const bool outdated = traffic.header->generation < traffic_generation_ &&
+                        traffic_generation_ == tile_extract_->traffic_snapshot->generation();
+  graph_tile_ptr reattached =
+      GraphTile::Create(base, std::make_unique<const SharedTileGraphMemory>(tile),
+                        LoadTrafficTile(base, traffic_generation_), speed_cache_size_);
+  if (!reattached) {
+    return nullptr;
+  }
+  if (outdated) {
+    // another reader may have replaced it first, theirs will do if it has the same generation
+    auto cached = cache_->Replace(base, tile, reattached);
+    if (cached && (cached == reattached ||
+                   (cached->get_traffic_tile()() &&
+                    cached->get_traffic_tile().header->generation == traffic_generation_))) {
+      return cached;
+    }
+  }
+  return pinned_tiles_.emplace(base, std::move(reattached)).first->second;
+}
 
+// Loads a tile without the cache, along with its size for the cache
+graph_tile_ptr
+GraphReader::LoadGraphTile(const GraphId& base, size_t& size, const uint32_t traffic_generation) {
   // Try getting it from the memmapped tar extract
   if (!tile_extract_->tiles.empty()) {
     // Do we have this tile
@@ -571,35 +1053,39 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
       // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
       return nullptr;
     }
-    auto memory = std::make_unique<TarballGraphMemory>(tile_extract_->archive, t->second);
+    // Compressed tiles are decompressed into memory of their own, which the cache accounts for
+    std::unique_ptr<const GraphMemory> memory;
+    size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
+    if (tile_extract_->compressed) {
+      auto data = tile_extract_->compressed->Decompress(base);
+      if (data.empty()) {
+        return nullptr;
+      }
+      size = data.size();
+      memory = std::make_unique<const DecompressedGraphMemory>(std::move(data));
+    } else {
+      memory = std::make_unique<const TarballGraphMemory>(tile_extract_->archive, t->second);
+    }
 
-    auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
+    auto traffic_memory = LoadTrafficTile(base, traffic_generation);
 
     // This initializes the tile from mmap
-    auto tile = GraphTile::Create(base, std::move(memory), std::move(traffic_memory));
+    auto tile = GraphTile::Create(base, std::move(memory), std::move(traffic_memory),
+                                  speed_cache_size_);
     if (!tile) {
       // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
       return nullptr;
     }
     // LOG_DEBUG("Memory map cache hit " + GraphTile::FileSuffix(base));
 
-    // Keep a copy in the cache and return it
-    const size_t size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
-    return cache_->Put(base, std::move(tile), size);
+    return tile;
   } // Try getting it from flat file
   else {
-    auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
+    auto traffic_memory = LoadTrafficTile(base, traffic_generation);
 
     // Try to get it from disk and if we cant..
-    graph_tile_ptr tile = GraphTile::Create(tile_dir_, base, std::move(traffic_memory));
+    graph_tile_ptr tile =
+        GraphTile::Create(tile_dir_, base, std::move(traffic_memory), speed_cache_size_);
     if (!tile || !tile->header()) {
       if (!tile_getter_) {
         return nullptr;
@@ -614,7 +1100,8 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
       }
 
       // Get it from the url and cache it to disk if you can
-      tile = GraphTile::CacheTileURL(tile_url_, base, tile_getter_.get(), tile_dir_);
+      tile = GraphTile::CacheTileURL(tile_url_, base, tile_getter_.get(), tile_dir_,
+                                     speed_cache_size_);
       if (!tile) {
         std::lock_guard<std::mutex> lock(_404s_lock);
         _404s.insert(base);
@@ -626,9 +1113,72 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
       // LOG_DEBUG("Disk cache hit " + GraphTile::FileSuffix(base));
     }
 
-    // Keep a copy in the cache and return it
-    const size_t size = tile->header()->end_offset();
-    return cache_->Put(base, std::move(tile), size);
+    size = tile->header()->end_offset();
+    return tile;
+  }
+}
+
+std::unique_ptr<const GraphMemory>
+GraphReader::LoadTrafficTile(const GraphId& base, const uint32_t traffic_generation) const {
+  const auto& snapshot = tile_extract_->traffic_snapshot;
+  const auto& archive =
+      snapshot ? snapshot->buffer(traffic_generation).archive : tile_extract_->traffic_archive;
+  const auto& tiles =
+      snapshot ? snapshot->buffer(traffic_generation).tiles : tile_extract_->traffic_tiles;
+  auto traffic_ptr = tiles.find(base);
+  if (traffic_ptr == tiles.end()) {
+    return nullptr;
+  }
+  return std::make_unique<TarballGraphMemory>(archive, traffic_ptr->second);
+}
+
+// Queues a tile to be loaded in the background
+void GraphReader::Prefetch(const GraphId& graphid) {
+  if (!prefetcher_ || !graphid.Is_Valid()) {
+    return;
+  }
+  auto base = graphid.Tile_Base();
+  if (cache_->Contains(base) || (!tile_extract_->tiles.empty() &&
+                                 tile_extract_->tiles.find(base) == tile_extract_->tiles.cend())) {
+    return;
+  }
+  if (prefetcher_->Queue(base)) {
+    tile_counters_.prefetch_requests.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// Queues the tiles ahead of a search
+void GraphReader::Prefetch(const GraphId& graphid, const PointLL& ll, const PointLL& target) {
+  if (!prefetcher_ || !graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
+    return;
+  }
+  const auto& tiles = TileHierarchy::get_tiling(graphid.level());
+  const int32_t tileid = graphid.tileid();
+  std::vector<int32_t> ahead;
+  if (!ll.IsValid() || !target.IsValid()) {
+    // Without a target the search spreads out to all the neighbours
+    for (auto row : {tiles.TopNeighbor(tileid), tileid, tiles.BottomNeighbor(tileid)}) {
+      ahead.push_back(tiles.LeftNeighbor(row));
+      ahead.push_back(row);
+      ahead.push_back(tiles.RightNeighbor(row));
+    }
+  } else {
+    // The tiles one and two tile sizes ahead toward the target, then the neighbours on the
+    // sides which face it
+    const double dx = target.lng() - ll.lng();
+    const double dy = target.lat() - ll.lat();
+    const double distance = std::sqrt(dx * dx + dy * dy);
+    for (int step = 1; step <= 2 && distance > 0.0; ++step) {
+      const double along = std::min<double>(distance, step * tiles.TileSize()) / distance;
+      ahead.push_back(tiles.TileId(ll.lat() + dy * along, ll.lng() + dx * along));
+    }
+    ahead.push_back(dx > 0.0 ? tiles.RightNeighbor(tileid) : tiles.LeftNeighbor(tileid));
+    ahead.push_back(dy > 0.0 ? tiles.TopNeighbor(tileid) : tiles.BottomNeighbor(tileid));
+  }
+  for (auto id : ahead) {
+    if (id >= 0 && id != tileid) {
+      Prefetch(GraphId(id, graphid.level(), 0));
+    }
   }
 }
 
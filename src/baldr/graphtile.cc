@@ -57,7 +57,8 @@ private:
 };
 
 graph_tile_ptr GraphTile::DecompressTile(const GraphId& graphid,
-                                         const std::vector<char>& compressed) {
+                                         const std::vector<char>& compressed,
+                                         const uint32_t speed_cache_size) {
   // for setting where to read compressed data from
   auto src_func = [&compressed](z_stream& s) -> void {
     s.next_in =
@@ -89,14 +90,16 @@ graph_tile_ptr GraphTile::DecompressTile(const GraphId& graphid,
     return nullptr;
   }
 
-  return graph_tile_ptr{
-      new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(data)))};
+  return graph_tile_ptr{new GraphTile(graphid,
+                                      std::make_unique<const VectorGraphMemory>(std::move(data)),
+                                      nullptr, speed_cache_size)};
 }
 
 // Constructor given a filename. Reads the graph data into memory.
 graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
                                  const GraphId& graphid,
-                                 std::unique_ptr<const GraphMemory>&& traffic_memory) {
+                                 std::unique_ptr<const GraphMemory>&& traffic_memory,
+                                 const uint32_t speed_cache_size) {
   if (!graphid.Is_Valid()) {
     LOG_ERROR("Failed to build GraphTile. Error: GraphId is invalid");
     return nullptr;
@@ -126,7 +129,7 @@ graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
     file.close();
     return graph_tile_ptr{new GraphTile(graphid,
                                         std::make_unique<const VectorGraphMemory>(std::move(data)),
-                                        std::move(traffic_memory))};
+                                        std::move(traffic_memory), speed_cache_size)};
   }
 
   // Try to load a gzipped tile
@@ -138,7 +141,7 @@ graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
     std::vector<char> compressed(filesize);
     gz_file.read(&compressed[0], filesize);
     gz_file.close();
-    return DecompressTile(graphid, std::move(compressed));
+    return DecompressTile(graphid, std::move(compressed), speed_cache_size);
   }
 
   // Nothing to load anywhere
@@ -152,19 +155,27 @@ graph_tile_ptr GraphTile::Create(const GraphId& graphid, std::vector<char>&& mem
 
 graph_tile_ptr GraphTile::Create(const GraphId& graphid,
                                  std::unique_ptr<const GraphMemory>&& memory,
-                                 std::unique_ptr<const GraphMemory>&& traffic_memory) {
-  return graph_tile_ptr{new GraphTile(graphid, std::move(memory), std::move(traffic_memory))};
+                                 std::unique_ptr<const GraphMemory>&& traffic_memory,
+                                 const uint32_t speed_cache_size) {
+  return graph_tile_ptr{
+      new GraphTile(graphid, std::move(memory), std::move(traffic_memory), speed_cache_size)};
 }
 
 // the right c-tor for GraphTile
 GraphTile::GraphTile(const GraphId& graphid,
                      std::unique_ptr<const GraphMemory> memory,
-                     std::unique_ptr<const GraphMemory> traffic_memory)
+                     std::unique_ptr<const GraphMemory> traffic_memory,
+                     const uint32_t speed_cache_size)
     : header_(nullptr), traffic_tile(std::move(traffic_memory)) {
   // Initialize the internal tile data structures using a pointer to the
   // tile and the tile size
   memory_ = std::move(memory);
   Initialize(graphid);
+
+  // Only tiles with predicted speeds need somewhere to keep the decoded ones
+  if (header_->predictedspeeds_count() > 0) {
+    predictedspeeds_.set_cache_size(speed_cache_size, header_->predictedspeeds_count());
+  }
 }
 
 GraphTile::GraphTile(const std::string& tile_dir,
@@ -225,7 +236,8 @@ void store(const std::string& cache_location,
 graph_tile_ptr GraphTile::CacheTileURL(const std::string& tile_url,
                                        const GraphId& graphid,
                                        tile_getter_t* tile_getter,
-                                       const std::string& cache_location) {
+                                       const std::string& cache_location,
+                                       const uint32_t speed_cache_size) {
   // Don't bother with invalid ids
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level() || !tile_getter) {
     return nullptr;
@@ -242,11 +254,12 @@ graph_tile_ptr GraphTile::CacheTileURL(const std::string& tile_url,
 
   // turn the memory into a tile
   if (tile_getter->gzipped()) {
-    return DecompressTile(graphid, result.bytes_);
+    return DecompressTile(graphid, result.bytes_, speed_cache_size);
   }
 
   return graph_tile_ptr{
-      new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(result.bytes_)))};
+      new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(result.bytes_)),
+                    nullptr, speed_cache_size)};
 }
 
 GraphTile::~GraphTile() = default;
@@ -354,7 +367,8 @@ void GraphTile::Initialize(const GraphId& graphid) {
   // Start of lane connections and their size
   lane_connectivity_ =
       reinterpret_cast<LaneConnectivity*>(tile_ptr + header_->lane_connectivity_offset());
-  lane_connectivity_size_ = header_->predictedspeeds_offset() - header_->lane_connectivity_offset();
+  // Lane connections end where the first of the optional sections appended after them starts
+  uint32_t lane_connectivity_end = header_->end_offset();
 
   // Start of predicted speed data.
   if (header_->predictedspeeds_count() > 0) {
@@ -363,10 +377,18 @@ void GraphTile::Initialize(const GraphId& graphid) {
     predictedspeeds_.set_offset(reinterpret_cast<uint32_t*>(ptr1));
     predictedspeeds_.set_profiles(reinterpret_cast<int16_t*>(ptr2));
 
-    lane_connectivity_size_ = header_->predictedspeeds_offset() - header_->lane_connectivity_offset();
-  } else {
-    lane_connectivity_size_ = header_->end_offset() - header_->lane_connectivity_offset();
+    lane_connectivity_end = std::min(lane_connectivity_end, header_->predictedspeeds_offset());
+  }
+
+  // Start of edge reach data.
+  if (header_->edge_reach_offset() > 0) {
+    char* ptr1 = tile_ptr + header_->edge_reach_offset();
+    edge_reach_header_ = reinterpret_cast<EdgeReachHeader*>(ptr1);
+    edge_reach_ = reinterpret_cast<EdgeReach*>(ptr1 + sizeof(EdgeReachHeader));
+
+    lane_connectivity_end = std::min(lane_connectivity_end, header_->edge_reach_offset());
   }
+  lane_connectivity_size_ = lane_connectivity_end - header_->lane_connectivity_offset();
 
   // For reference - how to use the end offset to set size of an object (that
   // is not fixed size and count).
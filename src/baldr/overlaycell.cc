@@ -0,0 +1,131 @@
+#include "baldr/overlaycell.h"
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+uint32_t find(const uint64_t* begin, const uint64_t* end, const uint64_t value) {
+  auto found = std::lower_bound(begin, end, value);
+  return found != end && *found == value ? static_cast<uint32_t>(found - begin)
+                                         : valhalla::baldr::kInvalidBoundary;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+GraphId OverlayCellId(const midgard::PointLL& ll, const uint32_t level) {
+  const auto& local = TileHierarchy::levels().back().tiles;
+  const uint8_t graph_level = kOverlayLevels - level;
+  const auto& tiles = TileHierarchy::levels()[graph_level].tiles;
+  int32_t row = local.Row(ll.lat());
+  int32_t col = local.Col(ll.lng());
+  if (row < 0 || col < 0) {
+    return {};
+  }
+  int32_t ratio = static_cast<int32_t>(std::round(tiles.TileSize() / local.TileSize()));
+  return GraphId(tiles.TileId(col / ratio, row / ratio), graph_level, 0);
+}
+
+uint32_t OverlayBoundaryLevel(const midgard::PointLL& a, const midgard::PointLL& b) {
+  for (uint32_t level = kOverlayLevels; level > 0; --level) {
+    if (OverlayCellId(a, level) != OverlayCellId(b, level)) {
+      return level;
+    }
+  }
+  return 0;
+}
+
+std::shared_ptr<const OverlayCell> OverlayCell::Create(const std::string& dir,
+                                                       const GraphId& cellid) {
+  const std::string file_location = dir + filesystem::path::preferred_separator +
+                                    GraphTile::FileSuffix(cellid.Tile_Base(), SUFFIX_OVERLAY);
+  std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+
+  size_t filesize = file.tellg();
+  std::vector<char> data(filesize);
+  file.seekg(0, std::ios::beg);
+  file.read(data.data(), filesize);
+  file.close();
+  try {
+    auto cell = std::make_shared<const OverlayCell>(std::move(data));
+    if (GraphId(cell->header()->cellid) != cellid.Tile_Base()) {
+      throw std::runtime_error("it belongs to another cell");
+    }
+    return cell;
+  } catch (const std::exception& e) {
+    LOG_ERROR("Invalid overlay cell " + file_location + ": " + e.what());
+  }
+  return nullptr;
+}
+
+OverlayCell::OverlayCell(std::vector<char>&& data) : data_(std::move(data)) {
+  if (data_.size() < sizeof(OverlayCellHeader)) {
+    throw std::runtime_error("Overlay cell is too small for its header");
+  }
+  header_ = reinterpret_cast<const OverlayCellHeader*>(data_.data());
+  if (data_.size() != sizeof(OverlayCellHeader) +
+                          (static_cast<size_t>(header_->entrycount) + header_->exitcount) *
+                              sizeof(uint64_t)) {
+    throw std::runtime_error("Overlay cell size does not match its header");
+  }
+  entries_ = reinterpret_cast<const uint64_t*>(data_.data() + sizeof(OverlayCellHeader));
+  exits_ = entries_ + header_->entrycount;
+  if (!std::is_sorted(entries_, exits_) || !std::is_sorted(exits_, exits_ + header_->exitcount)) {
+    throw std::runtime_error("Overlay cell boundary edges are not sorted");
+  }
+}
+
+uint32_t OverlayCell::EntryIndex(const GraphId& edgeid) const {
+  return find(entries_, entries_ + header_->entrycount, edgeid.value);
+}
+
+uint32_t OverlayCell::ExitIndex(const GraphId& edgeid) const {
+  return find(exits_, exits_ + header_->exitcount, edgeid.value);
+}
+
+OverlayReader::OverlayReader(const std::string& dir, const size_t max_cache_size)
+    : dir_(dir), max_cache_size_(max_cache_size), cache_size_(0) {
+}
+
+std::shared_ptr<const OverlayCell> OverlayReader::GetCell(const GraphId& cellid,
+                                                          GraphReader& graphreader) {
+  auto cached = cache_.find(cellid.value);
+  if (cached != cache_.end()) {
+    return cached->second;
+  }
+
+  // Missing and outdated cells are cached as well so they are only looked for once
+  auto cell = OverlayCell::Create(dir_, cellid);
+  if (cell && cell->entry_count() + cell->exit_count() > 0) {
+    auto edgeid = cell->entry_count() > 0 ? cell->entry(0) : cell->exit(0);
+    auto graph_tile = graphreader.GetGraphTile(edgeid);
+    if (!graph_tile || graph_tile->header()->dataset_id() != cell->header()->dataset_id) {
+      LOG_WARN("Overlay cell " + std::to_string(cellid) + " was built from another dataset");
+      cell = nullptr;
+    }
+  }
+  cache_size_ += cell ? cell->size() : 0;
+  return cache_.emplace(cellid.value, std::move(cell)).first->second;
+}
+
+void OverlayReader::Trim() {
+  if (cache_size_ > max_cache_size_) {
+    cache_.clear();
+    cache_size_ = 0;
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
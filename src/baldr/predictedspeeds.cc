@@ -1,5 +1,11 @@
 #include "baldr/predictedspeeds.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace valhalla {
 namespace baldr {
 
@@ -72,19 +78,113 @@ std::array<int16_t, kCoefficientCount> compress_speed_buckets(const float* speed
   return result;
 }
 
+// The vectorized sums below work on blocks of 8 coefficients
+static_assert(kCoefficientCount % 8 == 0, "Coefficient count must be a multiple of 8");
+
+namespace {
+
+#if defined(__AVX2__)
+float horizontal_sum(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+#elif defined(__SSE2__)
+float horizontal_sum(__m128 v) {
+  __m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+#endif
+
+// Sum of the coefficients weighted by the cos values of a bucket. The vector kernels keep
+// several partial sums and add them up at the end, so the float result can differ from the
+// scalar loop in the last bits. That is far below the 1 kph speeds are used at.
+float dot(const int16_t* coefficients, const float* cos_values) {
+#if defined(__AVX2__)
+  __m256 sum = _mm256_setzero_ps();
+  for (uint32_t c = 0; c < kCoefficientCount; c += 8) {
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + c));
+    __m256 coef = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(packed));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(coef, _mm256_loadu_ps(cos_values + c)));
+  }
+  return horizontal_sum(sum);
+#elif defined(__SSE2__)
+  __m128 lo_sum = _mm_setzero_ps();
+  __m128 hi_sum = _mm_setzero_ps();
+  for (uint32_t c = 0; c < kCoefficientCount; c += 8) {
+    // sign extend the 16 bit coefficients by moving them to the top of 32 bit lanes
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + c));
+    __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+    __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+    lo_sum = _mm_add_ps(lo_sum, _mm_mul_ps(lo, _mm_loadu_ps(cos_values + c)));
+    hi_sum = _mm_add_ps(hi_sum, _mm_mul_ps(hi, _mm_loadu_ps(cos_values + c + 4)));
+  }
+  return horizontal_sum(_mm_add_ps(lo_sum, hi_sum));
+#else
+  float sum = 0.f;
+  for (uint32_t c = 0; c < kCoefficientCount; ++c) {
+    sum += coefficients[c] * cos_values[c];
+  }
+  return sum;
+#endif
+}
+
+// Same as above for coefficients that were already converted to floats
+float dot(const float* coefficients, const float* cos_values) {
+#if defined(__AVX2__)
+  __m256 sum = _mm256_setzero_ps();
+  for (uint32_t c = 0; c < kCoefficientCount; c += 8) {
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(coefficients + c),
+                                           _mm256_loadu_ps(cos_values + c)));
+  }
+  return horizontal_sum(sum);
+#elif defined(__SSE2__)
+  __m128 lo_sum = _mm_setzero_ps();
+  __m128 hi_sum = _mm_setzero_ps();
+  for (uint32_t c = 0; c < kCoefficientCount; c += 8) {
+    lo_sum = _mm_add_ps(lo_sum,
+                        _mm_mul_ps(_mm_loadu_ps(coefficients + c), _mm_loadu_ps(cos_values + c)));
+    hi_sum = _mm_add_ps(hi_sum, _mm_mul_ps(_mm_loadu_ps(coefficients + c + 4),
+                                           _mm_loadu_ps(cos_values + c + 4)));
+  }
+  return horizontal_sum(_mm_add_ps(lo_sum, hi_sum));
+#else
+  float sum = 0.f;
+  for (uint32_t c = 0; c < kCoefficientCount; ++c) {
+    sum += coefficients[c] * cos_values[c];
+  }
+  return sum;
+#endif
+}
+
+} // namespace
+
 float decompress_speed_bucket(const int16_t* coefficients, uint32_t bucket_idx) {
   // Get a pointer to the precomputed cos values for this bucket
   const float* b = BucketCosTable::GetInstance().get(bucket_idx);
 
-  // DCT-III with speed normalization
-  float speed = *coefficients * k1OverSqrt2;
-  const auto* coef_end = coefficients + kCoefficientCount;
-  for (++b, ++coefficients; coefficients < coef_end; ++coefficients, ++b) {
-    speed += *coefficients * *b;
-  }
+  // DCT-III with speed normalization. The cos value of the first coefficient is 1 so
+  // the sum counts it fully, correct it to the 1 / sqrt(2) weight it has
+  float speed = dot(coefficients, b) + *coefficients * (k1OverSqrt2 - 1.f);
   return speed * kSpeedNormalization;
 }
 
+void decompress_speed_buckets(const int16_t* coefficients, float* speeds) {
+  // Convert the coefficients once for all the buckets, with the weight of the first one
+  std::array<float, kCoefficientCount> values;
+  for (uint32_t c = 0; c < kCoefficientCount; ++c) {
+    values[c] = coefficients[c];
+  }
+  values[0] *= k1OverSqrt2;
+
+  const BucketCosTable& table = BucketCosTable::GetInstance();
+  for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
+    speeds[bucket] = dot(values.data(), table.get(bucket)) * kSpeedNormalization;
+  }
+}
+
 std::string encode_compressed_speeds(const int16_t* coefficients) {
   std::string result;
   result.reserve(kCoefficientCount * sizeof(uint16_t) / sizeof(char));
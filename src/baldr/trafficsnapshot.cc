@@ -0,0 +1,160 @@
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "baldr/graphtile.h"
+#include "baldr/trafficsnapshot.h"
+#include "midgard/logging.h"
+
+namespace {
+
+using namespace valhalla::baldr;
+
+// Maps the tiles of a traffic extract to their ids
+TrafficSnapshot::buffer_t load_buffer(const std::string& file_name, const bool readonly) {
+  TrafficSnapshot::buffer_t buffer;
+  buffer.archive.reset(new valhalla::midgard::tar(file_name, readonly, true));
+  for (const auto& c : buffer.archive->contents) {
+    try {
+      auto id = GraphTile::GetTileId(c.first);
+      buffer.tiles[id] = std::make_pair(const_cast<char*>(c.second.first), c.second.second);
+    } catch (...) {
+      // The index and other files which are not tiles are skipped
+    }
+  }
+  if (buffer.tiles.empty()) {
+    throw std::runtime_error("Traffic snapshot buffer " + file_name + " contained no usable tiles");
+  }
+  return buffer;
+}
+
+TrafficTileHeader* tile_header(const std::pair<char*, size_t>& tile) {
+  if (tile.second < sizeof(TrafficTileHeader)) {
+    return nullptr;
+  }
+  return reinterpret_cast<TrafficTileHeader*>(tile.first);
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+TrafficSnapshot::TrafficSnapshot(const std::string& file_name, bool readonly)
+    : file_name_(file_name) {
+  struct stat s;
+  if (stat(file_name.c_str(), &s) ||
+      static_cast<size_t>(s.st_size) < sizeof(traffic_snapshot_header_t)) {
+    throw std::runtime_error("Traffic snapshot " + file_name + " is missing or too small");
+  }
+  // The generation is written in place so the control file is always shared
+  memmap_.map(file_name, sizeof(traffic_snapshot_header_t), POSIX_MADV_NORMAL, readonly);
+  header_ = reinterpret_cast<traffic_snapshot_header_t*>(memmap_.get());
+  if (memcmp(header_->magic, kTrafficSnapshotMagic, sizeof(kTrafficSnapshotMagic)) != 0) {
+    throw std::runtime_error(file_name + " is not a traffic snapshot");
+  }
+  if (header_->version != kTrafficSnapshotVersion) {
+    throw std::runtime_error("Traffic snapshot " + file_name + " has unsupported version " +
+                             std::to_string(header_->version));
+  }
+  generation_ = reinterpret_cast<std::atomic<uint32_t>*>(&header_->generation);
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    buffers_[i] = load_buffer(BufferName(file_name, i), readonly);
+  }
+  if (buffers_[0].tiles.size() != buffers_[1].tiles.size()) {
+    throw std::runtime_error("The buffers of traffic snapshot " + file_name +
+                             " hold different tiles");
+  }
+}
+
+void TrafficSnapshot::Create(const std::string& traffic_extract, const std::string& file_name) {
+  // Both buffers start as copies of the extract
+  for (uint32_t i = 0; i < 2; ++i) {
+    std::ifstream in(traffic_extract, std::ios::binary);
+    std::ofstream out(BufferName(file_name, i), std::ios::binary | std::ios::trunc);
+    if (!in.is_open() || !out.is_open()) {
+      throw std::runtime_error("Could not copy " + traffic_extract + " to " +
+                               BufferName(file_name, i));
+    }
+    out << in.rdbuf();
+    if (!out) {
+      throw std::runtime_error("Could not write " + BufferName(file_name, i));
+    }
+  }
+
+  traffic_snapshot_header_t header{};
+  memcpy(header.magic, kTrafficSnapshotMagic, sizeof(kTrafficSnapshotMagic));
+  header.version = kTrafficSnapshotVersion;
+  {
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+      throw std::runtime_error("Could not write " + file_name);
+    }
+  }
+
+  // Generation 0 is never published, so preparing from it publishes the extract as generation 1
+  TrafficSnapshot snapshot(file_name, false);
+  snapshot.Publish(snapshot.Prepare());
+}
+
+uint32_t TrafficSnapshot::Prepare(const bool reset) {
+  const uint32_t current = generation();
+  // Skip generation 0 when wrapping around, the parity still alternates
+  const uint32_t next = current + 1 == 0 ? 2 : current + 1;
+  const auto& active = buffer(current).tiles;
+  for (auto& tile : buffers_[next & 1].tiles) {
+    auto* header = tile_header(tile.second);
+    if (!header) {
+      continue;
+    }
+    if (reset) {
+      const auto tile_id = header->tile_id;
+      const auto count = header->directed_edge_count;
+      const auto version = header->traffic_tile_version;
+      memset(tile.second.first, 0, tile.second.second);
+      header->tile_id = tile_id;
+      header->directed_edge_count = count;
+      header->traffic_tile_version = version;
+    } else {
+      auto found = active.find(tile.first);
+      if (found == active.cend() || found->second.second != tile.second.second) {
+        throw std::runtime_error("The buffers of traffic snapshot " + file_name_ +
+                                 " hold different tiles");
+      }
+      memcpy(tile.second.first, found->second.first, tile.second.second);
+    }
+    header->generation = next;
+  }
+  return next;
+}
+
+TrafficSpeed* TrafficSnapshot::speed(const uint32_t generation, const GraphId& edge_id) const {
+  const auto& tiles = buffer(generation).tiles;
+  auto found = tiles.find(edge_id.Tile_Base());
+  if (found == tiles.cend()) {
+    return nullptr;
+  }
+  auto* header = tile_header(found->second);
+  if (!header || edge_id.id() >= header->directed_edge_count ||
+      sizeof(TrafficTileHeader) + (edge_id.id() + 1) * sizeof(TrafficSpeed) >
+          found->second.second) {
+    return nullptr;
+  }
+  return reinterpret_cast<TrafficSpeed*>(found->second.first + sizeof(TrafficTileHeader)) +
+         edge_id.id();
+}
+
+void TrafficSnapshot::Publish(const uint32_t generation) {
+  header_->published = std::time(nullptr);
+  // Everything written into the buffer happens before the readers see the generation
+  generation_->store(generation, std::memory_order_release);
+  LOG_INFO("Published generation " + std::to_string(generation) + " of traffic snapshot " +
+           file_name_);
+}
+
+} // namespace baldr
+} // namespace valhalla
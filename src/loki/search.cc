@@ -4,12 +4,15 @@
 #include "loki/reach.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/linesegment2.h"
+#include "midgard/logging.h"
 #include "midgard/util.h"
 
 #include <algorithm>
 #include <cmath>
 #include <iterator>
 #include <list>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace valhalla::midgard;
@@ -241,38 +244,54 @@ struct projector_wrapper {
   projector_t project;
 };
 
-struct bin_handler_t {
-  std::vector<projector_wrapper> pps;
+// Bins with fewer edge and location pairs than this are not worth handing to the worker threads
+constexpr size_t kMinParallelProjections = 512;
+
+// The number of edges of a bin projected onto in one step of the worker threads
+constexpr uint32_t kProjectionStepEdges = 16;
+
+// An edge of a bin which at least one of the locations sharing the bin may snap to
+struct bin_edge_t {
+  GraphId edge_id;
+  const DirectedEdge* edge;
+  graph_tile_ptr tile;
+  std::shared_ptr<const EdgeInfo> edge_info;
+};
+
+// the most reach any of the locations asks for
+unsigned int get_max_reach_limit(const std::vector<valhalla::baldr::Location>& locations) {
+  unsigned int max_reach_limit = 0;
+  for (const auto& loc : locations) {
+    max_reach_limit = std::max(max_reach_limit, loc.min_outbound_reach_);
+    max_reach_limit = std::max(max_reach_limit, loc.min_inbound_reach_);
+  }
+  return max_reach_limit;
+}
+
+// Works out the reach of edges and turns the candidates of a location into a path location.
+// Every thread correlating locations has one of its own since it expands the graph with the
+// reader of the thread
+struct correlator_t {
   valhalla::baldr::GraphReader& reader;
-  std::shared_ptr<DynamicCost> costing;
+  const std::shared_ptr<DynamicCost>& costing;
   unsigned int max_reach_limit;
-  std::vector<candidate_t> bin_candidates;
+  // mode class of the edge reach stored in the tiles, kReachModeCount when it cannot be used
+  uint32_t edge_reach_mode;
   std::unordered_set<uint64_t> correlated_edges;
   Reach reach_finder;
 
   // keep track of edges whose reachability we've already computed
-  // TODO: dont use pointers as keys, its safe for now but fancy caching one day could be bad
-  std::unordered_map<const DirectedEdge*, directed_reach> directed_reaches;
-
-  bin_handler_t(const std::vector<valhalla::baldr::Location>& locations,
-                valhalla::baldr::GraphReader& reader,
-                const std::shared_ptr<DynamicCost>& costing)
-      : reader(reader), costing(costing) {
-    // get the unique set of input locations and the max reachability of them all
-    std::unordered_set<Location> uniq_locations(locations.begin(), locations.end());
-    pps.reserve(uniq_locations.size());
-    max_reach_limit = 0;
-    for (const auto& loc : uniq_locations) {
-      pps.emplace_back(loc, reader);
-      max_reach_limit = std::max(max_reach_limit, loc.min_outbound_reach_);
-      max_reach_limit = std::max(max_reach_limit, loc.min_inbound_reach_);
-    }
-    // very annoying but it saves a lot of time to preallocate this instead of doing it in the loop
-    // in handle_bins
-    bin_candidates.resize(pps.size());
-    // TODO: make space for reach check in a more empirical way
-    auto reservation = std::max(max_reach_limit, static_cast<decltype(max_reach_limit)>(1));
-    directed_reaches.reserve(reservation * 1024);
+  std::unordered_map<uint64_t, directed_reach> directed_reaches;
+  // the reaches computed while searching, which the threads correlating locations share
+  const std::unordered_map<uint64_t, directed_reach>* searched_reaches;
+
+  correlator_t(valhalla::baldr::GraphReader& reader,
+               const std::shared_ptr<DynamicCost>& costing,
+               const unsigned int max_reach_limit,
+               const uint32_t edge_reach_mode,
+               const std::unordered_map<uint64_t, directed_reach>* searched_reaches = nullptr)
+      : reader(reader), costing(costing), max_reach_limit(max_reach_limit),
+        edge_reach_mode(edge_reach_mode), searched_reaches(searched_reaches) {
   }
 
   void correlate_node(const Location& location,
@@ -439,21 +458,179 @@ struct bin_handler_t {
     }
   }
 
+  // get the reach stored in the tile unless the edge may reach more nodes than we need and
+  // than it was computed up to
+  bool get_edge_reach(const GraphId edge_id, directed_reach& reach) {
+    if (edge_reach_mode >= kReachModeCount)
+      return false;
+    auto tile = reader.GetGraphTile(edge_id);
+    const EdgeReach* edge_reach = tile ? tile->edge_reach(edge_id.id()) : nullptr;
+    if (edge_reach == nullptr)
+      return false;
+
+    const uint32_t outbound = edge_reach->outbound[edge_reach_mode];
+    const uint32_t inbound = edge_reach->inbound[edge_reach_mode];
+    const uint32_t max_edge_reach = tile->max_edge_reach();
+    if (max_reach_limit > max_edge_reach &&
+        (outbound >= max_edge_reach || inbound >= max_edge_reach))
+      return false;
+
+    reach.outbound = std::min(outbound, max_reach_limit);
+    reach.inbound = std::min(inbound, max_reach_limit);
+    return true;
+  }
+
+  // the reach of the edge if we already know it
+  const directed_reach* find_reach(const GraphId edge_id) const {
+    auto itr = directed_reaches.find(edge_id);
+    if (itr != directed_reaches.cend())
+      return &itr->second;
+    if (searched_reaches != nullptr) {
+      itr = searched_reaches->find(edge_id);
+      if (itr != searched_reaches->cend())
+        return &itr->second;
+    }
+    return nullptr;
+  }
+
   directed_reach get_reach(const GraphId edge_id, const DirectedEdge* edge) {
     // if its in cache return it
-    auto itr = directed_reaches.find(edge);
-    if (itr != directed_reaches.cend())
-      return itr->second;
+    if (const auto* known = find_reach(edge_id))
+      return *known;
+
+    // or if its in the tile
+    directed_reach reach;
+    if (get_edge_reach(edge_id, reach)) {
+      directed_reaches[edge_id] = reach;
+      return reach;
+    }
 
     // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
-    directed_reaches[edge] = reach;
+    reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    directed_reaches[edge_id] = reach;
     return reach;
   }
 
+  // get the actual correlated location with edge_id etc from the sorted candidates of a location
+  void correlate(const projector_wrapper& pp, PathLocation& correlated) {
+    // keep a look up around so we dont add duplicates with worse scores
+    correlated_edges.reserve(pp.reachable.size());
+    correlated_edges.clear();
+    // TODO: this is already in PathLocation, use it there
+    std::vector<PathLocation::PathEdge> filtered;
+    for (const auto& candidate : pp.reachable) {
+      // this may be at a node, either because it was the closest thing or from snap tolerance
+      bool front = candidate.point == candidate.edge_info->shape().front() ||
+                   pp.location.latlng_.Distance(candidate.edge_info->shape().front()) <
+                       pp.location.node_snap_tolerance_;
+      bool back = candidate.point == candidate.edge_info->shape().back() ||
+                  pp.location.latlng_.Distance(candidate.edge_info->shape().back()) <
+                      pp.location.node_snap_tolerance_;
+      // it was the begin node
+      if ((front && candidate.edge->forward()) || (back && !candidate.edge->forward())) {
+        graph_tile_ptr other_tile;
+        auto opposing_edge = reader.GetOpposingEdge(candidate.edge_id, other_tile);
+        if (!other_tile) {
+          continue; // TODO: do an edge snap instead, but you'll only get one direction
+        }
+        correlate_node(pp.location, opposing_edge->endnode(), candidate, correlated, filtered);
+      } // it was the end node
+      else if ((back && candidate.edge->forward()) || (front && !candidate.edge->forward())) {
+        correlate_node(pp.location, candidate.edge->endnode(), candidate, correlated, filtered);
+      } // it was along the edge
+      else {
+        correlate_edge(pp.location, candidate, correlated, filtered);
+      }
+    }
+
+    // if it was a through location with a heading its pretty confusing.
+    // does the user want to come into and exit the location at the preferred
+    // angle? for now we are just saying that they want it to exit at the
+    // heading provided. this means that if it was node snapped we only
+    // want the outbound edges
+    if ((pp.location.stoptype_ == Location::StopType::THROUGH ||
+         pp.location.stoptype_ == Location::StopType::BREAK_THROUGH) &&
+        pp.location.heading_) {
+      // partition the ones we want to move to the end
+      auto new_end =
+          std::stable_partition(correlated.edges.begin(), correlated.edges.end(),
+                                [](const PathLocation::PathEdge& e) { return !e.end_node(); });
+      // move them to the end
+      filtered.insert(filtered.end(), std::make_move_iterator(new_end),
+                      std::make_move_iterator(correlated.edges.end()));
+      // remove them from the original
+      correlated.edges.erase(new_end, correlated.edges.end());
+    }
+
+    // if we have nothing because of filtering (heading/side) we'll just ignore it
+    if (correlated.edges.size() == 0 && filtered.size()) {
+      for (auto&& path_edge : filtered) {
+        if (correlated_edges.insert(path_edge.id).second) {
+          correlated.edges.push_back(std::move(path_edge));
+        }
+      }
+      filtered.clear();
+    }
+
+    // keep filtered edges for retry in case we cant find a route with non filtered edges
+    // use the max score of the non filtered edges as a penalty increase on each of the
+    // filtered edges so that when finding a route using non filtered edges fails the
+    // use of filtered edges are always penalized higher than the non filtered ones
+    auto max =
+        std::max_element(correlated.edges.begin(), correlated.edges.end(),
+                         [](const PathLocation::PathEdge& a, const PathLocation::PathEdge& b) {
+                           return a.distance < b.distance;
+                         });
+    std::for_each(filtered.begin(), filtered.end(),
+                  [&max](PathLocation::PathEdge& e) { e.distance += (3600.0f + max->distance); });
+    correlated.filtered_edges.insert(correlated.filtered_edges.end(),
+                                     std::make_move_iterator(filtered.begin()),
+                                     std::make_move_iterator(filtered.end()));
+  }
+};
+
+struct bin_handler_t {
+  std::vector<projector_wrapper> pps;
+  valhalla::baldr::GraphReader& reader;
+  std::shared_ptr<DynamicCost> costing;
+  unsigned int max_reach_limit;
+  // mode class of the edge reach stored in the tiles, kReachModeCount when it cannot be used
+  uint32_t edge_reach_mode;
+  // correlates on the calling thread, its reaches are the ones found while searching
+  correlator_t correlator;
+  SearchWorkers* workers;
+  // the edges of the bin being handled and the candidates of the locations sharing it on them,
+  // one after the other for every edge
+  std::vector<bin_edge_t> bin_edges;
+  std::vector<candidate_t> bin_candidates;
+  // the shapes of the edges decoded by each thread projecting onto them
+  std::vector<std::vector<PointLL>> shapes;
+
+  bin_handler_t(const std::vector<valhalla::baldr::Location>& locations,
+                valhalla::baldr::GraphReader& reader,
+                const std::shared_ptr<DynamicCost>& costing,
+                const bool use_edge_reach,
+                SearchWorkers* workers)
+      : reader(reader), costing(costing), max_reach_limit(get_max_reach_limit(locations)),
+        edge_reach_mode(use_edge_reach ? static_cast<uint32_t>(costing->travel_mode())
+                                       : kReachModeCount),
+        correlator(reader, this->costing, max_reach_limit, edge_reach_mode), workers(workers),
+        shapes(workers ? workers->size() : 1) {
+    // get the unique set of input locations
+    std::unordered_set<Location> uniq_locations(locations.begin(), locations.end());
+    pps.reserve(uniq_locations.size());
+    for (const auto& loc : uniq_locations) {
+      pps.emplace_back(loc, reader);
+    }
+    // TODO: make space for reach check in a more empirical way
+    auto reservation = std::max(max_reach_limit, static_cast<decltype(max_reach_limit)>(1));
+    correlator.directed_reaches.reserve(reservation * 1024);
+  }
+
   // do a mini network expansion or maybe not
   directed_reach check_reachability(std::vector<projector_wrapper>::iterator begin,
                                     std::vector<projector_wrapper>::iterator end,
+                                    std::vector<candidate_t>::const_iterator candidates,
                                     graph_tile_ptr tile,
                                     const DirectedEdge* edge,
                                     const GraphId edge_id) {
@@ -462,14 +639,15 @@ struct bin_handler_t {
       return {};
 
     // do we already know about this one?
-    auto found = directed_reaches.find(edge);
+    auto& directed_reaches = correlator.directed_reaches;
+    auto found = directed_reaches.find(edge_id);
     if (found != directed_reaches.cend())
       return found->second;
 
     // we only want to waste time checking if this could become the best reachable option for a
     // given location
     bool check = false;
-    auto c_itr = bin_candidates.begin();
+    auto c_itr = candidates;
     for (auto p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
       check = check || p_itr->reachable.empty() ||
               c_itr->sq_distance < p_itr->reachable.back().sq_distance;
@@ -479,24 +657,38 @@ struct bin_handler_t {
     if (!check)
       return {max_reach_limit, max_reach_limit};
 
+    // the tile may know it already
+    directed_reach reach;
+    if (correlator.get_edge_reach(edge_id, reach)) {
+      directed_reaches[edge_id] = reach;
+      return reach;
+    }
+
     // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
-    directed_reaches[edge] = reach;
+    reach = correlator.reach_finder(edge, edge_id, max_reach_limit, reader, costing,
+                                    kInbound | kOutbound);
+    directed_reaches[edge_id] = reach;
 
     // if the inbound reach is not 0 and the outbound reach is not 0 and the opposing edge is not
     // filtered then the reaches of both edges are the same
 
     const DirectedEdge* opp_edge = nullptr;
-    if (reach.outbound > 0 && reach.inbound > 0 && (opp_edge = reader.GetOpposingEdge(edge, tile)) &&
+    GraphId opp_edge_id;
+    if (reach.outbound > 0 && reach.inbound > 0 &&
+        (opp_edge_id = reader.GetOpposingEdgeId(edge_id, opp_edge, tile)) &&
         costing->Allowed(opp_edge, tile, kDisallowShortcut)) {
-      directed_reaches[opp_edge] = reach;
+      directed_reaches[opp_edge_id] = reach;
     }
     return reach;
   }
 
-  // handle a bin for the range of candidates that share it
-  void handle_bin(std::vector<projector_wrapper>::iterator begin,
+  // collect the edges of the bin that at least one of the locations sharing it may snap to
+  void gather_bin(std::vector<projector_wrapper>::iterator begin,
                   std::vector<projector_wrapper>::iterator end) {
+    bin_edges.clear();
+    bin_candidates.clear();
+    const size_t count = end - begin;
+
     // iterate over the edges in the bin
     auto tile = begin->cur_tile;
     auto edges = tile->GetBin(begin->bin_index);
@@ -516,70 +708,98 @@ struct bin_handler_t {
           continue;
       }
 
-      // initialize candidates vector:
-      // - reset sq_distance to max so we know the best point along the edge
+      // initialize the candidates of this edge:
+      // - set sq_distance to max so we know the best point along the edge
       // - apply prefilters based on user's SearchFilter request options
-      auto c_itr = bin_candidates.begin();
-      decltype(begin) p_itr;
       bool all_prefiltered = true;
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        c_itr->sq_distance = std::numeric_limits<double>::max();
-        c_itr->prefiltered =
+      for (auto p_itr = begin; p_itr != end; ++p_itr) {
+        bin_candidates.emplace_back();
+        auto& candidate = bin_candidates.back();
+        candidate.sq_distance = std::numeric_limits<double>::max();
+        candidate.prefiltered =
             is_search_filter_triggered(edge, *costing, tile, p_itr->location.search_filter_);
         // set to false if even one candidate was not filtered
-        all_prefiltered = all_prefiltered && c_itr->prefiltered;
+        all_prefiltered = all_prefiltered && candidate.prefiltered;
       }
 
       // short-circuit if all candidates were prefiltered
       if (all_prefiltered) {
+        bin_candidates.resize(bin_candidates.size() - count);
         continue;
       }
+      bin_edges.push_back({edge_id, edge, tile, nullptr});
+    }
+  }
 
-      // TODO: can we speed this up? the majority of edges will be short and far away enough
-      // such that the closest point on the edge will be one of the edges end points, we can get
-      // these coordinates them from the nodes in the graph. we can then find whichever end is
-      // closest to the input point p, call it n. we can then define an half plane h intersecting n
-      // so that its orthogonal to the ray from p to n. using h, we only need to test segments
-      // of the shape which are on the same side of h that p is. to make this fast we would need a
-      // a trivial half plane test as maybe a single dot product and comparison?
-
-      // get some shape of the edge
-      auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge));
-      auto shape = edge_info->lazy_shape();
-      PointLL v;
-      if (!shape.empty()) {
-        v = shape.pop();
-      }
+  // find the best point along the edges of the bin for each of the locations sharing it
+  void project_bin(std::vector<projector_wrapper>::iterator begin,
+                   std::vector<projector_wrapper>::iterator end) {
+    const size_t count = end - begin;
+    // the edges are independent of each other and only read the tiles so that several threads
+    // can project onto them, the reader is not needed
+    auto project = [&](const size_t first, const size_t last, std::vector<PointLL>& shape) {
+      for (size_t i = first; i < last; ++i) {
+        auto& bin_edge = bin_edges[i];
+        // TODO: can we speed this up? the majority of edges will be short and far away enough
+        // such that the closest point on the edge will be one of the edges end points, we can get
+        // these coordinates them from the nodes in the graph. we can then find whichever end is
+        // closest to the input point p, call it n. we can then define an half plane h intersecting
+        // n so that its orthogonal to the ray from p to n. using h, we only need to test segments
+        // of the shape which are on the same side of h that p is. to make this fast we would need
+        // a trivial half plane test as maybe a single dot product and comparison?
+
+        // get the shape of the edge
+        bin_edge.edge_info =
+            std::make_shared<const EdgeInfo>(bin_edge.tile->edgeinfo(bin_edge.edge));
+        auto decoder = bin_edge.edge_info->lazy_shape();
+        shape.clear();
+        while (!decoder.empty()) {
+          shape.push_back(decoder.pop());
+        }
 
-      // iterate along this edges segments projecting each of the points
-      for (size_t i = 0; !shape.empty(); ++i) {
-        auto u = v;
-        v = shape.pop();
-        // for each input point
-        c_itr = bin_candidates.begin();
-        for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+        // project each input point onto all of its segments
+        auto c_itr = bin_candidates.begin() + i * count;
+        for (auto p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
           // skip updating this candidate because it was prefiltered
-          if (c_itr->prefiltered) {
-            continue;
-          }
-          // how close is the input to this segment
-          auto point = p_itr->project(u, v);
-          auto sq_distance = p_itr->project.approx.DistanceSquared(point);
-          // do we want to keep it
-          if (sq_distance < c_itr->sq_distance) {
-            c_itr->sq_distance = sq_distance;
-            c_itr->point = std::move(point);
-            c_itr->index = i;
+          if (!c_itr->prefiltered) {
+            p_itr->project.closest(shape, c_itr->point, c_itr->sq_distance, c_itr->index);
           }
         }
       }
+    };
+
+    if (workers == nullptr || bin_edges.size() * count < kMinParallelProjections) {
+      project(0, bin_edges.size(), shapes.front());
+      return;
+    }
+    const uint32_t steps = (bin_edges.size() + kProjectionStepEdges - 1) / kProjectionStepEdges;
+    workers->Run(steps, reader, [&](const uint32_t step, GraphReader&, const size_t thread) {
+      const size_t first = static_cast<size_t>(step) * kProjectionStepEdges;
+      project(first, std::min(first + kProjectionStepEdges, bin_edges.size()), shapes[thread]);
+    });
+  }
+
+  // handle a bin for the range of candidates that share it
+  void handle_bin(std::vector<projector_wrapper>::iterator begin,
+                  std::vector<projector_wrapper>::iterator end) {
+    gather_bin(begin, end);
+    project_bin(begin, end);
+
+    // the reachability checks build on each other so the edges are kept in the order of the bin
+    const size_t count = end - begin;
+    for (size_t i = 0; i < bin_edges.size(); ++i) {
+      auto tile = bin_edges[i].tile;
+      const auto* edge = bin_edges[i].edge;
+      auto edge_id = bin_edges[i].edge_id;
+      const auto& edge_info = bin_edges[i].edge_info;
+      const auto candidates = bin_candidates.begin() + i * count;
 
       // if we already have a better reachable candidate we can just assume this one is reachable
-      auto reach = check_reachability(begin, end, tile, edge, edge_id);
+      auto reach = check_reachability(begin, end, candidates, tile, edge, edge_id);
 
       // keep the best point along this edge if it makes sense
-      c_itr = bin_candidates.begin();
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      auto c_itr = candidates;
+      for (auto p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
         // skip updating this candidate because it was prefiltered
         if (c_itr->prefiltered) {
           continue;
@@ -593,7 +813,8 @@ struct bin_handler_t {
         // it's possible that it isnt reachable but the opposing is, switch to that if so
         if (!reachable && (opp_edgeid = reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile)) &&
             costing->Allowed(opp_edge, opp_tile, kDisallowShortcut)) {
-          auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge, opp_edgeid);
+          auto opp_reach =
+              check_reachability(begin, end, candidates, opp_tile, opp_edge, opp_edgeid);
           if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
               opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
             tile = opp_tile;
@@ -695,7 +916,8 @@ struct bin_handler_t {
   std::unordered_map<Location, PathLocation> finalize() {
     // at this point we have candidates for each location so now we
     // need to go get the actual correlated location with edge_id etc.
-    std::unordered_map<Location, PathLocation> searched;
+    std::vector<PathLocation> correlated;
+    correlated.reserve(pps.size());
     for (auto& pp : pps) {
       // remove non-sensical island candidates
       auto new_end = std::remove_if(pp.unreachable.begin(), pp.unreachable.end(),
@@ -707,85 +929,38 @@ struct bin_handler_t {
       pp.reachable.reserve(pp.reachable.size() + pp.unreachable.size());
       std::move(pp.unreachable.begin(), pp.unreachable.end(), std::back_inserter(pp.reachable));
       std::sort(pp.reachable.begin(), pp.reachable.end());
-      // keep a look up around so we dont add duplicates with worse scores
-      correlated_edges.reserve(pp.reachable.size());
-      correlated_edges.clear();
-      // go through getting all the results for this one
-      PathLocation correlated(pp.location);
-      // TODO: this is already in PathLocation, use it there
-      std::vector<PathLocation::PathEdge> filtered;
+      // the locations of a bin share the edge infos, which decode their shapes when first asked
       for (const auto& candidate : pp.reachable) {
-        // this may be at a node, either because it was the closest thing or from snap tolerance
-        bool front = candidate.point == candidate.edge_info->shape().front() ||
-                     pp.location.latlng_.Distance(candidate.edge_info->shape().front()) <
-                         pp.location.node_snap_tolerance_;
-        bool back = candidate.point == candidate.edge_info->shape().back() ||
-                    pp.location.latlng_.Distance(candidate.edge_info->shape().back()) <
-                        pp.location.node_snap_tolerance_;
-        // it was the begin node
-        if ((front && candidate.edge->forward()) || (back && !candidate.edge->forward())) {
-          graph_tile_ptr other_tile;
-          auto opposing_edge = reader.GetOpposingEdge(candidate.edge_id, other_tile);
-          if (!other_tile) {
-            continue; // TODO: do an edge snap instead, but you'll only get one direction
-          }
-          correlate_node(pp.location, opposing_edge->endnode(), candidate, correlated, filtered);
-        } // it was the end node
-        else if ((back && candidate.edge->forward()) || (front && !candidate.edge->forward())) {
-          correlate_node(pp.location, candidate.edge->endnode(), candidate, correlated, filtered);
-        } // it was along the edge
-        else {
-          correlate_edge(pp.location, candidate, correlated, filtered);
-        }
-      }
-
-      // if it was a through location with a heading its pretty confusing.
-      // does the user want to come into and exit the location at the preferred
-      // angle? for now we are just saying that they want it to exit at the
-      // heading provided. this means that if it was node snapped we only
-      // want the outbound edges
-      if ((pp.location.stoptype_ == Location::StopType::THROUGH ||
-           pp.location.stoptype_ == Location::StopType::BREAK_THROUGH) &&
-          pp.location.heading_) {
-        // partition the ones we want to move to the end
-        auto new_end =
-            std::stable_partition(correlated.edges.begin(), correlated.edges.end(),
-                                  [](const PathLocation::PathEdge& e) { return !e.end_node(); });
-        // move them to the end
-        filtered.insert(filtered.end(), std::make_move_iterator(new_end),
-                        std::make_move_iterator(correlated.edges.end()));
-        // remove them from the original
-        correlated.edges.erase(new_end, correlated.edges.end());
+        candidate.edge_info->shape();
       }
+      correlated.emplace_back(pp.location);
+    }
 
-      // if we have nothing because of filtering (heading/side) we'll just ignore it
-      if (correlated.edges.size() == 0 && filtered.size()) {
-        for (auto&& path_edge : filtered) {
-          if (correlated_edges.insert(path_edge.id).second) {
-            correlated.edges.push_back(std::move(path_edge));
-          }
-        }
-        filtered.clear();
+    // the candidates are only read from here on so the locations can be correlated on several
+    // threads, each with its own reader and its own reaches on top of the ones found searching
+    if (workers != nullptr && pps.size() > 1) {
+      std::vector<std::unique_ptr<correlator_t>> correlators(workers->size());
+      workers->Run(pps.size(), reader,
+                   [&](const uint32_t index, GraphReader& thread_reader, const size_t thread) {
+                     auto& thread_correlator = correlators[thread];
+                     if (!thread_correlator) {
+                       thread_correlator.reset(
+                           new correlator_t(thread_reader, costing, max_reach_limit,
+                                            edge_reach_mode, &correlator.directed_reaches));
+                     }
+                     thread_correlator->correlate(pps[index], correlated[index]);
+                   });
+    } else {
+      for (size_t i = 0; i < pps.size(); ++i) {
+        correlator.correlate(pps[i], correlated[i]);
       }
+    }
 
-      // keep filtered edges for retry in case we cant find a route with non filtered edges
-      // use the max score of the non filtered edges as a penalty increase on each of the
-      // filtered edges so that when finding a route using non filtered edges fails the
-      // use of filtered edges are always penalized higher than the non filtered ones
-      auto max =
-          std::max_element(correlated.edges.begin(), correlated.edges.end(),
-                           [](const PathLocation::PathEdge& a, const PathLocation::PathEdge& b) {
-                             return a.distance < b.distance;
-                           });
-      std::for_each(filtered.begin(), filtered.end(),
-                    [&max](PathLocation::PathEdge& e) { e.distance += (3600.0f + max->distance); });
-      correlated.filtered_edges.insert(correlated.filtered_edges.end(),
-                                       std::make_move_iterator(filtered.begin()),
-                                       std::make_move_iterator(filtered.end()));
-
+    std::unordered_map<Location, PathLocation> searched;
+    for (size_t i = 0; i < pps.size(); ++i) {
       // if we found nothing that is no good but if its batch maybe throwing makes no sense?
-      if (correlated.edges.size() != 0) {
-        searched.insert({pp.location, correlated});
+      if (correlated[i].edges.size() != 0) {
+        searched.insert({pps[i].location, std::move(correlated[i])});
       }
     }
     // give back all the results
@@ -798,10 +973,128 @@ struct bin_handler_t {
 namespace valhalla {
 namespace loki {
 
+SearchWorkers::SearchWorkers(const boost::property_tree::ptree& config,
+                             const uint32_t concurrency) {
+  // the readers of the threads leave prefetching to the reader of the calling thread. they all
+  // read through the process wide sharded cache so the tiles are held once for all of them,
+  // not once per thread on top of the cache of the calling thread
+  auto reader_config = config;
+  reader_config.put("prefetch_threads", 0);
+  if (concurrency > 1 && (!config.get<bool>("use_sharded_mem_cache", false) ||
+                          !config.get<bool>("global_synchronized_cache", false))) {
+    LOG_WARN("The search threads read through a process wide sharded tile cache instead of the "
+             "configured one, set use_sharded_mem_cache and global_synchronized_cache to use it "
+             "for every reader");
+  }
+  reader_config.put("use_sharded_mem_cache", true);
+  reader_config.put("global_synchronized_cache", true);
+  for (uint32_t i = 1; i < concurrency; ++i) {
+    readers_.emplace_back(new GraphReader(reader_config));
+  }
+  for (uint32_t i = 1; i < concurrency; ++i) {
+    threads_.emplace_back(&SearchWorkers::Loop, this, i);
+  }
+}
+
+SearchWorkers::~SearchWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  ready_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void SearchWorkers::Run(const uint32_t count, GraphReader& reader, const step_t& step) {
+  // the threads read the live traffic of the generation the request has pinned
+  const uint32_t generation = reader.PinTrafficSnapshot();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& thread_reader : readers_) {
+      thread_reader->PinTrafficSnapshot(generation);
+    }
+    step_ = &step;
+    reader_ = &reader;
+    count_ = count;
+    next_ = 0;
+    running_ = threads_.size();
+    error_ = nullptr;
+    ++pass_;
+  }
+  ready_.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return running_ == 0; });
+  step_ = nullptr;
+  reader_ = nullptr;
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void SearchWorkers::SetInterrupt(const tile_getter_t::interrupt_t* interrupt) {
+  for (auto& reader : readers_) {
+    reader->SetInterrupt(interrupt);
+  }
+}
+
+void SearchWorkers::Cleanup() {
+  for (auto& reader : readers_) {
+    reader->UnpinTrafficSnapshot();
+    if (reader->OverCommitted()) {
+      reader->Trim();
+    }
+  }
+}
+
+void SearchWorkers::Loop(const size_t id) {
+  uint64_t pass = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this, pass]() { return shutdown_ || pass_ != pass; });
+      if (shutdown_) {
+        return;
+      }
+      pass = pass_;
+    }
+
+    Work(id);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --running_;
+    }
+    done_.notify_one();
+  }
+}
+
+void SearchWorkers::Work(const size_t id) {
+  auto& reader = id == 0 ? *reader_ : *readers_[id - 1];
+  try {
+    for (uint32_t i = next_++; i < count_; i = next_++) {
+      (*step_)(i, reader, id);
+    }
+  } catch (...) {
+    // stop handing out steps and keep the first failure
+    next_ = count_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_) {
+      error_ = std::current_exception();
+    }
+  }
+}
+
 std::unordered_map<valhalla::baldr::Location, PathLocation>
 Search(const std::vector<valhalla::baldr::Location>& locations,
        GraphReader& reader,
-       const std::shared_ptr<DynamicCost>& costing) {
+       const std::shared_ptr<DynamicCost>& costing,
+       const bool use_edge_reach,
+       SearchWorkers* workers) {
   // we cannot continue without costing
   if (!costing)
     throw std::runtime_error("No costing was provided for edge candidate search");
@@ -811,7 +1104,7 @@ Search(const std::vector<valhalla::baldr::Location>& locations,
     return std::unordered_map<valhalla::baldr::Location, PathLocation>{};
 
   // setup the unique list of locations
-  bin_handler_t handler(locations, reader, costing);
+  bin_handler_t handler(locations, reader, costing, use_edge_reach, workers);
   // search over the bins doing multiple locations per bin
   handler.search();
   // turn each locations candidate set into path locations
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
 #include <functional>
@@ -7,6 +8,7 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "baldr/edgereach.h"
 #include "baldr/json.h"
 #include "baldr/rapidjson_utils.h"
 #include "midgard/logging.h"
@@ -64,6 +66,13 @@ void loki_worker_t::parse_locations(google::protobuf::RepeatedPtrField<valhalla:
   }
 }
 
+// correlate the locations to the graph, timing it as the search phase of the request
+std::unordered_map<baldr::Location, baldr::PathLocation>
+loki_worker_t::search(Api& request, const std::vector<baldr::Location>& locations) {
+  auto _ = measure_scope_time(request, "search");
+  return loki::Search(locations, *reader, costing, edge_reach_usable, search_workers.get());
+}
+
 void loki_worker_t::parse_costing(Api& api, bool allow_none) {
   auto& options = *api.mutable_options();
   // using the costing we can determine what type of edge filtering to use
@@ -142,6 +151,14 @@ void loki_worker_t::parse_costing(Api& api, bool allow_none) {
     }
   }
 
+  // Avoids, non default options and live traffic closures can change the reach of the edges. It
+  // is only stored for the default options of a few costings, see mjolnir::ReachBuilder
+  auto parsed = options.costings().find(options.costing_type());
+  edge_reach_usable = use_edge_reach && !reader->HasLiveTraffic() &&
+                      std::find(kReachCostings.cbegin(), kReachCostings.cend(),
+                                options.costing_type()) != kReachCostings.cend() &&
+                      parsed != options.costings().cend() && sif::IsDefaultCosting(parsed->second);
+
   // If more alternates are requested than we support we cap it
   if (options.action() != Options::trace_attributes && options.alternates() > max_alternates)
     options.set_alternates(max_alternates);
@@ -228,6 +245,8 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
   max_exclude_polygons_length = config.get<float>("service_limits.max_exclude_polygons_length");
   max_reachability = config.get<unsigned int>("service_limits.max_reachability");
   default_reachability = config.get<unsigned int>("loki.service_defaults.minimum_reachability");
+  use_edge_reach = config.get<bool>("loki.use_edge_reach", true);
+  edge_reach_usable = false;
   max_radius = config.get<unsigned int>("service_limits.max_radius");
   default_radius = config.get<unsigned int>("loki.service_defaults.radius");
   default_heading_tolerance = config.get<unsigned int>("loki.service_defaults.heading_tolerance");
@@ -245,6 +264,10 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
   max_alternates = config.get<unsigned int>("service_limits.max_alternates");
   allow_verbose = config.get<bool>("service_limits.status.allow_verbose", false);
   max_timedep_dist_matrix = config.get<size_t>("service_limits.max_timedep_distance_matrix", 0);
+  const auto search_concurrency = std::max(config.get<uint32_t>("loki.search_concurrency", 1), 1u);
+  if (search_concurrency > 1) {
+    search_workers.reset(new SearchWorkers(config.get_child("mjolnir"), search_concurrency));
+  }
 
   // signal that the worker started successfully
   started();
@@ -252,14 +275,22 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
 
 void loki_worker_t::cleanup() {
   service_worker_t::cleanup();
+  // the next request reads the live traffic which is current then
+  reader->UnpinTrafficSnapshot();
   if (reader->OverCommitted()) {
     reader->Trim();
   }
+  if (search_workers) {
+    search_workers->Cleanup();
+  }
 }
 
 void loki_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
   interrupt = interrupt_function;
   reader->SetInterrupt(interrupt);
+  if (search_workers) {
+    search_workers->SetInterrupt(interrupt);
+  }
 }
 
 #ifdef HAVE_HTTP
@@ -37,6 +37,7 @@ void Config::Read(const boost::property_tree::ptree& params) {
   transition_cost.Read(params);
   emission_cost.Read(params);
   routing.Read(params);
+  streaming.Read(params);
 }
 
 void Config::CandidateSearch::Read(const boost::property_tree::ptree& params) {
@@ -108,5 +109,12 @@ void Config::Routing::Read(const boost::property_tree::ptree& params) {
   }
 }
 
+void Config::Streaming::Read(const boost::property_tree::ptree& params) {
+  ReadParamOptional(window, params, "default.streaming_window");
+  // a window of a single measurement could never move past the state it starts from
+  CHECK_THROWS(window != 1,
+               std::string("Expect 'streaming_window' to be 0 or more than 1 (got: 1)"));
+}
+
 } // namespace meili
 } // namespace valhalla
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "worker.h"
 
 #include <array>
+#include <memory>
 
 namespace {
 
@@ -456,6 +457,44 @@ std::vector<MatchResult> FindMatchResults(const MapMatcher& mapmatcher,
   return results;
 }
 
+// Put the results of the measurements which were interpolated right after the result of the state
+// they were interpolated from, so that the results are in the order of the measurements. The
+// offsets, if wanted, receive the index in the best path of the result of every state
+void InsertInterpolatedResults(
+    const MapMatcher& mapmatcher,
+    const std::vector<StateId>& stateids,
+    const std::vector<MatchResult>& results,
+    const std::unordered_map<StateId::Time, std::vector<Measurement>>& interpolated,
+    std::vector<MatchResult>& best_path,
+    std::vector<size_t>* offsets = nullptr) {
+  for (StateId::Time time = 0; time < stateids.size(); time++) {
+    // Add in this states result
+    if (offsets) {
+      offsets->push_back(best_path.size());
+    }
+    best_path.emplace_back(results[time]);
+
+    // See if there were any interpolated points with this state move on if not
+    const auto it = interpolated.find(time);
+    if (it == interpolated.end()) {
+      continue;
+    }
+
+    // Interpolate the points between this and the next state
+    const auto& this_stateid = stateids[time];
+    const auto& next_stateid = time + 1 < stateids.size() ? stateids[time + 1] : StateId();
+
+    const auto& first_result = results[time];
+    const auto& last_result = results[time + 1];
+    const auto interpolated_results =
+        InterpolateMeasurements(mapmatcher, it->second, this_stateid, next_stateid, first_result,
+                                last_result);
+
+    // Copy the interpolated match results into the final set
+    best_path.insert(best_path.cend(), interpolated_results.cbegin(), interpolated_results.cend());
+  }
+}
+
 struct path_t {
   path_t(const std::vector<EdgeSegment>& segments) {
     edges.reserve(segments.size());
@@ -717,31 +756,7 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   state_ids.reserve(container_.size());
   while (best_paths.size() < k && !found_discontinuity) {
     // Get the states for the kth best path in reversed order then fix the order
-    state_ids.clear();
-    double accumulated_cost = 0.f;
-    while (state_ids.size() < container_.size()) {
-      // Get the time at the last column of states
-      const auto time = container_.size() - state_ids.size() - 1;
-      // Find the most probable path
-      std::copy(vs_.SearchPathVS(time, false), vs_.PathEnd(), std::back_inserter(state_ids));
-      // See what the last state was that we reached
-      const auto& winner = vs_.SearchWinner(time);
-      // If we got all the way to the end there were no discontinuities and the cost is a normal value
-      if (winner.IsValid()) {
-        accumulated_cost += vs_.AccumulatedCost(winner);
-      } // We got a discontinuity before reaching the last state
-      else {
-        // TODO need a sane constant cost for invalid state
-        accumulated_cost += MAX_ACCUMULATED_COST;
-        found_discontinuity = true;
-      }
-
-      // if we need to match more we add a penalty for connecting over the discontinuity
-      if (state_ids.size() < container_.size()) {
-        found_discontinuity = true;
-        accumulated_cost += MAX_ACCUMULATED_COST;
-      }
-    }
+    const auto accumulated_cost = SearchPath(state_ids, found_discontinuity);
 
     // we dont return additional paths (alternatives) if the have discontinuities
     if (!best_paths.empty() && found_discontinuity) {
@@ -761,30 +776,7 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     // Insert the interpolated results into the result list
     std::vector<MatchResult> best_path;
     best_path.reserve(measurements.size());
-    for (StateId::Time time = 0; time < original_state_ids.size(); time++) {
-      // Add in this states result
-      best_path.emplace_back(results[time]);
-
-      // See if there were any interpolated points with this state move on if not
-      const auto it = interpolated.find(time);
-      if (it == interpolated.end()) {
-        continue;
-      }
-
-      // Interpolate the points between this and the next state
-      const auto& this_stateid = original_state_ids[time];
-      const auto& next_stateid =
-          time + 1 < original_state_ids.size() ? original_state_ids[time + 1] : StateId();
-
-      const auto& first_result = results[time];
-      const auto& last_result = results[time + 1];
-      const auto interpolated_results =
-          InterpolateMeasurements(*this, it->second, this_stateid, next_stateid, first_result,
-                                  last_result);
-
-      // Copy the interpolated match results into the final set
-      best_path.insert(best_path.cend(), interpolated_results.cbegin(), interpolated_results.cend());
-    }
+    InsertInterpolatedResults(*this, original_state_ids, results, interpolated, best_path);
 
     // Construct a result
     auto segments = ConstructRoute(*this, best_path);
@@ -820,8 +812,112 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   return best_paths;
 }
 
+MatchResults MapMatcher::StreamingMatch(const std::vector<Measurement>& measurements,
+                                        const commit_callback_t& commit) {
+  const size_t window = config_.streaming.window;
+  if (window < 2) {
+    throw std::invalid_argument("expect a streaming window of more than 1 measurement but got " +
+                                std::to_string(window));
+  }
+
+  std::vector<MatchResult> trace_results;
+  trace_results.reserve(measurements.size());
+  std::vector<EdgeSegment> trace_segments;
+  double score = 0.f;
+  bool found_candidates = false;
+
+  // The candidate of the state the last window was committed at, the next window starts from it
+  std::unique_ptr<baldr::PathLocation> pinned;
+  for (size_t begin = 0; begin < measurements.size();) {
+    // Forget the states of the last window
+    Clear();
+    const auto end = std::min(measurements.size(), begin + window);
+    const std::vector<Measurement> window_measurements(measurements.cbegin() + begin,
+                                                       measurements.cbegin() + end);
+    const auto interpolated = AppendMeasurements(window_measurements, pinned.get());
+    found_candidates = found_candidates || container_.HasMinimumCandidates();
+    const bool started_pinned = pinned != nullptr;
+    pinned.reset();
+
+    // Match the window as a whole
+    std::vector<StateId> state_ids;
+    bool found_discontinuity = false;
+    double window_cost = SearchPath(state_ids, found_discontinuity);
+    const std::vector<StateId> original_state_ids(state_ids.rbegin(), state_ids.rend());
+    const auto results = FindMatchResults(*this, original_state_ids, graphreader_);
+    std::vector<MatchResult> window_results;
+    window_results.reserve(window_measurements.size());
+    std::vector<size_t> offsets;
+    InsertInterpolatedResults(*this, original_state_ids, results, interpolated, window_results,
+                              &offsets);
+
+    // Unless this is the end of the trace only the part of the window which is decided is kept
+    size_t next = end;
+    if (end < measurements.size()) {
+      bool after_break = false;
+      auto time = FindDecidedTime(after_break);
+      if (!after_break && time == 0) {
+        time = std::max<StateId::Time>(1, (container_.size() - 1) / 2);
+      }
+      // The next window starts from the decided state or, if there is none, after the last result
+      const auto& stateid = original_state_ids[time];
+      if (!after_break && stateid.IsValid()) {
+        pinned.reset(new baldr::PathLocation(container_.state(stateid).candidate()));
+        window_results.resize(offsets[time] + 1);
+        window_cost = vs_.AccumulatedCost(stateid);
+      } else {
+        window_results.resize(offsets[time]);
+        window_cost = MAX_ACCUMULATED_COST;
+      }
+      next = begin + offsets[time];
+    }
+    score += window_cost;
+
+    // The route of the window has to be found while we still have its states
+    auto segments = ConstructRoute(*this, window_results);
+    for (auto& segment : segments) {
+      segment.first_match_idx += segment.first_match_idx >= 0 ? begin : 0;
+      segment.last_match_idx += segment.last_match_idx >= 0 ? begin : 0;
+    }
+    // If the window started from the state the last one ended at, its first result is already
+    // committed and its first segment may continue the last committed one
+    if (started_pinned && !segments.empty() && !trace_segments.empty() &&
+        !trace_segments.back().discontinuity && !trace_results.back().is_break_point &&
+        trace_segments.back().edgeid == segments.front().edgeid) {
+      segments.front().source = trace_segments.back().source;
+      if (trace_segments.back().first_match_idx != -1)
+        segments.front().first_match_idx = trace_segments.back().first_match_idx;
+      if (segments.front().last_match_idx == -1)
+        segments.front().last_match_idx = trace_segments.back().last_match_idx;
+      trace_segments.pop_back();
+    }
+    trace_segments.insert(trace_segments.end(), segments.cbegin(), segments.cend());
+
+    // A window which does not start from the last state of this one cannot continue its route
+    if (!pinned && next < measurements.size() && !trace_segments.empty()) {
+      trace_segments.back().discontinuity = true;
+    }
+
+    const auto committed = trace_results.size();
+    trace_results.insert(trace_results.end(), window_results.cbegin() + (started_pinned ? 1 : 0),
+                         window_results.cend());
+    if (commit) {
+      commit(trace_results.cbegin() + committed, trace_results.cend());
+    }
+    begin = next;
+  }
+
+  // Without minimum number of edge candidates, throw a 443 - NoSegment error code.
+  if (!found_candidates) {
+    throw valhalla_exception_t{443};
+  }
+
+  return MatchResults(std::move(trace_results), std::move(trace_segments), score);
+}
+
 std::unordered_map<StateId::Time, std::vector<Measurement>>
-MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
+MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements,
+                               const baldr::PathLocation* first_candidate) {
   const float sq_max_search_radius = config_.candidate_search.max_search_radius_meters *
                                      config_.candidate_search.max_search_radius_meters;
   const float sq_interpolation_distance =
@@ -830,7 +926,7 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
 
   // Always match the first measurement
   auto last = measurements.cbegin();
-  auto time = AppendMeasurement(*last, sq_max_search_radius);
+  auto time = AppendMeasurement(*last, sq_max_search_radius, first_candidate);
   double interpolated_epoch_time = -1;
   for (auto m = std::next(last); m != measurements.end(); ++m) {
     const auto sq_distance = GreatCircleDistanceSquared(*last, *m);
@@ -867,7 +963,8 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
 }
 
 StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
-                                            const float sq_max_search_radius) {
+                                            const float sq_max_search_radius,
+                                            const baldr::PathLocation* candidate) {
   // Test interrupt
   if (interrupt_) {
     (*interrupt_)();
@@ -876,8 +973,11 @@ StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
   auto sq_radius = std::min(sq_max_search_radius,
                             std::max(measurement.sq_search_radius(), measurement.sq_gps_accuracy()));
 
+  // A measurement whose state was already decided keeps only the candidate of that state
   const auto& candidates =
-      candidatequery_.Query(measurement.lnglat(), measurement.stop_type(), sq_radius, costing());
+      candidate ? std::vector<baldr::PathLocation>{*candidate}
+                : candidatequery_.Query(measurement.lnglat(), measurement.stop_type(), sq_radius,
+                                        costing());
 
   const auto time = container_.AppendMeasurement(measurement);
 
@@ -889,5 +989,87 @@ StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
   return time;
 }
 
+// Collect the states of the most probable path in reverse order and return its cost, where
+// there are discontinuities the path goes on from the winner before them
+double MapMatcher::SearchPath(std::vector<StateId>& state_ids, bool& found_discontinuity) {
+  state_ids.clear();
+  double accumulated_cost = 0.f;
+  while (state_ids.size() < container_.size()) {
+    // Get the time at the last column of states
+    const auto time = container_.size() - state_ids.size() - 1;
+    // Find the most probable path
+    std::copy(vs_.SearchPathVS(time, false), vs_.PathEnd(), std::back_inserter(state_ids));
+    // See what the last state was that we reached
+    const auto& winner = vs_.SearchWinner(time);
+    // If we got all the way to the end there were no discontinuities and the cost is a normal value
+    if (winner.IsValid()) {
+      accumulated_cost += vs_.AccumulatedCost(winner);
+    } // We got a discontinuity before reaching the last state
+    else {
+      // TODO need a sane constant cost for invalid state
+      accumulated_cost += MAX_ACCUMULATED_COST;
+      found_discontinuity = true;
+    }
+
+    // if we need to match more we add a penalty for connecting over the discontinuity
+    if (state_ids.size() < container_.size()) {
+      found_discontinuity = true;
+      accumulated_cost += MAX_ACCUMULATED_COST;
+    }
+  }
+  return accumulated_cost;
+}
+
+// Find the latest time before the last one at which the best paths to all the states of the last
+// time go through the same state, nothing up to there can change whatever measurements come next.
+// If instead all of them start after a discontinuity the time they start at is returned and
+// nothing before it can change either. Returns 0 if neither happened
+StateId::Time MapMatcher::FindDecidedTime(bool& after_break) {
+  // Every state we can reach needs its best predecessor, not only the ones the winner needed
+  vs_.SearchReachable();
+
+  const auto last_time = container_.size() - 1;
+  std::unordered_set<StateId> heads;
+  for (const auto& state : container_.column(last_time)) {
+    if (vs_.AccumulatedCost(state.stateid()) >= 0) {
+      heads.emplace(state.stateid());
+    }
+  }
+
+  // No path reaches the last time so there is nothing the next measurements could continue
+  after_break = heads.empty();
+  if (after_break) {
+    return last_time;
+  }
+
+  // Walk back all the paths at once until they meet
+  std::unordered_set<StateId> predecessors;
+  for (auto time = last_time; time > 0; --time) {
+    if (heads.size() == 1 && time < last_time) {
+      return time;
+    }
+
+    predecessors.clear();
+    bool found_start = false;
+    for (const auto& head : heads) {
+      const auto predecessor = vs_.Predecessor(head);
+      if (predecessor.IsValid()) {
+        predecessors.emplace(predecessor);
+      } else {
+        found_start = true;
+      }
+    }
+
+    // If only some of the paths start here it is still open which of them wins
+    if (found_start) {
+      after_break = predecessors.empty();
+      return after_break ? time : 0;
+    }
+    heads.swap(predecessors);
+  }
+
+  return 0;
+}
+
 } // namespace meili
 } // namespace valhalla
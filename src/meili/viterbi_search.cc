@@ -554,26 +554,7 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
     }
 
     // Mark it as scanned and remember its cost and predecessor
-    const auto& inserted = scanned_labels_.emplace(stateid, label);
-    if (!inserted.second) {
-      throw std::logic_error("the principle of optimality is violated in the viterbi search,"
-                             " probably negative costs occurred");
-    }
-
-    // Remove it from its column
-    auto& column = unreached_states_by_time[stateid.time()];
-    const auto it = std::find(column.begin(), column.end(), stateid);
-    if (it == column.end()) {
-      throw std::logic_error("the state must exist in the column");
-    }
-    column.erase(it);
-
-    // Since current column is empty now, earlier labels can't reach
-    // future winners in a optimal way any more, so we mark time + 1
-    // as the earliest time to skip all earlier labels
-    if (column.empty()) {
-      earliest_time_ = stateid.time() + 1;
-    }
+    Scan(label);
 
     // If it's the first state that arrives at this column, mark it as
     // the winner at this time
@@ -613,6 +594,53 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
   return searched_time;
 }
 
+void ViterbiSearch::Scan(const StateLabel& label) {
+  const auto& stateid = label.stateid();
+  const auto& inserted = scanned_labels_.emplace(stateid, label);
+  if (!inserted.second) {
+    throw std::logic_error("the principle of optimality is violated in the viterbi search,"
+                           " probably negative costs occurred");
+  }
+
+  // Remove it from its column
+  auto& column = unreached_states_by_time[stateid.time()];
+  const auto it = std::find(column.begin(), column.end(), stateid);
+  if (it == column.end()) {
+    throw std::logic_error("the state must exist in the column");
+  }
+  column.erase(it);
+
+  // Since current column is empty now, earlier labels can't reach
+  // future winners in a optimal way any more, so we mark time + 1
+  // as the earliest time to skip all earlier labels
+  if (column.empty()) {
+    earliest_time_ = stateid.time() + 1;
+  }
+}
+
+void ViterbiSearch::SearchReachable() {
+  if (unreached_states_by_time.empty()) {
+    return;
+  }
+
+  // The search stops at the first state of the last time, the states it left in the queue are
+  // scanned the same way but none of them is a winner any more
+  const StateId::Time last_time = unreached_states_by_time.size() - 1;
+  SearchWinner(last_time);
+  while (!queue_.empty()) {
+    const auto label = queue_.top();
+    queue_.pop();
+    if (label.stateid().time() < earliest_time_) {
+      continue;
+    }
+
+    Scan(label);
+    if (label.stateid().time() < last_time) {
+      AddSuccessorsToQueue(label.stateid());
+    }
+  }
+}
+
 constexpr bool ViterbiSearch::IsInvalidCost(double cost) {
   return cost < 0.f;
 }
@@ -0,0 +1,63 @@
+#include "midgard/gridded_data.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace valhalla {
+namespace midgard {
+
+size_t crossed_cells(const float* bottom,
+                     const float* top,
+                     const size_t count,
+                     const float value,
+                     uint32_t* cells) {
+  size_t crossed = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256 v = _mm256_set1_ps(value);
+  for (; i + 8 <= count; i += 8) {
+    const __m256 b0 = _mm256_loadu_ps(bottom + i);
+    const __m256 b1 = _mm256_loadu_ps(bottom + i + 1);
+    const __m256 t0 = _mm256_loadu_ps(top + i);
+    const __m256 t1 = _mm256_loadu_ps(top + i + 1);
+    const __m256 lo = _mm256_min_ps(_mm256_min_ps(b0, b1), _mm256_min_ps(t0, t1));
+    const __m256 hi = _mm256_max_ps(_mm256_max_ps(b0, b1), _mm256_max_ps(t0, t1));
+    const int mask = _mm256_movemask_ps(
+        _mm256_and_ps(_mm256_cmp_ps(lo, v, _CMP_LE_OQ), _mm256_cmp_ps(hi, v, _CMP_GE_OQ)));
+    // write every lane and only advance past the crossed ones
+    for (int lane = 0; lane < 8; ++lane) {
+      cells[crossed] = static_cast<uint32_t>(i + lane);
+      crossed += (mask >> lane) & 1;
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128 v = _mm_set1_ps(value);
+  for (; i + 4 <= count; i += 4) {
+    const __m128 b0 = _mm_loadu_ps(bottom + i);
+    const __m128 b1 = _mm_loadu_ps(bottom + i + 1);
+    const __m128 t0 = _mm_loadu_ps(top + i);
+    const __m128 t1 = _mm_loadu_ps(top + i + 1);
+    const __m128 lo = _mm_min_ps(_mm_min_ps(b0, b1), _mm_min_ps(t0, t1));
+    const __m128 hi = _mm_max_ps(_mm_max_ps(b0, b1), _mm_max_ps(t0, t1));
+    const int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(lo, v), _mm_cmpge_ps(hi, v)));
+    // write every lane and only advance past the crossed ones
+    for (int lane = 0; lane < 4; ++lane) {
+      cells[crossed] = static_cast<uint32_t>(i + lane);
+      crossed += (mask >> lane) & 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    const float lo = std::min(std::min(bottom[i], bottom[i + 1]), std::min(top[i], top[i + 1]));
+    const float hi = std::max(std::max(bottom[i], bottom[i + 1]), std::max(top[i], top[i + 1]));
+    cells[crossed] = static_cast<uint32_t>(i);
+    crossed += lo <= value && value <= hi;
+  }
+  return crossed;
+}
+
+} // namespace midgard
+} // namespace valhalla
@@ -23,6 +23,12 @@
 #include <boost/archive/iterators/remove_whitespace.hpp>
 #include <boost/archive/iterators/transform_width.hpp>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace {
 
 std::vector<valhalla::midgard::PointLL>
@@ -47,6 +53,20 @@ resample_at_1hz(const std::vector<valhalla::midgard::gps_segment_t>& segments) {
   return resampled;
 }
 
+#if defined(__AVX2__)
+// The lng and lat of a followed by those of b
+inline __m256d load_points(const valhalla::midgard::PointLL& a,
+                           const valhalla::midgard::PointLL& b) {
+  return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(&a.first)),
+                              _mm_loadu_pd(&b.first), 1);
+}
+#elif defined(__SSE2__)
+// The lanes of b where the mask is set and the lanes of a elsewhere
+inline __m128d select(const __m128d a, const __m128d b, const __m128d mask) {
+  return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+#endif
+
 } // namespace
 
 namespace valhalla {
@@ -731,6 +751,172 @@ polygon_t to_boundary(const std::unordered_set<uint32_t>& region, const Tiles<Po
   return polygon;
 }
 
+bool projector_t::closest(const std::vector<PointLL>& shape,
+                          PointLL& point,
+                          double& sq_distance,
+                          size_t& index) const {
+  const size_t segments = shape.size() < 2 ? 0 : shape.size() - 1;
+  const double m_per_lng_degree = approx.GetLngScale() * kMetersPerDegreeLat;
+  bool found = false;
+  size_t i = 0;
+
+  // The arithmetic is done in the same order as in operator() and DistanceSquared. A zero
+  // length segment needs no test of its own since its scale is 0 so u is taken. Every lane keeps
+  // the first of its closest projections and the lanes are reduced to the first one overall
+#if defined(__AVX2__)
+  if (segments >= 4) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d lon_scale4 = _mm256_set1_pd(lon_scale);
+    const __m256d lng4 = _mm256_set1_pd(lng);
+    const __m256d lat4 = _mm256_set1_pd(lat);
+    const __m256d lat_meters = _mm256_set1_pd(kMetersPerDegreeLat);
+    const __m256d lng_meters = _mm256_set1_pd(m_per_lng_degree);
+    __m256d best = _mm256_set1_pd(sq_distance);
+    __m256d best_x = zero, best_y = zero;
+    __m256d best_index = _mm256_set1_pd(-1.0);
+    // unpacking the points puts the segments i, i + 2, i + 1 and i + 3 into the lanes
+    __m256d lane_index = _mm256_setr_pd(0.0, 2.0, 1.0, 3.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    for (; i + 4 <= segments; i += 4, lane_index = _mm256_add_pd(lane_index, four)) {
+      const __m256d u01 = load_points(shape[i], shape[i + 1]);
+      const __m256d u23 = load_points(shape[i + 2], shape[i + 3]);
+      const __m256d v01 = load_points(shape[i + 1], shape[i + 2]);
+      const __m256d v23 = load_points(shape[i + 3], shape[i + 4]);
+      const __m256d ux = _mm256_unpacklo_pd(u01, u23);
+      const __m256d uy = _mm256_unpackhi_pd(u01, u23);
+      const __m256d vx = _mm256_unpacklo_pd(v01, v23);
+      const __m256d vy = _mm256_unpackhi_pd(v01, v23);
+
+      const __m256d bx = _mm256_sub_pd(vx, ux);
+      const __m256d by = _mm256_sub_pd(vy, uy);
+      const __m256d bx2 = _mm256_mul_pd(bx, lon_scale4);
+      const __m256d sq = _mm256_add_pd(_mm256_mul_pd(bx2, bx2), _mm256_mul_pd(by, by));
+      const __m256d scale =
+          _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(lng4, ux), lon_scale4), bx2),
+                        _mm256_mul_pd(_mm256_sub_pd(lat4, uy), by));
+      const __m256d ratio = _mm256_div_pd(scale, sq);
+      __m256d x = _mm256_add_pd(ux, _mm256_mul_pd(bx, ratio));
+      __m256d y = _mm256_add_pd(uy, _mm256_mul_pd(by, ratio));
+      const __m256d after = _mm256_cmp_pd(scale, sq, _CMP_GE_OQ);
+      x = _mm256_blendv_pd(x, vx, after);
+      y = _mm256_blendv_pd(y, vy, after);
+      const __m256d before = _mm256_cmp_pd(scale, zero, _CMP_LE_OQ);
+      x = _mm256_blendv_pd(x, ux, before);
+      y = _mm256_blendv_pd(y, uy, before);
+
+      const __m256d dy = _mm256_mul_pd(_mm256_sub_pd(y, lat4), lat_meters);
+      const __m256d dx = _mm256_mul_pd(_mm256_sub_pd(x, lng4), lng_meters);
+      const __m256d d = _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dx, dx));
+      const __m256d closer = _mm256_cmp_pd(d, best, _CMP_LT_OQ);
+      best = _mm256_blendv_pd(best, d, closer);
+      best_x = _mm256_blendv_pd(best_x, x, closer);
+      best_y = _mm256_blendv_pd(best_y, y, closer);
+      best_index = _mm256_blendv_pd(best_index, lane_index, closer);
+    }
+
+    double lane_best[4], lane_x[4], lane_y[4], lane_best_index[4];
+    _mm256_storeu_pd(lane_best, best);
+    _mm256_storeu_pd(lane_x, best_x);
+    _mm256_storeu_pd(lane_y, best_y);
+    _mm256_storeu_pd(lane_best_index, best_index);
+    for (int lane = 0; lane < 4; ++lane) {
+      if (lane_best_index[lane] < 0.0) {
+        continue;
+      }
+      const auto lane_segment = static_cast<size_t>(lane_best_index[lane]);
+      if (!found || lane_best[lane] < sq_distance ||
+          (lane_best[lane] == sq_distance && lane_segment < index)) {
+        sq_distance = lane_best[lane];
+        point = PointLL(lane_x[lane], lane_y[lane]);
+        index = lane_segment;
+        found = true;
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  if (segments >= 2) {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d lon_scale2 = _mm_set1_pd(lon_scale);
+    const __m128d lng2 = _mm_set1_pd(lng);
+    const __m128d lat2 = _mm_set1_pd(lat);
+    const __m128d lat_meters = _mm_set1_pd(kMetersPerDegreeLat);
+    const __m128d lng_meters = _mm_set1_pd(m_per_lng_degree);
+    __m128d best = _mm_set1_pd(sq_distance);
+    __m128d best_x = zero, best_y = zero;
+    __m128d best_index = _mm_set1_pd(-1.0);
+    __m128d lane_index = _mm_setr_pd(0.0, 1.0);
+    const __m128d two = _mm_set1_pd(2.0);
+    for (; i + 2 <= segments; i += 2, lane_index = _mm_add_pd(lane_index, two)) {
+      const __m128d u0 = _mm_loadu_pd(&shape[i].first);
+      const __m128d u1 = _mm_loadu_pd(&shape[i + 1].first);
+      const __m128d v1 = _mm_loadu_pd(&shape[i + 2].first);
+      const __m128d ux = _mm_unpacklo_pd(u0, u1);
+      const __m128d uy = _mm_unpackhi_pd(u0, u1);
+      const __m128d vx = _mm_unpacklo_pd(u1, v1);
+      const __m128d vy = _mm_unpackhi_pd(u1, v1);
+
+      const __m128d bx = _mm_sub_pd(vx, ux);
+      const __m128d by = _mm_sub_pd(vy, uy);
+      const __m128d bx2 = _mm_mul_pd(bx, lon_scale2);
+      const __m128d sq = _mm_add_pd(_mm_mul_pd(bx2, bx2), _mm_mul_pd(by, by));
+      const __m128d scale =
+          _mm_add_pd(_mm_mul_pd(_mm_mul_pd(_mm_sub_pd(lng2, ux), lon_scale2), bx2),
+                     _mm_mul_pd(_mm_sub_pd(lat2, uy), by));
+      const __m128d ratio = _mm_div_pd(scale, sq);
+      __m128d x = _mm_add_pd(ux, _mm_mul_pd(bx, ratio));
+      __m128d y = _mm_add_pd(uy, _mm_mul_pd(by, ratio));
+      const __m128d after = _mm_cmpge_pd(scale, sq);
+      x = select(x, vx, after);
+      y = select(y, vy, after);
+      const __m128d before = _mm_cmple_pd(scale, zero);
+      x = select(x, ux, before);
+      y = select(y, uy, before);
+
+      const __m128d dy = _mm_mul_pd(_mm_sub_pd(y, lat2), lat_meters);
+      const __m128d dx = _mm_mul_pd(_mm_sub_pd(x, lng2), lng_meters);
+      const __m128d d = _mm_add_pd(_mm_mul_pd(dy, dy), _mm_mul_pd(dx, dx));
+      const __m128d closer = _mm_cmplt_pd(d, best);
+      best = select(best, d, closer);
+      best_x = select(best_x, x, closer);
+      best_y = select(best_y, y, closer);
+      best_index = select(best_index, lane_index, closer);
+    }
+
+    double lane_best[2], lane_x[2], lane_y[2], lane_best_index[2];
+    _mm_storeu_pd(lane_best, best);
+    _mm_storeu_pd(lane_x, best_x);
+    _mm_storeu_pd(lane_y, best_y);
+    _mm_storeu_pd(lane_best_index, best_index);
+    for (int lane = 0; lane < 2; ++lane) {
+      if (lane_best_index[lane] < 0.0) {
+        continue;
+      }
+      const auto lane_segment = static_cast<size_t>(lane_best_index[lane]);
+      if (!found || lane_best[lane] < sq_distance ||
+          (lane_best[lane] == sq_distance && lane_segment < index)) {
+        sq_distance = lane_best[lane];
+        point = PointLL(lane_x[lane], lane_y[lane]);
+        index = lane_segment;
+        found = true;
+      }
+    }
+  }
+#endif
+
+  // the segments left over
+  for (; i < segments; ++i) {
+    auto projection = (*this)(shape[i], shape[i + 1]);
+    auto distance = approx.DistanceSquared(projection);
+    if (distance < sq_distance) {
+      sq_distance = distance;
+      point = projection;
+      index = i;
+      found = true;
+    }
+  }
+  return found;
+}
+
 constexpr char PADDING_ENCODED = '=';
 constexpr char ZERO_ENCODED = 'A';
 
@@ -3,12 +3,12 @@
 #include "baldr/graphid.h"
 #include "midgard/pointll.h"
 #include "mjolnir/graphtilebuilder.h"
+#include "mjolnir/taskpool.h"
 
 #include <algorithm>
 #include <limits>
 #include <list>
 #include <mutex>
-#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -340,13 +340,15 @@ void add_bss_nodes_and_edges(GraphTileBuilder& tilebuilder_local,
 
 void project_and_add_bss_nodes(const boost::property_tree::ptree& pt,
                                std::mutex& lock,
-                               bss_by_tile_t::const_iterator tile_start,
-                               bss_by_tile_t::const_iterator tile_end,
+                               const std::vector<bss_by_tile_t::const_iterator>& tiles,
                                const OSMData& osm_data,
-                               std::vector<BSSConnection>& all) {
+                               std::vector<BSSConnection>& all,
+                               TaskPool::Worker& worker) {
 
   GraphReader reader_local_level(pt);
-  for (; tile_start != tile_end; ++tile_start) {
+  size_t task;
+  while (worker.next(task)) {
+    auto tile_start = tiles[task];
 
     graph_tile_ptr local_tile = nullptr;
     std::unique_ptr<GraphTileBuilder> tilebuilder_local = nullptr;
@@ -491,11 +493,13 @@ void create_edges(GraphTileBuilder& tilebuilder_local,
 void create_edges_from_way_node(
     const boost::property_tree::ptree& pt,
     std::mutex& lock,
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_start,
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_end) {
+    const std::vector<std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator>& tiles,
+    TaskPool::Worker& worker) {
 
   GraphReader reader_local_level(pt);
-  for (; tile_start != tile_end; ++tile_start) {
+  size_t task;
+  while (worker.next(task)) {
+    auto tile_start = tiles[task];
 
     graph_tile_ptr local_tile = nullptr;
     std::unique_ptr<GraphTileBuilder> tilebuilder_local = nullptr;
@@ -613,41 +617,26 @@ void BssBuilder::Build(const boost::property_tree::ptree& pt,
     bss_by_tile[tile_id].push_back(node);
   }
 
-  size_t nb_threads =
-      std::max(static_cast<uint32_t>(1),
-               pt.get<uint32_t>("mjolnir.concurrency", std::thread::hardware_concurrency()));
-  std::vector<std::shared_ptr<std::thread>> threads(nb_threads);
+  auto& pool = TaskPool::get(pt);
 
   // An atomic object we can use to do the synchronization
   std::mutex lock;
 
   // Start the threads
   LOG_INFO("Adding " + std::to_string(osm_nodes.size()) + " bike share stations to " +
-           std::to_string(bss_by_tile.size()) + " local graphs with " + std::to_string(nb_threads) +
-           " thread(s)");
+           std::to_string(bss_by_tile.size()) + " local graphs with " +
+           std::to_string(pool.concurrency()) + " thread(s)");
 
   std::vector<BSSConnection> all;
   {
-    size_t floor = bss_by_tile.size() / threads.size();
-    size_t at_ceiling = bss_by_tile.size() - (threads.size() * floor);
-    bss_by_tile_t::const_iterator tile_start, tile_end = bss_by_tile.begin();
-
-    for (size_t i = 0; i < threads.size(); ++i) {
-      // Figure out how many this thread will work on (either ceiling or floor)
-      size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-      // Where the range begins
-      tile_start = tile_end;
-      // Where the range ends
-      std::advance(tile_end, tile_count);
-      // Make the thread
-      threads[i].reset(new std::thread(project_and_add_bss_nodes, std::cref(pt.get_child("mjolnir")),
-                                       std::ref(lock), tile_start, tile_end, std::cref(osmdata),
-                                       std::ref(all)));
-    }
-
-    for (auto& thread : threads) {
-      thread->join();
+    std::vector<bss_by_tile_t::const_iterator> tiles;
+    tiles.reserve(bss_by_tile.size());
+    for (auto tile = bss_by_tile.cbegin(); tile != bss_by_tile.cend(); ++tile) {
+      tiles.push_back(tile);
     }
+    pool.Run("BssBuilder project", tiles.size(), [&](TaskPool::Worker& worker) {
+      project_and_add_bss_nodes(pt.get_child("mjolnir"), lock, tiles, osmdata, all, worker);
+    });
   }
 
   // the collection is sorted so that the search will be much faster later.
@@ -671,26 +660,14 @@ void BssBuilder::Build(const boost::property_tree::ptree& pt,
   }
 
   {
-    size_t floor = map.size() / threads.size();
-    size_t at_ceiling = map.size() - (threads.size() * floor);
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_start,
-        tile_end = map.begin();
-
-    for (size_t i = 0; i < threads.size(); ++i) {
-      // Figure out how many this thread will work on (either ceiling or floor)
-      size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-      // Where the range begins
-      tile_start = tile_end;
-      // Where the range ends
-      std::advance(tile_end, tile_count);
-      // Make the thread
-      threads[i].reset(new std::thread(create_edges_from_way_node, std::cref(pt.get_child("mjolnir")),
-                                       std::ref(lock), tile_start, tile_end));
-    }
-
-    for (auto& thread : threads) {
-      thread->join();
+    std::vector<std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator> tiles;
+    tiles.reserve(map.size());
+    for (auto tile = map.cbegin(); tile != map.cend(); ++tile) {
+      tiles.push_back(tile);
     }
+    pool.Run("BssBuilder edges", tiles.size(), [&](TaskPool::Worker& worker) {
+      create_edges_from_way_node(pt.get_child("mjolnir"), lock, tiles, worker);
+    });
   }
 }
 
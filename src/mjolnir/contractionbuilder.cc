@@ -0,0 +1,470 @@
+#include "mjolnir/contractionbuilder.h"
+#include "mjolnir/taskpool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/contractiontile.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "sif/costfactory.h"
+#include "sif/edgelabel.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+using namespace valhalla::sif;
+
+namespace {
+
+// Nodes a witness search settles before it gives up, the shortcut is added then
+constexpr uint32_t kMaxWitnessSettles = 500;
+
+// Middle of an arc which is not a shortcut
+constexpr uint32_t kNoMiddle = std::numeric_limits<uint32_t>::max();
+
+// An arc found in a tile, before the edges of all tiles are numbered
+struct TileArc {
+  uint32_t from; // Index of the edge within the tile
+  GraphId to;
+  float cost;
+  float secs;
+  uint32_t length;
+  uint8_t flags;
+};
+
+// The edges of a tile the default auto costing can use and their arcs
+struct TileArcs {
+  uint64_t dataset_id;
+  std::vector<bool> in_hierarchy;
+  std::vector<TileArc> arcs;
+};
+
+// An arc between two numbered edges
+struct Arc {
+  uint32_t from;
+  uint32_t to;
+  uint32_t middle;
+  float cost;
+  float secs;
+  uint32_t length;
+  uint8_t flags;
+};
+
+// Creates the auto costing with the options a request without costing options gets
+cost_ptr_t default_auto_costing() {
+  rapidjson::Document doc;
+  doc.SetObject();
+  valhalla::Costing costing;
+  ParseCosting(doc, "/costing_options/auto", &costing, valhalla::Costing::auto_);
+  return CostFactory().Create(costing);
+}
+
+// Whether the default costing needs more than the edge itself, like the rest of the path
+// or the time, to tell if and at which cost a path can use the edge
+bool is_restricted(const DirectedEdge* edge) {
+  return edge->part_of_complex_restriction() || edge->start_restriction() ||
+         edge->end_restriction() || edge->access_restriction() || edge->destonly();
+}
+
+// Finds the edges of a tile the costing can use and the turns from them onto the next
+// edges, the same way the path algorithms expand a label
+TileArcs compute_arcs(GraphReader& reader, const cost_ptr_t& costing, const GraphId& tile_id) {
+  auto tile = reader.GetGraphTile(tile_id);
+  TileArcs result;
+  result.dataset_id = tile->header()->dataset_id();
+  result.in_hierarchy.resize(tile->header()->directededgecount(), false);
+
+  GraphId edge_id = tile_id;
+  for (uint32_t i = 0; i < result.in_hierarchy.size(); ++i, ++edge_id) {
+    const DirectedEdge* edge = tile->directededge(i);
+    if (!costing->Allowed(edge, tile, kDisallowShortcut)) {
+      continue;
+    }
+    result.in_hierarchy[i] = true;
+
+    graph_tile_ptr end_tile = edge->leaves_tile() ? reader.GetGraphTile(edge->endnode()) : tile;
+    if (end_tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* end_node = end_tile->node(edge->endnode());
+    if (!costing->Allowed(end_node)) {
+      continue;
+    }
+
+    // The turns only see the edge itself, the path before it is not known
+    BDEdgeLabel pred(kInvalidLabel, edge_id, end_tile->GetOpposingEdgeId(edge), edge, Cost{},
+                     costing->travel_mode(), Cost{}, 0, false, true, false, InternalTurn::kNoTurn,
+                     -1);
+    pred.set_not_thru(false);
+
+    std::function<void(const graph_tile_ptr&, const GraphId&, const NodeInfo*, const bool)> expand;
+    expand = [&](const graph_tile_ptr& t, const GraphId& node, const NodeInfo* nodeinfo,
+                 const bool from_transition) {
+      GraphId next_id(node.tileid(), node.level(), nodeinfo->edge_index());
+      const DirectedEdge* next = t->directededge(nodeinfo->edge_index());
+      for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++next, ++next_id) {
+        uint8_t restriction_idx = -1;
+        if (!costing->Allowed(next, t, kDisallowShortcut) ||
+            !costing->Allowed(next, false, pred, t, next_id, 0, 0, restriction_idx)) {
+          continue;
+        }
+        uint8_t flow_sources;
+        Cost cost = costing->TransitionCost(next, nodeinfo, pred) +
+                    costing->EdgeCost(next, t, TimeInfo::invalid(), flow_sources);
+        uint8_t flags = is_restricted(edge) || is_restricted(next) ? kContractionArcRestricted : 0;
+        result.arcs.push_back({i, next_id, cost.cost, cost.secs, next->length(), flags});
+      }
+
+      // Handle transitions - expand from the end node of each transition
+      if (!from_transition && nodeinfo->transition_count() > 0) {
+        const NodeTransition* trans = t->transition(nodeinfo->transition_index());
+        for (uint32_t j = 0; j < nodeinfo->transition_count(); ++j, ++trans) {
+          graph_tile_ptr trans_tile = reader.GetGraphTile(trans->endnode());
+          if (trans_tile != nullptr) {
+            expand(trans_tile, trans->endnode(), trans_tile->node(trans->endnode()), true);
+          }
+        }
+      }
+    };
+    expand(end_tile, edge->endnode(), end_node, false);
+  }
+  return result;
+}
+
+/**
+ * Contracts the nodes of the hierarchy, the numbered edges, one at a time. Contracting a
+ * node adds a shortcut for every pair of its remaining neighbours which has no other
+ * path, a witness, costing at most as much as the path through it. The next node is the
+ * one with the smallest edge difference, the shortcuts it needs less the arcs it
+ * removes, plus the number of its neighbours contracted before so the contracted nodes
+ * spread over the graph. Priorities change as neighbours are contracted so they are
+ * updated lazily when a node comes out of the queue.
+ */
+class Contractor {
+public:
+  Contractor(std::vector<Arc>&& arcs, std::vector<bool>&& in_hierarchy)
+      : arcs_(std::move(arcs)), in_hierarchy_(std::move(in_hierarchy)),
+        rank_(in_hierarchy_.size(), kInvalidRank), deleted_(in_hierarchy_.size(), 0),
+        out_(in_hierarchy_.size()), in_(in_hierarchy_.size()),
+        dist_(in_hierarchy_.size(), std::numeric_limits<float>::max()) {
+    for (uint32_t i = 0; i < arcs_.size(); ++i) {
+      out_[arcs_[i].from].push_back(i);
+      in_[arcs_[i].to].push_back(i);
+    }
+  }
+
+  void Contract() {
+    using entry_t = std::pair<int32_t, uint32_t>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    for (uint32_t v = 0; v < in_hierarchy_.size(); ++v) {
+      if (in_hierarchy_[v]) {
+        queue.emplace(Priority(v), v);
+      }
+    }
+
+    uint32_t next_rank = 0;
+    const size_t count = queue.size();
+    while (!queue.empty()) {
+      uint32_t v = queue.top().second;
+      queue.pop();
+      int32_t priority = Priority(v);
+      if (!queue.empty() && priority > queue.top().first) {
+        queue.emplace(priority, v);
+        continue;
+      }
+
+      Shortcuts(v, true);
+      rank_[v] = next_rank++;
+      for (const auto* arcs : {&in_[v], &out_[v]}) {
+        for (auto idx : *arcs) {
+          uint32_t neighbour = arcs_[idx].from == v ? arcs_[idx].to : arcs_[idx].from;
+          if (alive(neighbour)) {
+            ++deleted_[neighbour];
+          }
+        }
+      }
+      if (next_rank % 1000000 == 0) {
+        LOG_INFO("Contracted " + std::to_string(next_rank) + " of " + std::to_string(count) +
+                 " edges, " + std::to_string(arcs_.size()) + " arcs");
+      }
+    }
+  }
+
+  const std::vector<Arc>& arcs() const {
+    return arcs_;
+  }
+  const std::vector<uint32_t>& rank() const {
+    return rank_;
+  }
+  const std::vector<std::vector<uint32_t>>& out() const {
+    return out_;
+  }
+  const std::vector<std::vector<uint32_t>>& in() const {
+    return in_;
+  }
+
+protected:
+  std::vector<Arc> arcs_;
+  std::vector<bool> in_hierarchy_;
+  std::vector<uint32_t> rank_;
+  std::vector<int32_t> deleted_;
+  std::vector<std::vector<uint32_t>> out_;
+  std::vector<std::vector<uint32_t>> in_;
+
+  // Costs of the witness search, reset through the touched nodes
+  std::vector<float> dist_;
+  std::vector<uint32_t> touched_;
+
+  bool alive(const uint32_t v) const {
+    return in_hierarchy_[v] && rank_[v] == kInvalidRank;
+  }
+
+  int32_t Priority(const uint32_t v) {
+    int32_t removed = 0;
+    for (const auto* arcs : {&in_[v], &out_[v]}) {
+      for (auto idx : *arcs) {
+        removed += alive(arcs_[idx].from) && alive(arcs_[idx].to);
+      }
+    }
+    return static_cast<int32_t>(Shortcuts(v, false)) - removed + deleted_[v];
+  }
+
+  // Counts, and adds if asked to, the shortcuts needed to contract a node
+  uint32_t Shortcuts(const uint32_t v, const bool add) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < in_[v].size(); ++i) {
+      const Arc a = arcs_[in_[v][i]];
+      if (a.from == v || !alive(a.from)) {
+        continue;
+      }
+      float max_cost = -1.0f;
+      for (auto idx : out_[v]) {
+        const Arc& b = arcs_[idx];
+        if (b.to != a.from && b.to != v && alive(b.to)) {
+          max_cost = std::max(max_cost, a.cost + b.cost);
+        }
+      }
+      if (max_cost < 0.0f) {
+        continue;
+      }
+
+      WitnessSearch(a.from, v, max_cost);
+      for (size_t j = 0; j < out_[v].size(); ++j) {
+        const Arc b = arcs_[out_[v][j]];
+        if (b.to == a.from || b.to == v || !alive(b.to) || dist_[b.to] <= a.cost + b.cost) {
+          continue;
+        }
+        ++count;
+        if (add) {
+          AddShortcut({a.from, b.to, v, a.cost + b.cost, a.secs + b.secs, a.length + b.length,
+                       static_cast<uint8_t>(a.flags | b.flags)});
+        }
+      }
+      for (auto t : touched_) {
+        dist_[t] = std::numeric_limits<float>::max();
+      }
+      touched_.clear();
+    }
+    return count;
+  }
+
+  // Dijkstra from a node over the remaining nodes without the one being contracted
+  void WitnessSearch(const uint32_t source, const uint32_t skip, const float max_cost) {
+    using entry_t = std::pair<float, uint32_t>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    dist_[source] = 0.0f;
+    touched_.push_back(source);
+    queue.emplace(0.0f, source);
+    uint32_t settled = 0;
+    while (!queue.empty() && settled < kMaxWitnessSettles) {
+      auto top = queue.top();
+      queue.pop();
+      if (top.first > dist_[top.second]) {
+        continue;
+      }
+      if (top.first > max_cost) {
+        break;
+      }
+      ++settled;
+      for (auto idx : out_[top.second]) {
+        const Arc& arc = arcs_[idx];
+        if (arc.to == skip || !alive(arc.to)) {
+          continue;
+        }
+        float cost = top.first + arc.cost;
+        if (cost < dist_[arc.to]) {
+          if (dist_[arc.to] == std::numeric_limits<float>::max()) {
+            touched_.push_back(arc.to);
+          }
+          dist_[arc.to] = cost;
+          queue.emplace(cost, arc.to);
+        }
+      }
+    }
+  }
+
+  // Adds a shortcut or replaces a more expensive arc between the same nodes. Arcs into or
+  // out of a contracted node never change again so the shortcuts through it stay valid.
+  void AddShortcut(const Arc& shortcut) {
+    for (auto idx : out_[shortcut.from]) {
+      if (arcs_[idx].to == shortcut.to) {
+        if (shortcut.cost < arcs_[idx].cost) {
+          arcs_[idx] = shortcut;
+        }
+        return;
+      }
+    }
+    out_[shortcut.from].push_back(arcs_.size());
+    in_[shortcut.to].push_back(arcs_.size());
+    arcs_.push_back(shortcut);
+  }
+};
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ContractionBuilder::Build(const boost::property_tree::ptree& pt) {
+  const std::string contraction_dir = pt.get<std::string>("mjolnir.contraction_dir", "");
+  if (contraction_dir.empty()) {
+    LOG_INFO("Skipping contraction builder");
+    return;
+  }
+
+  std::vector<GraphId> tiles;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    const auto transit_level = TileHierarchy::GetTransitLevel().level;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      if (tile_id.level() != transit_level) {
+        tiles.push_back(tile_id);
+      }
+    }
+  }
+  std::sort(tiles.begin(), tiles.end());
+
+  // Find the turns between the edges of every tile
+  auto& pool = TaskPool::get(pt);
+  LOG_INFO("Finding the arcs of " + std::to_string(tiles.size()) + " tiles with " +
+           std::to_string(pool.concurrency()) + " thread(s)");
+  std::vector<TileArcs> tile_arcs(tiles.size());
+  pool.Run("ContractionBuilder arcs", tiles.size(), [&](TaskPool::Worker& worker) {
+    GraphReader reader(pt.get_child("mjolnir"));
+    const auto costing = default_auto_costing();
+    size_t task;
+    while (worker.next(task)) {
+      tile_arcs[task] = compute_arcs(reader, costing, tiles[task]);
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  });
+
+  // Number the edges of all tiles one after the other
+  std::vector<uint64_t> offsets(tiles.size() + 1, 0);
+  std::unordered_map<uint64_t, uint32_t> tile_index;
+  for (uint32_t i = 0; i < tiles.size(); ++i) {
+    offsets[i + 1] = offsets[i] + tile_arcs[i].in_hierarchy.size();
+    tile_index.emplace(tiles[i].value, i);
+  }
+  if (offsets.back() >= kNoMiddle) {
+    throw std::runtime_error("Too many directed edges to build a contraction hierarchy");
+  }
+  auto to_graphid = [&](const uint32_t index) {
+    size_t t = std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1;
+    return GraphId(tiles[t].tileid(), tiles[t].level(), index - offsets[t]);
+  };
+
+  std::vector<bool> in_hierarchy;
+  in_hierarchy.reserve(offsets.back());
+  std::vector<Arc> arcs;
+  for (uint32_t i = 0; i < tiles.size(); ++i) {
+    in_hierarchy.insert(in_hierarchy.end(), tile_arcs[i].in_hierarchy.begin(),
+                        tile_arcs[i].in_hierarchy.end());
+    for (const auto& arc : tile_arcs[i].arcs) {
+      auto to_tile = tile_index.find(arc.to.Tile_Base().value);
+      if (to_tile == tile_index.end()) {
+        continue;
+      }
+      arcs.push_back({static_cast<uint32_t>(offsets[i] + arc.from),
+                      static_cast<uint32_t>(offsets[to_tile->second] + arc.to.id()), kNoMiddle,
+                      arc.cost, arc.secs, arc.length, arc.flags});
+    }
+    std::vector<TileArc>().swap(tile_arcs[i].arcs);
+  }
+
+  LOG_INFO("Contracting " + std::to_string(offsets.back()) + " edges with " +
+           std::to_string(arcs.size()) + " arcs");
+  Contractor contractor(std::move(arcs), std::move(in_hierarchy));
+  contractor.Contract();
+  LOG_INFO("Contracted with " + std::to_string(contractor.arcs().size()) + " arcs");
+
+  // Write one contraction tile per graph tile
+  pool.Run("ContractionBuilder store", tiles.size(), [&](TaskPool::Worker& worker) {
+    const auto& all_arcs = contractor.arcs();
+    const auto& rank = contractor.rank();
+    size_t task;
+    while (worker.next(task)) {
+      std::vector<ContractionNode> nodes;
+      std::vector<ContractionArc> stored_arcs;
+      for (uint64_t v = offsets[task]; v < offsets[task + 1]; ++v) {
+        ContractionNode node{rank[v], static_cast<uint32_t>(stored_arcs.size()), 0, 0};
+        auto add_arc = [&](const Arc& arc, const uint32_t target) {
+          stored_arcs.push_back({to_graphid(target),
+                                   arc.middle == kNoMiddle ? GraphId() : to_graphid(arc.middle),
+                                   arc.cost,
+                                   arc.secs,
+                                   arc.length,
+                                   arc.flags,
+                                   {}});
+        };
+        if (rank[v] != kInvalidRank) {
+          for (auto idx : contractor.out()[v]) {
+            if (rank[all_arcs[idx].to] > rank[v]) {
+              add_arc(all_arcs[idx], all_arcs[idx].to);
+              ++node.up_count;
+            }
+          }
+          for (auto idx : contractor.in()[v]) {
+            if (rank[all_arcs[idx].from] > rank[v]) {
+              add_arc(all_arcs[idx], all_arcs[idx].from);
+              ++node.down_count;
+            }
+          }
+        }
+        nodes.push_back(node);
+      }
+
+      ContractionTileHeader header{tiles[task].value, tile_arcs[task].dataset_id,
+                                   static_cast<uint32_t>(nodes.size()),
+                                   static_cast<uint32_t>(stored_arcs.size())};
+      filesystem::path filename =
+          contraction_dir + filesystem::path::preferred_separator +
+          GraphTile::FileSuffix(tiles[task], SUFFIX_CONTRACTION);
+      if (!filesystem::exists(filename.parent_path())) {
+        filesystem::create_directories(filename.parent_path());
+      }
+      std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file " + filename.string());
+      }
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(ContractionNode));
+      file.write(reinterpret_cast<const char*>(stored_arcs.data()),
+                 stored_arcs.size() * sizeof(ContractionArc));
+    }
+  });
+}
+
+} // namespace mjolnir
+} // namespace valhalla
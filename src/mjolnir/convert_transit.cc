@@ -1,14 +1,13 @@
 #include <cmath>
 #include <cstdint>
 #include <fstream>
-#include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
 #include <sstream>
 #include <string>
-#include <thread>
 #include <unordered_set>
 
 #include "baldr/rapidjson_utils.h"
@@ -34,6 +33,7 @@
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/ingest_transit.h"
 #include "mjolnir/servicedays.h"
+#include "mjolnir/taskpool.h"
 #include "mjolnir/util.h"
 
 #include "proto/transit.pb.h"
@@ -1010,11 +1010,10 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 void build_tiles(const boost::property_tree::ptree& pt,
                  std::mutex& lock,
                  const std::unordered_set<GraphId>& all_tiles,
-                 std::unordered_set<GraphId>::const_iterator tile_start,
-                 std::unordered_set<GraphId>::const_iterator tile_end,
-                 std::promise<builder_stats>& results) {
+                 const std::vector<std::unordered_set<GraphId>::const_iterator>& tile_list,
+                 builder_stats& stats,
+                 TaskPool::Worker& worker) {
 
-  builder_stats stats;
   stats.no_dir_edge_count = 0;
   stats.dep_count = 0;
   stats.midnight_dep_count = 0;
@@ -1030,7 +1029,9 @@ void build_tiles(const boost::property_tree::ptree& pt,
 
   const auto& tiles = TileHierarchy::levels().back().tiles;
   // Iterate through the tiles in the queue and find any that include stops
-  for (; tile_start != tile_end; ++tile_start) {
+  size_t task;
+  while (worker.next(task)) {
+    auto tile_start = tile_list[task];
     // Get the next tile Id from the queue and get a tile builder
     if (reader_transit_level.OverCommitted()) {
       reader_transit_level.Trim();
@@ -1221,9 +1222,6 @@ void build_tiles(const boost::property_tree::ptree& pt,
   if (tz_db_handle) {
     sqlite3_close(tz_db_handle);
   }
-
-  // Send back the statistics
-  results.set_value(stats);
 }
 
 } // namespace
@@ -1248,9 +1246,6 @@ std::unordered_set<GraphId> convert_transit(const ptree& pt) {
     }
   }
 
-  auto thread_count =
-      pt.get<unsigned int>("mjolnir.concurrency", std::max(static_cast<unsigned int>(1),
-                                                           std::thread::hardware_concurrency()));
   LOG_INFO("Building transit network.");
 
   auto t1 = std::chrono::high_resolution_clock::now();
@@ -1265,40 +1260,25 @@ std::unordered_set<GraphId> convert_transit(const ptree& pt) {
   // Second pass - for all tiles with transit stops get all transit information
   // and populate tiles
 
-  // A place to hold worker threads and their results
-  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+  // The shared pool of worker threads
+  auto& pool = TaskPool::get(pt);
 
   // An atomic object we can use to do the synchronization
   std::mutex lock;
 
-  // A place to hold the results of those threads (exceptions, stats)
-  std::list<std::promise<builder_stats>> results;
+  // A place to hold the results of each worker
+  std::vector<builder_stats> results(pool.concurrency());
 
-  // Start the threads, divvy up the work
+  // Start the threads, they pull tiles from the list until it is empty
   LOG_INFO("Adding " + std::to_string(all_tiles.size()) + " transit tiles to the transit graph...");
-  size_t floor = all_tiles.size() / threads.size();
-  size_t at_ceiling = all_tiles.size() - (threads.size() * floor);
-  std::unordered_set<GraphId>::const_iterator tile_start, tile_end = all_tiles.begin();
-
-  // Atomically pass around stats info
-  for (size_t i = 0; i < threads.size(); ++i) {
-    // Figure out how many this thread will work on (either ceiling or floor)
-    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    std::advance(tile_end, tile_count);
-    // Make the thread
-    results.emplace_back();
-    threads[i].reset(new std::thread(build_tiles, std::cref(pt.get_child("mjolnir")), std::ref(lock),
-                                     std::cref(all_tiles), tile_start, tile_end,
-                                     std::ref(results.back())));
-  }
-
-  // Wait for them to finish up their work
-  for (auto& thread : threads) {
-    thread->join();
+  std::vector<std::unordered_set<GraphId>::const_iterator> tile_list;
+  tile_list.reserve(all_tiles.size());
+  for (auto tile = all_tiles.cbegin(); tile != all_tiles.cend(); ++tile) {
+    tile_list.push_back(tile);
   }
+  pool.Run("ConvertTransit", tile_list.size(), [&](TaskPool::Worker& worker) {
+    build_tiles(pt.get_child("mjolnir"), lock, all_tiles, tile_list, results[worker.id()], worker);
+  });
 
   // Check all of the outcomes, to see about maximum density (km/km2)
   builder_stats stats{};
@@ -1306,17 +1286,11 @@ std::unordered_set<GraphId> convert_transit(const ptree& pt) {
   uint32_t total_dep_count = 0;
   uint32_t total_midnight_dep_count = 0;
 
-  for (auto& result : results) {
-    // If something bad went down this will rethrow it
-    try {
-      auto thread_stats = result.get_future().get();
-      stats(thread_stats);
-      total_no_dir_edge_count += stats.no_dir_edge_count;
-      total_dep_count += stats.dep_count;
-      total_midnight_dep_count += stats.midnight_dep_count;
-    } catch (std::exception& e) {
-      // TODO: throw further up the chain?
-    }
+  for (const auto& result : results) {
+    stats(result);
+    total_no_dir_edge_count += stats.no_dir_edge_count;
+    total_dep_count += stats.dep_count;
+    total_midnight_dep_count += stats.midnight_dep_count;
   }
 
   if (total_no_dir_edge_count) {
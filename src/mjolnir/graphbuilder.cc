@@ -1,6 +1,4 @@
-#include <future>
 #include <set>
-#include <thread>
 #include <utility>
 
 #include <boost/algorithm/string.hpp>
@@ -27,6 +25,7 @@
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/linkclassification.h"
 #include "mjolnir/node_expander.h"
+#include "mjolnir/taskpool.h"
 #include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
@@ -40,17 +39,20 @@ namespace {
  * we also need to then update the edges that pointed to them
  *
  */
-std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::string& edges_file) {
+std::map<GraphId, size_t>
+SortGraph(const std::string& nodes_file, const std::string& edges_file, size_t concurrency) {
   LOG_INFO("Sorting graph...");
 
   // Sort nodes by graphid then by osmid, so its basically a set of tiles
   sequence<Node> nodes(nodes_file, false);
-  nodes.sort([](const Node& a, const Node& b) {
-    if (a.graph_id == b.graph_id) {
-      return a.node.osmid_ < b.node.osmid_;
-    }
-    return a.graph_id < b.graph_id;
-  });
+  nodes.sort(
+      [](const Node& a, const Node& b) {
+        if (a.graph_id == b.graph_id) {
+          return a.node.osmid_ < b.node.osmid_;
+        }
+        return a.graph_id < b.graph_id;
+      },
+      sequence<Node>::kSortBufferSize, concurrency);
 
   // run through the sorted nodes, going back to the edges they reference and updating each edge
   // to point to the first (out of the duplicates) nodes index. at the end of this there will be
@@ -391,11 +393,12 @@ void BuildTileSet(const std::string& ways_file,
                   const std::string& pronunciation_file,
                   const std::string& tile_dir,
                   const OSMData& osmdata,
-                  std::map<GraphId, size_t>::const_iterator tile_start,
-                  std::map<GraphId, size_t>::const_iterator tile_end,
+                  const std::map<GraphId, size_t>& tiles,
+                  const std::vector<std::map<GraphId, size_t>::const_iterator>& tile_list,
                   const uint32_t tile_creation_date,
                   const boost::property_tree::ptree& pt,
-                  std::promise<DataQuality>& result) {
+                  TaskPool::Worker& worker,
+                  DataQuality& stats) {
 
   sequence<OSMWay> ways(ways_file, false);
   sequence<OSMWayNode> way_nodes(way_nodes_file, false);
@@ -449,7 +452,6 @@ void BuildTileSet(const std::string& ways_file,
 
   // For each tile in the task
   bool added = false;
-  DataQuality stats;
 
   // Lots of times in a given tile we may end up accessing the same
   // shape/attributes twice we avoid doing this by caching it here
@@ -457,7 +459,9 @@ void BuildTileSet(const std::string& ways_file,
 
   ////////////////////////////////////////////////////////////////////////////
   // Iterate over tiles
-  for (; tile_start != tile_end; ++tile_start) {
+  size_t task;
+  while (worker.next(task)) {
+    auto tile_start = tile_list[task];
     try {
       // What actually writes the tile
       GraphId tile_id = tile_start->first.Tile_Base();
@@ -505,7 +509,7 @@ void BuildTileSet(const std::string& ways_file,
       auto node_itr = nodes[tile_start->second];
       // to avoid realloc we guess how many edges there might be in a given tile
       geo_attribute_cache.clear();
-      geo_attribute_cache.reserve(5 * (std::next(tile_start) == tile_end
+      geo_attribute_cache.reserve(5 * (std::next(tile_start) == tiles.end()
                                            ? nodes.end() - node_itr
                                            : std::next(tile_start)->second - tile_start->second));
 
@@ -1106,10 +1110,15 @@ void BuildTileSet(const std::string& ways_file,
                     .str());
     } // Whatever happens in Vegas..
     catch (std::exception& e) {
-      // ..gets sent back to the main thread
-      result.set_exception(std::current_exception());
+      // ..gets sent back to the main thread by the task pool
       LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile_start->first % e.what()).str());
-      return;
+      if (admin_db_handle) {
+        sqlite3_close(admin_db_handle);
+      }
+      if (tz_db_handle) {
+        sqlite3_close(tz_db_handle);
+      }
+      throw;
     }
   }
 
@@ -1120,13 +1129,10 @@ void BuildTileSet(const std::string& ways_file,
   if (tz_db_handle) {
     sqlite3_close(tz_db_handle);
   }
-
-  // Let the main thread see how this thread faired
-  result.set_value(stats);
 }
 
 // Build tiles for the local graph hierarchy
-void BuildLocalTiles(const unsigned int thread_count,
+void BuildLocalTiles(TaskPool& pool,
                      const OSMData& osmdata,
                      const std::string& ways_file,
                      const std::string& way_nodes_file,
@@ -1144,56 +1150,31 @@ void BuildLocalTiles(const unsigned int thread_count,
       DateTime::days_from_pivot_date(DateTime::get_formatted_date(DateTime::iso_date_time(tz)));
 
   LOG_INFO("Building " + std::to_string(tiles.size()) + " tiles with " +
-           std::to_string(thread_count) + " threads...");
-
-  // A place to hold worker threads and their results, be they exceptions or otherwise
-  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
-
-  // Hold the results (DataQuality/stats) for the threads
-  std::vector<std::promise<DataQuality>> results(threads.size());
-
-  // Divvy up the work
-  size_t floor = tiles.size() / threads.size();
-  size_t at_ceiling = tiles.size() - (threads.size() * floor);
-  std::map<GraphId, size_t>::const_iterator tile_start, tile_end = tiles.begin();
-
-  // Atomically pass around stats info
-  for (size_t i = 0; i < threads.size(); ++i) {
-    // Figure out how many this thread will work on (either ceiling or floor)
-    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    std::advance(tile_end, tile_count);
-    // Make the thread
-    threads[i].reset(new std::thread(BuildTileSet, std::cref(ways_file), std::cref(way_nodes_file),
-                                     std::cref(nodes_file), std::cref(edges_file),
-                                     std::cref(complex_from_restriction_file),
-                                     std::cref(complex_to_restriction_file),
-                                     std::cref(pronunciation_file), std::cref(tile_dir),
-                                     std::cref(osmdata), tile_start, tile_end, tile_creation_date,
-                                     std::cref(pt.get_child("mjolnir")), std::ref(results[i])));
-  }
+           std::to_string(pool.concurrency()) + " threads...");
 
-  // Join all the threads to wait for them to finish up their work
-  for (auto& thread : threads) {
-    thread->join();
+  // Each tile is a task, a thread that runs out of tiles steals them from the others
+  std::vector<std::map<GraphId, size_t>::const_iterator> tile_list;
+  tile_list.reserve(tiles.size());
+  for (auto tile = tiles.cbegin(); tile != tiles.cend(); ++tile) {
+    tile_list.push_back(tile);
   }
 
+  // Hold the results (DataQuality/stats) for the threads. If we couldnt write a tile for whatever
+  // reason the pool rethrows and we fail the whole job
+  std::vector<DataQuality> results(pool.concurrency());
+  pool.Run("BuildLocalTiles", tile_list.size(), [&](TaskPool::Worker& worker) {
+    BuildTileSet(ways_file, way_nodes_file, nodes_file, edges_file, complex_from_restriction_file,
+                 complex_to_restriction_file, pronunciation_file, tile_dir, osmdata, tiles, tile_list,
+                 tile_creation_date, pt.get_child("mjolnir"), worker, results[worker.id()]);
+  });
+
   LOG_INFO("Finished");
 
-  // Check all of the outcomes and accumulate stats
-  for (auto& result : results) {
-    // If something bad went down this will rethrow it
-    try {
-      // Add statistics and log issues on this thread
-      const auto& stat = result.get_future().get();
-      stats.AddStatistics(stat);
-      stat.LogIssues();
-    } // If we couldnt write a tile for whatever reason we fail the whole job
-    catch (std::exception& e) {
-      throw e;
-    }
+  // Accumulate stats
+  for (const auto& stat : results) {
+    // Add statistics and log issues on this thread
+    stats.AddStatistics(stat);
+    stat.LogIssues();
   }
 }
 
@@ -1214,7 +1195,7 @@ std::map<GraphId, size_t> GraphBuilder::BuildEdges(const boost::property_tree::p
       [&level](const OSMNode& node) { return TileHierarchy::GetGraphId(node.latlng(), level); },
       pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true));
 
-  return SortGraph(nodes_file, edges_file);
+  return SortGraph(nodes_file, edges_file, TaskPool::get(pt).concurrency());
 }
 
 // Build the graph from the input
@@ -1247,13 +1228,9 @@ void GraphBuilder::Build(const boost::property_tree::ptree& pt,
   }
   ReclassifyFerryConnections(ways_file, way_nodes_file, nodes_file, edges_file,
                              static_cast<uint32_t>(rc));
-  unsigned int threads =
-      std::max(static_cast<unsigned int>(1),
-               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
-
   // Build tiles at the local level. Form connected graph from nodes and edges.
   std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
-  BuildLocalTiles(threads, osmdata, ways_file, way_nodes_file, nodes_file, edges_file,
+  BuildLocalTiles(TaskPool::get(pt), osmdata, ways_file, way_nodes_file, nodes_file, edges_file,
                   complex_from_restriction_file, complex_to_restriction_file, pronunciation_file,
                   tiles, tile_dir, stats, pt);
   stats.LogStatistics();
@@ -228,8 +228,13 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
 
 // Output the tile to file. Stores as binary data.
 void GraphTileBuilder::StoreTileData() {
+  StoreTileData(tile_dir_);
+}
+
+// Output the tile to file below the given tile directory
+void GraphTileBuilder::StoreTileData(const std::string& tile_dir) {
   // Get the name of the file
-  filesystem::path filename(tile_dir_ + filesystem::path::preferred_separator +
+  filesystem::path filename(tile_dir + filesystem::path::preferred_separator +
                             GraphTile::FileSuffix(header_builder_.graphid()));
 
   // Make sure the directory exists on the system
@@ -375,6 +380,9 @@ void GraphTileBuilder::StoreTileData() {
     header_builder_.set_end_offset(header_builder_.lane_connectivity_offset() +
                                    (lane_connectivity_builder_.size() * sizeof(LaneConnectivity)));
 
+    // Edge reach is not carried over by the builder, it has to be computed again
+    header_builder_.set_edge_reach_offset(0);
+
     // Sanity check for the end offset
     uint32_t curr =
         static_cast<uint32_t>(in_mem.tellp()) + static_cast<uint32_t>(sizeof(GraphTileHeader));
@@ -1144,6 +1152,9 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   header.set_edgeinfo_offset(header.edgeinfo_offset() + shift);
   header.set_textlist_offset(header.textlist_offset() + shift);
   header.set_lane_connectivity_offset(header.lane_connectivity_offset() + shift);
+  if (header.edge_reach_offset() > 0) {
+    header.set_edge_reach_offset(header.edge_reach_offset() + shift);
+  }
   header.set_end_offset(header.end_offset() + shift);
   // rewrite the tile
   filesystem::path filename =
@@ -1258,5 +1269,65 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
   }
 }
 
+// Updates a tile with the reach of its directed edges. Edge reach is either
+// replaced in place or appended after the rest of the tile.
+void GraphTileBuilder::UpdateEdgeReach(const uint32_t max_reach,
+                                       const std::vector<EdgeReach>& reaches) {
+  if (reaches.size() != header_->directededgecount()) {
+    throw std::runtime_error("GraphTileBuilder::UpdateEdgeReach - directed edge count has changed");
+  }
+  if (max_reach > kMaxStoredReach) {
+    throw std::runtime_error("GraphTileBuilder::UpdateEdgeReach - max reach is above " +
+                             std::to_string(kMaxStoredReach));
+  }
+
+  // Get the name of the file
+  filesystem::path filename = tile_dir_ + filesystem::path::preferred_separator +
+                              GraphTile::FileSuffix(header_builder_.graphid());
+
+  // Make sure the directory exists on the system
+  if (!filesystem::exists(filename.parent_path()))
+    filesystem::create_directories(filename.parent_path());
+
+  EdgeReachHeader reach_header{};
+  reach_header.max_reach = static_cast<uint8_t>(max_reach);
+
+  // Open file and truncate
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (file.is_open()) {
+    // Write a new header. If the tile has no edge reach yet it goes at the end of the tile.
+    const bool append = header_->edge_reach_offset() == 0;
+    const uint32_t offset = append ? header_->end_offset() : header_->edge_reach_offset();
+    if (append) {
+      header_builder_.set_end_offset(header_->end_offset() + sizeof(EdgeReachHeader) +
+                                     reaches.size() * sizeof(EdgeReach));
+    }
+    header_builder_.set_edge_reach_offset(offset);
+    file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
+
+    // Copy everything up to the edge reach data
+    auto begin = reinterpret_cast<const char*>(header()) + sizeof(GraphTileHeader);
+    auto end = reinterpret_cast<const char*>(header()) + offset;
+    file.write(begin, end - begin);
+
+    // Write the edge reach data
+    file.write(reinterpret_cast<const char*>(&reach_header), sizeof(EdgeReachHeader));
+    file.write(reinterpret_cast<const char*>(reaches.data()), reaches.size() * sizeof(EdgeReach));
+
+    // Copy whatever followed the edge reach data it replaced
+    if (!append) {
+      begin = end + sizeof(EdgeReachHeader) + reaches.size() * sizeof(EdgeReach);
+      end = reinterpret_cast<const char*>(header()) + header_->end_offset();
+      file.write(begin, end - begin);
+    }
+
+    // Close the file
+    file.close();
+  } else {
+    throw std::runtime_error("GraphTileBuilder::UpdateEdgeReach - Failed to open file " +
+                             filename.string());
+  }
+}
+
 } // namespace mjolnir
 } // namespace valhalla
@@ -1,11 +1,14 @@
 #include "mjolnir/hierarchybuilder.h"
 #include "mjolnir/graphtilebuilder.h"
+#include "mjolnir/taskpool.h"
 
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -48,6 +51,27 @@ struct OldToNewNodes {
   }
 };
 
+// Hierarchy levels a base node exists on. These are found for a batch of base tiles concurrently
+// and then handed out new node Ids in tile order, so the Ids do not depend on the thread count.
+struct NodeLevels {
+  uint32_t highway_tile;  // Tile on the highway level (if highway is set)
+  uint32_t arterial_tile; // Tile on the arterial level (if arterial is set)
+  uint32_t density;       // Density at the node
+  bool highway;
+  bool arterial;
+  bool local;
+};
+
+// Number of base tiles per thread that are held in memory while creating node associations
+constexpr size_t kTilesPerThread = 16;
+
+// Range of the sorted new to old sequence that forms one tile in a new level
+struct NewTile {
+  GraphId tile_id;
+  size_t begin;
+  size_t end;
+};
+
 // Add a downward transition edge if the node is valid.
 bool AddDownwardTransition(const GraphId& node, GraphTileBuilder* tilebuilder) {
   if (node.Is_Valid()) {
@@ -68,23 +92,27 @@ bool AddUpwardTransition(const GraphId& node, GraphTileBuilder* tilebuilder) {
   }
 }
 
-void SortSequences(const std::string& new_to_old_file, const std::string& old_to_new_file) {
+void SortSequences(const std::string& new_to_old_file,
+                   const std::string& old_to_new_file,
+                   size_t concurrency) {
   // Sort the new nodes. Sort so highway level is first
   sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-  new_to_old.sort([](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
-    if (a.first.level() == b.first.level()) {
-      if (a.first.tileid() == b.first.tileid()) {
-        return a.first.id() < b.first.id();
-      }
-      return a.first.tileid() < b.first.tileid();
-    }
-    return a.first.level() < b.first.level();
-  });
+  new_to_old.sort(
+      [](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
+        if (a.first.level() == b.first.level()) {
+          if (a.first.tileid() == b.first.tileid()) {
+            return a.first.id() < b.first.id();
+          }
+          return a.first.tileid() < b.first.tileid();
+        }
+        return a.first.level() < b.first.level();
+      },
+      sequence<std::pair<GraphId, GraphId>>::kSortBufferSize, concurrency);
 
   // Sort old to new by node Id
   sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-  old_to_new.sort(
-      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
+  old_to_new.sort_by_key([](const OldToNewNodes& a) { return a.node_id.value; },
+                         sequence<OldToNewNodes>::kSortBufferSize, concurrency);
 }
 
 // Convenience method to find the node association.
@@ -121,78 +149,55 @@ bool OpposingEdgeInfoMatches(const graph_tile_ptr& tile, const DirectedEdge* edg
   return false;
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader,
-                         const std::string& new_to_old_file,
-                         const std::string& old_to_new_file) {
-  // Use the sequence that associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-
-  // lambda to indicate whether a directed edge should be included
-  auto include_edge = [&old_to_new](const DirectedEdge* directededge, const GraphId& base_node,
-                                    const uint8_t current_level) {
-    if (directededge->use() == Use::kTransitConnection ||
-        directededge->use() == Use::kEgressConnection ||
-        directededge->use() == Use::kPlatformConnection) {
-      // Transit connection edges should live on the lowest class level
-      // where a new node exists
-      auto f = find_nodes(old_to_new, base_node);
-      uint8_t lowest_level;
-      if (f.local_node.Is_Valid())
-        lowest_level = 2;
-      else if (f.arterial_node.Is_Valid())
-        lowest_level = 1;
-      else if (f.highway_node.Is_Valid())
-        lowest_level = 0;
-      else
-        throw std::logic_error("Could not find valid node level");
-      return (lowest_level == current_level);
-    } else if (directededge->bss_connection()) {
-      // Despite the road class, Bike Share Stations' connections are always at local level
-      return (2 == current_level);
-    } else {
-      return (TileHierarchy::get_level(directededge->classification()) == current_level);
-    }
-  };
+// Is the directed edge part of the given level
+bool IncludeEdge(sequence<OldToNewNodes>& old_to_new,
+                 const DirectedEdge* directededge,
+                 const GraphId& base_node,
+                 const uint8_t current_level) {
+  if (directededge->use() == Use::kTransitConnection ||
+      directededge->use() == Use::kEgressConnection ||
+      directededge->use() == Use::kPlatformConnection) {
+    // Transit connection edges should live on the lowest class level
+    // where a new node exists
+    auto f = find_nodes(old_to_new, base_node);
+    uint8_t lowest_level;
+    if (f.local_node.Is_Valid())
+      lowest_level = 2;
+    else if (f.arterial_node.Is_Valid())
+      lowest_level = 1;
+    else if (f.highway_node.Is_Valid())
+      lowest_level = 0;
+    else
+      throw std::logic_error("Could not find valid node level");
+    return (lowest_level == current_level);
+  } else if (directededge->bss_connection()) {
+    // Despite the road class, Bike Share Stations' connections are always at local level
+    return (2 == current_level);
+  } else {
+    return (TileHierarchy::get_level(directededge->classification()) == current_level);
+  }
+}
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
+// Form one tile in the new level from its range of new nodes.
+void FormTileInNewLevel(GraphReader& reader,
+                        sequence<std::pair<GraphId, GraphId>>& new_to_old,
+                        sequence<OldToNewNodes>& old_to_new,
+                        const NewTile& new_tile) {
+  // New tilebuilder for this tile
   bool added = false;
-  uint8_t current_level = std::numeric_limits<uint8_t>::max();
-  GraphId tile_id;
+  GraphId tile_id = new_tile.tile_id;
+  uint8_t current_level = tile_id.level();
   std::hash<std::string> hasher;
-  PointLL base_ll;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
-    GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
-      }
-
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
-
-      // Set the base ll for this tile
-      base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
-      tilebuilder->header_builder().set_base_ll(base_ll);
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
 
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Trim();
-      }
-    }
+  // Set the base ll for this tile
+  PointLL base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
+  tilebuilder.header_builder().set_base_ll(base_ll);
 
-    // Get the node in the base level
+  auto new_node = new_to_old.at(new_tile.begin);
+  for (size_t n = new_tile.begin; n < new_tile.end; ++n, new_node++) {
+    // Get the new node and the node in the base level
+    GraphId nodea = (*new_node).first;
     GraphId base_node = (*new_node).second;
     graph_tile_ptr tile = reader.GetGraphTile(base_node);
     if (tile == nullptr) {
@@ -201,17 +206,17 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
 
     // Copy the data version
-    tilebuilder->header_builder().set_dataset_id(tile->header()->dataset_id());
+    tilebuilder.header_builder().set_dataset_id(tile->header()->dataset_id());
 
     // Copy node information and set the node lat,lon offsets within the new tile
     NodeInfo baseni = *(tile->node(base_node.id()));
-    tilebuilder->nodes().push_back(baseni);
+    tilebuilder.nodes().push_back(baseni);
     const auto& admin = tile->admininfo(baseni.admin_index());
-    NodeInfo& node = tilebuilder->nodes().back();
+    NodeInfo& node = tilebuilder.nodes().back();
     node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
-    node.set_edge_index(tilebuilder->directededges().size());
+    node.set_edge_index(tilebuilder.directededges().size());
     node.set_timezone(baseni.timezone());
-    node.set_admin_index(tilebuilder->AddAdmin(admin.country_text(), admin.state_text(),
+    node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
                                                admin.country_iso(), admin.state_iso()));
 
     // Update node LL based on tile base
@@ -219,7 +224,7 @@ void FormTilesInNewLevel(GraphReader& reader,
     uint32_t density1 = baseni.density();
 
     // Current edge count
-    size_t edge_count = tilebuilder->directededges().size();
+    size_t edge_count = tilebuilder.directededges().size();
 
     // Iterate through directed edges of the base node to get remaining
     // directed edges (based on classification/importance cutoff)
@@ -227,7 +232,7 @@ void FormTilesInNewLevel(GraphReader& reader,
     for (uint32_t i = 0; i < baseni.edge_count(); i++, ++base_edge_id) {
       // Check if the directed edge should exist on this level
       const DirectedEdge* directededge = tile->directededge(base_edge_id);
-      if (!include_edge(directededge, base_node, current_level)) {
+      if (!IncludeEdge(old_to_new, directededge, base_node, current_level)) {
         continue;
       }
 
@@ -273,13 +278,13 @@ void FormTilesInNewLevel(GraphReader& reader,
         if (signs.size() == 0) {
           LOG_ERROR("Base edge should have signs, but none found");
         }
-        tilebuilder->AddSigns(tilebuilder->directededges().size(), signs);
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
 
       // Get turn lanes from the base directed edge
       if (directededge->turnlanes()) {
         uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
-        tilebuilder->AddTurnLanes(tilebuilder->directededges().size(), tile->GetName(offset));
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
       }
 
       // Get access restrictions from the base directed edge. Add these to
@@ -288,7 +293,7 @@ void FormTilesInNewLevel(GraphReader& reader,
       if (directededge->access_restriction()) {
         auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
         for (const auto& res : restrictions) {
-          tilebuilder->AddAccessRestriction(AccessRestriction(tilebuilder->directededges().size(),
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
                                                               res.type(), res.modes(), res.value()));
         }
       }
@@ -300,9 +305,9 @@ void FormTilesInNewLevel(GraphReader& reader,
           LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
         for (auto& lc : laneconnectivity) {
-          lc.set_to(tilebuilder->directededges().size());
+          lc.set_to(tilebuilder.directededges().size());
         }
-        tilebuilder->AddLaneConnectivity(laneconnectivity);
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
       }
 
       // Do we need to force adding edgeinfo (opposing edge could have diff names)?
@@ -319,7 +324,7 @@ void FormTilesInNewLevel(GraphReader& reader,
       std::string encoded_shape = edgeinfo.encoded_shape();
       uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
       uint32_t edge_info_offset =
-          tilebuilder->AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+          tilebuilder.AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
                                    edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
                                    edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
                                    edgeinfo.GetTaggedValues(true), edgeinfo.GetTypes(), added,
@@ -328,34 +333,34 @@ void FormTilesInNewLevel(GraphReader& reader,
       newedge.set_edgeinfo_offset(edge_info_offset);
 
       // Add directed edge
-      tilebuilder->directededges().emplace_back(std::move(newedge));
+      tilebuilder.directededges().emplace_back(std::move(newedge));
     }
 
     // Add node transitions
-    uint32_t index = tilebuilder->transitions().size();
+    uint32_t index = tilebuilder.transitions().size();
     auto new_nodes = find_nodes(old_to_new, base_node);
     if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddDownwardTransition(new_nodes.arterial_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 1) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 2) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddUpwardTransition(new_nodes.arterial_node, &tilebuilder);
     } else {
       throw std::logic_error("current_level was never set");
     }
 
     // Set the node transition count and index
-    uint32_t count = tilebuilder->transitions().size() - index;
+    uint32_t count = tilebuilder.transitions().size() - index;
     if (count > 0) {
       node.set_transition_count(count);
       node.set_transition_index(index);
     }
 
     // Set the edge count for the new node
-    node.set_edge_count(tilebuilder->directededges().size() - edge_count);
+    node.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
     // Get named signs from the base node
     if (baseni.named_intersection()) {
@@ -364,14 +369,118 @@ void FormTilesInNewLevel(GraphReader& reader,
         LOG_ERROR("Base node should have signs, but none found");
       }
       node.set_named_intersection(true);
-      tilebuilder->AddSigns(tilebuilder->nodes().size() - 1, signs);
+      tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
+    }
+  }
+
+  // Store the tile
+  tilebuilder.StoreTileData();
+
+  // Check if we need to clear the base/local tile cache
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+}
+
+// Form tiles in the new level. Every new tile is built by one thread from its range of the
+// sorted new to old sequence.
+void FormTilesInNewLevel(TaskPool& pool,
+                         const boost::property_tree::ptree& pt,
+                         const std::string& new_to_old_file,
+                         const std::string& old_to_new_file) {
+  // Find the range of new nodes of each tile. They have been sorted by level so that
+  // highway level is done first.
+  std::vector<NewTile> upper_tiles, local_tiles;
+  {
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    std::vector<NewTile>* tiles = nullptr;
+    size_t index = 0;
+    for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++, index++) {
+      GraphId tile_id = (*new_node).first.Tile_Base();
+      if (tiles == nullptr || tiles->back().tile_id != tile_id) {
+        tiles = tile_id.level() == TileHierarchy::levels().back().level ? &local_tiles
+                                                                        : &upper_tiles;
+        tiles->push_back({tile_id, index, index});
+      }
+      tiles->back().end = index + 1;
+    }
+  }
+
+  // Build the highway and arterial tiles before the local tiles. They read the base tiles which
+  // get replaced by the new local tiles. Each new local tile only reads the base tile it replaces.
+  for (const auto* tiles : {&upper_tiles, &local_tiles}) {
+    pool.Run("FormTilesInNewLevel", tiles->size(), [&](TaskPool::Worker& worker) {
+      GraphReader reader(pt.get_child("mjolnir"));
+      sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+      sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+      size_t task;
+      while (worker.next(task)) {
+        FormTileInNewLevel(reader, new_to_old, old_to_new, (*tiles)[task]);
+      }
+    });
+  }
+}
+
+// Find the hierarchy levels each node of a base tile exists on.
+void GetNodeLevels(GraphReader& reader,
+                   const GraphId& base_tile_id,
+                   std::vector<NodeLevels>& node_levels) {
+  node_levels.clear();
+
+  // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+  graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
+  if (!tile) {
+    return;
+  }
+
+  // Hierarchy level information
+  const auto& arterial_level = TileHierarchy::levels()[1];
+  const auto& highway_level = TileHierarchy::levels()[0];
+
+  // Iterate through the nodes. Add nodes to the new level when
+  // best road class <= the new level classification cutoff
+  bool levels[3];
+  uint32_t nodecount = tile->header()->nodecount();
+  node_levels.reserve(nodecount);
+  GraphId basenode = base_tile_id;
+  GraphId edgeid = base_tile_id;
+  PointLL base_ll = tile->header()->base_ll();
+  const NodeInfo* nodeinfo = tile->node(basenode);
+  for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
+    // Iterate through the edges to see which levels this node exists.
+    levels[0] = levels[1] = levels[2] = false;
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
+      // Update the flag for the level of this edge (skip transit
+      // connection edges)
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      if (directededge->bss_connection()) {
+        // Despite the road class, Bike Share Stations' connections are always at local level
+        levels[2] = true;
+      } else if (directededge->use() != Use::kTransitConnection &&
+                 directededge->use() != Use::kEgressConnection &&
+                 directededge->use() != Use::kPlatformConnection) {
+        levels[TileHierarchy::get_level(directededge->classification())] = true;
+      }
     }
+
+    // Find the tiles of the new nodes on the highway and arterial levels
+    NodeLevels node{};
+    node.highway = levels[0];
+    node.arterial = levels[1];
+    node.local = levels[2];
+    node.density = nodeinfo->density();
+    if (levels[0]) {
+      node.highway_tile = highway_level.tiles.TileId(nodeinfo->latlng(base_ll));
+    }
+    if (levels[1]) {
+      node.arterial_tile = arterial_level.tiles.TileId(nodeinfo->latlng(base_ll));
+    }
+    node_levels.push_back(node);
   }
 
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
+  // Check if we need to clear the tile cache
+  if (reader.OverCommitted()) {
+    reader.Trim();
   }
 }
 
@@ -380,9 +489,12 @@ void FormTilesInNewLevel(GraphReader& reader,
  * hierarchy levels and the existing nodes on the base/local level. The
  * associations go both ways: from the "old" nodes on the base/local level
  * to new nodes (using a mapping in memory) and from new nodes to old nodes
- * using a sequence (file).
+ * using a sequence (file). The levels of the nodes are found for batches of
+ * tiles concurrently, new node Ids are then handed out in tile order.
  */
-void CreateNodeAssociations(GraphReader& reader,
+void CreateNodeAssociations(TaskPool& pool,
+                            const boost::property_tree::ptree& pt,
+                            GraphReader& reader,
                             const std::string& new_to_old_file,
                             const std::string& old_to_new_file) {
   // Map of tiles vs. count of nodes. Used to construct new node Ids.
@@ -409,141 +521,135 @@ void CreateNodeAssociations(GraphReader& reader,
   sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
 
   // Hierarchy level information
-  const auto& arterial_level = TileHierarchy::levels()[1];
-  uint32_t al = static_cast<uint32_t>(arterial_level.level);
-  const auto& highway_level = TileHierarchy::levels()[0];
-  uint32_t hl = static_cast<uint32_t>(highway_level.level);
-
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet();
-  for (const auto& base_tile_id : local_tiles) {
-    // We keep all transit data inside the transit hierarchy
-    if (base_tile_id.level() == TileHierarchy::GetTransitLevel().level) {
-      continue;
+  uint32_t al = static_cast<uint32_t>(TileHierarchy::levels()[1].level);
+  uint32_t hl = static_cast<uint32_t>(TileHierarchy::levels()[0].level);
+
+  // All tiles in the local level. We keep all transit data inside the transit hierarchy
+  std::vector<GraphId> local_tiles;
+  for (const auto& base_tile_id : reader.GetTileSet()) {
+    if (base_tile_id.level() != TileHierarchy::GetTransitLevel().level) {
+      local_tiles.push_back(base_tile_id);
     }
+  }
 
-    // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
-    graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
-    if (!tile) {
-      continue;
-    }
-
-    // Iterate through the nodes. Add nodes to the new level when
-    // best road class <= the new level classification cutoff
-    bool levels[3];
-    uint32_t nodecount = tile->header()->nodecount();
-    GraphId basenode = base_tile_id;
-    GraphId edgeid = base_tile_id;
-    PointLL base_ll = tile->header()->base_ll();
-    const NodeInfo* nodeinfo = tile->node(basenode);
-    for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
-      // Iterate through the edges to see which levels this node exists.
-      levels[0] = levels[1] = levels[2] = false;
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
-        // Update the flag for the level of this edge (skip transit
-        // connection edges)
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (directededge->bss_connection()) {
-          // Despite the road class, Bike Share Stations' connections are always at local level
-          levels[2] = true;
-        } else if (directededge->use() != Use::kTransitConnection &&
-                   directededge->use() != Use::kEgressConnection &&
-                   directededge->use() != Use::kPlatformConnection) {
-          levels[TileHierarchy::get_level(directededge->classification())] = true;
-        }
-      }
-
-      // Associate new nodes to base nodes and base node to new nodes
-      GraphId highway_node, arterial_node, local_node;
-      if (levels[0]) {
-        // New node is on the highway level. Associate back to base/local node
-        GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
-        highway_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(highway_node, basenode));
+  // Every thread keeps its reader for all the batches
+  std::vector<std::unique_ptr<GraphReader>> readers(pool.concurrency());
+  std::vector<std::vector<NodeLevels>> batch(pool.concurrency() * kTilesPerThread);
+  TaskStats stats;
+  for (size_t first = 0; first < local_tiles.size(); first += batch.size()) {
+    size_t count = std::min(batch.size(), local_tiles.size() - first);
+    stats += pool.Run("", count, [&](TaskPool::Worker& worker) {
+      auto& tile_reader = readers[worker.id()];
+      if (!tile_reader) {
+        tile_reader.reset(new GraphReader(pt.get_child("mjolnir")));
       }
-      if (levels[1]) {
-        // New node is on the arterial level. Associate back to base/local node
-        GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
-        arterial_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(arterial_node, basenode));
-      }
-      if (levels[2]) {
-        // New node is on the local level. Associate back to base/local node
-        local_node = get_new_node(base_tile_id);
-        new_to_old.push_back(std::make_pair(local_node, basenode));
-      }
-
-      if (!levels[0] && !levels[1] && !levels[2]) {
-        LOG_ERROR("No valid level for this node!");
+      size_t task;
+      while (worker.next(task)) {
+        GetNodeLevels(*tile_reader, local_tiles[first + task], batch[task]);
       }
+    });
+
+    // Associate new nodes to base nodes and base node to new nodes
+    for (size_t i = 0; i < count; ++i) {
+      const auto& base_tile_id = local_tiles[first + i];
+      GraphId basenode = base_tile_id;
+      for (const auto& node : batch[i]) {
+        GraphId highway_node, arterial_node, local_node;
+        if (node.highway) {
+          // New node is on the highway level. Associate back to base/local node
+          highway_node = get_new_node(GraphId(node.highway_tile, hl, 0));
+          new_to_old.push_back(std::make_pair(highway_node, basenode));
+        }
+        if (node.arterial) {
+          // New node is on the arterial level. Associate back to base/local node
+          arterial_node = get_new_node(GraphId(node.arterial_tile, al, 0));
+          new_to_old.push_back(std::make_pair(arterial_node, basenode));
+        }
+        if (node.local) {
+          // New node is on the local level. Associate back to base/local node
+          local_node = get_new_node(base_tile_id);
+          new_to_old.push_back(std::make_pair(local_node, basenode));
+        }
 
-      // Associate the old node to the new node(s). Entries in the tuple
-      // that are invalid nodes indicate no node exists in the new level.
-      OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
-      old_to_new.push_back(assoc);
-    }
+        if (!node.highway && !node.arterial && !node.local) {
+          LOG_ERROR("No valid level for this node!");
+        }
 
-    // Check if we need to clear the tile cache
-    if (reader.OverCommitted()) {
-      reader.Trim();
+        // Associate the old node to the new node(s). Entries in the tuple
+        // that are invalid nodes indicate no node exists in the new level.
+        OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, node.density);
+        old_to_new.push_back(assoc);
+        ++basenode;
+      }
     }
   }
+  stats.Log("CreateNodeAssociations", pool.concurrency());
 }
 
 /**
  * Update end nodes of transit connection directed edges.
  */
-void UpdateTransitConnections(GraphReader& reader, const std::string& old_to_new_file) {
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-
+void UpdateTransitConnections(TaskPool& pool,
+                              const boost::property_tree::ptree& pt,
+                              GraphReader& reader,
+                              const std::string& old_to_new_file) {
   uint8_t transit_level = TileHierarchy::GetTransitLevel().level;
-  auto transit_tiles = reader.GetTileSet(transit_level);
-  for (const auto& tile_id : transit_tiles) {
-    // Skip if no nodes exist in the tile
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    if (!tile) {
-      continue;
-    }
+  auto tile_set = reader.GetTileSet(transit_level);
+  std::vector<GraphId> transit_tiles(tile_set.begin(), tile_set.end());
+  pool.Run("UpdateTransitConnections", transit_tiles.size(), [&](TaskPool::Worker& worker) {
+    GraphReader transit_reader(pt.get_child("mjolnir"));
+
+    // Use the sorted sequence that associates old nodes to new nodes
+    sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+
+    size_t task;
+    while (worker.next(task)) {
+      const auto& tile_id = transit_tiles[task];
+      // Skip if no nodes exist in the tile
+      graph_tile_ptr tile = transit_reader.GetGraphTile(tile_id);
+      if (!tile) {
+        continue;
+      }
 
-    // Create a new tile builder
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-
-    // Update end nodes of transit connection directed edges
-    std::vector<NodeInfo> nodes;
-    std::vector<DirectedEdge> directededges;
-    for (uint32_t i = 0; i < tilebuilder.header()->nodecount(); i++) {
-      NodeInfo nodeinfo = tilebuilder.node(i);
-      uint32_t idx = nodeinfo.edge_index();
-      for (uint32_t j = 0; j < nodeinfo.edge_count(); j++, idx++) {
-        DirectedEdge directededge = tilebuilder.directededge(idx);
-
-        // Update the end node of any transit connection edge
-        if (directededge.use() == Use::kTransitConnection) {
-          // Get the updated end node
-          auto f = find_nodes(old_to_new, directededge.endnode());
-          GraphId new_end_node;
-          if (f.local_node.Is_Valid()) {
-            new_end_node = f.local_node;
-          } else if (f.arterial_node.Is_Valid()) {
-            new_end_node = f.arterial_node;
-          } else if (f.highway_node.Is_Valid()) {
-            new_end_node = f.highway_node;
-          } else {
-            LOG_ERROR("Transit Connection does not connect to valid node");
+      // Create a new tile builder
+      GraphTileBuilder tilebuilder(transit_reader.tile_dir(), tile_id, false);
+
+      // Update end nodes of transit connection directed edges
+      std::vector<NodeInfo> nodes;
+      std::vector<DirectedEdge> directededges;
+      for (uint32_t i = 0; i < tilebuilder.header()->nodecount(); i++) {
+        NodeInfo nodeinfo = tilebuilder.node(i);
+        uint32_t idx = nodeinfo.edge_index();
+        for (uint32_t j = 0; j < nodeinfo.edge_count(); j++, idx++) {
+          DirectedEdge directededge = tilebuilder.directededge(idx);
+
+          // Update the end node of any transit connection edge
+          if (directededge.use() == Use::kTransitConnection) {
+            // Get the updated end node
+            auto f = find_nodes(old_to_new, directededge.endnode());
+            GraphId new_end_node;
+            if (f.local_node.Is_Valid()) {
+              new_end_node = f.local_node;
+            } else if (f.arterial_node.Is_Valid()) {
+              new_end_node = f.arterial_node;
+            } else if (f.highway_node.Is_Valid()) {
+              new_end_node = f.highway_node;
+            } else {
+              LOG_ERROR("Transit Connection does not connect to valid node");
+            }
+            directededge.set_endnode(new_end_node);
           }
-          directededge.set_endnode(new_end_node);
+
+          // Add the directed edge to the local list
+          directededges.emplace_back(std::move(directededge));
         }
 
-        // Add the directed edge to the local list
-        directededges.emplace_back(std::move(directededge));
+        // Add the node to the local list
+        nodes.emplace_back(std::move(nodeinfo));
       }
-
-      // Add the node to the local list
-      nodes.emplace_back(std::move(nodeinfo));
+      tilebuilder.Update(nodes, directededges);
     }
-    tilebuilder.Update(nodes, directededges);
-  }
+  });
 }
 
 // Remove any base tiles that no longer have any data (nodes and edges
@@ -586,22 +692,20 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
                              const std::string& new_to_old_file,
                              const std::string& old_to_new_file) {
 
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
-
   // Construct GraphReader
   LOG_INFO("HierarchyBuilder");
   GraphReader reader(pt.get_child("mjolnir"));
+  auto& pool = TaskPool::get(pt);
 
   // Association of old nodes to new nodes
-  CreateNodeAssociations(reader, new_to_old_file, old_to_new_file);
+  CreateNodeAssociations(pool, pt, reader, new_to_old_file, old_to_new_file);
 
   // Sort the sequences
-  SortSequences(new_to_old_file, old_to_new_file);
+  SortSequences(new_to_old_file, old_to_new_file, pool.concurrency());
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, new_to_old_file, old_to_new_file);
+  FormTilesInNewLevel(pool, pt, new_to_old_file, old_to_new_file);
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
@@ -611,7 +715,7 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
   auto hierarchy_properties = pt.get_child("mjolnir");
   auto transit_dir = hierarchy_properties.get_optional<std::string>("transit_dir");
   if (transit_dir && filesystem::exists(*transit_dir) && filesystem::is_directory(*transit_dir)) {
-    UpdateTransitConnections(reader, old_to_new_file);
+    UpdateTransitConnections(pool, pt, reader, old_to_new_file);
   }
 
   LOG_INFO("Done HierarchyBuilder");
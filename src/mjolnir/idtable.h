@@ -2,14 +2,18 @@
 #define VALHALLA_MJOLNIR_IDTABLE_H
 
 #include <algorithm>
+#include <bitset>
 #include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include <robin_hood.h>
 
 #include <midgard/logging.h>
+#include <midgard/sequence.h>
 
 namespace valhalla {
 namespace mjolnir {
@@ -107,6 +111,262 @@ private:
   robin_hood::unordered_map<uint64_t, uint64_t> bitmarkers_;
 };
 
+
+/**
+ * Compact read only set of ids, built once from the ids in increasing order. The ids are Elias-Fano
+ * coded: the low bits of each id are packed in an array and the high bits are unary coded in a bit
+ * vector, so that each id takes about 2 + log2(universe / count) bits instead of 64. Besides
+ * membership it answers rank (the dense index of an id among the ids in the set) and select (the id
+ * at a dense index) so that it can also be used to remap sparse ids to dense indices and back.
+ *
+ * The table is written to a file by the Writer and then memory mapped, so the pages of the table
+ * are only resident while they are being used.
+ */
+class CompactIdTable final {
+public:
+  /**
+   * Builds the table from ids given in increasing order and writes it to a file.
+   */
+  class Writer {
+  public:
+    /**
+     * Constructor
+     * @param file_name  the file to write the table to
+     * @param max_count  the maximum number of ids that will be added
+     * @param universe   all ids added must be less than this
+     */
+    Writer(const std::string& file_name, const uint64_t max_count, const uint64_t universe)
+        : file_name_(file_name), max_count_(max_count), universe_(universe), count_(0), last_(0) {
+      low_bits_ = 0;
+      while (max_count_ && (universe_ / max_count_) >> (low_bits_ + 1)) {
+        ++low_bits_;
+      }
+      high_bits_ = max_count_ + (universe_ >> low_bits_) + 1;
+      highs_.resize((high_bits_ + 63) / 64, 0);
+      lows_.resize((max_count_ * low_bits_ + 63) / 64, 0);
+    }
+
+    /**
+     * Adds an id, they must come in increasing order. Adding the previous id again is a no-op.
+     * @param id  the id to add
+     */
+    void add(const uint64_t id) {
+      if (count_ && id == last_) {
+        return;
+      }
+      if ((count_ && id < last_) || id >= universe_ || count_ == max_count_) {
+        throw std::runtime_error("CompactIdTable ids must be increasing and within the bounds");
+      }
+      uint64_t high = (id >> low_bits_) + count_;
+      highs_[high / 64] |= uint64_t(1) << (high % 64);
+      if (low_bits_) {
+        uint64_t low = id & ((uint64_t(1) << low_bits_) - 1);
+        uint64_t bit = count_ * low_bits_;
+        lows_[bit / 64] |= low << (bit % 64);
+        if (bit % 64 + low_bits_ > 64) {
+          lows_[bit / 64 + 1] |= low >> (64 - bit % 64);
+        }
+      }
+      last_ = id;
+      ++count_;
+    }
+
+    /**
+     * Samples the positions of the ones and zeros of the high bits for fast select and writes the
+     * table to the file.
+     */
+    void finish() {
+      // only the part of the high bits that is used needs to be kept
+      uint64_t used_bits = count_ + (universe_ >> low_bits_) + 1;
+      highs_.resize((used_bits + 63) / 64);
+      lows_.resize((count_ * low_bits_ + 63) / 64);
+
+      std::vector<uint64_t> ones, zeros;
+      uint64_t one_count = 0, zero_count = 0;
+      for (uint64_t bit = 0; bit < used_bits; ++bit) {
+        if (highs_[bit / 64] & (uint64_t(1) << (bit % 64))) {
+          if (one_count++ % kSampleRate == 0) {
+            ones.push_back(bit);
+          }
+        } else if (zero_count++ % kSampleRate == 0) {
+          zeros.push_back(bit);
+        }
+      }
+
+      std::ofstream file(file_name_, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) {
+        throw std::runtime_error("Could not open " + file_name_ + " for writing");
+      }
+      uint64_t header[kHeaderSize] = {count_,        universe_,    low_bits_,
+                                      highs_.size(), lows_.size(), ones.size(),
+                                      zeros.size()};
+      file.write(reinterpret_cast<const char*>(header), sizeof(header));
+      for (const auto* words : {&highs_, &lows_, &ones, &zeros}) {
+        file.write(reinterpret_cast<const char*>(words->data()), words->size() * sizeof(uint64_t));
+      }
+      if (!file) {
+        throw std::runtime_error("Could not write " + file_name_);
+      }
+    }
+
+  protected:
+    std::string file_name_;
+    uint64_t max_count_, universe_, count_, last_, low_bits_, high_bits_;
+    std::vector<uint64_t> highs_, lows_;
+  };
+
+  /**
+   * Memory maps a table written by the Writer
+   * @param file_name  the file the table was written to
+   */
+  explicit CompactIdTable(const std::string& file_name) {
+    std::ifstream file(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      throw std::runtime_error("Could not open " + file_name);
+    }
+    size_t words = static_cast<size_t>(file.tellg()) / sizeof(uint64_t);
+    file.close();
+    if (words < kHeaderSize) {
+      throw std::runtime_error(file_name + " is not a CompactIdTable");
+    }
+    memmap_.map_readonly(file_name, words, POSIX_MADV_RANDOM);
+
+    const uint64_t* header = memmap_.get();
+    count_ = header[0];
+    universe_ = header[1];
+    low_bits_ = header[2];
+    highs_ = header + kHeaderSize;
+    lows_ = highs_ + header[3];
+    ones_ = lows_ + header[4];
+    zeros_ = ones_ + header[5];
+    zero_samples_ = header[6];
+    if (zeros_ + zero_samples_ != header + words) {
+      throw std::runtime_error(file_name + " has an incorrect size");
+    }
+  }
+
+  /**
+   * @return the number of ids in the table
+   */
+  uint64_t size() const {
+    return count_;
+  }
+
+  /**
+   * Test if the id is in the table and get its dense index
+   * @param  id     the id to look for
+   * @param  index  set to the dense index of the id, the number of smaller ids in the table
+   * @return true if the id is in the table
+   */
+  bool find(const uint64_t id, uint64_t& index) const {
+    if (id >= universe_) {
+      index = count_;
+      return false;
+    }
+    // the ids with the same high bits follow the zero that ends the previous high bits
+    uint64_t high = id >> low_bits_;
+    uint64_t bit = high == 0 ? 0 : select0(high - 1) + 1;
+    index = bit - high;
+    uint64_t low = id & low_mask();
+    for (; highs_[bit / 64] & (uint64_t(1) << (bit % 64)); ++bit, ++index) {
+      uint64_t candidate = get_low(index);
+      if (candidate >= low) {
+        return candidate == low;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Test if the id is in the table
+   * @param  id  the id to look for
+   * @return true if the id is in the table
+   */
+  bool get(const uint64_t id) const {
+    uint64_t index;
+    return find(id, index);
+  }
+
+  /**
+   * @param  id  an id, in the table or not
+   * @return the number of ids in the table that are smaller than it
+   */
+  uint64_t rank(const uint64_t id) const {
+    uint64_t index;
+    find(id, index);
+    return index;
+  }
+
+  /**
+   * @param  index  a dense index, less than size()
+   * @return the id at the dense index
+   */
+  uint64_t select(const uint64_t index) const {
+    uint64_t high = select1(index) - index;
+    return (high << low_bits_) | get_low(index);
+  }
+
+protected:
+  // the number of ones and zeros between two samples of their positions
+  static constexpr uint64_t kSampleRate = 256;
+  // count, universe, low bits and the sizes of the 4 arrays
+  static constexpr size_t kHeaderSize = 7;
+
+  uint64_t low_mask() const {
+    return low_bits_ ? (uint64_t(-1) >> (64 - low_bits_)) : 0;
+  }
+
+  uint64_t get_low(const uint64_t index) const {
+    if (!low_bits_) {
+      return 0;
+    }
+    uint64_t bit = index * low_bits_;
+    uint64_t low = lows_[bit / 64] >> (bit % 64);
+    if (bit % 64 + low_bits_ > 64) {
+      low |= lows_[bit / 64 + 1] << (64 - bit % 64);
+    }
+    return low & low_mask();
+  }
+
+  // position of the nth one or zero of the high bits starting from the closest sample
+  template <bool one> uint64_t select(const uint64_t* samples, uint64_t n) const {
+    uint64_t bit = samples[n / kSampleRate];
+    n %= kSampleRate;
+    uint64_t word = one ? highs_[bit / 64] : ~highs_[bit / 64];
+    word &= uint64_t(-1) << (bit % 64);
+    while (true) {
+      auto count = static_cast<uint64_t>(std::bitset<64>(word).count());
+      if (n < count) {
+        break;
+      }
+      n -= count;
+      bit = (bit / 64 + 1) * 64;
+      word = one ? highs_[bit / 64] : ~highs_[bit / 64];
+    }
+    // drop the lower set bits of the word until we are at the one we want
+    for (; n; --n) {
+      word &= word - 1;
+    }
+    // and the number of zeros below it is its position in the word
+    return (bit / 64) * 64 + static_cast<uint64_t>(std::bitset<64>((word & (~word + 1)) - 1).count());
+  }
+
+  uint64_t select1(const uint64_t n) const {
+    return select<true>(ones_, n);
+  }
+
+  uint64_t select0(const uint64_t n) const {
+    return select<false>(zeros_, n);
+  }
+
+  midgard::mem_map<uint64_t> memmap_;
+  uint64_t count_, universe_, low_bits_, zero_samples_;
+  const uint64_t* highs_;
+  const uint64_t* lows_;
+  const uint64_t* ones_;
+  const uint64_t* zeros_;
+};
+
 } // namespace mjolnir
 } // namespace valhalla
 
@@ -33,12 +33,15 @@
 #else
 #include <netinet/in.h>
 #endif
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <zlib.h>
 
 #include "midgard/logging.h"
 #include "mjolnir/osmpbfparser.h"
+#include "mjolnir/taskpool.h"
 
 using namespace OSMPBF;
 
@@ -81,9 +84,7 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
+int32_t read_blob(char* buffer, std::ifstream& file, const BlobHeader& header) {
   // is the size of the following blob sane
   int32_t sz = header.datasize();
   if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
@@ -94,6 +95,11 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   if (!file.read(buffer, sz)) {
     throw std::runtime_error("unable to read blob from file");
   }
+  return sz;
+}
+
+int32_t unpack_blob(const char* buffer, int32_t sz, char* unpack_buffer) {
+  Blob blob;
 
   // turn it into a protobuf object
   if (!blob.ParseFromArray(buffer, sz)) {
@@ -107,7 +113,7 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    memcpy(unpack_buffer, blob.raw().data(), sz);
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
@@ -139,6 +145,11 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   throw std::runtime_error("Unsupported blob data format");
 }
 
+int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
+  int32_t sz = read_blob(buffer, file, header);
+  return unpack_blob(buffer, sz, unpack_buffer);
+}
+
 template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::PrimitiveBlock& primblock) {
   OSMPBF::Tags result(object.keys_size());
   for (int i = 0; i < object.keys_size(); ++i) {
@@ -272,6 +283,109 @@ void parse_header_block(char* unpack_buffer, int32_t sz) {
   // TODO: do something with replication information?
 }
 
+// the number of blocks each thread of the pool decodes per batch when parsing on a pool
+constexpr size_t kBlocksPerThread = 4;
+
+// keeps what a primitive block hands to the callbacks so that blocks can be decoded on any thread
+// and then handed to the real callbacks in file order. the consumers transforms are applied to
+// the tags of ways and relations while recording so that they run concurrently as well
+struct recorder_t : public Callback {
+  recorder_t(Callback& consumer) : consumer(consumer), thread(0) {
+  }
+
+  virtual void
+  node_callback(const uint64_t osmid, const double lng, const double lat, const Tags& tags) override {
+    order.push_back(NODES);
+    nodes.push_back({osmid, lng, lat, tags});
+  }
+
+  virtual void
+  way_callback(const uint64_t osmid, const Tags& tags, const std::vector<uint64_t>& refs) override {
+    order.push_back(WAYS);
+    ways.push_back({osmid, tags, refs});
+    consumer.way_transform(thread, osmid, ways.back().tags, ways.back().refs);
+  }
+
+  virtual void relation_callback(const uint64_t osmid,
+                                 const Tags& tags,
+                                 const std::vector<Member>& members) override {
+    order.push_back(RELATIONS);
+    relations.push_back({osmid, tags, {}});
+    auto& relation = relations.back();
+    relation.members.reserve(members.size());
+    for (const auto& member : members) {
+      relation.members.emplace_back(member.member_type, member.member_id, member.role);
+    }
+    consumer.relation_transform(thread, osmid, relation.tags, relation.members);
+  }
+
+  virtual void changeset_callback(const uint64_t changeset_id) override {
+    order.push_back(CHANGESETS);
+    changesets.push_back(changeset_id);
+  }
+
+  // hands everything to the consumer in the order it was recorded
+  void replay() const {
+    auto node = nodes.cbegin();
+    auto way = ways.cbegin();
+    auto relation = relations.cbegin();
+    auto changeset = changesets.cbegin();
+    for (auto interest : order) {
+      switch (interest) {
+        case NODES:
+          consumer.node_callback(node->osmid, node->lng, node->lat, node->tags);
+          ++node;
+          break;
+        case WAYS:
+          consumer.way_callback(way->osmid, way->tags, way->refs);
+          ++way;
+          break;
+        case RELATIONS:
+          consumer.relation_callback(relation->osmid, relation->tags, relation->members);
+          ++relation;
+          break;
+        default:
+          consumer.changeset_callback(*changeset);
+          ++changeset;
+          break;
+      }
+    }
+  }
+
+  // drops what was recorded but keeps the allocations around for the next block
+  void clear() {
+    order.clear();
+    nodes.clear();
+    ways.clear();
+    relations.clear();
+    changesets.clear();
+  }
+
+  struct node_t {
+    uint64_t osmid;
+    double lng, lat;
+    Tags tags;
+  };
+  struct way_t {
+    uint64_t osmid;
+    Tags tags;
+    std::vector<uint64_t> refs;
+  };
+  struct relation_t {
+    uint64_t osmid;
+    Tags tags;
+    std::vector<Member> members;
+  };
+
+  Callback& consumer;
+  size_t thread;
+  std::vector<Interest> order;
+  std::vector<node_t> nodes;
+  std::vector<way_t> ways;
+  std::vector<relation_t> relations;
+  std::vector<uint64_t> changesets;
+};
+
 } // namespace
 
 // extend the protobuf osmpbf namespace
@@ -319,6 +433,71 @@ void Parser::parse(std::ifstream& file, const Interest interest, Callback& callb
   delete[] unpack_buffer;
 }
 
+void Parser::parse(std::ifstream& file,
+                   const Interest interest,
+                   Callback& callback,
+                   valhalla::mjolnir::TaskPool& pool) {
+  // the blocks are read in batches, each batch is decoded on the pool and then replayed in order
+  const size_t batch_size = pool.concurrency() * kBlocksPerThread;
+  std::vector<BlobHeader> headers;
+  std::vector<std::string> blobs(batch_size);
+  std::vector<std::unique_ptr<recorder_t>> blocks;
+  for (size_t i = 0; i < batch_size; ++i) {
+    blocks.emplace_back(new recorder_t(callback));
+  }
+  std::vector<std::unique_ptr<char[]>> unpack_buffers(pool.concurrency());
+  std::unique_ptr<char[]> buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+
+  // start from the top
+  file.clear();
+  file.seekg(0, std::ios::beg);
+
+  // while there is more to read
+  bool finished = false;
+  while (!finished && !file.eof()) {
+    // grab the next batch of blob headers and the raw blobs that go with them
+    headers.clear();
+    while (headers.size() < batch_size && !file.eof()) {
+      BlobHeader header = read_header(buffer.get(), file, finished);
+      if (finished) {
+        break;
+      }
+      int32_t sz = read_blob(buffer.get(), file, header);
+      blobs[headers.size()].assign(buffer.get(), sz);
+      headers.emplace_back(std::move(header));
+    }
+
+    // unpack and decode them on the pool
+    pool.Run("", headers.size(), [&](valhalla::mjolnir::TaskPool::Worker& worker) {
+      auto& unpack_buffer = unpack_buffers[worker.id()];
+      if (!unpack_buffer) {
+        unpack_buffer.reset(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+      }
+      size_t i;
+      while (worker.next(i)) {
+        auto& block = *blocks[i];
+        block.clear();
+        block.thread = worker.id();
+        int32_t sz = unpack_blob(blobs[i].data(), blobs[i].size(), unpack_buffer.get());
+        if (headers[i].type() == "OSMData") {
+          parse_primitive_block(unpack_buffer.get(), sz, interest, block);
+        } else if (headers[i].type() == "OSMHeader") {
+          parse_header_block(unpack_buffer.get(), sz);
+        }
+      }
+    });
+
+    // hand them to the callback in file order
+    for (size_t i = 0; i < headers.size(); ++i) {
+      if (headers[i].type() == "OSMData") {
+        blocks[i]->replay();
+      } else if (headers[i].type() != "OSMHeader") {
+        LOG_WARN("Unknown blob type: " + headers[i].type());
+      }
+    }
+  }
+}
+
 void Parser::free() {
   google::protobuf::ShutdownProtobufLibrary();
 }
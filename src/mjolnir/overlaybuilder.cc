@@ -0,0 +1,154 @@
+#include "mjolnir/overlaybuilder.h"
+#include "mjolnir/taskpool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/overlaycell.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// A directed edge entering or leaving a cell
+struct BoundaryEdge {
+  uint64_t cellid;
+  uint64_t edgeid;
+  bool entry;
+};
+
+// The boundary edges of a cell
+struct CellBoundary {
+  std::vector<uint64_t> entries;
+  std::vector<uint64_t> exits;
+};
+
+// Finds the edges of a tile which cross the border of a cell, at every level they do
+std::vector<BoundaryEdge> find_boundary_edges(GraphReader& reader, const GraphId& tile_id) {
+  std::vector<BoundaryEdge> boundary;
+  auto tile = reader.GetGraphTile(tile_id);
+  GraphId node_id = tile_id;
+  for (uint32_t n = 0; n < tile->header()->nodecount(); ++n, ++node_id) {
+    const NodeInfo* node = tile->node(n);
+    const auto node_ll = node->latlng(tile->header()->base_ll());
+    GraphId edge_id(tile_id.tileid(), tile_id.level(), node->edge_index());
+    const DirectedEdge* edge = tile->directededge(node->edge_index());
+    for (uint32_t i = 0; i < node->edge_count(); ++i, ++edge, ++edge_id) {
+      // Shortcuts are not expanded by the cell searches, their edges are
+      if (edge->is_shortcut() || edge->IsTransitLine()) {
+        continue;
+      }
+      graph_tile_ptr end_tile = edge->leaves_tile() ? reader.GetGraphTile(edge->endnode()) : tile;
+      if (end_tile == nullptr) {
+        continue;
+      }
+      const auto end_ll = end_tile->get_node_ll(edge->endnode());
+      const uint32_t level = OverlayBoundaryLevel(node_ll, end_ll);
+      for (uint32_t l = 1; l <= level; ++l) {
+        boundary.push_back({OverlayCellId(node_ll, l).value, edge_id.value, false});
+        boundary.push_back({OverlayCellId(end_ll, l).value, edge_id.value, true});
+      }
+    }
+  }
+  return boundary;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void OverlayBuilder::Build(const boost::property_tree::ptree& pt) {
+  const std::string overlay_dir = pt.get<std::string>("mjolnir.overlay_dir", "");
+  if (overlay_dir.empty()) {
+    LOG_INFO("Skipping overlay builder");
+    return;
+  }
+
+  std::vector<GraphId> tiles;
+  uint64_t dataset_id = 0;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    const auto transit_level = TileHierarchy::GetTransitLevel().level;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      if (tile_id.level() != transit_level) {
+        tiles.push_back(tile_id);
+      }
+    }
+    if (!tiles.empty()) {
+      dataset_id = reader.GetGraphTile(tiles.front())->header()->dataset_id();
+    }
+  }
+
+  // Find the edges crossing the borders of the cells
+  auto& pool = TaskPool::get(pt);
+  LOG_INFO("Finding the boundary edges of " + std::to_string(tiles.size()) + " tiles with " +
+           std::to_string(pool.concurrency()) + " thread(s)");
+  std::vector<std::vector<BoundaryEdge>> tile_boundaries(tiles.size());
+  pool.Run("OverlayBuilder boundary", tiles.size(), [&](TaskPool::Worker& worker) {
+    GraphReader reader(pt.get_child("mjolnir"));
+    size_t task;
+    while (worker.next(task)) {
+      tile_boundaries[task] = find_boundary_edges(reader, tiles[task]);
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  });
+
+  // Gather them by cell
+  std::unordered_map<uint64_t, CellBoundary> boundaries;
+  for (auto& tile_boundary : tile_boundaries) {
+    for (const auto& b : tile_boundary) {
+      auto& cell = boundaries[b.cellid];
+      (b.entry ? cell.entries : cell.exits).push_back(b.edgeid);
+    }
+    std::vector<BoundaryEdge>().swap(tile_boundary);
+  }
+  std::vector<std::pair<const uint64_t, CellBoundary>*> cells;
+  cells.reserve(boundaries.size());
+  for (auto& cell : boundaries) {
+    cells.push_back(&cell);
+  }
+  LOG_INFO("Found the boundary edges of " + std::to_string(cells.size()) + " cells");
+
+  // Write one overlay cell per cell
+  pool.Run("OverlayBuilder store", cells.size(), [&](TaskPool::Worker& worker) {
+    size_t task;
+    while (worker.next(task)) {
+      const GraphId cellid(cells[task]->first);
+      auto& cell = cells[task]->second;
+      std::sort(cell.entries.begin(), cell.entries.end());
+      std::sort(cell.exits.begin(), cell.exits.end());
+
+      OverlayCellHeader header{cellid.value, dataset_id,
+                               static_cast<uint32_t>(cell.entries.size()),
+                               static_cast<uint32_t>(cell.exits.size())};
+      filesystem::path filename = overlay_dir + filesystem::path::preferred_separator +
+                                  GraphTile::FileSuffix(cellid, SUFFIX_OVERLAY);
+      if (!filesystem::exists(filename.parent_path())) {
+        filesystem::create_directories(filename.parent_path());
+      }
+      std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file " + filename.string());
+      }
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(cell.entries.data()),
+                 cell.entries.size() * sizeof(uint64_t));
+      file.write(reinterpret_cast<const char*>(cell.exits.data()),
+                 cell.exits.size() * sizeof(uint64_t));
+    }
+  });
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -2,10 +2,13 @@
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/util.h"
 
+#include "filesystem.h"
 #include "graph_lua_proc.h"
+#include "idtable.h"
 #include "mjolnir/luatagtransform.h"
 #include "mjolnir/osmaccess.h"
 #include "mjolnir/osmpronunciation.h"
+#include "mjolnir/taskpool.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
@@ -150,7 +153,7 @@ public:
   }
 
   graph_callback(const boost::property_tree::ptree& pt, OSMData& osmdata)
-      : lua_(get_lua(pt)), osmdata_(osmdata) {
+      : lua_script_(get_lua(pt)), lua_(lua_script_), transformed_(false), osmdata_(osmdata) {
     current_way_node_index_ = last_node_ = last_way_ = last_relation_ = 0;
 
     highway_cutoff_rc_ = RoadClass::kPrimary;
@@ -1483,28 +1486,14 @@ public:
       return; // we are done.
     }
 
-    // if we found all of the node ids we were looking for already we can bail
-    if (current_way_node_index_ >= way_nodes_->size()) {
-      return;
-    }
-
-    // if the current osmid of this node of this pbf file is greater than the waynode we are looking
-    // for then it must be in another pbf file. so we need to move on to the next waynode that could
-    // possibly actually be in this pbf file
-    if (osmid > (*(*way_nodes_)[current_way_node_index_]).node.osmid_) {
-      current_way_node_index_ = way_nodes_->find_first_of(
-          OSMWayNode{{osmid}},
-          [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ <= b.node.osmid_; },
-          current_way_node_index_);
-    }
-
-    // if this nodes id is less than the waynode we are looking for then we know its a node we can
-    // skip because it means there were no ways that we kept that referenced it. also we could run out
-    // of waynodes to look for and in that case we are done as well
-    if (current_way_node_index_ >= way_nodes_->size() ||
-        osmid < (*(*way_nodes_)[current_way_node_index_]).node.osmid_) {
+    // skip the node if none of the ways we kept referenced it. otherwise jump to the first of the
+    // waynodes that reference it, the index tells us where they start without looking at the
+    // waynodes so we dont have to scan through them
+    uint64_t node_index;
+    if (!node_ids_->find(osmid, node_index)) {
       return;
     }
+    current_way_node_index_ = way_node_index_->select(node_index);
 
     // Get tags if not already available.  Don't bother calling Lua if there
     // are no OSM tags to process.
@@ -1681,21 +1670,16 @@ public:
     osmdata_.edge_count -= intersection; // more accurate but undercounts by skipping lone edges
   }
 
-  virtual void way_callback(const uint64_t osmid,
-                            const OSMPBF::Tags& tags,
-                            const std::vector<uint64_t>& nodes) override {
-    osmid_ = osmid;
-
-    // unsorted extracts are just plain nasty, so they can bugger off!
-    if (osmid_ < last_way_) {
-      throw std::runtime_error("Detected unsorted input data");
-    }
-    last_way_ = osmid_;
-
+  // Filters out the ways that cannot be routable and transforms the tags of the rest. Returns no
+  // tags for the ways that should be thrown away
+  Tags transform_way(LuaTagTransform& lua,
+                     const uint64_t osmid,
+                     const OSMPBF::Tags& tags,
+                     const std::vector<uint64_t>& nodes) const {
     // Do not add ways with < 2 nodes. Log error or add to a problem list
     // TODO - find out if we do need these, why they exist...
     if (nodes.size() < 2) {
-      return;
+      return {};
     }
 
     // Throw away closed features with following tags: building, landuse,
@@ -1705,15 +1689,35 @@ public:
         if (tag.first == "building" || tag.first == "landuse" || tag.first == "leisure" ||
             tag.first == "natural") {
           // LOG_INFO("Loop wayid " + std::to_string(osmid) + " Discard?");
-          return;
+          return {};
         }
       }
     }
 
-    // Transform tags. If no results that means the way does not have tags
-    // suitable for use in routing.
-    Tags results =
-        tags.size() == 0 ? empty_way_results_ : lua_.Transform(OSMType::kWay, osmid_, tags);
+    return tags.size() == 0 ? empty_way_results_ : lua.Transform(OSMType::kWay, osmid, tags);
+  }
+
+  virtual void way_transform(const size_t thread,
+                             const uint64_t osmid,
+                             OSMPBF::Tags& tags,
+                             const std::vector<uint64_t>& nodes) override {
+    tags = transform_way(*thread_lua_[thread], osmid, tags, nodes);
+  }
+
+  virtual void way_callback(const uint64_t osmid,
+                            const OSMPBF::Tags& tags,
+                            const std::vector<uint64_t>& nodes) override {
+    osmid_ = osmid;
+
+    // unsorted extracts are just plain nasty, so they can bugger off!
+    if (osmid_ < last_way_) {
+      throw std::runtime_error("Detected unsorted input data");
+    }
+    last_way_ = osmid_;
+
+    // Transform tags, unless the parser already did it on its threads. If no results that means
+    // the way does not have tags suitable for use in routing.
+    Tags results = transformed_ ? tags : transform_way(lua_, osmid_, tags, nodes);
     if (results.size() == 0) {
       return;
     }
@@ -2196,6 +2200,18 @@ public:
     ways_->push_back(way_);
   }
 
+  // Transforms the tags of a relation, no tags means it is of no use
+  Tags transform_relation(LuaTagTransform& lua, const uint64_t osmid, const OSMPBF::Tags& tags) const {
+    return tags.empty() ? empty_relation_results_ : lua.Transform(OSMType::kRelation, osmid, tags);
+  }
+
+  virtual void relation_transform(const size_t thread,
+                                  const uint64_t osmid,
+                                  OSMPBF::Tags& tags,
+                                  const std::vector<OSMPBF::Member>& /*members*/) override {
+    tags = transform_relation(*thread_lua_[thread], osmid, tags);
+  }
+
   virtual void relation_callback(const uint64_t osmid,
                                  const OSMPBF::Tags& tags,
                                  const std::vector<OSMPBF::Member>& members) override {
@@ -2205,9 +2221,8 @@ public:
     }
     last_relation_ = osmid;
 
-    // Get tags
-    Tags results =
-        tags.empty() ? empty_relation_results_ : lua_.Transform(OSMType::kRelation, osmid, tags);
+    // Get tags, unless the parser already transformed them on its threads
+    Tags results = transformed_ ? tags : transform_relation(lua_, osmid, tags);
     if (results.size() == 0) {
       return;
     }
@@ -2644,6 +2659,18 @@ public:
     osmdata_.max_changeset_id_ = std::max(osmdata_.max_changeset_id_, changeset_id);
   }
 
+  // parses the file with the blocks decoded on the pool. each thread of the pool gets its own lua
+  // state so that the tags of ways and relations are transformed concurrently as well
+  void parse(std::ifstream& file, const OSMPBF::Interest interest, TaskPool& pool) {
+    while (thread_lua_.size() < pool.concurrency()) {
+      thread_lua_.emplace_back(new LuaTagTransform(lua_script_));
+    }
+    current_way_node_index_ = last_node_ = last_way_ = last_relation_ = 0;
+    transformed_ = true;
+    OSMPBF::Parser::parse(file, interest, *this, pool);
+    transformed_ = false;
+  }
+
   // lets the sequences be set and reset
   void reset(sequence<OSMWay>* ways,
              sequence<OSMWayNode>* way_nodes,
@@ -2986,8 +3013,13 @@ public:
   // Road class assignment needs to be set to the highway cutoff for ferries and auto trains.
   RoadClass highway_cutoff_rc_;
 
-  // Lua Tag Transformation class
+  // Lua Tag Transformation class, the script it runs and one more per thread of the pool when
+  // parsing on a pool
+  std::string lua_script_;
   LuaTagTransform lua_;
+  std::vector<std::unique_ptr<LuaTagTransform>> thread_lua_;
+  // whether the tags handed to the callbacks were transformed already
+  bool transformed_;
 
   // Pointer to all the OSM data (for use by callbacks)
   OSMData& osmdata_;
@@ -2998,6 +3030,10 @@ public:
   // When updating the references with the node information we keep the last index we looked at
   // this lets us only have to iterate over the whole set once
   size_t current_way_node_index_;
+  // The distinct node ids referenced by the way nodes and, at the dense index of each node id, the
+  // index of the first of the (sorted by node id) way nodes that reference it
+  std::unique_ptr<CompactIdTable> node_ids_;
+  std::unique_ptr<CompactIdTable> way_node_index_;
   uint64_t last_node_, last_way_, last_relation_;
   std::unordered_map<uint64_t, size_t> loop_nodes_;
 
@@ -3033,12 +3069,9 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
                                   const std::string& way_nodes_file,
                                   const std::string& access_file,
                                   const std::string& pronunciation_file) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // The blocks of the files are decoded and their tags transformed on the pool, the results are
+  // then added to the one osmdata in file order so they dont depend on the number of threads
+  auto& pool = TaskPool::get(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   OSMData osmdata{};
@@ -3064,12 +3097,10 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   // way's node list. Iterate through each pbf input file.
   LOG_INFO("Parsing ways...");
   for (auto& file_handle : file_handles) {
-    callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
-        callback.last_relation_ = 0;
-    OSMPBF::Parser::parse(file_handle,
-                          static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
-                                                        OSMPBF::Interest::CHANGESETS),
-                          callback);
+    callback.parse(file_handle,
+                   static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
+                                                 OSMPBF::Interest::CHANGESETS),
+                   pool);
   }
 
   // Clarifies types of loop roads and saves fixed ways.
@@ -3083,15 +3114,16 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm access tags by way id...");
   {
     sequence<OSMAccess> access(access_file, false);
-    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
+    access.sort_by_key([](const OSMAccess& a) { return a.way_id(); },
+                       sequence<OSMAccess>::kSortBufferSize, pool.concurrency());
   }
 
   // we need to sort the pronunciation indexes so that we can easily find them.
   LOG_INFO("Sorting pronunciation indexes by way id...");
   {
     sequence<OSMPronunciation> pronunciation(pronunciation_file, false);
-    pronunciation.sort(
-        [](const OSMPronunciation& a, const OSMPronunciation& b) { return a.way_id() < b.way_id(); });
+    pronunciation.sort_by_key([](const OSMPronunciation& a) { return a.way_id(); },
+                              sequence<OSMPronunciation>::kSortBufferSize, pool.concurrency());
   }
 
   LOG_INFO("Finished");
@@ -3106,12 +3138,9 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
                                     const std::string& complex_restriction_from_file,
                                     const std::string& complex_restriction_to_file,
                                     OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // The blocks of the files are decoded and their tags transformed on the pool, the results are
+  // then added to the one osmdata in file order so they dont depend on the number of threads
+  auto& pool = TaskPool::get(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -3139,12 +3168,10 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   // Parse relations.
   LOG_INFO("Parsing relations...");
   for (auto& file_handle : file_handles) {
-    callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
-        callback.last_relation_ = 0;
-    OSMPBF::Parser::parse(file_handle,
-                          static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
-                                                        OSMPBF::Interest::CHANGESETS),
-                          callback);
+    callback.parse(file_handle,
+                   static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
+                                                 OSMPBF::Interest::CHANGESETS),
+                   pool);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) + " simple restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
@@ -3156,16 +3183,18 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting complex restrictions by from id...");
   {
     sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
-    complex_restrictions_from.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+    complex_restrictions_from.sort([](const OSMRestriction& a,
+                                      const OSMRestriction& b) { return a < b; },
+                                   sequence<OSMRestriction>::kSortBufferSize, pool.concurrency());
   }
 
   // Sort complex restrictions. Keep this scoped so the file handles are closed when done sorting.
   LOG_INFO("Sorting complex restrictions by to id...");
   {
     sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
-    complex_restrictions_to.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+    complex_restrictions_to.sort([](const OSMRestriction& a,
+                                    const OSMRestriction& b) { return a < b; },
+                                 sequence<OSMRestriction>::kSortBufferSize, pool.concurrency());
   }
   LOG_INFO("Finished");
 }
@@ -3175,12 +3204,9 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
                                 const std::string& way_nodes_file,
                                 const std::string& bss_nodes_file,
                                 OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // The blocks of the files are decoded and their tags transformed on the pool, the results are
+  // then added to the one osmdata in file order so they dont depend on the number of threads
+  auto& pool = TaskPool::get(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -3206,13 +3232,10 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
 
     bool create = true;
     for (auto& file_handle : file_handles) {
-      callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
-          callback.last_relation_ = 0;
       // we send a null way_nodes file so that only the bike share stations are parsed
       callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
                      new sequence<OSMNode>(bss_nodes_file, create));
-      OSMPBF::Parser::parse(file_handle, static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES),
-                            callback);
+      callback.parse(file_handle, static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES), pool);
       create = false;
     }
     // Since the sequence must be flushed before reading it...
@@ -3228,10 +3251,36 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by node id...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort(
-        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; });
+    way_nodes.sort_by_key([](const OSMWayNode& a) { return a.node.osmid_; },
+                          sequence<OSMWayNode>::kSortBufferSize, pool.concurrency());
   }
 
+  // index the node ids referenced by the way nodes and where the way nodes of each start. the
+  // tables are compact (a few bits per node) and memory mapped so the lookups while parsing nodes
+  // dont need to scan through the way nodes
+  LOG_INFO("Indexing osm way node references...");
+  const std::string node_ids_file = way_nodes_file + ".ids";
+  const std::string way_node_index_file = way_nodes_file + ".idx";
+  {
+    sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+    uint64_t universe = way_nodes.size() ? way_nodes.back().node.osmid_ + 1 : 0;
+    CompactIdTable::Writer node_ids(node_ids_file, way_nodes.size(), universe);
+    CompactIdTable::Writer way_node_index(way_node_index_file, way_nodes.size(), way_nodes.size());
+    uint64_t way_node_count = 0, last_osmid = 0;
+    for (const OSMWayNode way_node : way_nodes) {
+      if (way_node_count == 0 || way_node.node.osmid_ != last_osmid) {
+        last_osmid = way_node.node.osmid_;
+        node_ids.add(last_osmid);
+        way_node_index.add(way_node_count);
+      }
+      ++way_node_count;
+    }
+    node_ids.finish();
+    way_node_index.finish();
+  }
+  callback.node_ids_.reset(new CompactIdTable(node_ids_file));
+  callback.way_node_index_.reset(new CompactIdTable(way_node_index_file));
+
   // Parse node in all the input files. Skip any that are not marked from
   // being used in a way.
   // TODO: we know how many knows we expect, stop early once we have that many
@@ -3241,15 +3290,17 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
     // because osm node ids are only sorted at the single pbf file level
     callback.reset(nullptr, new sequence<OSMWayNode>(way_nodes_file, false), nullptr, nullptr,
                    nullptr, nullptr, nullptr);
-    callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
-        callback.last_relation_ = 0;
-    OSMPBF::Parser::parse(file_handle,
-                          static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
-                                                        OSMPBF::Interest::CHANGESETS),
-                          callback);
+    callback.parse(file_handle,
+                   static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
+                                                 OSMPBF::Interest::CHANGESETS),
+                   pool);
   }
   uint64_t max_osm_id = callback.last_node_;
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+  callback.node_ids_.reset();
+  callback.way_node_index_.reset();
+  filesystem::remove(node_ids_file);
+  filesystem::remove(way_node_index_file);
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_node_count) +
            " nodes contained in routable ways");
 
@@ -3258,13 +3309,12 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by way index and node shape index...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
-      if (a.way_index == b.way_index) {
-        // TODO: if its equal we have screwed something up, should we check and throw here?
-        return a.way_shape_node_index < b.way_shape_node_index;
-      }
-      return a.way_index < b.way_index;
-    });
+    // TODO: if two are equal we have screwed something up, should we check and throw here?
+    way_nodes.sort_by_key(
+        [](const OSMWayNode& a) {
+          return (static_cast<uint64_t>(a.way_index) << 32) | a.way_shape_node_index;
+        },
+        sequence<OSMWayNode>::kSortBufferSize, pool.concurrency());
   }
 
   // Some OSM extracts do not have changeset Ids. For these set the max changeset Id
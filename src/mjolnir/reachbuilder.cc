@@ -0,0 +1,127 @@
+#include "mjolnir/reachbuilder.h"
+#include "mjolnir/graphtilebuilder.h"
+#include "mjolnir/taskpool.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "baldr/edgereach.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "baldr/tilehierarchy.h"
+#include "loki/reach.h"
+#include "midgard/logging.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::loki;
+using namespace valhalla::mjolnir;
+using namespace valhalla::sif;
+
+namespace {
+
+// Creates the costings with the same default options a request without costing options gets
+std::array<cost_ptr_t, kReachModeCount> default_costings() {
+  rapidjson::Document doc;
+  doc.SetObject();
+  CostFactory factory;
+  std::array<cost_ptr_t, kReachModeCount> costings;
+  for (size_t i = 0; i < kReachModeCount; ++i) {
+    valhalla::Costing costing;
+    const auto& costing_str = valhalla::Costing_Enum_Name(kReachCostings[i]);
+    ParseCosting(doc, "/costing_options/" + costing_str, &costing, kReachCostings[i]);
+    costings[i] = factory.Create(costing);
+    if (static_cast<size_t>(costings[i]->travel_mode()) != i) {
+      throw std::logic_error("Travel mode of " + costing_str + " costing does not match its reach");
+    }
+  }
+  return costings;
+}
+
+// Computes the reach of all directed edges of a tile
+std::vector<EdgeReach> compute_reach(GraphReader& reader,
+                                     Reach& reach_finder,
+                                     const std::array<cost_ptr_t, kReachModeCount>& costings,
+                                     const GraphId& tile_id,
+                                     const uint32_t max_reach) {
+  auto tile = reader.GetGraphTile(tile_id);
+  std::vector<EdgeReach> reaches(tile->header()->directededgecount(), EdgeReach{});
+  GraphId edge_id = tile_id;
+  for (uint32_t i = 0; i < reaches.size(); ++i, ++edge_id) {
+    const DirectedEdge* edge = tile->directededge(i);
+    for (size_t mode = 0; mode < kReachModeCount; ++mode) {
+      // loki only asks for the reach of edges the costing allows
+      if (!costings[mode]->Allowed(edge, tile, kDisallowShortcut)) {
+        continue;
+      }
+      auto reach = reach_finder(edge, edge_id, max_reach, reader, costings[mode]);
+      reaches[i].outbound[mode] = static_cast<uint8_t>(std::min<uint32_t>(reach.outbound, max_reach));
+      reaches[i].inbound[mode] = static_cast<uint8_t>(std::min<uint32_t>(reach.inbound, max_reach));
+    }
+  }
+  return reaches;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ReachBuilder::Build(const boost::property_tree::ptree& pt) {
+  const uint32_t max_reach = pt.get<uint32_t>("mjolnir.max_edge_reach", 0);
+  if (max_reach == 0) {
+    LOG_INFO("Skipping reach builder");
+    return;
+  }
+  if (max_reach > kMaxStoredReach) {
+    throw std::runtime_error("mjolnir.max_edge_reach must not be above " +
+                             std::to_string(kMaxStoredReach));
+  }
+
+  // Reach is computed on the whole graph before any tile is rewritten, the
+  // expansions run into neighbouring tiles which have to stay readable
+  std::vector<GraphId> tiles;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    const auto transit_level = TileHierarchy::GetTransitLevel().level;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      if (tile_id.level() != transit_level) {
+        tiles.push_back(tile_id);
+      }
+    }
+  }
+  std::sort(tiles.begin(), tiles.end());
+
+  auto& pool = TaskPool::get(pt);
+  LOG_INFO("Computing the reach of " + std::to_string(tiles.size()) + " tiles up to " +
+           std::to_string(max_reach) + " nodes with " + std::to_string(pool.concurrency()) +
+           " thread(s)");
+  std::vector<std::vector<EdgeReach>> reaches(tiles.size());
+  pool.Run("ReachBuilder compute", tiles.size(), [&](TaskPool::Worker& worker) {
+    GraphReader reader(pt.get_child("mjolnir"));
+    Reach reach_finder;
+    const auto costings = default_costings();
+    size_t task;
+    while (worker.next(task)) {
+      reaches[task] = compute_reach(reader, reach_finder, costings, tiles[task], max_reach);
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  });
+
+  pool.Run("ReachBuilder store", tiles.size(), [&](TaskPool::Worker& worker) {
+    const std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+    size_t task;
+    while (worker.next(task)) {
+      GraphTileBuilder tilebuilder(tile_dir, tiles[task], false);
+      tilebuilder.UpdateEdgeReach(max_reach, reaches[task]);
+      std::vector<EdgeReach>().swap(reaches[task]);
+    }
+  });
+}
+
+} // namespace mjolnir
+} // namespace valhalla
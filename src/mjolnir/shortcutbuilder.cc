@@ -1,8 +1,10 @@
 #include "mjolnir/shortcutbuilder.h"
 #include "mjolnir/graphtilebuilder.h"
+#include "mjolnir/taskpool.h"
 
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <ostream>
@@ -17,6 +19,7 @@
 #include "baldr/graphreader.h"
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -581,156 +584,192 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   return shortcut_count;
 }
 
-// Form shortcuts for tiles in this level.
-uint32_t FormShortcuts(GraphReader& reader, const TileLevel& level) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for one tile and store the new tile below out_dir.
+uint32_t FormShortcuts(GraphReader& reader, const GraphId& tile_id, const std::string& out_dir) {
+  // Get the graph tile. Skip if no tile exists
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  if (!tile) {
+    return 0;
+  }
+
   bool added = false;
   uint32_t shortcut_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
-  uint32_t tile_level = (uint32_t)level.level;
-  graph_tile_ptr tile;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
-    // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
-    if (!tile) {
-      continue;
-    }
 
-    // Create GraphTileBuilder for the new tile
-    GraphId new_tile(tileid, tile_level, 0);
-    GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
+  // Create GraphTileBuilder for the new tile
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
 
-    // Since the old tile is not serialized we must copy any data that is not
-    // dependent on edge Id into the new builders (e.g., node transitions)
-    if (tile->header()->transitioncount() > 0) {
-      for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
-        tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
-      }
+  // Since the old tile is not serialized we must copy any data that is not
+  // dependent on edge Id into the new builders (e.g., node transitions)
+  if (tile->header()->transitioncount() > 0) {
+    for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
+      tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
     }
+  }
 
-    // Iterate through the nodes in the tile
-    GraphId node_id(tileid, tile_level, 0);
-    for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
-      // Get the node info, copy node index and count from old tile
-      NodeInfo nodeinfo = *(tile->node(node_id));
-      uint32_t old_edge_index = nodeinfo.edge_index();
-      uint32_t old_edge_count = nodeinfo.edge_count();
-
-      // Update node information
-      const auto& admin = tile->admininfo(nodeinfo.admin_index());
-      nodeinfo.set_edge_index(tilebuilder.directededges().size());
-      nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                    admin.country_iso(), admin.state_iso()));
-
-      // Current edge count
-      size_t edge_count = tilebuilder.directededges().size();
-
-      // Add shortcut edges first.
-      std::unordered_map<uint32_t, uint32_t> shortcuts;
-      shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                         old_edge_count, shortcuts);
-
-      // Copy the rest of the directed edges from this node
-      GraphId edgeid(tileid, tile_level, old_edge_index);
-      for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
-        // Copy the directed edge information and update end node,
-        // edge data offset, and opp_index
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        DirectedEdge newedge = *directededge;
-
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
-        }
+  // Iterate through the nodes in the tile
+  GraphId node_id = tile_id;
+  for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
+    // Get the node info, copy node index and count from old tile
+    NodeInfo nodeinfo = *(tile->node(node_id));
+    uint32_t old_edge_index = nodeinfo.edge_index();
+    uint32_t old_edge_count = nodeinfo.edge_count();
+
+    // Update node information
+    const auto& admin = tile->admininfo(nodeinfo.admin_index());
+    nodeinfo.set_edge_index(tilebuilder.directededges().size());
+    nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                  admin.country_iso(), admin.state_iso()));
+
+    // Current edge count
+    size_t edge_count = tilebuilder.directededges().size();
+
+    // Add shortcut edges first.
+    std::unordered_map<uint32_t, uint32_t> shortcuts;
+    shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
+                                       old_edge_count, shortcuts);
+
+    // Copy the rest of the directed edges from this node
+    GraphId edgeid(tile_id.tileid(), tile_id.level(), old_edge_index);
+    for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
+      // Copy the directed edge information and update end node,
+      // edge data offset, and opp_index
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      DirectedEdge newedge = *directededge;
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      // Get signs from the base directed edge
+      if (directededge->sign()) {
+        std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+        if (signs.size() == 0) {
+          LOG_ERROR("Base edge should have signs, but none found");
         }
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+      }
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
-          }
-        }
+      // Get turn lanes from the base directed edge
+      if (directededge->turnlanes()) {
+        uint32_t offset = tile->turnlanes_offset(edgeid.id());
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      }
 
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
-          }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
+      // Get access restrictions from the base directed edge. Add these to
+      // the list of access restrictions in the new tile. Update the
+      // edge index in the restriction to be the current directed edge Id
+      if (directededge->access_restriction()) {
+        auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+        for (const auto& res : restrictions) {
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
+      }
 
-        // Get edge info, shape, and names from the old tile and add
-        // to the new. Use prior edgeinfo offset as the key to make sure
-        // edges that have the same end nodes are differentiated (this
-        // should be a valid key since tile sizes aren't changed)
-        auto edgeinfo = tile->edgeinfo(directededge);
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
-                                    edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                    edgeinfo.bike_network(), edgeinfo.speed_limit(),
-                                    edgeinfo.encoded_shape(), edgeinfo.GetNames(),
-                                    edgeinfo.GetTaggedValues(), edgeinfo.GetTaggedValues(true),
-                                    edgeinfo.GetTypes(), added);
-        newedge.set_edgeinfo_offset(edge_info_offset);
-
-        // Set the superseded mask - this is the shortcut mask that supersedes this edge
-        // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
-        // from a node has been exceeded.
-        auto s = shortcuts.find(i);
-        uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
-        if (superseded_idx <= kMaxShortcutsFromNode) {
-          newedge.set_superseded(superseded_idx);
+      // Copy lane connectivity
+      if (directededge->laneconnectivity()) {
+        auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+        if (laneconnectivity.size() == 0) {
+          LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
+        for (auto& lc : laneconnectivity) {
+          lc.set_to(tilebuilder.directededges().size());
+        }
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
+      }
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
+      // Get edge info, shape, and names from the old tile and add
+      // to the new. Use prior edgeinfo offset as the key to make sure
+      // edges that have the same end nodes are differentiated (this
+      // should be a valid key since tile sizes aren't changed)
+      auto edgeinfo = tile->edgeinfo(directededge);
+      uint32_t edge_info_offset =
+          tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
+                                  edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                  edgeinfo.bike_network(), edgeinfo.speed_limit(),
+                                  edgeinfo.encoded_shape(), edgeinfo.GetNames(),
+                                  edgeinfo.GetTaggedValues(), edgeinfo.GetTaggedValues(true),
+                                  edgeinfo.GetTypes(), added);
+      newedge.set_edgeinfo_offset(edge_info_offset);
+
+      // Set the superseded mask - this is the shortcut mask that supersedes this edge
+      // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
+      // from a node has been exceeded.
+      auto s = shortcuts.find(i);
+      uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
+      if (superseded_idx <= kMaxShortcutsFromNode) {
+        newedge.set_superseded(superseded_idx);
       }
 
-      // Set the edge count for the new node
-      nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+    }
 
-      // Get named signs from the base node
-      if (nodeinfo.named_intersection()) {
+    // Set the edge count for the new node
+    nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
-        std::vector<SignInfo> signs = tile->GetSigns(n, true);
-        if (signs.size() == 0) {
-          LOG_ERROR("Base node should have signs, but none found");
-        }
-        tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
+    // Get named signs from the base node
+    if (nodeinfo.named_intersection()) {
+
+      std::vector<SignInfo> signs = tile->GetSigns(n, true);
+      if (signs.size() == 0) {
+        LOG_ERROR("Base node should have signs, but none found");
       }
-      tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+      tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
     }
+    tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+  }
+
+  // Store the new tile
+  tilebuilder.StoreTileData(out_dir);
+  LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
+             tilebuilder.header_builder().end_offset())
+                .str());
 
-    // Store the new tile
-    tilebuilder.StoreTileData();
-    LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
-               tilebuilder.header_builder().end_offset())
-                  .str());
+  // Check if we need to clear the tile cache.
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+  return shortcut_count;
+}
 
-    // Check if we need to clear the tile cache.
-    if (reader.OverCommitted()) {
-      reader.Trim();
+// Form shortcuts for tiles in this level.
+uint32_t FormShortcuts(TaskPool& pool,
+                       const boost::property_tree::ptree& pt,
+                       GraphReader& reader,
+                       const TileLevel& level) {
+  // Iterate through the tiles at this level (TODO - can we mark the tiles
+  // the tiles that shortcuts end within?)
+  auto tile_set = reader.GetTileSet(level.level);
+  std::vector<GraphId> tiles(tile_set.begin(), tile_set.end());
+  std::sort(tiles.begin(), tiles.end());
+
+  // Shortcuts run into the neighbouring tiles, so those have to be read as they were before this
+  // level got its shortcuts. The new tiles are written to a staging directory and only moved into
+  // place once all tiles of the level are done.
+  const std::string staging_dir =
+      reader.tile_dir() + filesystem::path::preferred_separator + ".shortcuts";
+  std::vector<uint32_t> shortcut_counts(pool.concurrency(), 0);
+  pool.Run("FormShortcuts", tiles.size(), [&](TaskPool::Worker& worker) {
+    GraphReader tile_reader(pt.get_child("mjolnir"));
+    size_t task;
+    while (worker.next(task)) {
+      shortcut_counts[worker.id()] += FormShortcuts(tile_reader, tiles[task], staging_dir);
+    }
+  });
+
+  // Move the new tiles into place
+  for (const auto& tile_id : tiles) {
+    std::string suffix = GraphTile::FileSuffix(tile_id);
+    std::string staged = staging_dir + filesystem::path::preferred_separator + suffix;
+    if (filesystem::exists(staged) &&
+        !filesystem::rename(staged,
+                            reader.tile_dir() + filesystem::path::preferred_separator + suffix)) {
+      throw std::runtime_error("Could not move " + staged + " into the tile directory");
     }
   }
+  filesystem::remove_all(staging_dir);
+
+  uint32_t shortcut_count = 0;
+  for (auto count : shortcut_counts) {
+    shortcut_count += count;
+  }
   return shortcut_count;
 }
 
@@ -744,19 +783,16 @@ namespace mjolnir {
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
 
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
   // Get GraphReader
   GraphReader reader(pt.get_child("mjolnir"));
+  auto& pool = TaskPool::get(pt);
 
   auto tile_level = TileHierarchy::levels().rbegin();
   tile_level++;
   for (; tile_level != TileHierarchy::levels().rend(); ++tile_level) {
     // Create shortcuts on this level
     LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level->level));
-    uint32_t count = FormShortcuts(reader, *tile_level);
+    uint32_t count = FormShortcuts(pool, pt, reader, *tile_level);
     LOG_INFO("Finished with " + std::to_string(count) + " shortcuts");
   }
 }
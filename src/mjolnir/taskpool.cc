@@ -0,0 +1,246 @@
+#include "mjolnir/taskpool.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "midgard/logging.h"
+
+namespace {
+
+double seconds_since(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+TaskStats& TaskStats::operator+=(const TaskStats& other) {
+  tasks += other.tasks;
+  steals += other.steals;
+  seconds += other.seconds;
+  if (thread_seconds.size() < other.thread_seconds.size()) {
+    thread_seconds.resize(other.thread_seconds.size(), 0);
+  }
+  for (size_t i = 0; i < other.thread_seconds.size(); ++i) {
+    thread_seconds[i] += other.thread_seconds[i];
+  }
+  if (!thread_seconds.empty()) {
+    const auto minmax = std::minmax_element(thread_seconds.cbegin(), thread_seconds.cend());
+    idlest_seconds = *minmax.first;
+    busiest_seconds = *minmax.second;
+  }
+  if (other.slowest_task_seconds > slowest_task_seconds) {
+    slowest_task_seconds = other.slowest_task_seconds;
+    slowest_task = other.slowest_task;
+  }
+  return *this;
+}
+
+void TaskStats::Log(const std::string& name, size_t concurrency) const {
+  std::stringstream summary;
+  summary << name << ": " << tasks << " tasks on " << concurrency << " threads in " << seconds
+          << "s with " << steals << " steals. Busiest thread " << busiest_seconds
+          << "s, idlest thread " << idlest_seconds << "s, slowest task " << slowest_task
+          << " took " << slowest_task_seconds << "s";
+  LOG_INFO(summary.str());
+}
+
+TaskPool::TaskPool(size_t concurrency) {
+  concurrency = std::max(concurrency, size_t(1));
+  for (size_t i = 0; i < concurrency; ++i) {
+    workers_.emplace_back(new Worker(*this, i));
+  }
+  for (size_t i = 0; i < concurrency; ++i) {
+    threads_.emplace_back(&TaskPool::loop, this, i);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  work_ready_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+TaskPool& TaskPool::get(const boost::property_tree::ptree& pt) {
+  const auto& config = pt.get_child("mjolnir", pt);
+  size_t concurrency =
+      std::max(static_cast<unsigned int>(1),
+               config.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+
+  // stages run one after the other so we only resize the pool between runs
+  static std::mutex pool_mutex;
+  static std::unique_ptr<TaskPool> pool;
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  if (!pool || pool->concurrency() != concurrency) {
+    pool.reset();
+    pool.reset(new TaskPool(concurrency));
+  }
+  return *pool;
+}
+
+TaskStats TaskPool::Run(const std::string& name, size_t task_count, const work_t& work) {
+  auto start = std::chrono::steady_clock::now();
+
+  // Divvy up the work, the workers are all idle at this point so no need to lock
+  size_t floor = task_count / workers_.size();
+  size_t at_ceiling = task_count - (workers_.size() * floor);
+  size_t range_end = 0;
+  for (auto& worker : workers_) {
+    worker->begin_ = range_end;
+    range_end += worker->id_ < at_ceiling ? floor + 1 : floor;
+    worker->end_ = range_end;
+    worker->in_task_ = false;
+    worker->steals_ = 0;
+    worker->busy_seconds_ = 0;
+    worker->slowest_seconds_ = 0;
+    worker->slowest_task_ = 0;
+  }
+  error_ = nullptr;
+  failed_ = false;
+
+  // Wake everyone up and wait for all of them to finish
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_ = &work;
+    ++run_;
+    running_ = workers_.size();
+    work_ready_.notify_all();
+    work_done_.wait(lock, [this]() { return running_ == 0; });
+    work_ = nullptr;
+  }
+
+  // Gather up the statistics
+  TaskStats stats;
+  stats.tasks = task_count;
+  stats.seconds = seconds_since(start);
+  stats.idlest_seconds = workers_.front()->busy_seconds_;
+  stats.thread_seconds.reserve(workers_.size());
+  for (const auto& worker : workers_) {
+    stats.steals += worker->steals_;
+    stats.thread_seconds.push_back(worker->busy_seconds_);
+    stats.busiest_seconds = std::max(stats.busiest_seconds, worker->busy_seconds_);
+    stats.idlest_seconds = std::min(stats.idlest_seconds, worker->busy_seconds_);
+    if (worker->slowest_seconds_ > stats.slowest_task_seconds) {
+      stats.slowest_task_seconds = worker->slowest_seconds_;
+      stats.slowest_task = worker->slowest_task_;
+    }
+  }
+
+  if (!name.empty()) {
+    stats.Log(name, workers_.size());
+  }
+
+  // If something bad went down this will rethrow it
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+  return stats;
+}
+
+void TaskPool::loop(size_t id) {
+  uint64_t last_run = 0;
+  auto& worker = *workers_[id];
+  while (true) {
+    // Wait for a new run or for the pool to go away
+    const work_t* work = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock, [this, last_run]() { return shutdown_ || run_ != last_run; });
+      if (shutdown_) {
+        return;
+      }
+      last_run = run_;
+      work = work_;
+    }
+
+    // Whatever happens in Vegas..
+    try {
+      (*work)(worker);
+    } // ..gets sent back to the main thread
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      failed_ = true;
+    }
+    worker.finish_task();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0) {
+      work_done_.notify_all();
+    }
+  }
+}
+
+bool TaskPool::steal(Worker& thief, size_t& task) {
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto& victim = *workers_[(thief.id_ + i) % workers_.size()];
+    size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex_);
+      if (victim.begin_ == victim.end_) {
+        continue;
+      }
+      // Take the back half, the victim is working its way up from the front
+      end = victim.end_;
+      begin = victim.begin_ + (victim.end_ - victim.begin_) / 2;
+      victim.end_ = begin;
+    }
+
+    std::lock_guard<std::mutex> lock(thief.mutex_);
+    task = begin;
+    thief.begin_ = begin + 1;
+    thief.end_ = end;
+    ++thief.steals_;
+    return true;
+  }
+  return false;
+}
+
+bool TaskPool::Worker::next(size_t& task) {
+  finish_task();
+  if (pool_.failed_) {
+    return false;
+  }
+
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (begin_ < end_) {
+      task = begin_++;
+      found = true;
+    }
+  }
+  if (!found && !pool_.steal(*this, task)) {
+    return false;
+  }
+
+  in_task_ = true;
+  task_ = task;
+  task_start_ = clock_t::now();
+  return true;
+}
+
+void TaskPool::Worker::finish_task() {
+  if (!in_task_) {
+    return;
+  }
+  in_task_ = false;
+  auto elapsed = seconds_since(task_start_);
+  busy_seconds_ += elapsed;
+  if (elapsed > slowest_seconds_) {
+    slowest_seconds_ = elapsed;
+    slowest_task_ = task_;
+  }
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -7,6 +7,7 @@
 #include "midgard/point2.h"
 #include "midgard/polyline2.h"
 #include "mjolnir/bssbuilder.h"
+#include "mjolnir/contractionbuilder.h"
 #include "mjolnir/elevationbuilder.h"
 #include "mjolnir/graphbuilder.h"
 #include "mjolnir/graphenhancer.h"
@@ -14,7 +15,9 @@
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
 #include "mjolnir/osmpbfparser.h"
+#include "mjolnir/overlaybuilder.h"
 #include "mjolnir/pbfgraphparser.h"
+#include "mjolnir/reachbuilder.h"
 #include "mjolnir/restrictionbuilder.h"
 #include "mjolnir/shortcutbuilder.h"
 #include "mjolnir/transitbuilder.h"
@@ -393,6 +396,23 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     GraphValidator::Validate(config);
   }
 
+  // Precompute the reach of the edges. Needs the opposing edges and bins set by the validation
+  // and has to come after every stage which rewrites the tiles through the tile builders.
+  if (start_stage <= BuildStage::kReach && BuildStage::kReach <= end_stage) {
+    ReachBuilder::Build(config);
+  }
+
+  // Build the contraction hierarchy of the default auto costing. It is stored next to the
+  // tiles and only holds for the final tiles so it has to come last.
+  if (start_stage <= BuildStage::kContraction && BuildStage::kContraction <= end_stage) {
+    ContractionBuilder::Build(config);
+  }
+
+  // Build the overlay partition which thor customizes for the costing of a request
+  if (start_stage <= BuildStage::kOverlay && BuildStage::kOverlay <= end_stage) {
+    OverlayBuilder::Build(config);
+  }
+
   // Cleanup bin files
   if (start_stage <= BuildStage::kCleanup && BuildStage::kCleanup <= end_stage) {
     LOG_INFO("Cleaning up temporary *.bin files within " + tile_dir);
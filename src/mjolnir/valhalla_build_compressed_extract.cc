@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "baldr/compressedextract.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/util.h"
+
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+using namespace valhalla::baldr;
+
+filesystem::path config_file_path;
+std::string output_file;
+uint32_t dictionary_size = kMaxCompressedExtractDictionary;
+int level = 9;
+
+bool ParseArguments(int argc, char* argv[]) {
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_build_compressed_extract",
+      "valhalla_build_compressed_extract " VALHALLA_VERSION "\n\n"
+      "valhalla_build_compressed_extract is a program that compresses the tiles of the\n"
+      "tile_dir into a single extract, which can be used as the tile_extract. Every tile\n"
+      "is compressed on its own so it is only decompressed once it is first needed.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>())
+      ("o,output", "Path of the extract to write.", cxxopts::value<std::string>())
+      ("d,dictionary-size", "Bytes sampled from the tiles for the shared dictionary, up to 65536.",
+        cxxopts::value<uint32_t>(dictionary_size)->default_value("65536"))
+      ("l,level", "LZ4 HC compression level, from 1 to 12.",
+        cxxopts::value<int>(level)->default_value("9"));
+    // clang-format on
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("version")) {
+      std::cout << "valhalla_build_compressed_extract " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (!result.count("output")) {
+      std::cerr << "Output file is required\n\n" << options.help() << "\n\n";
+      return false;
+    }
+    output_file = result["output"].as<std::string>();
+
+    if (result.count("config") &&
+        filesystem::is_regular_file(config_file_path =
+                                        filesystem::path(result["config"].as<std::string>()))) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options.help() << "\n\n";
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+  }
+
+  return false;
+}
+
+int main(int argc, char** argv) {
+  // Parse command line arguments
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.string(), pt);
+
+  // configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree =
+      pt.get_child_optional("mjolnir.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // The tiles are always read from the tile_dir, whatever extract is configured
+  auto mjolnir = pt.get_child("mjolnir");
+  mjolnir.erase("tile_extract");
+  mjolnir.erase("traffic_extract");
+  const auto tile_dir = mjolnir.get<std::string>("tile_dir");
+  GraphReader reader(mjolnir);
+  const auto tiles = reader.GetTileSet();
+  if (tiles.empty()) {
+    LOG_ERROR("No tiles found in " + tile_dir);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    CompressedExtract::Build(tile_dir, tiles, output_file, dictionary_size, level);
+  } catch (const std::exception& e) {
+    LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
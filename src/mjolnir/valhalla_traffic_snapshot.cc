@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "baldr/rapidjson_utils.h"
+#include "baldr/trafficsnapshot.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+#include "midgard/util.h"
+
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+using namespace valhalla::baldr;
+
+filesystem::path config_file_path;
+std::vector<std::string> input_files;
+bool create = false;
+bool reset = false;
+uint32_t grace = 60;
+unsigned int num_threads = 1;
+
+namespace {
+
+struct stats {
+  std::atomic<uint64_t> updated{0};
+  std::atomic<uint64_t> unknown{0};
+  std::atomic<uint64_t> invalid{0};
+};
+
+// Parses an edge id given either as level/tileid/id or as the value of the id
+bool parse_edge_id(const char* begin, const char* end, GraphId& edge_id) {
+  const std::string value(begin, end);
+  try {
+    edge_id = value.find('/') != std::string::npos ? GraphId(value) : GraphId(std::stoull(value));
+  } catch (...) {
+    return false;
+  }
+  return edge_id.Is_Valid();
+}
+
+// Parses an unsigned number, an empty field gives 0
+bool parse_number(const char* begin, const char* end, uint32_t& number) {
+  number = 0;
+  for (const char* c = begin; c < end; ++c) {
+    if (*c < '0' || *c > '9' || number > 1000000) {
+      return false;
+    }
+    number = number * 10 + (*c - '0');
+  }
+  return true;
+}
+
+/**
+ * Writes the speeds of the rows of a piece of a CSV file into the buffer of a generation. The
+ * rows are edge_id,speed[,congestion] with the speed in kph, an empty speed leaving the speed of
+ * the edge unknown and a speed of 0 closing the edge. The congestion ranges from 1 (none) to 63
+ * (closed), 0 or nothing leaves it unknown.
+ */
+void update_speeds(const TrafficSnapshot& snapshot,
+                   const uint32_t generation,
+                   const char* begin,
+                   const char* end,
+                   stats& stat) {
+  while (begin < end) {
+    const char* line_end = std::find(begin, end, '\n');
+    const char* fields[3][2] = {};
+    size_t field_count = 0;
+    for (const char* field = begin; field_count < 3;) {
+      const char* field_end = std::find(field, line_end, ',');
+      fields[field_count][0] = field;
+      fields[field_count][1] = field_end;
+      ++field_count;
+      if (field_end == line_end) {
+        break;
+      }
+      field = field_end + 1;
+    }
+    // Trailing carriage returns of files written on windows
+    if (fields[field_count - 1][1] > fields[field_count - 1][0] &&
+        *(fields[field_count - 1][1] - 1) == '\r') {
+      --fields[field_count - 1][1];
+    }
+    begin = line_end + 1;
+
+    GraphId edge_id;
+    uint32_t speed = 0, congestion = 0;
+    if (field_count < 2 || !parse_edge_id(fields[0][0], fields[0][1], edge_id) ||
+        !parse_number(fields[1][0], fields[1][1], speed) ||
+        (field_count > 2 && !parse_number(fields[2][0], fields[2][1], congestion)) ||
+        congestion > MAX_CONGESTION_VAL) {
+      ++stat.invalid;
+      continue;
+    }
+    TrafficSpeed* target = snapshot.speed(generation, edge_id);
+    if (!target) {
+      ++stat.unknown;
+      continue;
+    }
+
+    // The whole record is written at once
+    TrafficSpeed traffic = *target;
+    if (fields[1][0] == fields[1][1]) {
+      traffic.overall_encoded_speed = UNKNOWN_TRAFFIC_SPEED_RAW;
+      traffic.encoded_speed1 = UNKNOWN_TRAFFIC_SPEED_RAW;
+      traffic.breakpoint1 = 0;
+    } else {
+      // The speed is stored in units of 2 kph where 0 closes the edge, so the slowest open edges
+      // are rounded up rather than closed
+      const uint32_t encoded = std::min<uint32_t>(speed, MAX_TRAFFIC_SPEED_KPH) >> 1;
+      traffic.overall_encoded_speed = speed == 0 ? 0 : std::max<uint32_t>(encoded, 1);
+      traffic.encoded_speed1 = traffic.overall_encoded_speed;
+      traffic.breakpoint1 = 255;
+    }
+    traffic.congestion1 = congestion;
+    *target = traffic;
+    ++stat.updated;
+  }
+}
+
+bool ParseArguments(int argc, char* argv[]) {
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_traffic_snapshot",
+      "valhalla_traffic_snapshot " VALHALLA_VERSION "\n\n"
+      "valhalla_traffic_snapshot is a program that writes live speeds into the idle buffer of\n"
+      "the traffic_snapshot and then publishes them, so that the services read them from their\n"
+      "next request on. The rows of the csv files are edge_id,speed[,congestion] with the edge\n"
+      "id as level/tileid/id and the speed in kph, 0 closes the edge.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>())
+      ("create", "Create the traffic_snapshot from the traffic_extract.",
+        cxxopts::value<bool>(create))
+      ("r,reset", "Leave the speeds of the edges missing from the csv files unknown rather than "
+        "keeping their current speeds.", cxxopts::value<bool>(reset))
+      ("g,grace", "Seconds requests may still read the buffer which is written, since it was "
+        "last published.", cxxopts::value<uint32_t>(grace)->default_value("60"))
+      ("j,concurrency", "Number of threads to use.",
+        cxxopts::value<unsigned int>(num_threads)->default_value(std::to_string(std::thread::hardware_concurrency())))
+      ("input_files", "positional arguments", cxxopts::value<std::vector<std::string>>(input_files));
+    // clang-format on
+
+    options.parse_positional({"input_files"});
+    options.positional_help("CSV file list");
+    auto result = options.parse(argc, argv);
+
+    if (result.count("version")) {
+      std::cout << "valhalla_traffic_snapshot " << VALHALLA_VERSION << "\n";
+      exit(EXIT_SUCCESS);
+    }
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      exit(EXIT_SUCCESS);
+    }
+
+    if (!create && input_files.empty()) {
+      std::cerr << "Input files are required unless creating the snapshot\n\n"
+                << options.help() << "\n\n";
+      return false;
+    }
+
+    if (result.count("config") &&
+        filesystem::is_regular_file(config_file_path =
+                                        filesystem::path(result["config"].as<std::string>()))) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options.help() << "\n\n";
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+  }
+
+  return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  // Parse command line arguments
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.string(), pt);
+
+  // configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree =
+      pt.get_child_optional("mjolnir.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  const auto snapshot_file = pt.get<std::string>("mjolnir.traffic_snapshot", "");
+  if (snapshot_file.empty()) {
+    LOG_ERROR("No traffic_snapshot configured");
+    return EXIT_FAILURE;
+  }
+
+  try {
+    if (create) {
+      TrafficSnapshot::Create(pt.get<std::string>("mjolnir.traffic_extract"), snapshot_file);
+      if (input_files.empty()) {
+        return EXIT_SUCCESS;
+      }
+    }
+    TrafficSnapshot snapshot(snapshot_file, false);
+
+    // Requests which started before the current generation was published may still read the
+    // buffer which is about to be written
+    const uint64_t now = std::time(nullptr);
+    const uint64_t idle = snapshot.published() + grace;
+    if (now < idle) {
+      LOG_INFO("Waiting " + std::to_string(idle - now) + " seconds for the idle buffer");
+      std::this_thread::sleep_for(std::chrono::seconds(idle - now));
+    }
+    const uint32_t generation = snapshot.Prepare(reset);
+
+    // Every thread takes a piece of the file ending at the end of a row
+    stats counts;
+    num_threads = std::max(num_threads, 1u);
+    for (const auto& input_file : input_files) {
+      struct stat s;
+      if (stat(input_file.c_str(), &s)) {
+        throw std::runtime_error("Could not open " + input_file);
+      }
+      if (s.st_size == 0) {
+        continue;
+      }
+      valhalla::midgard::mem_map<char> csv(input_file, s.st_size, POSIX_MADV_SEQUENTIAL, true);
+      const char* end = csv.get() + csv.size();
+      std::vector<const char*> pieces{csv.get()};
+      for (unsigned int i = 1; i < num_threads; ++i) {
+        const char* piece =
+            std::max<const char*>(pieces.back(), csv.get() + csv.size() * i / num_threads);
+        piece = std::find(piece, end, '\n');
+        pieces.push_back(piece == end ? end : piece + 1);
+      }
+      pieces.push_back(end);
+
+      std::vector<std::thread> threads;
+      for (size_t i = 1; i < pieces.size(); ++i) {
+        threads.emplace_back(update_speeds, std::cref(snapshot), generation, pieces[i - 1],
+                             pieces[i], std::ref(counts));
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+    LOG_INFO("Updated " + std::to_string(counts.updated) + " speeds, skipped " +
+             std::to_string(counts.unknown) + " unknown edges and " +
+             std::to_string(counts.invalid) + " invalid rows");
+
+    snapshot.Publish(generation);
+  } catch (const std::exception& e) {
+    LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -47,11 +47,15 @@ void DirectionsBuilder::Build(Api& api, const MarkupFormatter& markup_formatter)
         // Update the heading of ~0 length edges
         UpdateHeading(&etp);
 
-        ManeuversBuilder maneuversBuilder(options, &etp);
-        maneuvers = maneuversBuilder.Build();
+        {
+          auto maneuvers_time = measure_phase_time(api, "odin", "maneuversbuilder");
+          ManeuversBuilder maneuversBuilder(options, &etp);
+          maneuvers = maneuversBuilder.Build();
+        }
 
         // Create the instructions if desired
         if (options.directions_type() == DirectionsType::instructions) {
+          auto narrative_time = measure_phase_time(api, "odin", "narrative");
           std::unique_ptr<NarrativeBuilder> narrative_builder =
               NarrativeBuilderFactory::Create(options, &etp, markup_formatter);
           narrative_builder->Build(maneuvers);
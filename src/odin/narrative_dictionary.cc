@@ -1,3 +1,4 @@
+#include <cstring>
 #include <stdexcept>
 
 #include <boost/property_tree/ptree.hpp>
@@ -30,11 +31,93 @@ std::unordered_map<K, V> as_unordered_map(boost::property_tree::ptree const& pt,
   return items;
 }
 
+// Every tag a phrase may hold
+constexpr PhraseTag kPhraseTags[] = {kCardinalDirectionTag,
+                                     kRelativeDirectionTag,
+                                     kOrdinalValueTag,
+                                     kStreetNamesTag,
+                                     kPreviousStreetNamesTag,
+                                     kBeginStreetNamesTag,
+                                     kCrossStreetNamesTag,
+                                     kRoundaboutExitStreetNamesTag,
+                                     kRoundaboutExitBeginStreetNamesTag,
+                                     kRampExitNumbersVisualTag,
+                                     kLengthTag,
+                                     kDestinationTag,
+                                     kCurrentVerbalCueTag,
+                                     kNextVerbalCueTag,
+                                     kKilometersTag,
+                                     kMetersTag,
+                                     kMilesTag,
+                                     kTenthsOfMilesTag,
+                                     kFeetTag,
+                                     kNumberSignTag,
+                                     kBranchSignTag,
+                                     kTowardSignTag,
+                                     kNameSignTag,
+                                     kJunctionNameTag,
+                                     kFerryLabelTag,
+                                     kTransitPlatformTag,
+                                     kStationLabelTag,
+                                     kTimeTag,
+                                     kTransitNameTag,
+                                     kTransitHeadSignTag,
+                                     kTransitPlatformCountTag,
+                                     kTransitPlatformCountLabelTag,
+                                     kLevelTag};
+static_assert(sizeof(kPhraseTags) / sizeof(PhraseTag) == kPhraseTagCount,
+              "Every phrase tag has to be listed");
+
 } // namespace
 
 namespace valhalla {
 namespace odin {
 
+constexpr uint8_t PhraseTemplate::kLiteral;
+
+PhraseTemplate::PhraseTemplate(const std::string& phrase) : phrase_(phrase) {
+  // Split the phrase at its tags, the rest of it is kept as literal text
+  size_t literal = 0;
+  size_t pos = phrase_.find('<');
+  while (pos != std::string::npos) {
+    const PhraseTag* found = nullptr;
+    for (const auto& tag : kPhraseTags) {
+      if (phrase_.compare(pos, strlen(tag.text), tag.text) == 0) {
+        found = &tag;
+        break;
+      }
+    }
+    if (found == nullptr) {
+      pos = phrase_.find('<', pos + 1);
+      continue;
+    }
+    if (pos > literal) {
+      segments_.push_back({static_cast<uint32_t>(literal), static_cast<uint32_t>(pos - literal),
+                           kLiteral});
+    }
+    const size_t length = strlen(found->text);
+    segments_.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(length), found->slot});
+    literal = pos + length;
+    pos = phrase_.find('<', literal);
+  }
+  if (literal < phrase_.size()) {
+    segments_.push_back({static_cast<uint32_t>(literal),
+                         static_cast<uint32_t>(phrase_.size() - literal), kLiteral});
+  }
+}
+
+void PhraseTemplate::Format(std::string& out, const PhraseValues& values) const {
+  out.clear();
+  for (const auto& segment : segments_) {
+    const std::string* value = segment.slot == kLiteral ? nullptr : values.Get(segment.slot);
+    if (value) {
+      out.append(*value);
+    } else {
+      out.append(phrase_, segment.offset, segment.length);
+    }
+  }
+}
+
 NarrativeDictionary::NarrativeDictionary(const std::string& language_tag,
                                          const boost::property_tree::ptree& narrative_pt) {
   this->language_tag = language_tag;
@@ -341,6 +424,12 @@ void NarrativeDictionary::Load(PhraseSet& phrase_handle,
                                const boost::property_tree::ptree& phrase_pt) {
 
   phrase_handle.phrases = as_unordered_map<std::string, std::string>(phrase_pt, kPhrasesKey);
+
+  // Compile the phrases so they are not searched for their tags every time they are used
+  phrase_handle.templates.clear();
+  for (const auto& phrase : phrase_handle.phrases) {
+    phrase_handle.templates.emplace(phrase.first, PhraseTemplate(phrase.second));
+  }
 }
 
 void NarrativeDictionary::Load(StartSubset& start_handle,
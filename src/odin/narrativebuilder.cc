@@ -524,14 +524,16 @@ std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
   instruction.reserve(kInstructionInitialCapacity);
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.approach_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
-                                dictionary_.approach_verbal_alert_subset.us_customary_lengths));
-  boost::replace_all(instruction, kCurrentVerbalCueTag, verbal_cue);
+  PhraseValues values;
+  values.Set(kLengthTag,
+             FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
+                        dictionary_.approach_verbal_alert_subset.us_customary_lengths));
+  values.Set(kCurrentVerbalCueTag, verbal_cue);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.approach_verbal_alert_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -589,13 +591,14 @@ std::string NarrativeBuilder::FormStartInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  PhraseValues values;
+  values.Set(kCardinalDirectionTag, cardinal_direction);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.start_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -676,16 +679,18 @@ std::string NarrativeBuilder::FormVerbalStartInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  PhraseValues values;
+  values.Set(kCardinalDirectionTag, cardinal_direction);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+  values.Set(kLengthTag,
+             FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                        dictionary_.start_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.start_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -729,15 +734,17 @@ std::string NarrativeBuilder::FormDestinationInstruction(Maneuver& maneuver) {
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_subset.phrases.at(std::to_string(phrase_id));
-
+  // Replace phrase tags with values
+  PhraseValues values;
   if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    values.Set(kRelativeDirectionTag, relative_direction);
+    values.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  dictionary_.destination_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -785,15 +792,17 @@ std::string NarrativeBuilder::FormVerbalAlertDestinationInstruction(Maneuver& ma
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
+  // Replace phrase tags with values
+  PhraseValues values;
   if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    values.Set(kRelativeDirectionTag, relative_direction);
+    values.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  dictionary_.destination_verbal_alert_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -841,15 +850,17 @@ std::string NarrativeBuilder::FormVerbalDestinationInstruction(Maneuver& maneuve
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
+  // Replace phrase tags with values
+  PhraseValues values;
   if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    values.Set(kRelativeDirectionTag, relative_direction);
+    values.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  dictionary_.destination_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -871,12 +882,13 @@ std::string NarrativeBuilder::FormBecomesInstruction(Maneuver& maneuver, Maneuve
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  PhraseValues values;
+  values.Set(kPreviousStreetNamesTag, prev_street_names);
+  values.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.becomes_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -906,12 +918,14 @@ std::string NarrativeBuilder::FormVerbalBecomesInstruction(Maneuver& maneuver,
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  PhraseValues values;
+  values.Set(kPreviousStreetNamesTag, prev_street_names);
+  values.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.becomes_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -957,13 +971,14 @@ std::string NarrativeBuilder::FormContinueInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.continue_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1013,13 +1028,15 @@ std::string NarrativeBuilder::FormVerbalAlertContinueInstruction(Maneuver& maneu
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.continue_verbal_alert_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1078,16 +1095,18 @@ std::string NarrativeBuilder::FormVerbalContinueInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
-                                dictionary_.continue_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kLengthTag,
+             FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
+                        dictionary_.continue_verbal_subset.us_customary_lengths));
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.continue_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1163,16 +1182,17 @@ std::string NarrativeBuilder::FormTurnInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  subset->templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1271,16 +1291,17 @@ std::string NarrativeBuilder::FormVerbalTurnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  subset->templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1341,17 +1362,18 @@ std::string NarrativeBuilder::FormUturnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_subset.relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(),
+                                      dictionary_.uturn_subset.relative_directions));
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kCrossStreetNamesTag, cross_street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.uturn_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1496,15 +1518,17 @@ std::string NarrativeBuilder::FormVerbalUturnInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_dir);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kCrossStreetNamesTag, cross_street_names);
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.uturn_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1550,13 +1574,15 @@ std::string NarrativeBuilder::FormRampStraightInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.ramp_straight_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1655,13 +1681,15 @@ std::string NarrativeBuilder::FormVerbalRampStraightInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.ramp_straight_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1729,16 +1757,17 @@ std::string NarrativeBuilder::FormRampInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.ramp_subset.relative_directions));
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(),
+                                      dictionary_.ramp_subset.relative_directions));
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.ramp_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1889,14 +1918,16 @@ std::string NarrativeBuilder::FormVerbalRampInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_dir);
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.ramp_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1974,17 +2005,18 @@ std::string NarrativeBuilder::FormExitInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.exit_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(),
+                                      dictionary_.exit_subset.relative_directions));
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2145,15 +2177,17 @@ std::string NarrativeBuilder::FormVerbalExitInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_dir);
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kBranchSignTag, exit_branch_sign);
+  values.Set(kTowardSignTag, exit_toward_sign);
+  values.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2234,16 +2268,17 @@ std::string NarrativeBuilder::FormKeepInstruction(Maneuver& maneuver,
     phrase_id += 4;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(),
-                                                dictionary_.keep_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeThreeDirection(maneuver.type(),
+                                        dictionary_.keep_subset.relative_directions));
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.keep_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2425,14 +2460,16 @@ std::string NarrativeBuilder::FormVerbalKeepInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_dir);
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.keep_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2484,16 +2521,18 @@ std::string NarrativeBuilder::FormKeepToStayOnInstruction(Maneuver& maneuver,
     phrase_id += 2;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
-                                                                     .relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
+                                                             .relative_directions));
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.keep_to_stay_on_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2583,14 +2622,16 @@ std::string NarrativeBuilder::FormVerbalKeepToStayOnInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_dir);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kNumberSignTag, exit_number_sign);
+  values.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.keep_to_stay_on_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2641,13 +2682,14 @@ std::string NarrativeBuilder::FormMergeInstruction(Maneuver& maneuver,
         FormRelativeTwoDirection(maneuver.type(), dictionary_.merge_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_direction);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.merge_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2716,13 +2758,15 @@ std::string NarrativeBuilder::FormVerbalMergeInstruction(Maneuver& maneuver,
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_direction);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.merge_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2839,16 +2883,17 @@ std::string NarrativeBuilder::FormEnterRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  PhraseValues values;
+  values.Set(kOrdinalValueTag, ordinal_value);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, guide_sign);
+  values.Set(kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
+  values.Set(kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_roundabout_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2991,16 +3036,17 @@ std::string NarrativeBuilder::FormVerbalEnterRoundaboutInstruction(Maneuver& man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  PhraseValues values;
+  values.Set(kOrdinalValueTag, ordinal_value);
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kTowardSignTag, guide_sign);
+  values.Set(kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
+  values.Set(kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_roundabout_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3054,13 +3100,15 @@ std::string NarrativeBuilder::FormExitRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_roundabout_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3118,13 +3166,15 @@ std::string NarrativeBuilder::FormVerbalExitRoundaboutInstruction(Maneuver& mane
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kBeginStreetNamesTag, begin_street_names);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_roundabout_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3168,13 +3218,15 @@ std::string NarrativeBuilder::FormEnterFerryInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kFerryLabelTag, ferry_label);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_ferry_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3235,13 +3287,15 @@ std::string NarrativeBuilder::FormVerbalEnterFerryInstruction(Maneuver& maneuver
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+  values.Set(kFerryLabelTag, ferry_label);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_ferry_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3274,12 +3328,14 @@ std::string NarrativeBuilder::FormTransitConnectionStartInstruction(Maneuver& ma
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_start_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_start_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3312,13 +3368,14 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionStartInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_start_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3351,12 +3408,14 @@ std::string NarrativeBuilder::FormTransitConnectionTransferInstruction(Maneuver&
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_transfer_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_transfer_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3389,13 +3448,14 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionTransferInstruction(Man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_transfer_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3428,13 +3488,14 @@ std::string NarrativeBuilder::FormTransitConnectionDestinationInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_destination_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3467,13 +3528,14 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionDestinationInstruction(
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop);
+  values.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_connection_destination_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3496,13 +3558,14 @@ std::string NarrativeBuilder::FormDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop_name);
+  values.Set(kTimeTag,
+             get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.depart_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3525,13 +3588,15 @@ std::string NarrativeBuilder::FormVerbalDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop_name);
+  values.Set(kTimeTag,
+             get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.depart_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3554,13 +3619,14 @@ std::string NarrativeBuilder::FormArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop_name);
+  values.Set(kTimeTag,
+             get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.arrive_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3583,13 +3649,15 @@ std::string NarrativeBuilder::FormVerbalArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  PhraseValues values;
+  values.Set(kTransitPlatformTag, transit_stop_name);
+  values.Set(kTimeTag,
+             get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.arrive_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3616,16 +3684,17 @@ std::string NarrativeBuilder::FormTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+  values.Set(kTransitPlatformCountTag,
+             std::to_string(stop_count)); // TODO: locale specific numerals
+  values.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3648,14 +3717,16 @@ std::string NarrativeBuilder::FormVerbalTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_verbal_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver,
+                             dictionary_.transit_verbal_subset.empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3683,17 +3754,19 @@ std::string NarrativeBuilder::FormTransitRemainOnInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_remain_on_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver,
+                             dictionary_.transit_remain_on_subset.empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+  values.Set(kTransitPlatformCountTag,
+             std::to_string(stop_count)); // TODO: locale specific numerals
+  values.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_remain_on_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3716,14 +3789,16 @@ std::string NarrativeBuilder::FormVerbalTransitRemainOnInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
+                                           .empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_remain_on_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3751,17 +3826,19 @@ std::string NarrativeBuilder::FormTransitTransferInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_transfer_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver,
+                             dictionary_.transit_transfer_subset.empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+  values.Set(kTransitPlatformCountTag,
+             std::to_string(stop_count)); // TODO: locale specific numerals
+  values.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_transfer_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3784,14 +3861,16 @@ std::string NarrativeBuilder::FormVerbalTransitTransferInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  PhraseValues values;
+  values.Set(kTransitNameTag,
+             FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
+                                           .empty_transit_name_labels));
+  values.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.transit_transfer_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3832,14 +3911,16 @@ std::string NarrativeBuilder::FormVerbalPostTransitionInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transition_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  PhraseValues values;
+  values.Set(kLengthTag,
+             FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                        dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  values.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.post_transition_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3860,14 +3941,15 @@ std::string NarrativeBuilder::FormVerbalPostTransitionTransitInstruction(Maneuve
       FormTransitPlatformCountLabel(stop_count, dictionary_.post_transition_transit_verbal_subset
                                                     .transit_stop_count_labels);
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.post_transition_transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  PhraseValues values;
+  values.Set(kTransitPlatformCountTag,
+             std::to_string(stop_count)); // TODO: locale specific numerals
+  values.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.post_transition_transit_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3911,14 +3993,16 @@ std::string NarrativeBuilder::FormVerbalSuccinctStartTransitionInstruction(Maneu
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  PhraseValues values;
+  values.Set(kCardinalDirectionTag, cardinal_direction);
+  values.Set(kLengthTag,
+             FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                        dictionary_.start_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.start_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3977,14 +4061,15 @@ NarrativeBuilder::FormVerbalSuccinctTurnTransitionInstruction(Maneuver& maneuver
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  subset->templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4023,15 +4108,17 @@ NarrativeBuilder::FormVerbalSuccinctUturnTransitionInstruction(Maneuver& maneuve
         maneuver.signs().GetJunctionNameString(element_max_count, limit_by_consecutive_count, delim,
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_verbal_subset.relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag,
+             FormRelativeTwoDirection(maneuver.type(),
+                                      dictionary_.uturn_verbal_subset.relative_directions));
+  values.Set(kJunctionNameTag, junction_name);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.uturn_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4075,12 +4162,14 @@ NarrativeBuilder::FormVerbalSuccinctMergeTransitionInstruction(Maneuver& maneuve
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kRelativeDirectionTag, relative_direction);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.merge_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4123,12 +4212,14 @@ std::string NarrativeBuilder::FormVerbalSuccinctEnterRoundaboutTransitionInstruc
                                                         &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  PhraseValues values;
+  values.Set(kOrdinalValueTag, ordinal_value);
+  values.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_roundabout_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4159,10 +4250,13 @@ std::string NarrativeBuilder::FormVerbalSuccinctExitRoundaboutTransitionInstruct
                                                  maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Replace phrase tags with values
+  PhraseValues values;
+  values.Set(kTowardSignTag, guide_sign);
 
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_roundabout_verbal_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4188,11 +4282,12 @@ std::string NarrativeBuilder::FormElevatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.elevator_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  PhraseValues values;
+  values.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.elevator_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   return instruction;
 }
@@ -4213,11 +4308,12 @@ std::string NarrativeBuilder::FormStepsInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.steps_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  PhraseValues values;
+  values.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.steps_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   return instruction;
 }
@@ -4238,11 +4334,12 @@ std::string NarrativeBuilder::FormEscalatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.escalator_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  PhraseValues values;
+  values.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.escalator_subset.templates.at(std::to_string(phrase_id)).Format(instruction, values);
 
   return instruction;
 }
@@ -4265,11 +4362,13 @@ std::string NarrativeBuilder::FormEnterBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_building_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.enter_building_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   return instruction;
 }
@@ -4292,11 +4391,13 @@ std::string NarrativeBuilder::FormExitBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_building_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  PhraseValues values;
+  values.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  dictionary_.exit_building_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   return instruction;
 }
@@ -4408,8 +4509,8 @@ std::string NarrativeBuilder::FormMetricLength(float kilometers,
 
   // TODO: why do we need separate tags for kilometers and meters?
   // Replace tags with length values
-  boost::replace_all(length_string, kKilometersTag, distance.str());
-  boost::replace_all(length_string, kMetersTag, distance.str());
+  boost::replace_all(length_string, kKilometersTag.text, distance.str());
+  boost::replace_all(length_string, kMetersTag.text, distance.str());
 
   return length_string;
 }
@@ -4475,9 +4576,9 @@ NarrativeBuilder::FormUsCustomaryLength(float miles,
 
   // TODO: why do we need separate tags for miles, tenths and feet?
   // Replace tags with length values
-  boost::replace_all(length_string, kMilesTag, distance.str());
-  boost::replace_all(length_string, kTenthsOfMilesTag, distance.str());
-  boost::replace_all(length_string, kFeetTag, distance.str());
+  boost::replace_all(length_string, kMilesTag.text, distance.str());
+  boost::replace_all(length_string, kTenthsOfMilesTag.text, distance.str());
+  boost::replace_all(length_string, kFeetTag.text, distance.str());
 
   return length_string;
 }
@@ -4715,19 +4816,23 @@ std::string NarrativeBuilder::FormVerbalMultiCue(Maneuver& maneuver,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the proper verbal multi-cue
+  // Determine which phrase to use
   uint8_t phrase_id = 0;
   if (maneuver.distant_verbal_multi_cue()) {
     phrase_id = 1;
   }
-  instruction = dictionary_.verbal_multi_cue_subset.phrases.at(std::to_string(phrase_id));
 
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCurrentVerbalCueTag, first_verbal_cue);
-  boost::replace_all(instruction, kNextVerbalCueTag, second_verbal_cue);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  PhraseValues values;
+  values.Set(kCurrentVerbalCueTag, first_verbal_cue);
+  values.Set(kNextVerbalCueTag, second_verbal_cue);
+  values.Set(kLengthTag,
+             FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                        dictionary_.post_transition_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the proper verbal multi-cue
+  dictionary_.verbal_multi_cue_subset.templates.at(std::to_string(phrase_id))
+      .Format(instruction, values);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
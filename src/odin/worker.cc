@@ -46,6 +46,7 @@ std::string odin_worker_t::narrate(Api& request) const {
   } catch (...) { throw valhalla_exception_t{202}; }
 
   // serialize those to the proper format
+  auto serialization_time = measure_scope_time(request, "serialization");
   return tyr::serializeDirections(request);
 }
 
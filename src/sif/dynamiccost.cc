@@ -12,6 +12,9 @@
 #include "sif/transitcost.h"
 #include "sif/truckcost.h"
 #include "worker.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 using namespace valhalla::baldr;
@@ -562,5 +565,27 @@ void ParseCosting(const rapidjson::Document& doc,
   costing->set_type(costing_type);
 }
 
+bool IsDefaultCosting(const Costing& costing) {
+  static const std::unordered_map<int, std::string> default_options = [] {
+    rapidjson::Document doc;
+    doc.SetObject();
+    Options options;
+    ParseCosting(doc, "/costing_options", options);
+    std::unordered_map<int, std::string> defaults;
+    for (const auto& parsed : options.costings()) {
+      defaults.emplace(parsed.first, parsed.second.options().SerializeAsString());
+    }
+    return defaults;
+  }();
+
+  auto defaults = default_options.find(costing.type());
+  return defaults != default_options.cend() &&
+         costing.options().SerializeAsString() == defaults->second;
+}
+
+std::string CostingKey(const Costing& costing) {
+  return std::to_string(costing.type()) + ":" + costing.options().SerializeAsString();
+}
+
 } // namespace sif
 } // namespace valhalla
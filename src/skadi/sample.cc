@@ -1,11 +1,17 @@
 #include "skadi/sample.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <fstream>
 #include <future>
 #include <limits>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <stdexcept>
@@ -35,6 +41,8 @@ constexpr int16_t NO_DATA_HIGH = 16384;
 constexpr int16_t NO_DATA_LOW = -16384;
 constexpr size_t TILE_COUNT = 180 * 360;
 constexpr int8_t UNPACKED_TILES_COUNT = 50;
+// how long a replaced source tile stays mapped for readers that may still be using it
+constexpr std::chrono::seconds RETIRED_GRACE_PERIOD(60);
 
 // macro is faster than inline function for this...
 #define out_of_range(v) v > NO_DATA_HIGH || v < NO_DATA_LOW
@@ -57,19 +65,19 @@ namespace skadi {
 
 enum class format_t { UNKNOWN = 0, RAW = 1, GZIP = 2, LZ4 = 3 };
 
+// A source elevation tile as found on disk, memory mapped as is
 class cache_item_t {
 private:
   format_t format;
   valhalla::midgard::mem_map<char> data;
-  int usages;
-  const char* unpacked;
+  // set once the compressed data turned out to be unusable so we stop trying to unpack it
+  mutable std::atomic<bool> corrupt;
+  // increases every time a tile is loaded, so that data unpacked from a replaced file is not used
+  uint64_t version;
 
 public:
-  cache_item_t() : format(format_t::UNKNOWN), usages(0), unpacked(nullptr) {
-  }
-  cache_item_t(cache_item_t&&) = default;
-  ~cache_item_t() {
-    free((void*)unpacked);
+  cache_item_t(uint64_t version = 0)
+      : format(format_t::UNKNOWN), corrupt(false), version(version) {
   }
 
   bool init(const std::string& path, format_t format) {
@@ -87,36 +95,24 @@ public:
   }
 
   inline format_t get_format() const {
-    return format;
-  }
-
-  inline int& get_usages() {
-    return usages;
-  }
-
-  inline const char* get_unpacked() {
-    return unpacked;
+    return corrupt.load(std::memory_order_relaxed) ? format_t::UNKNOWN : format;
   }
 
-  inline const char* detach_unpacked() {
-    auto rv = unpacked;
-    unpacked = nullptr;
-    return rv;
+  inline uint64_t get_version() const {
+    return version;
   }
 
-  bool unpack(const char* unpacked) {
-    this->unpacked = unpacked;
-
+  bool unpack(int16_t* unpacked) const {
     if (format == format_t::GZIP) {
       // for setting where to read compressed data from
       auto src_func = [this](z_stream& s) -> void {
-        s.next_in = static_cast<Byte*>(static_cast<void*>(data.get()));
+        s.next_in = static_cast<Byte*>(static_cast<void*>(const_cast<char*>(data.get())));
         s.avail_in = static_cast<unsigned int>(data.size());
       };
 
       // for setting where to write the uncompressed data to
-      auto dst_func = [this](z_stream& s) -> int {
-        s.next_out = (Byte*)(this->unpacked);
+      auto dst_func = [unpacked](z_stream& s) -> int {
+        s.next_out = static_cast<Byte*>(static_cast<void*>(unpacked));
         s.avail_out = HGT_BYTES;
         return Z_FINISH; // we know the output will hold all the input
       };
@@ -124,7 +120,7 @@ public:
       // we have to unzip it
       if (!baldr::inflate(src_func, dst_func)) {
         LOG_WARN("Corrupt gzip elevation data");
-        format = format_t::UNKNOWN;
+        corrupt = true;
         return false;
       }
     } else if (format == format_t::LZ4) {
@@ -138,12 +134,12 @@ public:
       size_t result;
 
       do {
-        result = LZ4F_decompress(decode, const_cast<char*>(this->unpacked), &dest_size, data.get(),
-                                 &src_size, &options);
+        result =
+            LZ4F_decompress(decode, unpacked, &dest_size, data.get(), &src_size, &options);
         if (LZ4F_isError(result)) {
           LZ4F_freeDecompressionContext(decode);
           LOG_WARN("Corrupt lz4 elevation data");
-          format = format_t::UNKNOWN;
+          corrupt = true;
           return false;
         }
       } while (result != 0);
@@ -151,7 +147,7 @@ public:
       LZ4F_freeDecompressionContext(decode);
     } else {
       LOG_WARN("Corrupt elevation data of unknown type");
-      format = format_t::UNKNOWN;
+      corrupt = true;
       return false;
     }
 
@@ -186,33 +182,27 @@ public:
   }
 };
 
+// buffer holding an unpacked tile, shared by the cache and the tile_data reading from it
+using unpacked_t = std::shared_ptr<int16_t>;
+
 // tile_data object holds unpacked elevation tile data
 class tile_data {
 private:
-  cache_t* c;
   const int16_t* data;
   uint16_t index;
-  bool reusable;
+  // keeps an unpacked tile alive while it is read from, empty for memory mapped raw tiles
+  unpacked_t unpacked;
 
 public:
-  tile_data() : c(nullptr), index(TILE_COUNT), reusable(false), data(nullptr) {
+  tile_data() : data(nullptr), index(TILE_COUNT) {
   }
 
-  tile_data(const tile_data& other) : c(nullptr) {
-    *this = other;
+  // a tile without data, remembers that the tile at this index could not be loaded
+  explicit tile_data(uint16_t index) : data(nullptr), index(index) {
   }
 
-  tile_data(cache_t* c, uint16_t index, bool reusable, const int16_t* data);
-  ~tile_data();
-  tile_data& operator=(const tile_data& other);
-
-  tile_data& operator=(tile_data&& other) {
-    std::swap(c, other.c);
-    std::swap(data, other.data);
-    std::swap(index, other.index);
-    std::swap(reusable, other.reusable);
-
-    return *this;
+  tile_data(uint16_t index, const int16_t* data, unpacked_t unpacked = {})
+      : data(data), index(index), unpacked(std::move(unpacked)) {
   }
 
   inline explicit operator bool() const {
@@ -279,141 +269,241 @@ public:
   }
 };
 
+// Unpacked (decompressed) tiles. The cache is split into shards by tile index, each with its own
+// lock and least recently used eviction, so concurrent requests for different tiles rarely contend.
+// Buffers of evicted tiles that nobody reads from anymore are reused for the next tile to unpack.
+class unpacked_cache_t {
+public:
+  unpacked_cache_t() {
+    // the total capacity is spread over the shards
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+      shards[i].capacity =
+          UNPACKED_TILES_COUNT / SHARD_COUNT + (i < UNPACKED_TILES_COUNT % SHARD_COUNT ? 1 : 0);
+    }
+  }
+
+  tile_data get(uint16_t index, const cache_item_t& item) {
+    auto& shard = shards[index % SHARD_COUNT];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    const auto version = item.get_version();
+
+    // item in cache is already unpacked, unless it was unpacked from a file that got replaced since
+    auto found = shard.tiles.find(index);
+    if (found != shard.tiles.end()) {
+      if (found->second->version >= version) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        const auto& unpacked = found->second->unpacked;
+        return {index, unpacked.get(), unpacked};
+      }
+      shard.lru.erase(found->second);
+      shard.tiles.erase(found);
+    }
+
+    // no matter how many requests received, only one inflate job per tile is started
+    auto pending = shard.pending.find(index);
+    if (pending != shard.pending.end() && pending->second.version >= version) {
+      auto future = pending->second.future;
+      lock.unlock();
+      return future.get();
+    }
+    std::promise<tile_data> promise;
+    shard.pending[index] = {version, promise.get_future().share()};
+
+    // make room for the tile
+    unpacked_t unpacked;
+    if (shard.tiles.size() >= shard.capacity && !shard.lru.empty()) {
+      auto& last = shard.lru.back();
+      if (last.unpacked.use_count() == 1) {
+        unpacked = std::move(last.unpacked);
+      }
+      shard.tiles.erase(last.index);
+      shard.lru.pop_back();
+    }
+    lock.unlock();
+
+    tile_data tile;
+    try {
+      if (!unpacked) {
+        unpacked.reset(new int16_t[HGT_PIXELS], std::default_delete<int16_t[]>());
+      }
+      if (item.unpack(unpacked.get())) {
+        tile = tile_data(index, unpacked.get(), unpacked);
+      }
+    } catch (...) {
+      lock.lock();
+      erase_pending(shard, index, version);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    lock.lock();
+    // while we were unpacking the file may have been replaced and unpacked again
+    found = shard.tiles.find(index);
+    if (tile && (found == shard.tiles.end() || found->second->version < version)) {
+      if (found != shard.tiles.end()) {
+        shard.lru.erase(found->second);
+        shard.tiles.erase(found);
+      }
+      shard.lru.push_front({index, version, std::move(unpacked)});
+      shard.tiles.emplace(index, shard.lru.begin());
+    }
+    erase_pending(shard, index, version);
+    promise.set_value(tile);
+    return tile;
+  }
+
+  // drops the unpacked tile, called when its source file is replaced
+  void erase(uint16_t index) {
+    auto& shard = shards[index % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.tiles.find(index);
+    if (found != shard.tiles.end()) {
+      shard.lru.erase(found->second);
+      shard.tiles.erase(found);
+    }
+  }
+
+private:
+  static constexpr size_t SHARD_COUNT = 8;
+
+  struct entry_t {
+    uint16_t index;
+    // version of the source tile this was unpacked from
+    uint64_t version;
+    unpacked_t unpacked;
+  };
+
+  struct pending_t {
+    uint64_t version;
+    std::shared_future<tile_data> future;
+  };
+
+  struct shard_t {
+    std::mutex mutex;
+    // most recently used tiles first
+    std::list<entry_t> lru;
+    std::unordered_map<uint16_t, std::list<entry_t>::iterator> tiles;
+    std::unordered_map<uint16_t, pending_t> pending;
+    size_t capacity = 0;
+  };
+
+  // a newer version of the tile may be pending by now, which is not ours to remove
+  static void erase_pending(shard_t& shard, uint16_t index, uint64_t version) {
+    auto pending = shard.pending.find(index);
+    if (pending != shard.pending.end() && pending->second.version == version) {
+      shard.pending.erase(pending);
+    }
+  }
+
+  std::array<shard_t, SHARD_COUNT> shards;
+};
+
 struct cache_t {
-  // Cached tiles
-  std::vector<cache_item_t> cache;
-  // Set of reusable tile indexes
-  std::unordered_set<uint16_t> reusable;
-  // Map of pending tiles. No matter how many requests received, only one inflate job per tile
-  // started.
-  std::unordered_map<uint16_t, std::shared_future<tile_data>> pending_tiles;
-  // Guards access to the pending_tiles
-  std::recursive_mutex mutex;
+  // Source tiles by index. An item is only published once it is completely mapped so reading
+  // them needs no lock. Items are freed with the cache or a grace period after being replaced.
+  std::unique_ptr<std::atomic<cache_item_t*>[]> items;
+  size_t item_count = 0;
+  std::atomic<uint64_t> next_version{1};
+  // Items that were replaced by a newer file while readers might still be using them, oldest first
+  std::list<std::pair<std::chrono::steady_clock::time_point, std::unique_ptr<cache_item_t>>>
+      retired;
+  std::mutex retired_mutex;
+  // Unpacked compressed tiles
+  unpacked_cache_t unpacked;
   // Elevation tile path
   std::string data_source;
 
-  void increment_usages(uint16_t index) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    cache[index].get_usages()++;
+  ~cache_t() {
+    for (size_t i = 0; i < item_count; ++i) {
+      delete items[i].load(std::memory_order_relaxed);
+    }
   }
 
-  void decrement_usages(uint16_t index) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    cache[index].get_usages()--;
+  void resize(size_t count) {
+    items.reset(new std::atomic<cache_item_t*>[count]);
+    for (size_t i = 0; i < count; ++i) {
+      items[i].store(nullptr, std::memory_order_relaxed);
+    }
+    item_count = count;
   }
 
   // no need for synchronization as size is constant(set in constructor
   // and never change after thatn)
   std::size_t size() const noexcept {
-    return cache.size();
+    return item_count;
   }
 
   bool insert(int pos, const std::string& path, format_t format);
 
+  const cache_item_t* item(uint16_t index);
+
   tile_data source(uint16_t index);
 };
 
 bool cache_t::insert(int pos, const std::string& path, format_t format) {
-  if (pos >= cache.size())
+  if (pos >= static_cast<int>(size()))
+    return false;
+
+  std::unique_ptr<cache_item_t> item(new cache_item_t(next_version.fetch_add(1)));
+  if (!item->init(path, format))
     return false;
 
-  std::lock_guard<std::recursive_mutex> lock(mutex);
-  return cache[pos].init(path, format);
+  std::unique_ptr<cache_item_t> previous(
+      items[pos].exchange(item.release(), std::memory_order_acq_rel));
+  if (previous) {
+    // whatever was unpacked from the previous file is stale now
+    unpacked.erase(pos);
+
+    // readers may still be using what was there before so we keep it around for a while, items
+    // retired long enough ago are not in use anymore
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(retired_mutex);
+    while (!retired.empty() && now - retired.front().first > RETIRED_GRACE_PERIOD) {
+      retired.pop_front();
+    }
+    retired.emplace_back(now, std::move(previous));
+  }
+  return true;
 }
 
-tile_data cache_t::source(uint16_t index) {
-  // bail if it's out of bounds
-  if (index >= TILE_COUNT) {
-    return {};
+const cache_item_t* cache_t::item(uint16_t index) {
+  auto* item = items[index].load(std::memory_order_acquire);
+  if (item) {
+    return item;
   }
 
   // if we don't have anything maybe it's lazy loaded
-  auto& item = cache[index];
-  if (item.get_data() == nullptr) {
-    auto f = data_source + get_hgt_file_name(index);
-    item.init(f, format_t::RAW);
+  std::unique_ptr<cache_item_t> loaded(new cache_item_t(next_version.fetch_add(1)));
+  if (!loaded->init(data_source + get_hgt_file_name(index), format_t::RAW)) {
+    return nullptr;
   }
 
-  // it wasn't in cache and when we tried to load it the file was of unknown type
-  if (item.get_format() == format_t::UNKNOWN) {
-    return {};
+  // another thread may have beaten us to it, in which case we use theirs
+  if (items[index].compare_exchange_strong(item, loaded.get(), std::memory_order_acq_rel)) {
+    return loaded.release();
   }
+  return item;
+}
 
-  // we have it raw or we don't
-  if (item.get_format() == format_t::RAW) {
-    return {this, index, false, (const int16_t*)item.get_data()};
+tile_data cache_t::source(uint16_t index) {
+  // bail if it's out of bounds
+  if (index >= size()) {
+    return {};
   }
 
-  // we were able to load it but the format wasn't RAW, which only leaves compressed formats
-  mutex.lock();
-  auto it = pending_tiles.find(index);
-  if (it != pending_tiles.end()) {
-    auto future = it->second;
-    mutex.unlock();
-    return future.get();
-  }
-
-  // item in cache is already unpacked
-  const char* unpacked = item.get_unpacked();
-  if (unpacked) {
-    auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-    mutex.unlock();
-    return rv;
-  }
-
-  std::promise<tile_data> promise;
-  it = pending_tiles.emplace(index, promise.get_future()).first;
-
-  if (reusable.size() >= UNPACKED_TILES_COUNT) {
-    for (auto i : reusable) {
-      if (cache[i].get_usages() <= 0) {
-        reusable.erase(i);
-        unpacked = cache[i].detach_unpacked();
-        break;
-      }
-    }
-  }
-  if (!unpacked) {
-    unpacked = (char*)malloc(HGT_BYTES);
+  // it wasn't in cache and when we tried to load it the file was of unknown type
+  const auto* item = this->item(index);
+  if (!item || item->get_format() == format_t::UNKNOWN) {
+    return {};
   }
-  reusable.insert(index);
-  auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-  mutex.unlock();
 
-  if (!item.unpack(unpacked)) {
-    rv = tile_data();
+  // we have it raw or we don't
+  if (item->get_format() == format_t::RAW) {
+    return {index, reinterpret_cast<const int16_t*>(item->get_data())};
   }
 
-  mutex.lock();
-  promise.set_value(rv);
-  pending_tiles.erase(it);
-  mutex.unlock();
-  return rv;
-}
-
-tile_data::tile_data(cache_t* c, uint16_t index, bool reusable, const int16_t* data)
-    : c(c), data(data), index(index), reusable(reusable) {
-  if (reusable)
-    c->increment_usages(index);
-}
-
-tile_data::~tile_data() {
-  if (reusable)
-    c->decrement_usages(index);
-}
-
-tile_data& tile_data::operator=(const tile_data& other) {
-  if (c && reusable)
-    c->decrement_usages(index);
-
-  c = other.c;
-  data = other.data;
-  index = other.index;
-  reusable = other.reusable;
-
-  if (c && reusable)
-    c->increment_usages(index);
-  return *this;
+  // we were able to load it but the format wasn't RAW, which only leaves compressed formats
+  return unpacked.get(index, *item);
 }
 
 sample::sample(const boost::property_tree::ptree& pt)
@@ -447,18 +537,18 @@ template <class coord_t> double sample::get(const coord_t& coord, tile_data& til
 
   // the caller can pass a cached tile, so we only fetch one if its not the one they already have
   if (index != tile.get_index()) {
-    {
-      std::lock_guard<std::mutex> _(cache_lck);
+    tile = cache_->source(index);
+    if (!tile && fetch(index)) {
       tile = cache_->source(index);
     }
+    // remember the tile is missing so that following postings on it don't try again
     if (!tile) {
-      if (!fetch(index))
-        return get_no_data_value();
-
-      if (!(tile = cache_->source(index)))
-        return get_no_data_value();
+      tile = tile_data(index);
     }
   }
+  if (!tile) {
+    return get_no_data_value();
+  }
 
   // figure out what row and column we need from the array of data
   // NOTE: data is arranged from upper left to bottom right, so y is flipped
@@ -476,12 +566,22 @@ template <class coord_t> double sample::get(const coord_t& coord) {
 }
 
 template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) {
-  std::vector<double> values;
-  values.reserve(coords.size());
+  // group the postings by tile so that each tile is looked up once per call, even when the
+  // postings go back and forth over a tile boundary
+  std::vector<const typename coords_t::value_type*> postings;
+  std::vector<std::pair<uint16_t, uint32_t>> by_tile;
+  postings.reserve(coords.size());
+  by_tile.reserve(coords.size());
+  for (const auto& coord : coords) {
+    by_tile.emplace_back(get_tile_index(coord), static_cast<uint32_t>(postings.size()));
+    postings.push_back(&coord);
+  }
+  std::sort(by_tile.begin(), by_tile.end());
 
+  std::vector<double> values(postings.size());
   tile_data tile;
-  for (const auto& coord : coords) {
-    values.emplace_back(get(coord, tile));
+  for (const auto& posting : by_tile) {
+    values[posting.second] = get(*postings[posting.second], tile);
   }
 
   return values;
@@ -505,7 +605,6 @@ bool sample::store(const std::string& elev, const std::vector<char>& raw_data) {
   if (!filesystem::save(fpath, raw_data))
     return false;
 
-  std::lock_guard<std::mutex> _(cache_lck);
   return cache_->insert(data->first, fpath, data->second);
 }
 
@@ -542,7 +641,6 @@ template <class coord_t> uint16_t sample::get_tile_index(const coord_t& coord) {
 }
 
 void sample::add_single_tile(const std::string& path) {
-  std::lock_guard<std::mutex> _(cache_lck);
   cache_->insert(0, path, format_t::RAW);
 }
 
@@ -617,7 +715,7 @@ void sample::cache_initialisation(const std::string& data_source) {
     LOG_DEBUG("No elevation data_source was provided");
     return;
   }
-  cache_->cache.resize(TILE_COUNT);
+  cache_->resize(TILE_COUNT);
 
   // check the directory for files that look like what we need
   auto files = filesystem::get_files(cache_->data_source);
@@ -42,18 +42,12 @@ AStarBSSAlgorithm::~AStarBSSAlgorithm() {
 
 // Clear the temporary information generated during path construction.
 void AStarBSSAlgorithm::Clear() {
-  // Reduce edge labels capacity if it's more than limit
+  // Hand the edge labels and adjacency list back to the arena of this thread
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
-    edgelabels_.resize(reservation);
-    edgelabels_.shrink_to_fit();
-  }
+  LabelArena<EdgeLabel>::get().release(edgelabels_, adjacencylist_, reservation);
 
-  // Clear the edge labels and destination list. Reset the adjacency list
-  // and clear edge status.
-  edgelabels_.clear();
+  // Clear the destination list and edge status.
   destinations_.clear();
-  adjacencylist_.clear();
   pedestrian_edgestatus_.clear();
   bicycle_edgestatus_.clear();
 
@@ -81,16 +75,18 @@ void AStarBSSAlgorithm::Init(const midgard::PointLL& origll, const midgard::Poin
   float mincost =
       std::min(bicycle_astarheuristic_.Get(origll), pedestrian_astarheuristic_.Get(origll));
 
-  // Reserve size for edge labels - do this here rather than in constructor so
-  // to limit how much extra memory is used for persistent objects.
+  // Take storage for edge labels from the arena of this thread and reserve size for them - do
+  // this here rather than in constructor so to limit how much extra memory is used for
+  // persistent objects.
   // TODO - reserve based on estimate based on distance and route type.
-  edgelabels_.reserve(std::min(kInitialEdgeLabelCount, max_reserved_labels_count_));
+  LabelArena<EdgeLabel>::get().acquire(edgelabels_, adjacencylist_,
+                                       std::min(kInitialEdgeLabelCount, max_reserved_labels_count_));
 
   // Construct adjacency list, clear edge status.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = std::max(pedestrian_costing_->UnitSize(), bicycle_costing_->UnitSize());
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_);
+  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_, queue_policy_);
   pedestrian_edgestatus_.clear();
   bicycle_edgestatus_.clear();
 }
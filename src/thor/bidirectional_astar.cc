@@ -52,6 +52,8 @@ namespace thor {
 BidirectionalAStar::BidirectionalAStar(const boost::property_tree::ptree& config)
     : PathAlgorithm(config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCountBD),
                     config.get<bool>("clear_reserved_memory", false)),
+      edgestatus_forward_(clear_reserved_memory_ ? 0 : EdgeStatus::kDefaultMaxRetained),
+      edgestatus_reverse_(clear_reserved_memory_ ? 0 : EdgeStatus::kDefaultMaxRetained),
       extended_search_(config.get<bool>("extended_search", false)) {
   cost_threshold_ = 0;
   iterations_threshold_ = 0;
@@ -71,20 +73,12 @@ BidirectionalAStar::~BidirectionalAStar() {
 
 // Clear the temporary information generated during path construction.
 void BidirectionalAStar::Clear() {
+  // Hand the edge labels and adjacency lists back to the arena of this thread
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_forward_.size() > reservation) {
-    edgelabels_forward_.resize(reservation);
-    edgelabels_forward_.shrink_to_fit();
-  }
-  if (edgelabels_reverse_.size() > reservation) {
-    edgelabels_reverse_.resize(reservation);
-    edgelabels_reverse_.shrink_to_fit();
-  }
-  edgelabels_forward_.clear();
-  edgelabels_reverse_.clear();
+  auto& arena = LabelArena<BDEdgeLabel>::get();
+  arena.release(edgelabels_forward_, adjacencylist_forward_, reservation);
+  arena.release(edgelabels_reverse_, adjacencylist_reverse_, reservation);
 
-  adjacencylist_forward_.clear();
-  adjacencylist_reverse_.clear();
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
@@ -105,11 +99,18 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   float factor = costing_->AStarCostFactor();
   astarheuristic_forward_.Init(destll, factor);
   astarheuristic_reverse_.Init(origll, factor);
-
-  // Reserve size for edge labels - do this here rather than in constructor so
-  // to limit how much extra memory is used for persistent objects
-  edgelabels_forward_.reserve(std::min(max_reserved_labels_count_, kInitialEdgeLabelCountBD));
-  edgelabels_reverse_.reserve(std::min(max_reserved_labels_count_, kInitialEdgeLabelCountBD));
+  prefetch_target_forward_ = destll;
+  prefetch_target_reverse_ = origll;
+  prefetch_tile_forward_ = {};
+  prefetch_tile_reverse_ = {};
+
+  // Take storage for edge labels from the arena of this thread and reserve size for them - do
+  // this here rather than in constructor so to limit how much extra memory is used for
+  // persistent objects
+  const uint32_t reservation = std::min(max_reserved_labels_count_, kInitialEdgeLabelCountBD);
+  auto& arena = LabelArena<BDEdgeLabel>::get();
+  arena.acquire(edgelabels_forward_, adjacencylist_forward_, reservation);
+  arena.acquire(edgelabels_reverse_, adjacencylist_reverse_, reservation);
 
   // Construct adjacency list and initialize edge status lookup.
   // Set bucket size and cost range based on DynamicCost.
@@ -117,9 +118,9 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   const float range = kBucketCount * bucketsize;
 
   const float mincostf = astarheuristic_forward_.Get(origll);
-  adjacencylist_forward_.reuse(mincostf, range, bucketsize, &edgelabels_forward_);
+  adjacencylist_forward_.reuse(mincostf, range, bucketsize, &edgelabels_forward_, queue_policy_);
   const float mincostr = astarheuristic_reverse_.Get(destll);
-  adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_);
+  adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_, queue_policy_);
 
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
@@ -384,6 +385,14 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
   }
   const NodeInfo* nodeinfo = tile->node(node);
 
+  // Have the tiles ahead loaded in the background whenever the search enters another tile
+  auto& prefetch_tile = FORWARD ? prefetch_tile_forward_ : prefetch_tile_reverse_;
+  if (prefetch_tile != node.Tile_Base()) {
+    prefetch_tile = node.Tile_Base();
+    graphreader.Prefetch(node, nodeinfo->latlng(tile->header()->base_ll()),
+                         FORWARD ? prefetch_target_forward_ : prefetch_target_reverse_);
+  }
+
   // Keep track of superseded edges
   uint32_t shortcuts = 0;
 
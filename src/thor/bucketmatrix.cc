@@ -0,0 +1,566 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "thor/bucketmatrix.h"
+
+#include <robin_hood.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+// Radius of a backward search that reached every edge it could
+constexpr float kExhausted = std::numeric_limits<float>::max();
+
+// Conservative average speed (in MPH) for each travel mode, used to turn distances
+// into costs
+float GetAverageSpeed(const travel_mode_t mode) {
+  switch (mode) {
+    case travel_mode_t::kBicycle:
+      return 10.0f;
+    case travel_mode_t::kPedestrian:
+    case travel_mode_t::kPublicTransit:
+      return 2.0f;
+    case travel_mode_t::kDrive:
+    default:
+      return 35.0f;
+  }
+}
+
+bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
+  return a.has_lat_case() == b.has_lat_case() && a.has_lng_case() == b.has_lng_case() &&
+         (!a.has_lat_case() || a.lat() == b.lat()) && (!a.has_lng_case() || a.lng() == b.lng());
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+class BucketMatrix::Buckets
+    : public robin_hood::unordered_map<uint64_t, std::vector<BucketMatrix::BucketEntry>> {};
+
+BucketMatrix::BucketMatrix()
+    : access_mode_(kAutoAccess), mode_(travel_mode_t::kDrive), current_cost_threshold_(0),
+      source_count_(0), target_count_(0), queue_policy_(QueuePolicy::kDoubleBucket),
+      buckets_{new Buckets} {
+}
+
+BucketMatrix::~BucketMatrix() {
+}
+
+// Compute a cost threshold in seconds based on average speed for the travel mode.
+float BucketMatrix::GetCostThreshold(const float max_matrix_distance) const {
+  return max_matrix_distance / (GetAverageSpeed(mode_) * kMPHtoMetersPerSec);
+}
+
+// Half of the estimated cost to the farthest source. The estimate only decides how the
+// work is split between the two sides, the results do not depend on it.
+float BucketMatrix::GetTargetRadius(
+    const valhalla::Location& target,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& sources) const {
+  midgard::PointLL ll(target.ll().lng(), target.ll().lat());
+  float max_distance = 0.0f;
+  for (const auto& source : sources) {
+    max_distance =
+        std::max(max_distance, static_cast<float>(ll.Distance(
+                                   midgard::PointLL(source.ll().lng(), source.ll().lat()))));
+  }
+  return std::min(current_cost_threshold_,
+                  0.5f * max_distance / (GetAverageSpeed(mode_) * kMPHtoMetersPerSec));
+}
+
+// Clear the temporary information generated during time + distance matrix
+// construction.
+void BucketMatrix::clear() {
+  reset();
+  buckets_->clear();
+  target_radius_.clear();
+  best_connection_.clear();
+}
+
+// Reset the search state so the next search starts fresh.
+void BucketMatrix::reset() {
+  edgelabels_.clear();
+  adjacencylist_.clear();
+  edgestatus_.clear();
+}
+
+// Form a time distance matrix from the set of source locations
+// to the set of target locations.
+std::vector<TimeDistance> BucketMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const travel_mode_t mode,
+    const float max_matrix_distance) {
+  // Set the mode and costing
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  access_mode_ = costing_->access_mode();
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+
+  // Initialize best connections. Any locations that are the same get set to 0
+  // time and distance and are not searched for.
+  source_count_ = source_location_list.size();
+  target_count_ = target_location_list.size();
+  GraphId empty;
+  Cost trivial_cost(0.0f, 0.0f);
+  Cost max_cost(kMaxCost, kMaxCost);
+  for (const auto& source : source_location_list) {
+    for (const auto& target : target_location_list) {
+      if (equals(source.ll(), target.ll())) {
+        best_connection_.emplace_back(empty, empty, trivial_cost, 0.0f);
+        best_connection_.back().found = true;
+      } else {
+        best_connection_.emplace_back(empty, empty, max_cost, kMaxCost);
+      }
+    }
+  }
+  SetTrivialConnections(source_location_list, target_location_list, graphreader);
+
+  // Fill the buckets with one backward search per target
+  target_radius_.resize(target_count_);
+  for (uint32_t i = 0; i < target_count_; i++) {
+    const auto& target = target_location_list.Get(i);
+    BackwardSearch(i, target, GetTargetRadius(target, source_location_list), graphreader);
+    reset();
+  }
+
+  // Scan them with one forward search per source
+  for (uint32_t i = 0; i < source_count_; i++) {
+    ForwardSearch(i, source_location_list.Get(i), graphreader);
+    reset();
+  }
+
+  // Form the time, distance matrix from the best connections
+  std::vector<TimeDistance> td;
+  td.reserve(best_connection_.size());
+  for (const auto& connection : best_connection_) {
+    td.emplace_back(std::round(connection.cost.secs), std::round(connection.distance));
+  }
+  return td;
+}
+
+// Paths that start and end on the same edge never reach the opposing edge of the other
+// search so they are worked out from the correlated edges directly.
+void BucketMatrix::SetTrivialConnections(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+    GraphReader& graphreader) {
+  for (uint32_t i = 0; i < source_count_; i++) {
+    for (const auto& source_edge : sources.Get(i).correlation().edges()) {
+      GraphId edgeid(source_edge.graph_id());
+      if (costing_->AvoidAsOriginEdge(edgeid, source_edge.percent_along())) {
+        continue;
+      }
+      for (uint32_t j = 0; j < target_count_; j++) {
+        auto& connection = best_connection_[i * target_count_ + j];
+        if (connection.found) {
+          continue;
+        }
+        for (const auto& target_edge : targets.Get(j).correlation().edges()) {
+          if (target_edge.graph_id() != source_edge.graph_id() ||
+              target_edge.percent_along() < source_edge.percent_along() ||
+              costing_->AvoidAsDestinationEdge(edgeid, target_edge.percent_along())) {
+            continue;
+          }
+
+          // Cost of the part of the edge between the two, plus the penalties for
+          // the distances from the inputs like the searches add to their labels
+          graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+          const DirectedEdge* directededge = tile->directededge(edgeid);
+          float fraction = target_edge.percent_along() - source_edge.percent_along();
+          uint8_t flow_sources;
+          Cost cost =
+              costing_->EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources) * fraction;
+          cost.cost += source_edge.distance() + target_edge.distance();
+          if (cost.cost < connection.cost.cost) {
+            GraphId oppedge = graphreader.GetOpposingEdgeId(edgeid);
+            connection.Update(edgeid, oppedge, cost,
+                              std::round(directededge->length() * fraction));
+          }
+        }
+      }
+    }
+  }
+}
+
+// Add the bucket entry for an edge reached (or reached for less cost) by the backward
+// search of a target. Entries left by a more expensive path to the same edge stay in the
+// bucket, they are real paths and never win against the cheaper one.
+void BucketMatrix::AddBucketEntry(const uint32_t target, const BDEdgeLabel& label) {
+  // The labels at the target are only connected through the edges before them
+  uint32_t predidx = label.predecessor();
+  if (predidx == kInvalidLabel) {
+    return;
+  }
+  const BDEdgeLabel& pred = edgelabels_[predidx];
+  (*buckets_)[label.edgeid()].push_back(
+      {target, pred.path_distance(),
+       Cost(pred.cost().cost + label.transition_cost().cost,
+            pred.cost().secs + label.transition_cost().secs)});
+}
+
+// Check the bucket of the opposing edge of an edge reached by the forward search.
+bool BucketMatrix::ScanBucket(const uint32_t source, const BDEdgeLabel& label) {
+  // Disallow connections that are part of an uturn on an internal edge or part of a
+  // complex restriction, like CostMatrix does
+  if (label.internal_turn() != InternalTurn::kNoTurn || label.on_complex_rest()) {
+    return false;
+  }
+
+  auto bucket = buckets_->find(label.opp_edgeid());
+  if (bucket == buckets_->end()) {
+    return false;
+  }
+
+  bool improved = false;
+  for (const auto& entry : bucket->second) {
+    auto& connection = best_connection_[source * target_count_ + entry.target];
+    float c = label.cost().cost + entry.cost.cost;
+    if (connection.found || c >= connection.cost.cost) {
+      continue;
+    }
+    GraphId oppedge = label.opp_edgeid();
+    connection.Update(label.edgeid(), oppedge, Cost(c, label.cost().secs + entry.cost.secs),
+                      label.path_distance() + entry.distance);
+    improved = true;
+  }
+  return improved;
+}
+
+// A connection to a target cheaper than the best one so far would meet the backward
+// search on an edge whose predecessor costs at most best - radius. So once everything
+// up to that cost has been expanded, and for every target, the search can stop.
+float BucketMatrix::GetStopCost(const uint32_t source) const {
+  float stop_cost = 0.0f;
+  for (uint32_t target = 0; target < target_count_; target++) {
+    const auto& connection = best_connection_[source * target_count_ + target];
+    if (connection.found || target_radius_[target] == kExhausted) {
+      continue;
+    }
+    stop_cost = std::max(stop_cost, connection.cost.cost - target_radius_[target]);
+  }
+  return stop_cost;
+}
+
+// Run the backward search from a target location up to the radius.
+void BucketMatrix::BackwardSearch(const uint32_t index,
+                                  const valhalla::Location& target,
+                                  const float radius,
+                                  GraphReader& graphreader) {
+  adjacencylist_.reuse(0.0f, current_cost_threshold_, costing_->UnitSize(), &edgelabels_,
+                       queue_policy_);
+
+  // Only skip outbound edges if we have other options
+  bool has_other_edges = false;
+  std::for_each(target.correlation().edges().begin(), target.correlation().edges().end(),
+                [&has_other_edges](const valhalla::PathEdge& e) {
+                  has_other_edges = has_other_edges || !e.begin_node();
+                });
+
+  // Add the edges of the target location, same as CostMatrix::SetTargets
+  for (const auto& edge : target.correlation().edges()) {
+    if (has_other_edges && edge.begin_node()) {
+      continue;
+    }
+    GraphId edgeid(edge.graph_id());
+    if (costing_->AvoidAsDestinationEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    GraphId opp_edge_id = graphreader.GetOpposingEdgeId(edgeid);
+    if (!opp_edge_id.Is_Valid()) {
+      continue;
+    }
+    const DirectedEdge* opp_dir_edge = graphreader.GetOpposingEdge(edgeid);
+
+    uint8_t flow_sources;
+    Cost edgecost = costing_->EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources);
+    Cost cost = edgecost * edge.percent_along();
+    uint32_t d = std::round(directededge->length() * edge.percent_along());
+    cost.cost += edge.distance();
+    Cost ec(std::round(edgecost.secs), static_cast<uint32_t>(directededge->length()));
+
+    BDEdgeLabel edge_label(kInvalidLabel, opp_edge_id, edgeid, opp_dir_edge, cost, mode_, ec, d,
+                           false, true, static_cast<bool>(flow_sources & kDefaultFlowMask),
+                           InternalTurn::kNoTurn, -1);
+    edge_label.set_not_thru(false);
+    uint32_t idx = edgelabels_.size();
+    edgelabels_.push_back(std::move(edge_label));
+    adjacencylist_.add(idx);
+    edgestatus_.Set(opp_edge_id, EdgeSet::kUnreachedOrReset, idx,
+                    graphreader.GetGraphTile(opp_edge_id));
+  }
+
+  // Settle everything up to the radius
+  target_radius_[index] = kExhausted;
+  while (true) {
+    uint32_t pred_idx = adjacencylist_.pop();
+    if (pred_idx == kInvalidLabel) {
+      break;
+    }
+
+    // Labels come out of the bucket queue sorted to within a bucket so everything
+    // cheaper than this one, less a bucket, has been settled
+    BDEdgeLabel pred = edgelabels_[pred_idx];
+    if (pred.cost().cost > radius) {
+      target_radius_[index] = std::max(0.0f, pred.cost().cost - costing_->UnitSize());
+      break;
+    }
+    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+
+    // Expand from the end node in reverse direction
+    GraphId node = pred.endnode();
+    graph_tile_ptr tile = graphreader.GetGraphTile(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = tile->node(node);
+    if (!costing_->Allowed(nodeinfo)) {
+      continue;
+    }
+    const DirectedEdge* opp_pred_edge;
+    if (pred.opp_edgeid().Tile_Base() == tile->id().Tile_Base()) {
+      opp_pred_edge = tile->directededge(pred.opp_edgeid().id());
+    } else {
+      opp_pred_edge =
+          graphreader.GetGraphTile(pred.opp_edgeid().Tile_Base())->directededge(pred.opp_edgeid());
+    }
+
+    std::function<void(graph_tile_ptr, const GraphId&, const NodeInfo*, const bool)> expand;
+    expand = [&](graph_tile_ptr tile, const GraphId& node, const NodeInfo* nodeinfo,
+                 const bool from_transition) {
+      GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
+      EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile);
+      const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+      for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+        // Skip shortcuts, the buckets have to be on the edges the forward searches use
+        if (directededge->is_shortcut() || !(directededge->reverseaccess() & access_mode_) ||
+            es->set() == EdgeSet::kPermanent) {
+          continue;
+        }
+
+        graph_tile_ptr t2 =
+            directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+        if (t2 == nullptr) {
+          continue;
+        }
+        GraphId oppedge = t2->GetOpposingEdgeId(directededge);
+        const DirectedEdge* opp_edge = t2->directededge(oppedge);
+        uint8_t restriction_idx = -1;
+        if (!costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0,
+                                      restriction_idx) ||
+            costing_->Restricted(directededge, pred, edgelabels_, tile, edgeid, false)) {
+          continue;
+        }
+
+        uint8_t flow_sources;
+        Cost newcost =
+            pred.cost() + costing_->EdgeCost(opp_edge, t2, TimeInfo::invalid(), flow_sources);
+        Cost tc = costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
+                                                  opp_pred_edge,
+                                                  static_cast<bool>(flow_sources & kDefaultFlowMask),
+                                                  pred.internal_turn());
+        newcost += tc;
+
+        // Update the label if this path is cheaper, the new path gets its own entry
+        if (es->set() == EdgeSet::kTemporary) {
+          BDEdgeLabel& lab = edgelabels_[es->index()];
+          if (newcost.cost < lab.cost().cost) {
+            adjacencylist_.decrease(es->index(), newcost.cost);
+            lab.Update(pred_idx, newcost, newcost.cost, tc,
+                       pred.path_distance() + directededge->length(), restriction_idx);
+            AddBucketEntry(index, lab);
+          }
+          continue;
+        }
+
+        uint32_t idx = edgelabels_.size();
+        *es = {EdgeSet::kTemporary, idx};
+        edgelabels_.emplace_back(pred_idx, edgeid, oppedge, directededge, newcost, mode_, tc,
+                                 pred.path_distance() + directededge->length(),
+                                 (pred.not_thru_pruning() || !directededge->not_thru()),
+                                 (pred.closure_pruning() || !costing_->IsClosed(directededge, tile)),
+                                 static_cast<bool>(flow_sources & kDefaultFlowMask),
+                                 costing_->TurnType(directededge->localedgeidx(), nodeinfo,
+                                                    opp_edge, opp_pred_edge),
+                                 restriction_idx);
+        adjacencylist_.add(idx);
+        AddBucketEntry(index, edgelabels_.back());
+      }
+
+      // Handle transitions - expand from the end node of each transition
+      if (!from_transition && nodeinfo->transition_count() > 0) {
+        const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+        for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+          graph_tile_ptr endtile = graphreader.GetGraphTile(trans->endnode());
+          if (endtile != nullptr) {
+            expand(endtile, trans->endnode(), endtile->node(trans->endnode()), true);
+          }
+        }
+      }
+    };
+    expand(tile, node, nodeinfo, false);
+  }
+}
+
+// Run the forward search from a source location until no bucket can improve its
+// connections any more.
+void BucketMatrix::ForwardSearch(const uint32_t index,
+                                 const valhalla::Location& source,
+                                 GraphReader& graphreader) {
+  adjacencylist_.reuse(0.0f, current_cost_threshold_, costing_->UnitSize(), &edgelabels_,
+                       queue_policy_);
+
+  // Only skip inbound edges if we have other options
+  bool has_other_edges = false;
+  std::for_each(source.correlation().edges().begin(), source.correlation().edges().end(),
+                [&has_other_edges](const valhalla::PathEdge& e) {
+                  has_other_edges = has_other_edges || !e.end_node();
+                });
+
+  // Add the edges of the source location, same as CostMatrix::SetSources
+  bool improved = false;
+  for (const auto& edge : source.correlation().edges()) {
+    if (has_other_edges && edge.end_node()) {
+      continue;
+    }
+    GraphId edgeid(edge.graph_id());
+    if (costing_->AvoidAsOriginEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    GraphId oppedge = graphreader.GetOpposingEdgeId(edgeid);
+
+    uint8_t flow_sources;
+    Cost edgecost = costing_->EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources);
+    Cost cost = edgecost * (1.0f - edge.percent_along());
+    uint32_t d = std::round(directededge->length() * (1.0f - edge.percent_along()));
+    cost.cost += edge.distance();
+    Cost ec(std::round(edgecost.secs), static_cast<uint32_t>(directededge->length()));
+
+    BDEdgeLabel edge_label(kInvalidLabel, edgeid, oppedge, directededge, cost, mode_, ec, d, false,
+                           true, static_cast<bool>(flow_sources & kDefaultFlowMask),
+                           InternalTurn::kNoTurn, -1);
+    edge_label.set_not_thru(false);
+    uint32_t idx = edgelabels_.size();
+    edgelabels_.push_back(std::move(edge_label));
+    adjacencylist_.add(idx);
+    edgestatus_.Set(edgeid, EdgeSet::kUnreachedOrReset, idx, tile);
+    improved = ScanBucket(index, edgelabels_.back()) || improved;
+  }
+
+  float stop_cost = GetStopCost(index);
+  while (true) {
+    uint32_t pred_idx = adjacencylist_.pop();
+    if (pred_idx == kInvalidLabel) {
+      break;
+    }
+
+    // Stop once no better connection can be found or past the cost threshold. Labels
+    // come out sorted to within a bucket.
+    BDEdgeLabel pred = edgelabels_[pred_idx];
+    if (improved) {
+      stop_cost = GetStopCost(index);
+      improved = false;
+    }
+    if (pred.cost().cost - costing_->UnitSize() > stop_cost ||
+        pred.cost().cost > current_cost_threshold_) {
+      break;
+    }
+    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+
+    // Expand from the end node in forward direction
+    GraphId node = pred.endnode();
+    graph_tile_ptr tile = graphreader.GetGraphTile(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = tile->node(node);
+    if (!costing_->Allowed(nodeinfo)) {
+      continue;
+    }
+
+    std::function<void(graph_tile_ptr, const GraphId&, const NodeInfo*, const bool)> expand;
+    expand = [&](graph_tile_ptr tile, const GraphId& node, const NodeInfo* nodeinfo,
+                 const bool from_transition) {
+      GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
+      EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile);
+      const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+      for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+        // Skip shortcuts, the buckets are on regular edges only
+        if (directededge->is_shortcut() || es->set() == EdgeSet::kPermanent ||
+            !(directededge->forwardaccess() & access_mode_)) {
+          continue;
+        }
+
+        uint8_t restriction_idx = -1;
+        if (!costing_->Allowed(directededge, false, pred, tile, edgeid, 0, 0, restriction_idx) ||
+            costing_->Restricted(directededge, pred, edgelabels_, tile, edgeid, true)) {
+          continue;
+        }
+
+        Cost tc = costing_->TransitionCost(directededge, nodeinfo, pred);
+        uint8_t flow_sources;
+        Cost newcost = pred.cost() + tc +
+                       costing_->EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources);
+
+        // Update the label if this path is cheaper and look at the bucket again
+        if (es->set() == EdgeSet::kTemporary) {
+          BDEdgeLabel& lab = edgelabels_[es->index()];
+          if (newcost.cost < lab.cost().cost) {
+            adjacencylist_.decrease(es->index(), newcost.cost);
+            lab.Update(pred_idx, newcost, newcost.cost, tc,
+                       pred.path_distance() + directededge->length(), restriction_idx);
+            improved = ScanBucket(index, lab) || improved;
+          }
+          continue;
+        }
+
+        graph_tile_ptr t2 =
+            directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+        if (t2 == nullptr) {
+          continue;
+        }
+        GraphId oppedge = t2->GetOpposingEdgeId(directededge);
+
+        uint32_t idx = edgelabels_.size();
+        *es = {EdgeSet::kTemporary, idx};
+        edgelabels_.emplace_back(pred_idx, edgeid, oppedge, directededge, newcost, mode_, tc,
+                                 pred.path_distance() + directededge->length(),
+                                 (pred.not_thru_pruning() || !directededge->not_thru()),
+                                 (pred.closure_pruning() || !costing_->IsClosed(directededge, tile)),
+                                 static_cast<bool>(flow_sources & kDefaultFlowMask),
+                                 costing_->TurnType(pred.opp_local_idx(), nodeinfo, directededge),
+                                 restriction_idx);
+        adjacencylist_.add(idx);
+        improved = ScanBucket(index, edgelabels_.back()) || improved;
+      }
+
+      // Handle transitions - expand from the end node of each transition
+      if (!from_transition && nodeinfo->transition_count() > 0) {
+        const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+        for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+          graph_tile_ptr endtile = graphreader.GetGraphTile(trans->endnode());
+          if (endtile != nullptr) {
+            expand(endtile, trans->endnode(), endtile->node(trans->endnode()), true);
+          }
+        }
+      }
+    };
+    expand(tile, node, nodeinfo, false);
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
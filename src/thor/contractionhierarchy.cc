@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "midgard/logging.h"
+#include "sif/recost.h"
+#include "thor/contractionhierarchy.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+// Finds the arc of a node leading to or coming from another node
+const ContractionArc* find_arc(const ContractionTile& tile,
+                               const ContractionNode* node,
+                               const bool up,
+                               const GraphId& target) {
+  const ContractionArc* arc = up ? tile.up(node) : tile.down(node);
+  const uint32_t count = up ? node->up_count : node->down_count;
+  for (uint32_t i = 0; i < count; ++i, ++arc) {
+    if (arc->target == target) {
+      return arc;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+void ContractionSearch::Clear() {
+  labels_.clear();
+  index_.clear();
+}
+
+void ContractionSearch::Add(const GraphId& node,
+                            const float cost,
+                            const float secs,
+                            const float length) {
+  auto inserted = index_.emplace(node.value, labels_.size());
+  if (inserted.second) {
+    labels_.push_back({node, {}, cost, secs, length, kInvalidLabel, false});
+  } else if (cost < labels_[inserted.first->second].cost) {
+    labels_[inserted.first->second] = {node, {}, cost, secs, length, kInvalidLabel, false};
+  }
+}
+
+// Same candidate edges as the bidirectional searches of BucketMatrix
+void ContractionSearch::AddLocation(const bool forward,
+                                    const valhalla::Location& location,
+                                    GraphReader& graphreader,
+                                    const DynamicCost& costing) {
+  // Only skip the edges ending (origin) or starting (destination) at the location if we
+  // have other options
+  bool has_other_edges = false;
+  for (const auto& e : location.correlation().edges()) {
+    has_other_edges = has_other_edges || !(forward ? e.end_node() : e.begin_node());
+  }
+
+  for (const auto& edge : location.correlation().edges()) {
+    GraphId edgeid(edge.graph_id());
+    if ((has_other_edges && (forward ? edge.end_node() : edge.begin_node())) ||
+        (forward ? costing.AvoidAsOriginEdge(edgeid, edge.percent_along())
+                 : costing.AvoidAsDestinationEdge(edgeid, edge.percent_along()))) {
+      continue;
+    }
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    uint8_t flow_sources;
+    Cost cost = costing.EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources) *
+                (1.0f - edge.percent_along());
+    float length = directededge->length() * (1.0f - edge.percent_along());
+    if (forward) {
+      Add(edgeid, cost.cost + edge.distance(), cost.secs, length);
+    } else {
+      Add(edgeid, edge.distance() - cost.cost, -cost.secs, -length);
+    }
+  }
+}
+
+bool ContractionSearch::Run(const bool forward,
+                            GraphReader& graphreader,
+                            ContractionReader& contraction) {
+  using entry_t = std::pair<float, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+  for (uint32_t i = 0; i < labels_.size(); ++i) {
+    queue.emplace(labels_[i].cost, i);
+  }
+
+  bool complete = true;
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    if (top.first > labels_[top.second].cost) {
+      continue;
+    }
+
+    const Label pred = labels_[top.second];
+    auto tile = contraction.GetTile(pred.node, graphreader);
+    const ContractionNode* node = tile ? tile->node(pred.node.id()) : nullptr;
+    if (node == nullptr) {
+      complete = false;
+      continue;
+    }
+
+    const ContractionArc* arc = forward ? tile->up(node) : tile->down(node);
+    const uint32_t count = forward ? node->up_count : node->down_count;
+    for (uint32_t i = 0; i < count; ++i, ++arc) {
+      Label label{arc->target,
+                  arc->middle,
+                  pred.cost + arc->cost,
+                  pred.secs + arc->secs,
+                  pred.length + arc->length,
+                  top.second,
+                  pred.restricted || (arc->flags & kContractionArcRestricted)};
+      auto inserted = index_.emplace(arc->target.value, labels_.size());
+      if (inserted.second) {
+        labels_.push_back(label);
+      } else if (label.cost < labels_[inserted.first->second].cost) {
+        labels_[inserted.first->second] = label;
+      } else {
+        continue;
+      }
+      queue.emplace(label.cost, inserted.first->second);
+    }
+  }
+  return complete;
+}
+
+bool ContractionSearch::AppendPath(const bool forward,
+                                   const Label& label,
+                                   GraphReader& graphreader,
+                                   ContractionReader& contraction,
+                                   std::vector<GraphId>& edges) const {
+  if (forward) {
+    // Walk back to the start, then unpack the arcs in the order of the path
+    std::vector<const Label*> labels{&label};
+    while (labels.back()->predecessor != kInvalidLabel) {
+      labels.push_back(&labels_[labels.back()->predecessor]);
+    }
+    edges.push_back(labels.back()->node);
+    for (auto next = labels.rbegin() + 1; next != labels.rend(); ++next) {
+      if (!UnpackArc((*(next - 1))->node, (*next)->node, (*next)->middle, graphreader, contraction,
+                     edges)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The labels of the backward search already come in the order of the path
+  for (const Label* l = &label; l->predecessor != kInvalidLabel; l = &labels_[l->predecessor]) {
+    if (!UnpackArc(l->node, labels_[l->predecessor].node, l->middle, graphreader, contraction,
+                   edges)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool UnpackArc(const GraphId& from,
+               const GraphId& to,
+               const GraphId& middle,
+               GraphReader& graphreader,
+               ContractionReader& contraction,
+               std::vector<GraphId>& edges) {
+  if (!middle.Is_Valid()) {
+    edges.push_back(to);
+    return true;
+  }
+
+  // A shortcut is made of the arc into its middle, stored as a downward arc of the middle,
+  // and the arc out of it, stored as an upward arc
+  auto tile = contraction.GetTile(middle, graphreader);
+  const ContractionNode* node = tile ? tile->node(middle.id()) : nullptr;
+  if (node == nullptr) {
+    return false;
+  }
+  const ContractionArc* in = find_arc(*tile, node, false, from);
+  const ContractionArc* out = find_arc(*tile, node, true, to);
+  return in != nullptr && out != nullptr &&
+         UnpackArc(from, middle, in->middle, graphreader, contraction, edges) &&
+         UnpackArc(middle, to, out->middle, graphreader, contraction, edges);
+}
+
+ContractionHierarchy::ContractionHierarchy(const boost::property_tree::ptree& config)
+    : PathAlgorithm(0, config.get<bool>("clear_reserved_memory", false)) {
+}
+
+void ContractionHierarchy::Clear() {
+  forward_.Clear();
+  backward_.Clear();
+  if (contraction_) {
+    contraction_->Trim();
+  }
+}
+
+std::vector<std::vector<PathInfo>>
+ContractionHierarchy::GetBestPath(valhalla::Location& origin,
+                                  valhalla::Location& dest,
+                                  GraphReader& graphreader,
+                                  const mode_costing_t& mode_costing,
+                                  const travel_mode_t mode,
+                                  const Options& options) {
+  has_ferry_ = false;
+  if (!contraction_) {
+    return {};
+  }
+  const auto& costing = mode_costing[static_cast<uint32_t>(mode)];
+
+  // Search the hierarchy up from both sides
+  forward_.AddLocation(true, origin, graphreader, *costing);
+  backward_.AddLocation(false, dest, graphreader, *costing);
+  if (!forward_.Run(true, graphreader, *contraction_) ||
+      !backward_.Run(false, graphreader, *contraction_)) {
+    LOG_WARN("Contraction hierarchy is incomplete");
+    return {};
+  }
+
+  // The cheapest node settled by both is on the best path
+  const ContractionSearch::Label* forward_label = nullptr;
+  const ContractionSearch::Label* backward_label = nullptr;
+  float best = std::numeric_limits<float>::max();
+  for (const auto& label : backward_.labels()) {
+    const auto* other = forward_.Find(label.node);
+    if (other == nullptr) {
+      continue;
+    }
+    // Both start on the same edge. If the origin comes before the destination the path along
+    // the edge can not be beaten by going around, those are left to bidirectional A*
+    if (other->predecessor == kInvalidLabel && label.predecessor == kInvalidLabel) {
+      if (other->length + label.length >= 0.0f) {
+        return {};
+      }
+      continue;
+    }
+    if (other->cost + label.cost < best) {
+      best = other->cost + label.cost;
+      forward_label = other;
+      backward_label = &label;
+    }
+  }
+  if (forward_label == nullptr || forward_label->restricted || backward_label->restricted) {
+    return {};
+  }
+
+  std::vector<GraphId> path_edges;
+  if (!forward_.AppendPath(true, *forward_label, graphreader, *contraction_, path_edges) ||
+      !backward_.AppendPath(false, *backward_label, graphreader, *contraction_, path_edges)) {
+    LOG_ERROR("Contraction hierarchy failed to unpack a shortcut");
+    return {};
+  }
+
+  float source_pct = -1.0f, target_pct = -1.0f;
+  for (const auto& e : origin.correlation().edges()) {
+    if (e.graph_id() == path_edges.front()) {
+      source_pct = e.percent_along();
+    }
+  }
+  for (const auto& e : dest.correlation().edges()) {
+    if (e.graph_id() == path_edges.back()) {
+      target_pct = e.percent_along();
+    }
+  }
+  if (source_pct < 0.0f || target_pct < 0.0f) {
+    throw std::logic_error("Could not find candidate edge used for contraction hierarchy path");
+  }
+
+  // Recost the unpacked edges, the arcs do not hold the turns onto the edges they skip
+  std::vector<PathInfo> path;
+  path.reserve(path_edges.size());
+  auto edge_itr = path_edges.begin();
+  const auto edge_cb = [&edge_itr, &path_edges]() {
+    return (edge_itr == path_edges.end()) ? GraphId{} : (*edge_itr++);
+  };
+  const auto label_cb = [&path](const EdgeLabel& label) {
+    path.emplace_back(label.mode(), label.cost(), label.edgeid(), 0, label.path_distance(),
+                      label.restriction_idx(), label.transition_cost(), false);
+  };
+  try {
+    auto time_info = TimeInfo::make(origin, graphreader, &tz_cache_);
+    recost_forward(graphreader, *costing, edge_cb, label_cb, source_pct, target_pct, time_info,
+                   options.date_time_type() == Options::invariant, true);
+  } catch (const std::exception& e) {
+    LOG_ERROR(std::string("Contraction hierarchy failed to recost final path: ") + e.what());
+    return {};
+  }
+
+  for (const auto& edge : path_edges) {
+    if (graphreader.directededge(edge)->use() == Use::kFerry) {
+      has_ferry_ = true;
+    }
+  }
+  return {std::move(path)};
+}
+
+} // namespace thor
+} // namespace valhalla
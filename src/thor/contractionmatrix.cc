@@ -0,0 +1,105 @@
+#include <cmath>
+#include <limits>
+
+#include "midgard/logging.h"
+#include "thor/contractionmatrix.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
+  return a.has_lat_case() == b.has_lat_case() && a.has_lng_case() == b.has_lng_case() &&
+         (!a.has_lat_case() || a.lat() == b.lat()) && (!a.has_lng_case() || a.lng() == b.lng());
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+void ContractionMatrix::clear() {
+  search_.Clear();
+  buckets_.clear();
+  connections_.clear();
+  if (contraction_) {
+    contraction_->Trim();
+  }
+}
+
+std::vector<TimeDistance> ContractionMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const travel_mode_t mode) {
+  if (!contraction_) {
+    return {};
+  }
+  const auto& costing = mode_costing[static_cast<uint32_t>(mode)];
+  const uint32_t target_count = target_location_list.size();
+
+  // Fill the buckets with one backward search per target
+  for (uint32_t i = 0; i < target_count; i++) {
+    search_.Clear();
+    search_.AddLocation(false, target_location_list.Get(i), graphreader, *costing);
+    if (!search_.Run(false, graphreader, *contraction_)) {
+      LOG_WARN("Contraction hierarchy is incomplete");
+      return {};
+    }
+    for (const auto& label : search_.labels()) {
+      buckets_[label.node.value].push_back({i, label});
+    }
+  }
+
+  // Scan them with one forward search per source
+  connections_.assign(source_location_list.size() * target_count,
+                      {kMaxCost, kMaxCost, kMaxCost, false});
+  for (uint32_t i = 0; i < static_cast<uint32_t>(source_location_list.size()); i++) {
+    search_.Clear();
+    search_.AddLocation(true, source_location_list.Get(i), graphreader, *costing);
+    if (!search_.Run(true, graphreader, *contraction_)) {
+      LOG_WARN("Contraction hierarchy is incomplete");
+      return {};
+    }
+    for (const auto& label : search_.labels()) {
+      auto bucket = buckets_.find(label.node.value);
+      if (bucket == buckets_.end()) {
+        continue;
+      }
+      for (const auto& entry : bucket->second) {
+        // Within the same edge only if the source comes before the target
+        if (label.predecessor == kInvalidLabel && entry.label.predecessor == kInvalidLabel &&
+            label.length + entry.label.length < 0.0f) {
+          continue;
+        }
+        auto& connection = connections_[i * target_count + entry.target];
+        float cost = label.cost + entry.label.cost;
+        if (cost < connection.cost) {
+          connection = {cost, label.secs + entry.label.secs, label.length + entry.label.length,
+                        label.restricted || entry.label.restricted};
+        }
+      }
+    }
+  }
+
+  // Form the time, distance matrix from the best connections
+  std::vector<TimeDistance> td;
+  td.reserve(connections_.size());
+  for (uint32_t i = 0; i < connections_.size(); i++) {
+    const auto& connection = connections_[i];
+    if (equals(source_location_list.Get(i / target_count).ll(),
+               target_location_list.Get(i % target_count).ll())) {
+      td.emplace_back(0, 0);
+    } else if (connection.restricted) {
+      return {};
+    } else {
+      td.emplace_back(std::round(connection.secs), std::round(connection.length));
+    }
+  }
+  return td;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -1,5 +1,10 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "midgard/logging.h"
@@ -15,6 +20,16 @@ namespace {
 
 constexpr uint32_t kMaxMatrixIterations = 2000000;
 
+// Default most edge labels of a search whose storage is kept between requests
+constexpr uint32_t kMaxReservedLabelsCount = 1000000;
+
+// Passes over fewer locations than this are not worth handing to the worker threads
+constexpr uint32_t kMinParallelLocations = 8;
+
+// Most tiles a worker thread holds on to. They stay in memory while it does, even when the
+// reader evicts them, so the thread starts over once it has seen this many
+constexpr size_t kMaxThreadTiles = 64;
+
 // Find a threshold to continue the search - should be based on
 // the max edge cost in the adjacency set?
 int GetThreshold(const travel_mode_t mode, const int n) {
@@ -26,6 +41,20 @@ bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
          (!a.has_lat_case() || a.lat() == b.lat()) && (!a.has_lng_case() || a.lng() == b.lng());
 }
 
+// Remove a location from the remaining locations of a status and set the threshold to
+// continue the search if it was the last one
+void RemoveLocation(valhalla::thor::LocationStatus& status,
+                    const uint32_t location,
+                    const int threshold) {
+  auto it = status.remaining_locations.find(location);
+  if (it != status.remaining_locations.end()) {
+    status.remaining_locations.erase(it);
+    if (status.remaining_locations.empty() && status.threshold > 0) {
+      status.threshold = threshold;
+    }
+  }
+}
+
 } // namespace
 
 namespace valhalla {
@@ -33,11 +62,180 @@ namespace thor {
 
 class CostMatrix::TargetMap : public robin_hood::unordered_map<uint64_t, std::vector<uint32_t>> {};
 
+// Gives a search access to the graph tiles. GraphReader is not thread-safe so when the
+// searches run on several threads each thread keeps the last tiles it has seen, at most
+// kMaxThreadTiles of them, and only goes to the shared reader, under a lock, for others.
+class CostMatrix::TileSource {
+public:
+  TileSource(GraphReader& reader, std::mutex* lock = nullptr) : reader_(&reader), lock_(lock) {
+  }
+
+  graph_tile_ptr GetGraphTile(const GraphId& graphid) {
+    if (lock_ == nullptr) {
+      return Load(graphid);
+    }
+
+    auto base = graphid.Tile_Base();
+    auto found = tiles_.find(base);
+    if (found != tiles_.end()) {
+      return found->second;
+    }
+    graph_tile_ptr tile;
+    {
+      std::lock_guard<std::mutex> lock(*lock_);
+      tile = Load(base);
+    }
+    if (tiles_.size() >= kMaxThreadTiles) {
+      tiles_.clear();
+    }
+    tiles_.emplace(base, tile);
+    return tile;
+  }
+
+private:
+  // The searches spread out to all sides, so when one of them reaches a tile which is not
+  // loaded yet the neighbours of the tile are queued to be loaded in the background
+  graph_tile_ptr Load(const GraphId& graphid) {
+    const auto misses = reader_->tile_counters().cache_misses.load();
+    auto tile = reader_->GetGraphTile(graphid);
+    if (tile && reader_->tile_counters().cache_misses != misses) {
+      reader_->Prefetch(graphid, midgard::PointLL());
+    }
+    return tile;
+  }
+
+  GraphReader* reader_;
+  std::mutex* lock_;
+  robin_hood::unordered_map<uint64_t, graph_tile_ptr> tiles_;
+};
+
+// Threads that run the steps of a pass. The calling thread takes part in every pass and
+// the locations are handed out one at a time since the cost of a step varies a lot.
+class CostMatrix::Workers {
+public:
+  using step_t = std::function<void(const uint32_t, TileSource&)>;
+
+  explicit Workers(const uint32_t concurrency) {
+    for (uint32_t i = 1; i < concurrency; ++i) {
+      threads_.emplace_back(&Workers::Loop, this, i);
+    }
+  }
+
+  ~Workers() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Give every thread its own view of the tiles of the reader used by the current query
+  void Start(GraphReader& reader) {
+    tiles_.clear();
+    for (size_t i = 0; i <= threads_.size(); ++i) {
+      tiles_.emplace_back(reader, &tile_lock_);
+    }
+  }
+
+  // Drop the tiles held on to by the threads
+  void Finish() {
+    tiles_.clear();
+  }
+
+  // Run step for every location index in [0, count) and return once they are all done
+  void Run(const uint32_t count, const step_t& step) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      step_ = &step;
+      count_ = count;
+      next_ = 0;
+      running_ = threads_.size();
+      error_ = nullptr;
+      ++pass_;
+    }
+    ready_.notify_all();
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return running_ == 0; });
+    step_ = nullptr;
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  void Loop(const size_t id) {
+    uint64_t pass = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this, pass]() { return shutdown_ || pass_ != pass; });
+        if (shutdown_) {
+          return;
+        }
+        pass = pass_;
+      }
+
+      Work(id);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+      }
+      done_.notify_one();
+    }
+  }
+
+  void Work(const size_t id) {
+    try {
+      for (uint32_t i = next_++; i < count_; i = next_++) {
+        (*step_)(i, tiles_[id]);
+      }
+    } catch (...) {
+      // stop handing out locations and keep the first failure
+      next_ = count_;
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::vector<TileSource> tiles_;
+  std::mutex tile_lock_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable done_;
+  const step_t* step_ = nullptr;
+  uint32_t count_ = 0;
+  std::atomic<uint32_t> next_{0};
+  uint64_t pass_ = 0;
+  size_t running_ = 0;
+  bool shutdown_ = false;
+  std::exception_ptr error_;
+};
+
 // Constructor with cost threshold.
-CostMatrix::CostMatrix()
+CostMatrix::CostMatrix(const boost::property_tree::ptree& config)
     : mode_(travel_mode_t::kDrive), access_mode_(kAutoAccess), source_count_(0),
       remaining_sources_(0), target_count_(0), remaining_targets_(0),
-      current_cost_threshold_(0), targets_{new TargetMap} {
+      current_cost_threshold_(0), queue_policy_(QueuePolicy::kDoubleBucket),
+      concurrency_(std::max(config.get<uint32_t>("costmatrix_concurrency", 1), 1u)),
+      max_reserved_labels_count_(
+          config.get<bool>("clear_reserved_memory", false)
+              ? 0
+              : config.get<uint32_t>("max_reserved_labels_count", kMaxReservedLabelsCount)),
+      targets_{new TargetMap} {
+  if (concurrency_ > 1) {
+    workers_.reset(new Workers(concurrency_));
+  }
 }
 
 CostMatrix::~CostMatrix() {
@@ -74,20 +272,19 @@ void CostMatrix::clear() {
   }
   targets_->clear();
 
-  // Clear all source adjacency lists, edge labels, and edge status
-  // Resize and shrink_to_fit so all capacity is reduced.
+  // Hand the edge labels and adjacency lists of all searches back to the arena of this
+  // thread, then clear the edge status. Resize and shrink_to_fit so all capacity is reduced.
+  auto& arena = LabelArena<BDEdgeLabel>::get();
+  for (uint32_t i = 0; i < source_edgelabel_.size(); ++i) {
+    arena.release(source_edgelabel_[i], source_adjacency_[i], max_reserved_labels_count_);
+  }
+  for (uint32_t i = 0; i < target_edgelabel_.size(); ++i) {
+    arena.release(target_edgelabel_[i], target_adjacency_[i], max_reserved_labels_count_);
+  }
   source_adjacency_.clear();
-  source_adjacency_.resize(0);
-  source_adjacency_.shrink_to_fit();
   target_adjacency_.clear();
-  target_adjacency_.resize(0);
-  target_adjacency_.shrink_to_fit();
   source_edgelabel_.clear();
-  source_edgelabel_.resize(0);
-  source_edgelabel_.shrink_to_fit();
   target_edgelabel_.clear();
-  target_edgelabel_.resize(0);
-  target_edgelabel_.shrink_to_fit();
   source_edgestatus_.clear();
   source_edgestatus_.resize(0);
   source_edgestatus_.shrink_to_fit();
@@ -103,6 +300,11 @@ void CostMatrix::clear() {
   source_status_.clear();
   target_status_.clear();
   best_connection_.clear();
+  pending_status_.clear();
+  target_reached_.clear();
+  if (workers_) {
+    workers_->Finish();
+  }
 }
 
 // Form a time distance matrix from the set of source locations
@@ -133,60 +335,85 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
   // spaces is checked during the forward search.
+  pending_status_.resize(std::max(source_count_, target_count_));
+  target_reached_.resize(target_count_);
+  if (workers_) {
+    workers_->Start(graphreader);
+  }
   int n = 0;
   while (true) {
-    // Iterate all target locations in a backwards search
-    for (uint32_t i = 0; i < target_count_; i++) {
+    // Iterate all target locations in a backwards search. Each search only touches its own
+    // target, what it changes for the sources is applied afterwards in target order.
+    RunPass(target_count_, graphreader, [this](const uint32_t i, TileSource& tiles) {
       if (target_status_[i].threshold > 0) {
         target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        if (target_status_[i].threshold == 0) {
-          for (uint32_t source = 0; source < source_count_; source++) {
-            //  Get all targets remaining for the origin
-            auto& targets = source_status_[source].remaining_locations;
-            auto it = targets.find(i);
-            if (it != targets.end()) {
-              targets.erase(it);
-              if (targets.empty() && source_status_[source].threshold > 0) {
-                source_status_[i].threshold = -1;
-                if (remaining_sources_ > 0) {
-                  remaining_sources_--;
-                }
+        BackwardSearch(i, tiles);
+      }
+    });
+    for (uint32_t i = 0; i < target_count_; i++) {
+      for (const auto& update : pending_status_[i]) {
+        RemoveLocation(source_status_[update.first], i, update.second);
+      }
+      pending_status_[i].clear();
+      for (const auto& edgeid : target_reached_[i]) {
+        (*targets_)[edgeid].push_back(i);
+      }
+      target_reached_[i].clear();
+
+      if (target_status_[i].threshold == 0) {
+        for (uint32_t source = 0; source < source_count_; source++) {
+          //  Get all targets remaining for the origin
+          auto& targets = source_status_[source].remaining_locations;
+          auto it = targets.find(i);
+          if (it != targets.end()) {
+            targets.erase(it);
+            if (targets.empty() && source_status_[source].threshold > 0) {
+              source_status_[i].threshold = -1;
+              if (remaining_sources_ > 0) {
+                remaining_sources_--;
               }
             }
           }
-          target_status_[i].threshold = -1;
-          if (remaining_targets_ > 0) {
-            remaining_targets_--;
-          }
+        }
+        target_status_[i].threshold = -1;
+        if (remaining_targets_ > 0) {
+          remaining_targets_--;
         }
       }
     }
 
-    // Iterate all source locations in a forward search
-    for (uint32_t i = 0; i < source_count_; i++) {
+    // Iterate all source locations in a forward search. Connections are only recorded in
+    // the row of the source so again the searches are independent of each other.
+    RunPass(source_count_, graphreader, [this, n](const uint32_t i, TileSource& tiles) {
       if (source_status_[i].threshold > 0) {
         source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader);
-        if (source_status_[i].threshold == 0) {
-          for (uint32_t target = 0; target < target_count_; target++) {
-            //  Get all sources remaining for the destination
-            auto& sources = target_status_[target].remaining_locations;
-            auto it = sources.find(i);
-            if (it != sources.end()) {
-              sources.erase(it);
-              if (sources.empty() && target_status_[target].threshold > 0) {
-                target_status_[i].threshold = -1;
-                if (remaining_targets_ > 0) {
-                  remaining_targets_--;
-                }
+        ForwardSearch(i, n, tiles);
+      }
+    });
+    for (uint32_t i = 0; i < source_count_; i++) {
+      for (const auto& update : pending_status_[i]) {
+        RemoveLocation(target_status_[update.first], i, update.second);
+      }
+      pending_status_[i].clear();
+
+      if (source_status_[i].threshold == 0) {
+        for (uint32_t target = 0; target < target_count_; target++) {
+          //  Get all sources remaining for the destination
+          auto& sources = target_status_[target].remaining_locations;
+          auto it = sources.find(i);
+          if (it != sources.end()) {
+            sources.erase(it);
+            if (sources.empty() && target_status_[target].threshold > 0) {
+              target_status_[i].threshold = -1;
+              if (remaining_targets_ > 0) {
+                remaining_targets_--;
               }
             }
           }
-          source_status_[i].threshold = -1;
-          if (remaining_sources_ > 0) {
-            remaining_sources_--;
-          }
+        }
+        source_status_[i].threshold = -1;
+        if (remaining_sources_ > 0) {
+          remaining_sources_--;
         }
       }
     }
@@ -205,6 +432,10 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     n++;
   }
 
+  if (workers_) {
+    workers_->Finish();
+  }
+
   // Form the time, distance matrix from the destinations list
   uint32_t idx = 0;
   std::vector<TimeDistance> td;
@@ -264,8 +495,22 @@ void CostMatrix::Initialize(
   }
 }
 
+// Run one step of the searches of all the locations on one side of the matrix.
+void CostMatrix::RunPass(const uint32_t count,
+                         GraphReader& graphreader,
+                         const std::function<void(const uint32_t, TileSource&)>& step) {
+  if (workers_ && count >= kMinParallelLocations) {
+    workers_->Run(count, step);
+    return;
+  }
+  TileSource tiles(graphreader);
+  for (uint32_t i = 0; i < count; i++) {
+    step(i, tiles);
+  }
+}
+
 // Iterate the forward search from the source/origin location.
-void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphReader& graphreader) {
+void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, TileSource& tiles) {
   // Get the next edge from the adjacency list for this source location
   auto& adj = source_adjacency_[index];
   auto& edgelabels = source_edgelabel_[index];
@@ -274,7 +519,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     // Forward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t target = 0; target < target_count_; target++) {
-      UpdateStatus(index, target);
+      UpdateStatus(index, target, true);
     }
     source_status_[index].threshold = 0;
     return;
@@ -367,7 +612,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
 
       // Get end node tile (skip if tile is not found) and opposing edge Id
       graph_tile_ptr t2 =
-          directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+          directededge->leaves_tile() ? tiles.GetGraphTile(directededge->endnode()) : tile;
       if (t2 == nullptr) {
         continue;
       }
@@ -398,7 +643,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
 
         // Expand from end node of this transition.
         GraphId node = trans->endnode();
-        graph_tile_ptr endtile = graphreader.GetGraphTile(node);
+        graph_tile_ptr endtile = tiles.GetGraphTile(node);
         if (endtile != nullptr) {
           expand(endtile, node, endtile->node(node), pred, pred_idx, true);
         }
@@ -409,7 +654,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
   // Expand from node in forward search path. Get the tile and the node info.
   // Skip if tile is null (can happen with regional data sets) or if no access
   // at the node.
-  graph_tile_ptr tile = graphreader.GetGraphTile(node);
+  graph_tile_ptr tile = tiles.GetGraphTile(node);
   if (tile != nullptr) {
     const NodeInfo* nodeinfo = tile->node(node);
     if (costing_->Allowed(nodeinfo)) {
@@ -481,7 +726,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
         // Update status and update threshold if this is the last location
         // to find for this source or target
-        UpdateStatus(source, target);
+        UpdateStatus(source, target, true);
       } else {
         float oppcost = (predidx == kInvalidLabel) ? 0 : edgelabels[predidx].cost().cost;
         float c = pred.cost().cost + oppcost + opp_el.transition_cost().cost;
@@ -503,7 +748,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
           // Update status and update threshold if this is the last location
           // to find for this source or target
-          UpdateStatus(source, target);
+          UpdateStatus(source, target, true);
         }
       }
     }
@@ -511,36 +756,26 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 }
 
 // Update status when a connection is found.
-void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
-  // Remove the target from the source status
-  auto& s = source_status_[source].remaining_locations;
-  auto it = s.find(target);
-  if (it != s.end()) {
-    s.erase(it);
-    if (s.empty() && source_status_[source].threshold > 0) {
-      // At least 1 connection has been found to each target for this source.
-      // Set a threshold to continue search for a limited number of times.
-      source_status_[source].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
-    }
-  }
-
-  // Remove the source from the target status
-  auto& t = target_status_[target].remaining_locations;
-  it = t.find(source);
-  if (it != t.end()) {
-    t.erase(it);
-    if (t.empty() && target_status_[target].threshold > 0) {
-      // At least 1 connection has been found to each source for this target.
-      // Set a threshold to continue search for a limited number of times.
-      target_status_[target].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
-    }
+void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target, const bool forward) {
+  // Once at least 1 connection has been found to each location on the other side,
+  // set a threshold to continue search for a limited number of times.
+  int threshold =
+      GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+
+  // Remove the target from the source status and the source from the target status.
+  // Other searches of the same pass may be running so only the status of the location
+  // being expanded is updated here.
+  if (forward) {
+    RemoveLocation(source_status_[source], target, threshold);
+    pending_status_[source].emplace_back(target, threshold);
+  } else {
+    RemoveLocation(target_status_[target], source, threshold);
+    pending_status_[target].emplace_back(source, threshold);
   }
 }
 
 // Expand the backwards search trees.
-void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader) {
+void CostMatrix::BackwardSearch(const uint32_t index, TileSource& tiles) {
   // Get the next edge from the adjacency list for this target location
   auto& adj = target_adjacency_[index];
   auto& edgelabels = target_edgelabel_[index];
@@ -549,7 +784,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     // Backward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t source = 0; source < source_count_; source++) {
-      UpdateStatus(source, index);
+      UpdateStatus(source, index, false);
     }
     target_status_[index].threshold = 0;
     return;
@@ -615,7 +850,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
 
       // Get opposing edge Id and end node tile
       graph_tile_ptr t2 =
-          directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+          directededge->leaves_tile() ? tiles.GetGraphTile(directededge->endnode()) : tile;
       if (t2 == nullptr) {
         continue;
       }
@@ -668,8 +903,8 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
                               restriction_idx);
       adj.add(idx);
 
-      // Add to the list of targets that have reached this edge
-      (*targets_)[edgeid].push_back(index);
+      // Add to the list of targets that have reached this edge once the pass is done
+      target_reached_[index].push_back(edgeid);
     }
 
     // Handle transitions - expand from the end node of the transition
@@ -684,7 +919,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
 
         // Expand from end node of this transition edge.
         GraphId node = trans->endnode();
-        graph_tile_ptr endtile = graphreader.GetGraphTile(node);
+        graph_tile_ptr endtile = tiles.GetGraphTile(node);
         if (endtile != nullptr) {
           expand(endtile, node, endtile->node(node), index, pred, pred_idx, opp_pred_edge, true);
         }
@@ -695,7 +930,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
 
   // Get the tile and the node info. Skip if tile is null (can happen
   // with regional data sets) or if no access at the node.
-  graph_tile_ptr tile = graphreader.GetGraphTile(node);
+  graph_tile_ptr tile = tiles.GetGraphTile(node);
   if (tile != nullptr) {
     const NodeInfo* nodeinfo = tile->node(node);
     if (costing_->Allowed(nodeinfo)) {
@@ -706,7 +941,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
         opp_pred_edge = tile->directededge(pred.opp_edgeid().id());
       } else {
         opp_pred_edge =
-            graphreader.GetGraphTile(pred.opp_edgeid().Tile_Base())->directededge(pred.opp_edgeid());
+            tiles.GetGraphTile(pred.opp_edgeid().Tile_Base())->directededge(pred.opp_edgeid());
       }
       expand(tile, node, nodeinfo, index, pred, pred_idx, opp_pred_edge, false);
     }
@@ -720,18 +955,22 @@ void CostMatrix::SetSources(GraphReader& graphreader,
   // Allocate edge labels and edge status
   source_count_ = sources.size();
   source_edgelabel_.resize(source_count_);
+  source_adjacency_.resize(source_count_);
   source_edgestatus_.resize(source_count_);
   source_hierarchy_limits_.resize(source_count_);
 
+  // Edge labels and adjacency lists come from the label arena of this thread
+  auto& arena = LabelArena<BDEdgeLabel>::get();
+
   // Go through each source location
   uint32_t index = 0;
   Cost empty_cost;
   for (const auto& origin : sources) {
-    // Allocate the adjacency list and hierarchy limits for this source.
-    // Use the cost threshold to size the adjacency list.
-    source_adjacency_.emplace_back(DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
-                                                                  costing_->UnitSize(),
-                                                                  &source_edgelabel_[index]));
+    // Take the edge labels and adjacency list from the arena and set up the hierarchy
+    // limits for this source. Use the cost threshold to size the adjacency list.
+    arena.acquire(source_edgelabel_[index], source_adjacency_[index], 0);
+    source_adjacency_[index].reuse(0, current_cost_threshold_, costing_->UnitSize(),
+                                   &source_edgelabel_[index], queue_policy_);
     source_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Only skip inbound edges if we have other options
@@ -801,18 +1040,22 @@ void CostMatrix::SetTargets(baldr::GraphReader& graphreader,
   // Allocate target edge labels and edge status
   target_count_ = targets.size();
   target_edgelabel_.resize(targets.size());
+  target_adjacency_.resize(targets.size());
   target_edgestatus_.resize(targets.size());
   target_hierarchy_limits_.resize(targets.size());
 
+  // Edge labels and adjacency lists come from the label arena of this thread
+  auto& arena = LabelArena<BDEdgeLabel>::get();
+
   // Go through each target location
   uint32_t index = 0;
   Cost empty_cost;
   for (const auto& dest : targets) {
-    // Allocate the adjacency list and hierarchy limits for target location.
-    // Use the cost threshold to size the adjacency list.
-    target_adjacency_.emplace_back(DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
-                                                                  costing_->UnitSize(),
-                                                                  &target_edgelabel_[index]));
+    // Take the edge labels and adjacency list from the arena and set up the hierarchy
+    // limits for this target. Use the cost threshold to size the adjacency list.
+    arena.acquire(target_edgelabel_[index], target_adjacency_[index], 0);
+    target_adjacency_[index].reuse(0, current_cost_threshold_, costing_->UnitSize(),
+                                   &target_edgelabel_[index], queue_policy_);
     target_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Only skip outbound edges if we have other options
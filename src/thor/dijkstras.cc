@@ -46,27 +46,18 @@ Dijkstras::Dijkstras(const boost::property_tree::ptree& config)
     : mode_(travel_mode_t::kDrive), access_mode_(kAutoAccess),
       max_reserved_labels_count_(
           config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCount)),
-      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)), multipath_(false) {
+      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)),
+      queue_policy_(QueuePolicy::kDoubleBucket),
+      edgestatus_(clear_reserved_memory_ ? 0 : EdgeStatus::kDefaultMaxRetained), multipath_(false) {
 }
 
 // Clear the temporary information generated during path construction.
 void Dijkstras::Clear() {
-  // Clear the edge labels, edge status flags, and adjacency list
-  // TODO - clear only the edge label set that was used?
+  // Hand the edge labels and adjacency lists back to the arena of this thread. The label set
+  // which was not used has no storage so releasing it is a no-op.
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (bdedgelabels_.size() > reservation) {
-    bdedgelabels_.resize(reservation);
-    bdedgelabels_.shrink_to_fit();
-  }
-  bdedgelabels_.clear();
-  if (mmedgelabels_.size() > reservation) {
-    mmedgelabels_.resize(reservation);
-    mmedgelabels_.shrink_to_fit();
-  }
-  mmedgelabels_.clear();
-
-  adjacencylist_.clear();
-  mmadjacencylist_.clear();
+  LabelArena<BDEdgeLabel>::get().release(bdedgelabels_, adjacencylist_, reservation);
+  LabelArena<MMEdgeLabel>::get().release(mmedgelabels_, mmadjacencylist_, reservation);
   edgestatus_.clear();
 }
 
@@ -80,11 +71,12 @@ void Dijkstras::Initialize(label_container_t& labels,
   uint32_t edge_label_reservation;
   uint32_t bucket_count;
   GetExpansionHints(bucket_count, edge_label_reservation);
-  labels.reserve(std::min(max_reserved_labels_count_, edge_label_reservation));
+  LabelArena<typename label_container_t::value_type>::get()
+      .acquire(labels, queue, std::min(max_reserved_labels_count_, edge_label_reservation));
 
   // Set up lambda to get sort costs
   float range = bucket_count * bucket_size;
-  queue.reuse(0.0f, range, bucket_size, &labels);
+  queue.reuse(0.0f, range, bucket_size, &labels, queue_policy_);
 }
 template void
 Dijkstras::Initialize<decltype(Dijkstras::bdedgelabels_)>(decltype(Dijkstras::bdedgelabels_)&,
@@ -37,7 +37,11 @@ std::string thor_worker_t::isochrones(Api& request) {
   auto expansion_type = costing == "multimodal" || costing == "transit"
                             ? ExpansionType::multimodal
                             : (reverse ? ExpansionType::reverse : ExpansionType::forward);
-  auto grid = isochrone_gen.Expand(expansion_type, request, *reader, mode_costing, mode);
+  std::shared_ptr<const GriddedData<2>> grid;
+  {
+    auto expansion_time = measure_scope_time(request, "isochrone_expansion");
+    grid = isochrone_gen.Expand(expansion_type, request, *reader, mode_costing, mode);
+  }
 
   // e.g. in case of /expansion request
   if (options.action() == Options_Action_expansion)
@@ -46,10 +50,11 @@ std::string thor_worker_t::isochrones(Api& request) {
   // we have parallel vectors of contour properties and the actual geojson features
   // this method sorts the contour specifications by metric (time or distance) and then by value
   // with the largest values coming first. eg (60min, 30min, 10min, 40km, 10km)
-  auto isolines =
-      grid->GenerateContours(contours, options.polygons(), options.denoise(), options.generalize());
+  auto isolines = grid->GenerateContours(contours, options.polygons(), options.denoise(),
+                                         options.generalize(), contour_concurrency);
 
   // make the final json
+  auto serialization_time = measure_scope_time(request, "serialization");
   std::string ret = tyr::serializeIsochrones(request, contours, isolines, options.polygons(),
                                              options.show_locations());
 
@@ -1,7 +1,10 @@
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/pedestriancost.h"
+#include "thor/bucketmatrix.h"
+#include "thor/contractionmatrix.h"
 #include "thor/costmatrix.h"
+#include "thor/overlaymatrix.h"
 #include "thor/timedistancebssmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
@@ -66,23 +69,45 @@ std::string thor_worker_t::matrix(Api& request) {
   // lambdas to do the real work
   std::vector<TimeDistance> time_distances;
   auto costmatrix = [&]() {
+    auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
     return costmatrix_.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing,
                                       mode, max_matrix_distance.find(costing)->second);
   };
   auto timedistancematrix = [&]() {
+    auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
     return time_distance_matrix_.SourceToTarget(*options.mutable_sources(),
                                                 *options.mutable_targets(), *reader, mode_costing,
                                                 mode, max_matrix_distance.find(costing)->second,
                                                 options.matrix_locations(),
                                                 options.date_time_type() == Options::invariant);
   };
+  auto bucketmatrix = [&]() {
+    auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
+    return bucket_matrix_.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing,
+                                         mode, max_matrix_distance.find(costing)->second);
+  };
+  auto contractionmatrix = [&]() {
+    auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
+    return contraction_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
+                                              mode_costing, mode);
+  };
+  auto overlaymatrix = [&]() {
+    auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
+    overlay_matrix_.set_customization(get_customization(options));
+    return overlay_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
+                                          mode_costing, mode);
+  };
 
   if (costing == "bikeshare") {
-    time_distances =
-        time_distance_bss_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
-                                                 mode_costing, mode,
-                                                 max_matrix_distance.find(costing)->second,
-                                                 options.matrix_locations());
+    {
+      auto algorithm_time = measure_scope_time(request, "matrix_algorithm");
+      time_distances =
+          time_distance_bss_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
+                                                   mode_costing, mode,
+                                                   max_matrix_distance.find(costing)->second,
+                                                   options.matrix_locations());
+    }
+    auto serialization_time = measure_scope_time(request, "serialization");
     return tyr::serializeMatrix(request, time_distances, distance_scale);
   }
   switch (source_to_target_algorithm) {
@@ -108,7 +133,16 @@ std::string thor_worker_t::matrix(Api& request) {
           if (has_time(request)) {
             time_distances = timedistancematrix();
           } else {
-            time_distances = costmatrix();
+            // the contraction hierarchy and the overlay leave what they cannot answer to
+            // CostMatrix
+            if (contraction_usable(options)) {
+              time_distances = contractionmatrix();
+            } else if (overlay_usable(options)) {
+              time_distances = overlaymatrix();
+            }
+            if (time_distances.empty()) {
+              time_distances = costmatrix();
+            }
           }
       }
       break;
@@ -118,7 +152,17 @@ std::string thor_worker_t::matrix(Api& request) {
     case TIME_DISTANCE_MATRIX:
       time_distances = timedistancematrix();
       break;
+    case BUCKET_MATRIX:
+      // the buckets only hold time invariant costs and every pair is computed
+      if (has_time(request) ||
+          options.matrix_locations() != std::numeric_limits<uint32_t>::max()) {
+        time_distances = timedistancematrix();
+      } else {
+        time_distances = bucketmatrix();
+      }
+      break;
   }
+  auto serialization_time = measure_scope_time(request, "serialization");
   return tyr::serializeMatrix(request, time_distances, distance_scale);
 }
 } // namespace thor
@@ -58,15 +58,18 @@ void MultiModalPathAlgorithm::Init(const midgard::PointLL& destll,
   // Disable A* for multimodal
   astarheuristic_.Init(destll, 0.0f);
 
-  // Reserve size for edge labels - do this here rather than in constructor so
-  // to limit how much extra memory is used for persistent objects
-  edgelabels_.reserve(std::min(max_reserved_labels_count_, kInitialEdgeLabelCount));
+  // Take storage for edge labels from the arena of this thread and reserve size for them - do
+  // this here rather than in constructor so to limit how much extra memory is used for
+  // persistent objects
+  LabelArena<MMEdgeLabel>::get().acquire(edgelabels_, adjacencylist_,
+                                         std::min(max_reserved_labels_count_,
+                                                  kInitialEdgeLabelCount));
 
   // Construct adjacency list and edge status.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reuse(0.0f, range, bucketsize, &edgelabels_);
+  adjacencylist_.reuse(0.0f, range, bucketsize, &edgelabels_, queue_policy_);
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -76,19 +79,13 @@ void MultiModalPathAlgorithm::Init(const midgard::PointLL& destll,
 
 // Clear the temporary information generated during path construction.
 void MultiModalPathAlgorithm::Clear() {
+  // Hand the edge labels and adjacency list back to the arena of this thread
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
-    edgelabels_.resize(reservation);
-    edgelabels_.shrink_to_fit();
-  }
-  // Clear the edge labels and destination list
-  edgelabels_.clear();
+  LabelArena<MMEdgeLabel>::get().release(edgelabels_, adjacencylist_, reservation);
 
+  // Clear the destination list
   destinations_.clear();
 
-  // Clear elements from the adjacency list
-  adjacencylist_.clear();
-
   // Clear the edge status flags
   edgestatus_.clear();
 
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "midgard/logging.h"
+#include "sif/edgelabel.h"
+#include "thor/overlay.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::sif;
+
+namespace {
+
+constexpr float kNoArc = std::numeric_limits<float>::max();
+
+// Whether the costing needs more than the edge itself, like the rest of the path or the
+// time, to tell if and at which cost a path can use the edge
+bool is_restricted(const DirectedEdge* edge) {
+  return edge->part_of_complex_restriction() || edge->start_restriction() ||
+         edge->end_restriction() || edge->access_restriction() || edge->destonly();
+}
+
+// Position of the end node of a directed edge
+PointLL end_ll(GraphReader& graphreader, const graph_tile_ptr& tile, const DirectedEdge* edge) {
+  graph_tile_ptr end_tile = edge->leaves_tile() ? graphreader.GetGraphTile(edge->endnode()) : tile;
+  return end_tile ? end_tile->get_node_ll(edge->endnode()) : PointLL();
+}
+
+PointLL end_ll(GraphReader& graphreader, const GraphId& edgeid) {
+  graph_tile_ptr tile;
+  const DirectedEdge* edge = graphreader.directededge(edgeid, tile);
+  return edge ? end_ll(graphreader, tile, edge) : PointLL();
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+void OverlaySearch::Clear() {
+  labels_.clear();
+  index_.clear();
+  queue_ = decltype(queue_)();
+}
+
+void OverlaySearch::Add(const GraphId& edge,
+                        const PointLL& ll,
+                        const float cost,
+                        const float secs,
+                        const float length) {
+  auto inserted = index_.emplace(edge.value, labels_.size());
+  if (inserted.second) {
+    labels_.push_back({edge, ll, {}, cost, secs, length, kInvalidLabel, false});
+  } else if (cost < labels_[inserted.first->second].cost) {
+    labels_[inserted.first->second] = {edge, ll, {}, cost, secs, length, kInvalidLabel, false};
+  } else {
+    return;
+  }
+  queue_.emplace(cost, inserted.first->second);
+}
+
+uint32_t OverlaySearch::Next() {
+  while (!queue_.empty()) {
+    auto top = queue_.top();
+    queue_.pop();
+    if (top.first <= labels_[top.second].cost) {
+      return top.second;
+    }
+  }
+  return kInvalidLabel;
+}
+
+void OverlaySearch::Relax(const uint32_t pred,
+                          const GraphId& edge,
+                          const PointLL& ll,
+                          const GraphId& cell,
+                          const float cost,
+                          const float secs,
+                          const float length,
+                          const bool restricted) {
+  const Label& p = labels_[pred];
+  Label label{edge, ll, cell, p.cost + cost, p.secs + secs, p.length + length, pred,
+              p.restricted || restricted};
+  auto inserted = index_.emplace(edge.value, labels_.size());
+  if (inserted.second) {
+    labels_.push_back(label);
+  } else if (label.cost < labels_[inserted.first->second].cost) {
+    labels_[inserted.first->second] = label;
+  } else {
+    return;
+  }
+  queue_.emplace(label.cost, inserted.first->second);
+}
+
+void OverlaySearch::ExpandGraph(const uint32_t idx,
+                                GraphReader& graphreader,
+                                const DynamicCost& costing) {
+  const GraphId edgeid = labels_[idx].edge;
+  graph_tile_ptr tile;
+  const DirectedEdge* edge = graphreader.directededge(edgeid, tile);
+  if (edge == nullptr) {
+    return;
+  }
+  graph_tile_ptr end_tile = edge->leaves_tile() ? graphreader.GetGraphTile(edge->endnode()) : tile;
+  if (end_tile == nullptr) {
+    return;
+  }
+  const NodeInfo* end_node = end_tile->node(edge->endnode());
+  if (!costing.Allowed(end_node)) {
+    return;
+  }
+
+  // The turns only see the edge itself, the path before it is not known
+  BDEdgeLabel pred(kInvalidLabel, edgeid, end_tile->GetOpposingEdgeId(edge), edge, Cost{},
+                   costing.travel_mode(), Cost{}, 0, false, true, false, InternalTurn::kNoTurn, -1);
+  pred.set_not_thru(false);
+
+  std::function<void(const graph_tile_ptr&, const GraphId&, const NodeInfo*, const bool)> expand;
+  expand = [&](const graph_tile_ptr& t, const GraphId& node, const NodeInfo* nodeinfo,
+               const bool from_transition) {
+    GraphId next_id(node.tileid(), node.level(), nodeinfo->edge_index());
+    const DirectedEdge* next = t->directededge(nodeinfo->edge_index());
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++next, ++next_id) {
+      uint8_t restriction_idx = -1;
+      if (!costing.Allowed(next, t, kDisallowShortcut) ||
+          !costing.Allowed(next, false, pred, t, next_id, 0, 0, restriction_idx)) {
+        continue;
+      }
+      uint8_t flow_sources;
+      Cost cost = costing.TransitionCost(next, nodeinfo, pred) +
+                  costing.EdgeCost(next, t, TimeInfo::invalid(), flow_sources);
+      Relax(idx, next_id, end_ll(graphreader, t, next), {}, cost.cost, cost.secs, next->length(),
+            is_restricted(edge) || is_restricted(next));
+    }
+
+    // Handle transitions - expand from the end node of each transition
+    if (!from_transition && nodeinfo->transition_count() > 0) {
+      const NodeTransition* trans = t->transition(nodeinfo->transition_index());
+      for (uint32_t j = 0; j < nodeinfo->transition_count(); ++j, ++trans) {
+        graph_tile_ptr trans_tile = graphreader.GetGraphTile(trans->endnode());
+        if (trans_tile != nullptr) {
+          expand(trans_tile, trans->endnode(), trans_tile->node(trans->endnode()), true);
+        }
+      }
+    }
+  };
+  expand(end_tile, edge->endnode(), end_node, false);
+}
+
+bool OverlaySearch::ExpandClique(const uint32_t idx, const Clique& clique) {
+  const uint32_t entry = clique.cell->EntryIndex(labels_[idx].edge);
+  if (entry == kInvalidBoundary) {
+    return false;
+  }
+  const GraphId cellid(clique.cell->header()->cellid);
+  const uint32_t exit_count = clique.cell->exit_count();
+  const CliqueArc* arc = clique.arcs.data() + static_cast<size_t>(entry) * exit_count;
+  for (uint32_t j = 0; j < exit_count; ++j, ++arc) {
+    if (arc->cost != kNoArc) {
+      Relax(idx, clique.cell->exit(j), clique.exit_lls[j], cellid, arc->cost, arc->secs,
+            arc->length, arc->restricted);
+    }
+  }
+  return true;
+}
+
+const Clique* OverlayCustomization::GetClique(const GraphId& cellid,
+                                              GraphReader& graphreader,
+                                              OverlayReader& overlay,
+                                              const DynamicCost& costing) {
+  auto cached = cliques_.find(cellid.value);
+  if (cached != cliques_.end()) {
+    return cached->second.cell ? &cached->second : nullptr;
+  }
+
+  // Missing cells are cached as well so they are only looked for once
+  Clique clique;
+  clique.cell = overlay.GetCell(cellid, graphreader);
+  if (clique.cell) {
+    const uint32_t entry_count = clique.cell->entry_count();
+    const uint32_t exit_count = clique.cell->exit_count();
+    clique.exit_lls.reserve(exit_count);
+    for (uint32_t j = 0; j < exit_count; ++j) {
+      clique.exit_lls.push_back(end_ll(graphreader, clique.cell->exit(j)));
+    }
+    clique.arcs.assign(static_cast<size_t>(entry_count) * exit_count,
+                       {kNoArc, kNoArc, kNoArc, false});
+
+    OverlaySearch search;
+    for (uint32_t i = 0; i < entry_count && clique.cell; ++i) {
+      const GraphId entry = clique.cell->entry(i);
+      if (!CellSearch(search, cellid, entry, end_ll(graphreader, entry), {}, graphreader, overlay,
+                      costing)) {
+        LOG_WARN("Overlay cell " + std::to_string(cellid) + " could not be customized");
+        clique.cell = nullptr;
+        break;
+      }
+      for (uint32_t j = 0; j < exit_count; ++j) {
+        const auto* label = search.Find(clique.cell->exit(j));
+        if (label != nullptr) {
+          clique.arcs[static_cast<size_t>(i) * exit_count + j] = {label->cost, label->secs,
+                                                                  label->length, label->restricted};
+        }
+      }
+    }
+  }
+  if (!clique.cell) {
+    clique.arcs.clear();
+    clique.exit_lls.clear();
+  }
+  size_ += clique.arcs.size() * sizeof(CliqueArc) + clique.exit_lls.size() * sizeof(PointLL);
+  const auto& stored = cliques_.emplace(cellid.value, std::move(clique)).first->second;
+  return stored.cell ? &stored : nullptr;
+}
+
+bool OverlayCustomization::CellSearch(OverlaySearch& search,
+                                      const GraphId& cellid,
+                                      const GraphId& entry,
+                                      const PointLL& entry_ll,
+                                      const GraphId& target,
+                                      GraphReader& graphreader,
+                                      OverlayReader& overlay,
+                                      const DynamicCost& costing) {
+  const uint32_t level = kOverlayLevels - cellid.level();
+  search.Clear();
+  search.Add(entry, entry_ll, 0.0f, 0.0f, 0.0f);
+  for (uint32_t idx = search.Next(); idx != kInvalidLabel; idx = search.Next()) {
+    const auto label = search.label(idx);
+    if (label.edge == target) {
+      return true;
+    }
+    // The exits are not expanded, the paths of a clique stay inside of its cell
+    if (idx != 0 && OverlayCellId(label.ll, level) != cellid) {
+      continue;
+    }
+    if (level == 1) {
+      search.ExpandGraph(idx, graphreader, costing);
+      continue;
+    }
+    const Clique* clique =
+        GetClique(OverlayCellId(label.ll, level - 1), graphreader, overlay, costing);
+    if (clique == nullptr || !search.ExpandClique(idx, *clique)) {
+      return false;
+    }
+  }
+  return !target.Is_Valid();
+}
+
+bool OverlayCustomization::Unpack(const GraphId& cellid,
+                                  const GraphId& entry,
+                                  const PointLL& entry_ll,
+                                  const GraphId& exit,
+                                  GraphReader& graphreader,
+                                  OverlayReader& overlay,
+                                  const DynamicCost& costing,
+                                  std::vector<GraphId>& edges) {
+  OverlaySearch search;
+  if (!CellSearch(search, cellid, entry, entry_ll, exit, graphreader, overlay, costing)) {
+    return false;
+  }
+
+  std::vector<const OverlaySearch::Label*> labels{search.Find(exit)};
+  while (labels.back()->predecessor != kInvalidLabel) {
+    labels.push_back(&search.label(labels.back()->predecessor));
+  }
+  for (auto next = labels.rbegin() + 1; next != labels.rend(); ++next) {
+    const auto* prev = *(next - 1);
+    if (!(*next)->cell.Is_Valid()) {
+      edges.push_back((*next)->edge);
+    } else if (!Unpack((*next)->cell, prev->edge, prev->ll, (*next)->edge, graphreader, overlay,
+                       costing, edges)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void OverlayQuery::Clear() {
+  ClearOrigin();
+  destination_edges_.clear();
+  destination_cells_.clear();
+  connections_.clear();
+  max_reduction_ = 0.0f;
+}
+
+void OverlayQuery::ClearOrigin() {
+  search_.Clear();
+  origin_edges_.clear();
+  origin_cells_.clear();
+  for (auto& connection : connections_) {
+    connection = {kNoArc, kNoArc, kNoArc, kInvalidLabel, false};
+  }
+}
+
+// Same candidate edges as the bidirectional searches of BucketMatrix
+void OverlayQuery::AddOrigin(const valhalla::Location& location,
+                             GraphReader& graphreader,
+                             const DynamicCost& costing) {
+  // Only skip the edges ending at the location if we have other options
+  bool has_other_edges = false;
+  for (const auto& e : location.correlation().edges()) {
+    has_other_edges = has_other_edges || !e.end_node();
+  }
+
+  for (const auto& edge : location.correlation().edges()) {
+    GraphId edgeid(edge.graph_id());
+    if ((has_other_edges && edge.end_node()) ||
+        costing.AvoidAsOriginEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile;
+    const DirectedEdge* directededge = graphreader.directededge(edgeid, tile);
+    if (directededge == nullptr) {
+      continue;
+    }
+    uint8_t flow_sources;
+    Cost cost = costing.EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources) *
+                (1.0f - edge.percent_along());
+    const PointLL ll = end_ll(graphreader, tile, directededge);
+    search_.Add(edgeid, ll, cost.cost + edge.distance(), cost.secs,
+                directededge->length() * (1.0f - edge.percent_along()));
+    origin_edges_.emplace(edgeid.value, edge.percent_along());
+    for (uint32_t level = 1; level <= kOverlayLevels; ++level) {
+      origin_cells_.insert(OverlayCellId(ll, level).value);
+    }
+  }
+}
+
+void OverlayQuery::AddDestination(const valhalla::Location& location,
+                                  GraphReader& graphreader,
+                                  const DynamicCost& costing) {
+  const uint32_t index = connections_.size();
+  connections_.push_back({kNoArc, kNoArc, kNoArc, kInvalidLabel, false});
+
+  // Only skip the edges starting at the location if we have other options
+  bool has_other_edges = false;
+  for (const auto& e : location.correlation().edges()) {
+    has_other_edges = has_other_edges || !e.begin_node();
+  }
+
+  for (const auto& edge : location.correlation().edges()) {
+    GraphId edgeid(edge.graph_id());
+    if ((has_other_edges && edge.begin_node()) ||
+        costing.AvoidAsDestinationEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile;
+    const DirectedEdge* directededge = graphreader.directededge(edgeid, tile);
+    if (directededge == nullptr) {
+      continue;
+    }
+    uint8_t flow_sources;
+    Cost cost = costing.EdgeCost(directededge, tile, TimeInfo::invalid(), flow_sources) *
+                (1.0f - edge.percent_along());
+    const float percent_along = edge.percent_along();
+    const float distance = edge.distance();
+    destination_edges_[edgeid.value].push_back({index, percent_along, cost.cost, cost.secs,
+                                                directededge->length() * (1.0f - percent_along),
+                                                distance});
+    max_reduction_ = std::max(max_reduction_, cost.cost - distance);
+
+    // The search reaches the destination edges from their start nodes
+    GraphId start_node = graphreader.edge_startnode(edgeid);
+    graph_tile_ptr start_tile = start_node.Is_Valid() ? graphreader.GetGraphTile(start_node) : nullptr;
+    if (start_tile) {
+      const PointLL ll = start_tile->get_node_ll(start_node);
+      for (uint32_t level = 1; level <= kOverlayLevels; ++level) {
+        destination_cells_.insert(OverlayCellId(ll, level).value);
+      }
+    }
+  }
+}
+
+uint32_t OverlayQuery::QueryLevel(const PointLL& ll) const {
+  for (uint32_t level = kOverlayLevels; level > 0; --level) {
+    const uint64_t cell = OverlayCellId(ll, level).value;
+    if (origin_cells_.count(cell) == 0 && destination_cells_.count(cell) == 0) {
+      return level;
+    }
+  }
+  return 0;
+}
+
+bool OverlayQuery::Run(GraphReader& graphreader,
+                       OverlayReader& overlay,
+                       OverlayCustomization& customization,
+                       const DynamicCost& costing) {
+  size_t found = 0;
+  float bound = kNoArc;
+  for (uint32_t idx = search_.Next(); idx != kInvalidLabel; idx = search_.Next()) {
+    const auto label = search_.label(idx);
+    if (found == connections_.size() && label.cost > bound) {
+      break;
+    }
+
+    // Take the part after the destination off the destination edges
+    auto destination = destination_edges_.find(label.edge.value);
+    if (destination != destination_edges_.end()) {
+      for (const auto& d : destination->second) {
+        if (label.predecessor == kInvalidLabel) {
+          auto origin = origin_edges_.find(label.edge.value);
+          if (origin != origin_edges_.end() && d.percent_along < origin->second) {
+            return false;
+          }
+        }
+        auto& connection = connections_[d.index];
+        const float cost = label.cost - d.cost + d.distance;
+        if (cost < connection.cost) {
+          found += connection.label == kInvalidLabel;
+          connection = {cost, label.secs - d.secs, label.length - d.length, idx, label.restricted};
+          if (found == connections_.size()) {
+            bound = 0.0f;
+            for (const auto& c : connections_) {
+              bound = std::max(bound, c.cost);
+            }
+            bound += max_reduction_;
+          }
+        }
+      }
+    }
+
+    // The origin edges end in the cells of the origin so they are expanded over the graph
+    uint32_t level = 0;
+    if (label.predecessor != kInvalidLabel) {
+      level = std::min(QueryLevel(label.ll),
+                       OverlayBoundaryLevel(search_.label(label.predecessor).ll, label.ll));
+    }
+    if (level == 0) {
+      search_.ExpandGraph(idx, graphreader, costing);
+      continue;
+    }
+    const Clique* clique =
+        customization.GetClique(OverlayCellId(label.ll, level), graphreader, overlay, costing);
+    if (clique == nullptr || !search_.ExpandClique(idx, *clique)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OverlayQuery::AppendPath(const Connection& connection,
+                              GraphReader& graphreader,
+                              OverlayReader& overlay,
+                              OverlayCustomization& customization,
+                              const DynamicCost& costing,
+                              std::vector<GraphId>& edges) const {
+  std::vector<const OverlaySearch::Label*> labels{&search_.label(connection.label)};
+  while (labels.back()->predecessor != kInvalidLabel) {
+    labels.push_back(&search_.label(labels.back()->predecessor));
+  }
+  edges.push_back(labels.back()->edge);
+  for (auto next = labels.rbegin() + 1; next != labels.rend(); ++next) {
+    const auto* prev = *(next - 1);
+    if (!(*next)->cell.Is_Valid()) {
+      edges.push_back((*next)->edge);
+    } else if (!customization.Unpack((*next)->cell, prev->edge, prev->ll, (*next)->edge,
+                                     graphreader, overlay, costing, edges)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -0,0 +1,71 @@
+#include <cmath>
+
+#include "midgard/logging.h"
+#include "thor/overlaymatrix.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
+  return a.has_lat_case() == b.has_lat_case() && a.has_lng_case() == b.has_lng_case() &&
+         (!a.has_lat_case() || a.lat() == b.lat()) && (!a.has_lng_case() || a.lng() == b.lng());
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+void OverlayMatrix::clear() {
+  query_.Clear();
+  customization_.reset();
+  if (overlay_) {
+    overlay_->Trim();
+  }
+}
+
+std::vector<TimeDistance> OverlayMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const travel_mode_t mode) {
+  if (!overlay_ || !customization_) {
+    return {};
+  }
+  const auto& costing = mode_costing[static_cast<uint32_t>(mode)];
+
+  query_.Clear();
+  for (const auto& target : target_location_list) {
+    query_.AddDestination(target, graphreader, *costing);
+  }
+
+  std::vector<TimeDistance> td;
+  td.reserve(source_location_list.size() * target_location_list.size());
+  for (const auto& source : source_location_list) {
+    query_.ClearOrigin();
+    query_.AddOrigin(source, graphreader, *costing);
+    if (!query_.Run(graphreader, *overlay_, *customization_, *costing)) {
+      LOG_WARN("Overlay cannot answer the matrix");
+      return {};
+    }
+    for (int j = 0; j < target_location_list.size(); j++) {
+      const auto& connection = query_.connections()[j];
+      if (equals(source.ll(), target_location_list.Get(j).ll())) {
+        td.emplace_back(0, 0);
+      } else if (connection.restricted) {
+        return {};
+      } else if (connection.label == kInvalidLabel) {
+        td.emplace_back(kMaxCost, kMaxCost);
+      } else {
+        td.emplace_back(std::round(connection.secs), std::round(connection.length));
+      }
+    }
+  }
+  return td;
+}
+
+} // namespace thor
+} // namespace valhalla
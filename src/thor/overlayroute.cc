@@ -0,0 +1,100 @@
+#include "thor/overlayroute.h"
+#include "midgard/logging.h"
+#include "sif/recost.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+OverlayRoute::OverlayRoute(const boost::property_tree::ptree& config)
+    : PathAlgorithm(0, config.get<bool>("clear_reserved_memory", false)) {
+}
+
+void OverlayRoute::Clear() {
+  query_.Clear();
+  customization_.reset();
+  if (overlay_) {
+    overlay_->Trim();
+  }
+}
+
+std::vector<std::vector<PathInfo>> OverlayRoute::GetBestPath(valhalla::Location& origin,
+                                                             valhalla::Location& dest,
+                                                             GraphReader& graphreader,
+                                                             const mode_costing_t& mode_costing,
+                                                             const travel_mode_t mode,
+                                                             const Options& options) {
+  has_ferry_ = false;
+  label_count_ = 0;
+  if (!overlay_ || !customization_) {
+    return {};
+  }
+  const auto& costing = mode_costing[static_cast<uint32_t>(mode)];
+
+  query_.Clear();
+  query_.AddDestination(dest, graphreader, *costing);
+  query_.AddOrigin(origin, graphreader, *costing);
+  const bool complete = query_.Run(graphreader, *overlay_, *customization_, *costing);
+  label_count_ = query_.label_count();
+  if (!complete) {
+    return {};
+  }
+  const auto& connection = query_.connections().front();
+  if (connection.label == kInvalidLabel || connection.restricted) {
+    return {};
+  }
+
+  std::vector<GraphId> path_edges;
+  if (!query_.AppendPath(connection, graphreader, *overlay_, *customization_, *costing,
+                         path_edges)) {
+    LOG_ERROR("Overlay failed to unpack a clique arc");
+    return {};
+  }
+
+  float source_pct = -1.0f, target_pct = -1.0f;
+  for (const auto& e : origin.correlation().edges()) {
+    if (e.graph_id() == path_edges.front()) {
+      source_pct = e.percent_along();
+    }
+  }
+  for (const auto& e : dest.correlation().edges()) {
+    if (e.graph_id() == path_edges.back()) {
+      target_pct = e.percent_along();
+    }
+  }
+  if (source_pct < 0.0f || target_pct < 0.0f) {
+    throw std::logic_error("Could not find candidate edge used for overlay path");
+  }
+
+  // Recost the unpacked edges, the clique arcs do not hold the turns onto the edges they skip
+  std::vector<PathInfo> path;
+  path.reserve(path_edges.size());
+  auto edge_itr = path_edges.begin();
+  const auto edge_cb = [&edge_itr, &path_edges]() {
+    return (edge_itr == path_edges.end()) ? GraphId{} : (*edge_itr++);
+  };
+  const auto label_cb = [&path](const EdgeLabel& label) {
+    path.emplace_back(label.mode(), label.cost(), label.edgeid(), 0, label.path_distance(),
+                      label.restriction_idx(), label.transition_cost(), false);
+  };
+  try {
+    auto time_info = TimeInfo::make(origin, graphreader, &tz_cache_);
+    recost_forward(graphreader, *costing, edge_cb, label_cb, source_pct, target_pct, time_info,
+                   options.date_time_type() == Options::invariant, true);
+  } catch (const std::exception& e) {
+    LOG_ERROR(std::string("Overlay failed to recost final path: ") + e.what());
+    return {};
+  }
+
+  for (const auto& edge : path_edges) {
+    if (graphreader.directededge(edge)->use() == Use::kFerry) {
+      has_ferry_ = true;
+    }
+  }
+  return {std::move(path)};
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -239,6 +239,8 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &contraction_hierarchy,
+           &overlay_route,
        }) {
     alg->set_interrupt(interrupt);
   }
@@ -289,6 +291,21 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
     }
   }
 
+  // Default auto routes without time are answered from the contraction hierarchy, get_path
+  // falls back to bidirectional a* if it cannot answer
+  if (routetype == "auto" && options.alternates() == 0 && origin.date_time().empty() &&
+      destination.date_time().empty() && contraction_usable(options)) {
+    return &contraction_hierarchy;
+  }
+
+  // Routes of other costing options without time are answered from the overlay customized
+  // for them, get_path falls back to bidirectional a* if it cannot answer
+  if (options.alternates() == 0 && origin.date_time().empty() && destination.date_time().empty() &&
+      overlay_usable(options)) {
+    overlay_route.set_customization(get_customization(options));
+    return &overlay_route;
+  }
+
   // No other special cases we land on bidirectional a*
   return &bidir_astar;
 }
@@ -297,10 +314,28 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
                                                                  valhalla::Location& origin,
                                                                  valhalla::Location& destination,
                                                                  const std::string& costing,
-                                                                 const Options& options) {
+                                                                 Api& api) {
+  // time the path algorithm and keep track of how much work it did
+  auto _ = measure_scope_time(api, "path_algorithm");
+  const Options& options = api.options();
+
   // Find the path.
   valhalla::sif::cost_ptr_t cost = mode_costing[static_cast<uint32_t>(mode)];
 
+  // The contraction hierarchy and the overlay return no path when the best one needs more
+  // than they hold
+  if (path_algorithm == &contraction_hierarchy || path_algorithm == &overlay_route) {
+    cost->set_pass(0);
+    auto paths =
+        path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+    add_count(api, "labels_created", path_algorithm->label_count());
+    if (!paths.empty()) {
+      return paths;
+    }
+    path_algorithm = &bidir_astar;
+    path_algorithm->Clear();
+  }
+
   // If bidirectional A* disable use of destination-only edges on the
   // first pass. If there is a failure, we allow them on the second pass.
   // Other path algorithms can use destination-only edges on the first pass.
@@ -308,6 +343,7 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
 
   cost->set_pass(0);
   auto paths = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+  add_count(api, "labels_created", path_algorithm->label_count());
 
   // Check if we should run a second pass pedestrian route with different A*
   // (to look for better routes where a ferry is taken)
@@ -340,6 +376,7 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
     // Get the best path. Return if not empty (else return the original path)
     auto relaxed_paths =
         path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+    add_count(api, "labels_created", path_algorithm->label_count());
     if (!relaxed_paths.empty()) {
       return relaxed_paths;
     }
@@ -375,7 +412,7 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
     }
 
     // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
+    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, api);
     if (temp_paths.empty())
       return false;
 
@@ -451,9 +488,12 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
-        TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(), path.end(),
-                              *origin, *destination, leg, algorithms, interrupt, edge_trimming,
-                              intermediates);
+        {
+          auto tripleg_time = this->measure_scope_time(api, "triplegbuilder");
+          TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
+                                path.end(), *origin, *destination, leg, algorithms, interrupt,
+                                edge_trimming, intermediates);
+        }
 
         // advance the time for the next destination (i.e. algo origin) by the waiting_secs
         // of this origin (i.e. algo destination)
@@ -547,7 +587,7 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
                         [&last_edge](const auto& edge) { return edge.graph_id() != last_edge; });
     }
     // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
+    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, api);
     if (temp_paths.empty())
       return false;
 
@@ -604,9 +644,12 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
-        thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
-                                    path.end(), *origin, *destination, leg, algorithms, interrupt,
-                                    edge_trimming, {std::next(origin), destination});
+        {
+          auto tripleg_time = this->measure_scope_time(api, "triplegbuilder");
+          thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
+                                      path.end(), *origin, *destination, leg, algorithms,
+                                      interrupt, edge_trimming, {std::next(origin), destination});
+        }
 
         path.clear();
         edge_trimming.clear();
@@ -34,7 +34,8 @@ namespace valhalla {
 namespace thor {
 
 // Constructor with cost threshold.
-TimeDistanceBSSMatrix::TimeDistanceBSSMatrix() : settled_count_(0), current_cost_threshold_(0) {
+TimeDistanceBSSMatrix::TimeDistanceBSSMatrix()
+    : settled_count_(0), current_cost_threshold_(0), queue_policy_(QueuePolicy::kDoubleBucket) {
 }
 
 float TimeDistanceBSSMatrix::GetCostThreshold(const float max_matrix_distance) const {
@@ -201,7 +202,7 @@ std::vector<TimeDistance> TimeDistanceBSSMatrix::ComputeMatrix(
     std::vector<TimeDistance> one_to_many;
 
     current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
-    adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
+    adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_, queue_policy_);
 
     // Initialize the origin and set the available destination edges
     settled_count_ = 0;
@@ -58,7 +58,8 @@ namespace thor {
 
 // Constructor with cost threshold.
 TimeDistanceMatrix::TimeDistanceMatrix()
-    : mode_(travel_mode_t::kDrive), settled_count_(0), current_cost_threshold_(0) {
+    : mode_(travel_mode_t::kDrive), settled_count_(0), current_cost_threshold_(0),
+      queue_policy_(QueuePolicy::kDoubleBucket) {
 }
 
 // Compute a cost threshold in seconds based on average speed for the travel mode.
@@ -237,7 +238,7 @@ std::vector<TimeDistance> TimeDistanceMatrix::ComputeMatrix(
 
     // Construct adjacency list, edge status, and done set. Set bucket size and
     // cost range based on DynamicCost.
-    adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
+    adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_, queue_policy_);
 
     // Initialize the origin and set the available destination edges
     settled_count_ = 0;
@@ -184,7 +184,20 @@ thor_worker_t::map_match(Api& request) {
   int topk = request.options().action() == Options::trace_attributes
                  ? request.options().alternates() + 1
                  : 1;
-  auto topk_match_results = matcher->OfflineMatch(trace, topk);
+  // trace_attributes of a single path can match long traces in a sliding window, which keeps the
+  // viterbi states and candidates from growing with the length of the trace. the results of every
+  // window are still collected here since the path and the attributes are formed from all of them
+  // at the end, so those and the response do grow with the trace
+  // TODO: form the path and serialize the attributes of every window as StreamingMatch commits it
+  // so that the whole request is bounded and max_shape can be raised for it
+  std::vector<meili::MatchResults> topk_match_results;
+  const auto streaming_window = matcher->config().streaming.window;
+  if (topk == 1 && options.action() == Options::trace_attributes && streaming_window > 1 &&
+      trace.size() > streaming_window) {
+    topk_match_results.emplace_back(matcher->StreamingMatch(trace));
+  } else {
+    topk_match_results = matcher->OfflineMatch(trace, topk);
+  }
 
   // Process each score/match result
   std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>> map_match_results;
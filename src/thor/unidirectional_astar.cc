@@ -22,7 +22,9 @@ UnidirectionalAStar<expansion_direction, FORWARD>::UnidirectionalAStar(
     : PathAlgorithm(config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCount),
                     config.get<bool>("clear_reserved_memory", false)),
       max_label_count_(std::numeric_limits<uint32_t>::max()), mode_(travel_mode_t::kDrive),
-      travel_type_(0), access_mode_{kAutoAccess} {
+      travel_type_(0),
+      edgestatus_(clear_reserved_memory_ ? 0 : EdgeStatus::kDefaultMaxRetained),
+      access_mode_{kAutoAccess} {
 }
 
 // Default constructor
@@ -36,16 +38,11 @@ template UnidirectionalAStar<ExpansionType::reverse>::UnidirectionalAStar(
 // Clear the temporary information generated during path construction.
 template <const ExpansionType expansion_direction, const bool FORWARD>
 void UnidirectionalAStar<expansion_direction, FORWARD>::Clear() {
-  // Clear the edge labels and destination list. Reset the adjacency list
-  // and clear edge status.
+  // Hand the edge labels and adjacency list back to the arena of this thread. Clear the
+  // destination list and edge status.
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
-    edgelabels_.resize(reservation);
-    edgelabels_.shrink_to_fit();
-  }
-  edgelabels_.clear();
+  LabelArena<BDEdgeLabel>::get().release(edgelabels_, adjacencylist_, reservation);
   destinations_percent_along_.clear();
-  adjacencylist_.clear();
   edgestatus_.clear();
 
   // Set the ferry flag to false
@@ -583,13 +580,15 @@ void UnidirectionalAStar<expansion_direction, FORWARD>::Init(const midgard::Poin
     astarheuristic_.Init(origll, costing_->AStarCostFactor());
     mincost = astarheuristic_.Get(destll);
   }
-  edgelabels_.reserve(std::min(max_reserved_labels_count_, kInitialEdgeLabelCount));
+  LabelArena<BDEdgeLabel>::get().acquire(edgelabels_, adjacencylist_,
+                                         std::min(max_reserved_labels_count_,
+                                                  kInitialEdgeLabelCount));
 
   // Construct adjacency list, clear edge status.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_);
+  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_, queue_policy_);
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
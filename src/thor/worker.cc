@@ -31,6 +31,15 @@ namespace {
 // route starts to become suspect (due to user breaks and other factors).
 constexpr float kDefaultMaxTimeDependentDistance = 500000.0f; // 500 km
 
+// Default bytes of contraction tiles cached per worker, same as the graph tiles
+constexpr size_t kDefaultContractionCacheSize = 1073741824; // 1 GB
+
+// Default number of overlay customizations, one per set of costing options, kept per worker
+constexpr size_t kDefaultMaxCustomizations = 8;
+
+// Default bytes of customized cliques kept per worker
+constexpr size_t kDefaultMaxCustomizationSize = 1073741824; // 1 GB
+
 // Maximum edge score - base this on costing type.
 // Large values can cause very bad performance. Setting this back
 // to 2 hours for bike and pedestrian and 12 hours for driving routes.
@@ -69,7 +78,9 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
     : service_worker_t(config), mode(valhalla::sif::TravelMode::kPedestrian),
       bidir_astar(config.get_child("thor")), bss_astar(config.get_child("thor")),
       multi_modal_astar(config.get_child("thor")), timedep_forward(config.get_child("thor")),
-      timedep_reverse(config.get_child("thor")), isochrone_gen(config.get_child("thor")),
+      timedep_reverse(config.get_child("thor")), contraction_hierarchy(config.get_child("thor")),
+      overlay_route(config.get_child("thor")), costmatrix_(config.get_child("thor")),
+      isochrone_gen(config.get_child("thor")),
       reader(graph_reader ? graph_reader
                           : std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"))),
       matcher_factory(config, reader), controller{} {
@@ -94,6 +105,8 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
     source_to_target_algorithm = TIME_DISTANCE_MATRIX;
   } else if (conf_algorithm == "costmatrix") {
     source_to_target_algorithm = COST_MATRIX;
+  } else if (conf_algorithm == "bucketmatrix") {
+    source_to_target_algorithm = BUCKET_MATRIX;
   } else {
     source_to_target_algorithm = SELECT_OPTIMAL;
   }
@@ -101,6 +114,51 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
   max_timedep_distance =
       config.get<float>("service_limits.max_timedep_distance", kDefaultMaxTimeDependentDistance);
 
+  // Select the priority queue of the adjacency lists for each action based on the conf file
+  // (defaults to double_bucket for actions not present)
+  if (auto queue_policy = config.get_child_optional("thor.queue_policy")) {
+    for (const auto& kv : *queue_policy) {
+      Options::Action action;
+      if (!Options_Action_Enum_Parse(kv.first, &action)) {
+        throw std::runtime_error("Unknown action in thor.queue_policy: " + kv.first);
+      }
+      const auto policy = kv.second.get_value<std::string>();
+      if (policy == "radix_heap") {
+        queue_policies[action] = baldr::QueuePolicy::kRadixHeap;
+      } else if (policy == "double_bucket") {
+        queue_policies[action] = baldr::QueuePolicy::kDoubleBucket;
+      } else {
+        throw std::runtime_error("Unknown queue policy for " + kv.first + ": " + policy);
+      }
+    }
+  }
+
+  // Default auto routes and matrices are answered from the contraction hierarchy if one was built
+  auto contraction_dir = config.get<std::string>("mjolnir.contraction_dir", "");
+  if (!contraction_dir.empty() && config.get<bool>("thor.use_contraction", true)) {
+    contraction_reader =
+        std::make_shared<baldr::ContractionReader>(contraction_dir,
+                                                   config.get<size_t>("mjolnir.max_cache_size",
+                                                                      kDefaultContractionCacheSize));
+    contraction_hierarchy.set_contraction_reader(contraction_reader);
+    contraction_matrix_.set_contraction_reader(contraction_reader);
+  }
+
+  // Routes and matrices of any costing are answered from the overlay if one was built
+  auto overlay_dir = config.get<std::string>("mjolnir.overlay_dir", "");
+  if (!overlay_dir.empty() && config.get<bool>("thor.use_overlay", true)) {
+    overlay_reader =
+        std::make_shared<baldr::OverlayReader>(overlay_dir,
+                                               config.get<size_t>("mjolnir.max_cache_size",
+                                                                  kDefaultContractionCacheSize));
+    overlay_route.set_overlay_reader(overlay_reader);
+    overlay_matrix_.set_overlay_reader(overlay_reader);
+  }
+  max_customizations = config.get<size_t>("thor.max_customizations", kDefaultMaxCustomizations);
+  max_customization_size =
+      config.get<size_t>("thor.max_customization_size", kDefaultMaxCustomizationSize);
+  contour_concurrency = std::max(config.get<uint32_t>("thor.contour_concurrency", 1), 1u);
+
   // signal that the worker started successfully
   started();
 }
@@ -223,9 +281,54 @@ std::string thor_worker_t::parse_costing(const Api& request) {
   auto costing = options.costing_type();
   auto costing_str = Costing_Enum_Name(costing);
   mode_costing = factory.CreateModeCosting(options, mode);
+  set_queue_policy(options.action());
   return costing_str;
 }
 
+void thor_worker_t::set_queue_policy(const Options::Action action) {
+  auto found = queue_policies.find(action);
+  auto policy = found == queue_policies.end() ? baldr::QueuePolicy::kDoubleBucket : found->second;
+  for (PathAlgorithm* algorithm : std::initializer_list<PathAlgorithm*>{
+           &bidir_astar, &bss_astar, &multi_modal_astar, &timedep_forward, &timedep_reverse}) {
+    algorithm->set_queue_policy(policy);
+  }
+  costmatrix_.set_queue_policy(policy);
+  time_distance_matrix_.set_queue_policy(policy);
+  bucket_matrix_.set_queue_policy(policy);
+  time_distance_bss_matrix_.set_queue_policy(policy);
+  isochrone_gen.set_queue_policy(policy);
+  centroid_gen.set_queue_policy(policy);
+}
+
+bool thor_worker_t::contraction_usable(const Options& options) const {
+  auto costing = options.costings().find(options.costing_type());
+  return contraction_reader && options.costing_type() == Costing::auto_ &&
+         costing != options.costings().cend() && sif::IsDefaultCosting(costing->second) &&
+         !reader->HasLiveTraffic();
+}
+
+bool thor_worker_t::overlay_usable(const Options& options) const {
+  return overlay_reader && options.costing_type() != Costing::multimodal &&
+         options.costing_type() != Costing::bikeshare && !reader->HasLiveTraffic();
+}
+
+std::shared_ptr<OverlayCustomization> thor_worker_t::get_customization(const Options& options) {
+  auto costing = options.costings().find(options.costing_type());
+  if (costing == options.costings().cend()) {
+    return nullptr;
+  }
+  auto key = sif::CostingKey(costing->second);
+  auto cached = customizations.find(key);
+  if (cached != customizations.end()) {
+    return cached->second;
+  }
+  // Like the tile cache, start over once it is full
+  if (customizations.size() >= max_customizations) {
+    customizations.clear();
+  }
+  return customizations[std::move(key)] = std::make_shared<OverlayCustomization>();
+}
+
 void thor_worker_t::adjust_scores(valhalla::Options& options) {
   for (auto* locations :
        {options.mutable_locations(), options.mutable_sources(), options.mutable_targets()}) {
@@ -312,10 +415,24 @@ void thor_worker_t::cleanup() {
   trace.clear();
   costmatrix_.clear();
   time_distance_matrix_.clear();
+  bucket_matrix_.clear();
   time_distance_bss_matrix_.clear();
+  contraction_hierarchy.Clear();
+  contraction_matrix_.clear();
+  overlay_route.Clear();
+  overlay_matrix_.clear();
+  size_t customization_size = 0;
+  for (const auto& customization : customizations) {
+    customization_size += customization.second->size();
+  }
+  if (customization_size > max_customization_size) {
+    customizations.clear();
+  }
   isochrone_gen.Clear();
   centroid_gen.Clear();
   matcher_factory.ClearFullCache();
+  // the next request reads the live traffic which is current then
+  reader->UnpinTrafficSnapshot();
   if (reader->OverCommitted()) {
     reader->Trim();
   }
@@ -55,6 +55,9 @@ std::string actor_t::act(Api& api, const std::function<void()>* interrupt) {
   if (api.options().action() == Options::no_action)
     throw valhalla_exception_t{106};
 
+  // time the whole request
+  auto _ = measure_phase_time(api, "tyr", "act");
+
   switch (api.options().action()) {
     case Options::route:
       return route("", interrupt, &api);
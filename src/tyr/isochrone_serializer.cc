@@ -1,5 +1,5 @@
 
-#include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "midgard/point2.h"
 #include "midgard/pointll.h"
 #include "tyr/serializers.h"
@@ -8,11 +8,20 @@
 #include <sstream>
 #include <utility>
 
-using namespace valhalla::baldr::json;
-
 namespace {
 using rgba_t = std::tuple<float, float, float>;
+
+// writes the points of a contour, the caller opens and closes the array around them
+void serialize_contour(const valhalla::midgard::GriddedData<2>::contour_t& contour,
+                       rapidjson::writer_wrapper_t& writer) {
+  for (const auto& coord : contour) {
+    writer.start_array();
+    writer.fixed(coord.first, 6);
+    writer.fixed(coord.second, 6);
+    writer.end_array();
+  }
 }
+} // namespace
 
 namespace valhalla {
 namespace tyr {
@@ -22,9 +31,17 @@ std::string serializeIsochrones(const Api& request,
                                 midgard::GriddedData<2>::contours_t& contours,
                                 bool polygons,
                                 bool show_locations) {
+  // the buffer is kept around between requests on this thread
+  thread_local rapidjson::writer_wrapper_t writer(4096, true);
+  writer.clear();
+
+  // make the collection
+  writer.start_object();
+  writer("type", "FeatureCollection");
+  writer.start_array("features");
+
   // for each contour interval
   int i = 0;
-  auto features = array({});
   assert(intervals.size() == contours.size());
   for (size_t contour_index = 0; contour_index < intervals.size(); ++contour_index) {
     const auto& interval = intervals[contour_index];
@@ -47,43 +64,41 @@ std::string serializeIsochrones(const Api& request,
           << static_cast<int>(std::get<2>(color) * 255 + .5f);
     }
     ++i;
+    const auto color = hex.str();
 
     // for each feature on that interval
     for (const auto& feature : feature_collection) {
+      // add a feature
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("geometry");
+      writer("type", polygons ? "Polygon" : "LineString");
       // for each contour in that feature
-      auto geom = array({});
-      for (const auto& contour : feature) {
-        // make some geometry
-        auto coords = array({});
-        for (const auto& coord : contour) {
-          coords->push_back(array({fixed_t{coord.first, 6}, fixed_t{coord.second, 6}}));
-        }
+      writer.start_array("coordinates");
+      if (polygons) {
         // its either a ring
-        if (polygons) {
-          geom->emplace_back(coords);
-          // or a single line, if someone has more than one contour per feature they messed up
-        } else {
-          geom = coords;
+        for (const auto& contour : feature) {
+          writer.start_array();
+          serialize_contour(contour, writer);
+          writer.end_array();
         }
+      } else if (!feature.empty()) {
+        // or a single line, if someone has more than one contour per feature they messed up
+        serialize_contour(feature.back(), writer);
       }
-      // add a feature
-      features->emplace_back(map({
-          {"type", std::string("Feature")},
-          {"geometry", map({
-                           {"type", std::string(polygons ? "Polygon" : "LineString")},
-                           {"coordinates", geom},
-                       })},
-          {"properties", map({
-                             {"metric", std::get<2>(interval)},
-                             {"contour", baldr::json::float_t{std::get<1>(interval)}},
-                             {"color", hex.str()},               // lines
-                             {"fill", hex.str()},                // geojson.io polys
-                             {"fillColor", hex.str()},           // leaflet polys
-                             {"opacity", fixed_t{.33f, 2}},      // lines
-                             {"fill-opacity", fixed_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fixed_t{.33f, 2}},  // leaflet polys
-                         })},
-      }));
+      writer.end_array();
+      writer.end_object();
+      writer.start_object("properties");
+      writer("metric", std::get<2>(interval));
+      writer.significant("contour", std::get<1>(interval));
+      writer("color", color);                // lines
+      writer("fill", color);                 // geojson.io polys
+      writer("fillColor", color);            // leaflet polys
+      writer.fixed("opacity", .33f, 2);      // lines
+      writer.fixed("fill-opacity", .33f, 2); // geojson.io polys
+      writer.fixed("fillOpacity", .33f, 2);  // leaflet polys
+      writer.end_object();
+      writer.end_object();
     }
   }
   // Add input and snapped locations to the geojson
@@ -91,56 +106,68 @@ std::string serializeIsochrones(const Api& request,
     int idx = 0;
     for (const auto& location : request.options().locations()) {
       // first add all snapped points as MultiPoint feature per origin point
-      auto snapped_points_array = array({});
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("properties");
+      writer("type", "snapped");
+      writer("location_index", static_cast<uint64_t>(idx));
+      writer.end_object();
+      writer.start_object("geometry");
+      writer("type", "MultiPoint");
+      writer.start_array("coordinates");
       std::unordered_set<midgard::PointLL> snapped_points;
       for (const auto& path_edge : location.correlation().edges()) {
         const midgard::PointLL& snapped_current =
             midgard::PointLL(path_edge.ll().lng(), path_edge.ll().lat());
         // remove duplicates of path_edges in case the snapped object is a node
         if (snapped_points.insert(snapped_current).second) {
-          snapped_points_array->push_back(
-              array({fixed_t{snapped_current.lng(), 6}, fixed_t{snapped_current.lat(), 6}}));
+          writer.start_array();
+          writer.fixed(snapped_current.lng(), 6);
+          writer.fixed(snapped_current.lat(), 6);
+          writer.end_array();
         }
       };
-      features->emplace_back(map(
-          {{"type", std::string("Feature")},
-           {"properties",
-            map({{"type", std::string("snapped")}, {"location_index", static_cast<uint64_t>(idx)}})},
-           {"geometry",
-            map({{"type", std::string("MultiPoint")}, {"coordinates", snapped_points_array}})}}));
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
 
       // then each user input point as separate Point feature
       const valhalla::LatLng& input_latlng = location.ll();
-      const auto input_array =
-          array({fixed_t{input_latlng.lng(), 6}, fixed_t{input_latlng.lat(), 6}});
-      features->emplace_back(map(
-          {{"type", std::string("Feature")},
-           {"properties",
-            map({{"type", std::string("input")}, {"location_index", static_cast<uint64_t>(idx)}})},
-           {"geometry", map({{"type", std::string("Point")}, {"coordinates", input_array}})}}));
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("properties");
+      writer("type", "input");
+      writer("location_index", static_cast<uint64_t>(idx));
+      writer.end_object();
+      writer.start_object("geometry");
+      writer("type", "Point");
+      writer.start_array("coordinates");
+      writer.fixed(input_latlng.lng(), 6);
+      writer.fixed(input_latlng.lat(), 6);
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
       idx++;
     }
   }
-
-  // make the collection
-  auto feature_collection = map({
-      {"type", std::string("FeatureCollection")},
-      {"features", features},
-  });
+  writer.end_array();
 
   if (request.options().has_id_case()) {
-    feature_collection->emplace("id", request.options().id());
+    writer("id", request.options().id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    feature_collection->emplace("warnings", serializeWarnings(request));
+    serializeWarnings(request, writer);
   }
 
-  std::stringstream ss;
-  ss << *feature_collection;
+  // add the timings and counters if they were asked for
+  if (request.options().statistics()) {
+    serializeStatistics(request, writer);
+  }
 
-  return ss.str();
+  writer.end_object();
+  return std::string(writer.get_buffer(), writer.get_length());
 }
 } // namespace tyr
 } // namespace valhalla
@@ -1,6 +1,6 @@
 #include <cstdint>
 
-#include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "proto_conversions.h"
 #include "thor/costmatrix.h"
 #include "tyr/serializers.h"
@@ -12,63 +12,71 @@ using namespace valhalla::thor;
 
 namespace osrm_serializers {
 
-json::ArrayPtr
-serialize_duration(const std::vector<TimeDistance>& tds, size_t start_td, const size_t td_count) {
-  auto time = json::array({});
+void serialize_duration(const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for time in matrix result
     if (tds[i].time != kMaxCost) {
-      time->emplace_back(static_cast<uint64_t>(tds[i].time));
+      writer(static_cast<uint64_t>(tds[i].time));
     } else {
-      time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return time;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_distance(const std::vector<TimeDistance>& tds,
-                                  size_t start_td,
-                                  const size_t td_count,
-                                  const size_t /* source_index */,
-                                  const size_t /* target_index */,
-                                  double distance_scale) {
-  auto distance = json::array({});
+void serialize_distance(const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        double distance_scale,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance in matrix result
     if (tds[i].time != kMaxCost) {
-      distance->emplace_back(json::fixed_t{tds[i].dist * distance_scale, 3});
+      writer.fixed(tds[i].dist * distance_scale, 3);
     } else {
-      distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return distance;
+  writer.end_array();
 }
 
 // Serialize route response in OSRM compatible format.
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  auto json = json::map({});
-  auto time = json::array({});
-  auto distance = json::array({});
+void serialize(const Api& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale,
+               rapidjson::writer_wrapper_t& writer) {
   const auto& options = request.options();
 
   // If here then the matrix succeeded. Set status code to OK and serialize
   // waypoints (locations).
-  json->emplace("code", std::string("Ok"));
-  json->emplace("sources", osrm::waypoints(options.sources()));
-  json->emplace("destinations", osrm::waypoints(options.targets()));
+  writer.start_object();
+  writer("code", "Ok");
+  writer.start_array("sources");
+  osrm::waypoints(options.sources(), writer);
+  writer.end_array();
+  writer.start_array("destinations");
+  osrm::waypoints(options.targets(), writer);
+  writer.end_array();
+
+  writer.start_array("durations");
+  for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
+    serialize_duration(time_distances, source_index * options.targets_size(),
+                       options.targets_size(), writer);
+  }
+  writer.end_array();
 
+  writer.start_array("distances");
   for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    time->emplace_back(serialize_duration(time_distances, source_index * options.targets_size(),
-                                          options.targets_size()));
-    distance->emplace_back(serialize_distance(time_distances, source_index * options.targets_size(),
-                                              options.targets_size(), source_index, 0,
-                                              distance_scale));
+    serialize_distance(time_distances, source_index * options.targets_size(),
+                       options.targets_size(), distance_scale, writer);
   }
-  json->emplace("durations", time);
-  json->emplace("distances", distance);
-  return json;
+  writer.end_array();
+  writer.end_object();
 }
 } // namespace osrm_serializers
 
@@ -79,71 +87,84 @@ valhalla output looks like this:
 
 */
 
-json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated) {
-  auto input_locs = json::array({});
-  for (size_t i = 0; i < correlated.size(); i++) {
-    input_locs->emplace_back(json::map({{"lat", json::fixed_t{correlated.Get(i).ll().lat(), 6}},
-                                        {"lon", json::fixed_t{correlated.Get(i).ll().lng(), 6}}}));
+void locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated,
+               rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
+  for (const auto& location : correlated) {
+    writer.start_object();
+    writer.fixed("lat", location.ll().lat(), 6);
+    writer.fixed("lon", location.ll().lng(), 6);
+    writer.end_object();
   }
-  return input_locs;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
-                             size_t start_td,
-                             const size_t td_count,
-                             const size_t source_index,
-                             const size_t target_index,
-                             double distance_scale) {
-  auto row = json::array({});
+void serialize_row(const std::vector<TimeDistance>& tds,
+                   size_t start_td,
+                   const size_t td_count,
+                   const size_t source_index,
+                   const size_t target_index,
+                   double distance_scale,
+                   rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance & time in matrix
     // result
-    json::MapPtr map;
+    writer.start_object();
+    writer("from_index", static_cast<uint64_t>(source_index));
+    writer("to_index", static_cast<uint64_t>(target_index + (i - start_td)));
     if (tds[i].time != kMaxCost) {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<uint64_t>(tds[i].time)},
-                       {"distance", json::fixed_t{tds[i].dist * distance_scale, 3}}});
+      writer("time", static_cast<uint64_t>(tds[i].time));
+      writer.fixed("distance", tds[i].dist * distance_scale, 3);
       if (!tds[i].date_time.empty()) {
-        map->emplace("date_time", tds[i].date_time);
+        writer("date_time", tds[i].date_time);
       }
     } else {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<std::nullptr_t>(nullptr)},
-                       {"distance", static_cast<std::nullptr_t>(nullptr)}});
+      writer("time", nullptr);
+      writer("distance", nullptr);
     }
-    row->emplace_back(map);
+    writer.end_object();
   }
-  return row;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  json::ArrayPtr matrix = json::array({});
+void serialize(const Api& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale,
+               rapidjson::writer_wrapper_t& writer) {
   const auto& options = request.options();
+  writer.start_object();
+  writer.start_array("sources_to_targets");
   for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    matrix->emplace_back(serialize_row(time_distances, source_index * options.targets_size(),
-                                       options.targets_size(), source_index, 0, distance_scale));
+    serialize_row(time_distances, source_index * options.targets_size(), options.targets_size(),
+                  source_index, 0, distance_scale, writer);
   }
-  auto json = json::map({
-      {"sources_to_targets", matrix},
-      {"units", Options_Units_Enum_Name(options.units())},
-  });
-  json->emplace("targets", json::array({locations(options.targets())}));
-  json->emplace("sources", json::array({locations(options.sources())}));
+  writer.end_array();
+  writer("units", Options_Units_Enum_Name(options.units()));
+
+  // the locations are nested in an outer array
+  writer.start_array("targets");
+  locations(options.targets(), writer);
+  writer.end_array();
+  writer.start_array("sources");
+  locations(options.sources(), writer);
+  writer.end_array();
 
   if (options.has_id_case()) {
-    json->emplace("id", options.id());
+    writer("id", options.id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    json->emplace("warnings", valhalla::tyr::serializeWarnings(request));
+    valhalla::tyr::serializeWarnings(request, writer);
   }
 
-  return json;
+  // add the timings and counters if they were asked for
+  if (request.options().statistics()) {
+    valhalla::tyr::serializeStatistics(request, writer);
+  }
+
+  writer.end_object();
 }
 } // namespace valhalla_serializers
 
@@ -153,14 +174,18 @@ namespace tyr {
 std::string serializeMatrix(const Api& request,
                             const std::vector<TimeDistance>& time_distances,
                             double distance_scale) {
+  // the buffer is kept around between requests on this thread so the matrix is serialized
+  // without reallocating it every time
+  thread_local rapidjson::writer_wrapper_t writer(4096, true);
+  writer.clear();
+
+  if (request.options().format() == Options::osrm) {
+    osrm_serializers::serialize(request, time_distances, distance_scale, writer);
+  } else {
+    valhalla_serializers::serialize(request, time_distances, distance_scale, writer);
+  }
 
-  auto json = request.options().format() == Options::osrm
-                  ? osrm_serializers::serialize(request, time_distances, distance_scale)
-                  : valhalla_serializers::serialize(request, time_distances, distance_scale);
-
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return std::string(writer.get_buffer(), writer.get_length());
 }
 
 } // namespace tyr
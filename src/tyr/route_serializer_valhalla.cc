@@ -571,6 +571,11 @@ std::string serialize(const Api& api) {
       valhalla::tyr::serializeWarnings(api, writer);
     }
 
+    // get the timings and counters if they were asked for
+    if (api.options().statistics()) {
+      valhalla::tyr::serializeStatistics(api, writer);
+    }
+
     writer.end_object(); // trip
 
     // leave space for alternates by closing this one outside the loop
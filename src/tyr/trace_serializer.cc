@@ -550,6 +550,11 @@ std::string serializeTraceAttributes(
     valhalla::tyr::serializeWarnings(request, writer);
   }
 
+  // add the timings and counters if they were asked for
+  if (request.options().statistics()) {
+    valhalla::tyr::serializeStatistics(request, writer);
+  }
+
   writer.end_object();
   return writer.get_buffer();
 }
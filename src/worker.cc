@@ -650,6 +650,9 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
   // Whether or not to run isochrones in reverse in absence of time dependence
   options.set_reverse(rapidjson::get<bool>(doc, "/reverse", false));
 
+  // Whether or not to return the request statistics in the response
+  options.set_statistics(rapidjson::get<bool>(doc, "/statistics", options.statistics()));
+
   auto language = rapidjson::get_optional<std::string>(doc, "/language");
   if (language && odin::get_locales().find(*language) != odin::get_locales().end()) {
     options.set_language(*language);
@@ -1169,6 +1172,30 @@ void add_warning(valhalla::Api& api, unsigned code) {
   }
 }
 
+void add_statistic(Api& api, const std::string& key, double value, StatisticType type) {
+  for (auto& stat : *api.mutable_info()->mutable_statistics()) {
+    if (stat.key() == key && stat.type() == type) {
+      stat.set_value(stat.value() + value);
+      return;
+    }
+  }
+  auto* stat = api.mutable_info()->mutable_statistics()->Add();
+  stat->set_key(key);
+  stat->set_value(value);
+  stat->set_type(type);
+}
+
+midgard::Finally<std::function<void()>>
+measure_phase_time(Api& api, const std::string& worker_name, const std::string& phase) {
+  auto start = std::chrono::steady_clock::now();
+  return midgard::Finally<std::function<void()>>([&api, worker_name, phase, start]() {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto e = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(elapsed).count();
+    const auto& action = Options_Action_Enum_Name(api.options().action());
+    add_statistic(api, action + ".info." + worker_name + "." + phase + ".latency_ms", e, timing);
+  });
+}
+
 std::string serialize_error(const valhalla_exception_t& exception, Api& request) {
   // get the http status
   std::stringstream body;
@@ -1433,18 +1460,36 @@ void service_worker_t::enqueue_statistics(Api& api) const {
 midgard::Finally<std::function<void()>> service_worker_t::measure_scope_time(Api& api) const {
   // we copy the captures that could go out of scope
   auto start = std::chrono::steady_clock::now();
-  return midgard::Finally<std::function<void()>>([this, &api, start]() {
+  auto start_counters = counters();
+  return midgard::Finally<std::function<void()>>([this, &api, start, start_counters]() {
     auto elapsed = std::chrono::steady_clock::now() - start;
     auto e = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(elapsed).count();
     const auto& action = Options_Action_Enum_Name(api.options().action());
 
-    auto* stat = api.mutable_info()->mutable_statistics()->Add();
-    stat->set_key(action + ".info." + service_name() + ".latency_ms");
-    stat->set_value(e);
-    stat->set_type(timing);
+    add_statistic(api, action + ".info." + service_name() + ".latency_ms", e, timing);
+
+    // and how much the counters went up while doing it
+    auto end_counters = counters();
+    for (size_t i = 0; i < start_counters.size() && i < end_counters.size(); ++i) {
+      add_count(api, end_counters[i].first, end_counters[i].second - start_counters[i].second);
+    }
   });
 }
 
+void service_worker_t::add_count(Api& api, const std::string& metric, double value) const {
+  const auto& action = Options_Action_Enum_Name(api.options().action());
+  add_statistic(api, action + ".info." + service_name() + "." + metric, value, count);
+}
+
+midgard::Finally<std::function<void()>>
+service_worker_t::measure_scope_time(Api& api, const std::string& phase) const {
+  return measure_phase_time(api, service_name(), phase);
+}
+
+std::vector<std::pair<std::string, uint64_t>> service_worker_t::counters() const {
+  return {};
+}
+
 void service_worker_t::started() {
   if (statsd_client) {
     statsd_client->count("none.info." + service_name() + ".worker_started", 1, 1.f,
@@ -0,0 +1,90 @@
+#include "test.h"
+
+#include "baldr/compressedextract.h"
+#include "baldr/graphreader.h"
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace vb = valhalla::baldr;
+
+class TestGraphReader : vb::GraphReader {
+public:
+  using vb::GraphReader::GetGraphTile;
+  using vb::GraphReader::GetTileSet;
+  using vb::GraphReader::GraphReader;
+  using vb::GraphReader::tile_extract;
+  using vb::GraphReader::tile_extract_;
+};
+
+const std::string extract = "test/data/utrecht_tiles/tiles.vlz4";
+auto config_extract = test::make_config("test/data/utrecht_tiles", {{"mjolnir.tile_extract", extract}});
+auto config_dir = test::make_config("test/data/utrecht_tiles");
+
+TEST(CompressedExtract, Build) {
+  GraphReader reader_dir(config_dir.get_child("mjolnir"));
+  const auto tiles = reader_dir.GetTileSet();
+  ASSERT_EQ(vb::CompressedExtract::Build(reader_dir.tile_dir(), tiles, extract), tiles.size());
+  EXPECT_TRUE(vb::CompressedExtract::IsCompressedExtract(extract));
+  EXPECT_FALSE(vb::CompressedExtract::IsCompressedExtract("test/data/utrecht_tiles/tiles.tar"));
+
+  // the extract has to be smaller than the tiles
+  vb::CompressedExtract compressed(extract);
+  ASSERT_EQ(compressed.size(), tiles.size());
+  size_t raw_size = 0, compressed_size = 0;
+  for (const auto& entry : compressed) {
+    raw_size += entry.size;
+    compressed_size += entry.compressed_size;
+  }
+  EXPECT_LT(compressed_size, raw_size);
+  EXPECT_EQ(compressed.Find(vb::GraphId(0, 2, 0)), nullptr);
+}
+
+TEST(CompressedExtract, TilesMatchTileDir) {
+  TestGraphReader reader_extract(config_extract.get_child("mjolnir"));
+  GraphReader reader_dir(config_dir.get_child("mjolnir"));
+  ASSERT_NE(reader_extract.tile_extract_->compressed, nullptr);
+  EXPECT_EQ(reader_extract.tile_extract(), extract);
+  EXPECT_EQ(reader_extract.GetTileSet(), reader_dir.GetTileSet());
+
+  for (const auto& tile_id : reader_dir.GetTileSet()) {
+    auto dir_tile = reader_dir.GetGraphTile(tile_id);
+    auto extract_tile = reader_extract.GetGraphTile(tile_id);
+    ASSERT_NE(extract_tile, nullptr);
+    ASSERT_EQ(dir_tile->header()->end_offset(), extract_tile->header()->end_offset());
+    ASSERT_EQ(memcmp(reinterpret_cast<const char*>(dir_tile->header()),
+                     reinterpret_cast<const char*>(extract_tile->header()),
+                     dir_tile->header()->end_offset()),
+              0);
+  }
+}
+
+TEST(CompressedExtract, CorruptBlock) {
+  // flip the bytes of the first block, its tile has to be dropped rather than misread
+  const std::string corrupt = "test/data/utrecht_tiles/corrupt.vlz4";
+  {
+    std::ifstream in(extract, std::ios::binary);
+    std::ofstream out(corrupt, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+  }
+  vb::GraphId first_tile;
+  {
+    vb::CompressedExtract compressed(corrupt);
+    const auto& entry = *compressed.begin();
+    first_tile = vb::GraphId(entry.tile_id);
+    std::fstream file(corrupt, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(entry.offset);
+    const std::string garbage(std::min<size_t>(entry.compressed_size, 64), '\xff');
+    file.write(garbage.data(), garbage.size());
+  }
+  auto config = test::make_config("test/data/utrecht_tiles", {{"mjolnir.tile_extract", corrupt}});
+  TestGraphReader reader(config.get_child("mjolnir"));
+  EXPECT_EQ(reader.GetGraphTile(first_tile), nullptr);
+}
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
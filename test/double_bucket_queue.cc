@@ -2,6 +2,7 @@
 #include "config.h"
 #include "midgard/util.h"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <iostream>
@@ -80,6 +81,32 @@ TEST(DoubleBucketQueue, TestClear) {
   TryClear(costs);
 }
 
+TEST(DoubleBucketQueue, TestShrinkToFit) {
+  std::vector<simple_label> edgelabels;
+  DoubleBucketQueue<simple_label> adjlist(0, 1000, 1, &edgelabels);
+  for (uint32_t i = 0; i < 5000; ++i) {
+    edgelabels.emplace_back(simple_label{static_cast<float>(i % 2000)});
+    adjlist.add(i);
+  }
+  EXPECT_GE(adjlist.capacity(), 5000);
+  EXPECT_GT(adjlist.memory_size(), adjlist.capacity() * sizeof(uint32_t));
+
+  // Clearing keeps the memory of the buckets, shrinking frees it
+  adjlist.clear();
+  EXPECT_GE(adjlist.capacity(), 5000);
+  adjlist.shrink_to_fit();
+  EXPECT_EQ(adjlist.capacity(), 0);
+  EXPECT_EQ(adjlist.memory_size(), 0);
+
+  // The queue works again once it is set up
+  adjlist.clear();
+  adjlist.reuse(0, 1000, 1, &edgelabels);
+  adjlist.add(42);
+  adjlist.add(7);
+  EXPECT_EQ(adjlist.pop(), 7);
+  EXPECT_EQ(adjlist.pop(), 42);
+}
+
 TEST(DoubleBucketQueue, RC4FloatPrecisionErrors) {
   // Tests what happens when the internal floats in DoubleBucketQueue loses
   // precision
@@ -203,6 +230,80 @@ TEST(DoubleBucketQueue, TestSimulation) {
   }
 }
 
+TEST(DoubleBucketQueue, TestRadixHeap) {
+  // Costs spread far past any bucket range come out in order
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005, 0,
+                                 758, 167, 258, 16442, 278,  111111000};
+  std::vector<simple_label> edgelabels;
+  DoubleBucketQueue<simple_label> adjlist;
+  adjlist.reuse(0, 1, 1, &edgelabels, QueuePolicy::kRadixHeap);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    edgelabels.emplace_back(simple_label{static_cast<float>(costs[i])});
+    adjlist.add(i);
+  }
+  std::sort(costs.begin(), costs.end());
+  for (auto expected : costs) {
+    const auto label = adjlist.pop();
+    ASSERT_NE(label, baldr::kInvalidLabel);
+    EXPECT_EQ(edgelabels[label].sortcost(), static_cast<float>(expected));
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel);
+
+  // Costs below the last one popped come out next
+  edgelabels.emplace_back(simple_label{1.f});
+  adjlist.add(edgelabels.size() - 1);
+  EXPECT_EQ(adjlist.pop(), edgelabels.size() - 1);
+
+  // Decreasing moves the label ahead of the others
+  adjlist.clear();
+  edgelabels.clear();
+  adjlist.reuse(0, 1, 1, &edgelabels, QueuePolicy::kRadixHeap);
+  for (float cost : {500.f, 600.f, 70000.f}) {
+    edgelabels.emplace_back(simple_label{cost});
+    adjlist.add(edgelabels.size() - 1);
+  }
+  adjlist.decrease(2, 10.f);
+  edgelabels[2].c = 10.f;
+  EXPECT_EQ(adjlist.pop(), 2);
+  EXPECT_EQ(adjlist.pop(), 0);
+  EXPECT_EQ(adjlist.pop(), 1);
+
+  // Labels that share a bucket with others are found without searching it, including the ones
+  // moved into the place of a label that was taken out
+  adjlist.clear();
+  edgelabels.clear();
+  adjlist.reuse(0, 1, 1, &edgelabels, QueuePolicy::kRadixHeap);
+  for (uint32_t i = 0; i < 100; ++i) {
+    edgelabels.emplace_back(simple_label{static_cast<float>(1000 + i)});
+    adjlist.add(i);
+  }
+  for (uint32_t i = 0; i < 100; i += 3) {
+    adjlist.decrease(i, static_cast<float>(i));
+    edgelabels[i].c = static_cast<float>(i);
+  }
+  adjlist.decrease(98, 500.f);
+  edgelabels[98].c = 500.f;
+  float last = 0.f;
+  for (uint32_t i = 0; i < 100; ++i) {
+    const auto label = adjlist.pop();
+    ASSERT_NE(label, baldr::kInvalidLabel);
+    EXPECT_GE(edgelabels[label].sortcost(), last);
+    last = edgelabels[label].sortcost();
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel);
+}
+
+TEST(DoubleBucketQueue, TestRadixHeapSimulation) {
+  for (const auto& params : std::vector<std::array<size_t, 3>>{{1000, 10, 1000},
+                                                                {222, 40, 100},
+                                                                {333, 60, 100000}}) {
+    std::vector<simple_label> costs;
+    DoubleBucketQueue<simple_label> dbqueue;
+    dbqueue.reuse(0, 1, 1, &costs, QueuePolicy::kRadixHeap);
+    TrySimulation(dbqueue, costs, params[0], params[1], params[2]);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -66,6 +66,40 @@ TEST(EdgeStatus, TestStatus) {
   TryGet(edgestatus, GraphId(555, 3, 1), EdgeSet::kUnreachedOrReset);
 }
 
+TEST(EdgeStatus, ReuseAfterClear) {
+  GraphTileHeader header;
+  header.set_directededgecount(1000);
+  test_tile* tt = new test_tile;
+  tt->header_ = &header;
+  graph_tile_ptr tile{tt};
+
+  for (size_t max_retained : {size_t(0), EdgeStatus::kDefaultMaxRetained}) {
+    EdgeStatus edgestatus(max_retained);
+    for (uint32_t round = 0; round < 3; ++round) {
+      // nothing should survive from the previous round
+      TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kUnreachedOrReset);
+      TryGet(edgestatus, GraphId(555, 2, 11), EdgeSet::kUnreachedOrReset);
+      TryGet(edgestatus, GraphId(556, 2, 10), EdgeSet::kUnreachedOrReset);
+      EXPECT_THROW(edgestatus.Update(GraphId(555, 2, 10), EdgeSet::kPermanent), std::runtime_error);
+
+      edgestatus.Set(GraphId(555, 2, 10), EdgeSet::kTemporary, round, tile);
+      edgestatus.Set(GraphId(556, 2, 10), EdgeSet::kTemporary, round, tile, 3);
+      edgestatus.Update(GraphId(555, 2, 10), EdgeSet::kPermanent);
+
+      // walking the pointer over the edges of a node sees the same status
+      EdgeStatusInfo* es = edgestatus.GetPtr(GraphId(555, 2, 10), tile);
+      EXPECT_EQ(es->set(), EdgeSet::kPermanent);
+      EXPECT_EQ(es->index(), round);
+      EXPECT_EQ((es + 1)->set(), EdgeSet::kUnreachedOrReset);
+
+      TryGet(edgestatus, GraphId(556, 2, 10), EdgeSet::kUnreachedOrReset);
+      EXPECT_EQ(edgestatus.Get(GraphId(556, 2, 10), 3).set(), EdgeSet::kTemporary);
+      EXPECT_EQ(edgestatus.Get(GraphId(556, 2, 10), 3).index(), round);
+      edgestatus.clear();
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
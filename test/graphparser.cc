@@ -830,6 +830,48 @@ TEST(GraphParser, TestImportBssNode) {
   filesystem::remove(bss_nodes_file);
 }
 
+TEST(GraphParser, TestConcurrencyIsDeterministic) {
+  // parses the same file with one and with several threads and checks the outputs are identical
+  auto parse = [](unsigned int concurrency, const std::string& suffix) {
+    boost::property_tree::ptree conf;
+    rapidjson::read_json(config_file, conf);
+    conf.put("mjolnir.concurrency", concurrency);
+
+    const std::string pbf = VALHALLA_SOURCE_DIR "test/data/liechtenstein-latest.osm.pbf";
+    auto osmdata = PBFGraphParser::ParseWays(conf.get_child("mjolnir"), {pbf}, "ways" + suffix,
+                                             "way_nodes" + suffix, "access" + suffix,
+                                             "pronunciation" + suffix);
+    PBFGraphParser::ParseRelations(conf.get_child("mjolnir"), {pbf}, "from" + suffix,
+                                   "to" + suffix, osmdata);
+    PBFGraphParser::ParseNodes(conf.get_child("mjolnir"), {pbf}, "way_nodes" + suffix,
+                               "bss_nodes" + suffix, osmdata);
+    return osmdata;
+  };
+  auto serial = parse(1, ".serial.bin");
+  auto parallel = parse(4, ".parallel.bin");
+
+  EXPECT_EQ(serial.osm_way_count, parallel.osm_way_count);
+  EXPECT_EQ(serial.osm_way_node_count, parallel.osm_way_node_count);
+  EXPECT_EQ(serial.osm_node_count, parallel.osm_node_count);
+  EXPECT_EQ(serial.max_changeset_id_, parallel.max_changeset_id_);
+  EXPECT_EQ(serial.restrictions.size(), parallel.restrictions.size());
+  EXPECT_EQ(serial.name_offset_map.Size(), parallel.name_offset_map.Size());
+  EXPECT_EQ(serial.node_names.Size(), parallel.node_names.Size());
+
+  auto read = [](const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  };
+  for (const auto& name : {"ways", "way_nodes", "access", "pronunciation", "from", "to"}) {
+    EXPECT_EQ(read(name + std::string(".serial.bin")), read(name + std::string(".parallel.bin")))
+        << name << " differ";
+    filesystem::remove(name + std::string(".serial.bin"));
+    filesystem::remove(name + std::string(".parallel.bin"));
+  }
+  filesystem::remove("bss_nodes.serial.bin");
+  filesystem::remove("bss_nodes.parallel.bin");
+}
+
 } // namespace
 
 class GraphParserEnv : public ::testing::Environment {
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <thread>
 
 #include "baldr/connectivity_map.h"
 #include "baldr/graphreader.h"
@@ -880,6 +881,176 @@ TEST(CacheLruSoft, TrimOnExactlyFullCache) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
 }
 
+TEST(CacheSharded, ShardCountRoundedUp) {
+  EXPECT_EQ(ShardedTileCache(1000, TileCacheLRU::MemoryLimitControl::HARD, 0).ShardCount(), 1);
+  EXPECT_EQ(ShardedTileCache(1000, TileCacheLRU::MemoryLimitControl::HARD, 1).ShardCount(), 1);
+  EXPECT_EQ(ShardedTileCache(1000, TileCacheLRU::MemoryLimitControl::HARD, 5).ShardCount(), 8);
+  EXPECT_EQ(ShardedTileCache(1000, TileCacheLRU::MemoryLimitControl::HARD, 64).ShardCount(), 64);
+}
+
+TEST(CacheSharded, InsertGetClear) {
+  ShardedTileCache cache(100000, TileCacheLRU::MemoryLimitControl::SOFT, 8);
+
+  std::vector<GraphId> ids;
+  for (uint32_t i = 0; i < 50; ++i) {
+    ids.emplace_back(i * 7, i % 3, 0);
+    auto tile = cache.Put(ids.back(), graph_tile_ptr{new TestGraphTile(ids.back(), 1000)}, 1000);
+    CheckGraphTile(tile, ids.back(), 1000);
+  }
+  EXPECT_FALSE(cache.OverCommitted());
+
+  for (const auto& id : ids) {
+    EXPECT_TRUE(cache.Contains(id));
+    CheckGraphTile(cache.Get(id), id, 1000);
+  }
+  EXPECT_FALSE(cache.Contains({1, 2, 0}));
+  EXPECT_EQ(cache.Get({1, 2, 0}), nullptr);
+
+  cache.Clear();
+  EXPECT_FALSE(cache.OverCommitted());
+  for (const auto& id : ids) {
+    EXPECT_FALSE(cache.Contains(id));
+    EXPECT_EQ(cache.Get(id), nullptr);
+  }
+}
+
+TEST(CacheSharded, PutKeepsFirstTile) {
+  ShardedTileCache cache(1000, TileCacheLRU::MemoryLimitControl::HARD, 1);
+
+  GraphId id(100, 2, 0);
+  auto tile1 = cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+  auto tile2 = cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+  EXPECT_EQ(tile1, tile2);
+  EXPECT_EQ(cache.Get(id), tile1);
+}
+
+TEST(CacheSharded, CopiesShareTiles) {
+  ShardedTileCache cache(1000, TileCacheLRU::MemoryLimitControl::HARD, 4);
+  ShardedTileCache copy(cache);
+
+  GraphId id(100, 2, 0);
+  auto tile = cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+  EXPECT_EQ(copy.Get(id), tile);
+
+  copy.Clear();
+  EXPECT_FALSE(cache.Contains(id));
+}
+
+TEST(CacheSharded, HardEvictsUnreferencedFirst) {
+  ShardedTileCache cache(300, TileCacheLRU::MemoryLimitControl::HARD, 1);
+
+  GraphId id1(1, 2, 0), id2(2, 2, 0), id3(3, 2, 0), id4(4, 2, 0);
+  EXPECT_THROW(cache.Put(id1, graph_tile_ptr{new TestGraphTile(id1, 301)}, 301),
+               std::runtime_error);
+
+  cache.Put(id1, graph_tile_ptr{new TestGraphTile(id1, 100)}, 100);
+  cache.Put(id2, graph_tile_ptr{new TestGraphTile(id2, 100)}, 100);
+  cache.Put(id3, graph_tile_ptr{new TestGraphTile(id3, 100)}, 100);
+  EXPECT_FALSE(cache.OverCommitted());
+
+  // the first sweep clears the flags of the fresh entries then takes the oldest one
+  cache.Put(id4, graph_tile_ptr{new TestGraphTile(id4, 100)}, 100);
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_FALSE(cache.Contains(id1));
+  EXPECT_TRUE(cache.Contains(id2));
+  EXPECT_TRUE(cache.Contains(id3));
+  EXPECT_TRUE(cache.Contains(id4));
+
+  // touching id2 gives it a second chance so id3 goes next
+  EXPECT_NE(cache.Get(id2), nullptr);
+  cache.Put(id1, graph_tile_ptr{new TestGraphTile(id1, 100)}, 100);
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_TRUE(cache.Contains(id1));
+  EXPECT_TRUE(cache.Contains(id2));
+  EXPECT_FALSE(cache.Contains(id3));
+  EXPECT_TRUE(cache.Contains(id4));
+}
+
+TEST(CacheSharded, SoftTrim) {
+  ShardedTileCache cache(300, TileCacheLRU::MemoryLimitControl::SOFT, 1);
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    GraphId id(i, 2, 0);
+    cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+  }
+  EXPECT_TRUE(cache.OverCommitted());
+
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+  size_t resident = 0;
+  for (uint32_t i = 0; i < 5; ++i) {
+    resident += cache.Contains({i, 2, 0});
+  }
+  EXPECT_EQ(resident, 3);
+}
+
+TEST(CacheSharded, ConcurrentPutGet) {
+  ShardedTileCache cache(1073741824, TileCacheLRU::MemoryLimitControl::HARD, 16);
+
+  // each thread works on its own tiles because the tile ref count is not necessarily atomic
+  std::vector<std::thread> threads;
+  std::atomic<size_t> failures(0);
+  for (uint32_t t = 0; t < 8; ++t) {
+    threads.emplace_back([&cache, &failures, t]() {
+      for (uint32_t i = 0; i < 200; ++i) {
+        GraphId id(t * 1000 + i, 2, 0);
+        cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 1000)}, 1000);
+      }
+      for (uint32_t round = 0; round < 10; ++round) {
+        for (uint32_t i = 0; i < 200; ++i) {
+          GraphId id(t * 1000 + i, 2, 0);
+          auto tile = cache.Get(id);
+          failures += !tile || tile->header()->graphid() != id;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(failures.load(), 0);
+  EXPECT_FALSE(cache.OverCommitted());
+  for (uint32_t i = 0; i < 8 * 200; ++i) {
+    GraphId id((i / 200) * 1000 + i % 200, 2, 0);
+    EXPECT_TRUE(cache.Contains(id));
+  }
+}
+
+TEST(CacheFactory, ShardedGlobalCacheIsShared) {
+  boost::property_tree::ptree pt;
+  pt.put("use_sharded_mem_cache", true);
+  pt.put("global_synchronized_cache", true);
+  pt.put("sharded_mem_cache_shards", 4);
+  std::unique_ptr<TileCache> cache1(TileCacheFactory::createTileCache(pt));
+  std::unique_ptr<TileCache> cache2(TileCacheFactory::createTileCache(pt));
+  ASSERT_NE(dynamic_cast<ShardedTileCache*>(cache1.get()), nullptr);
+
+  GraphId id(100, 2, 0);
+  auto tile = cache1->Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+  EXPECT_EQ(cache2->Get(id), tile);
+  cache2->Clear();
+  EXPECT_FALSE(cache1->Contains(id));
+}
+
+TEST(CacheFactory, ShardCountKeepsRoomForDenseTiles) {
+  boost::property_tree::ptree pt;
+  pt.put("use_sharded_mem_cache", true);
+  pt.put("lru_mem_cache_hard_control", true);
+  pt.put("max_cache_size", 1073741824);
+  pt.put("sharded_mem_cache_shards", 256);
+  std::unique_ptr<TileCache> cache(TileCacheFactory::createTileCache(pt));
+  auto* sharded = dynamic_cast<ShardedTileCache*>(cache.get());
+  ASSERT_NE(sharded, nullptr);
+  EXPECT_EQ(sharded->ShardCount(), 16);
+
+  // a dense tile well within the total budget must not be rejected by the shard limit
+  GraphId id(100, 2, 0);
+  size_t dense_size = 40 * 1024 * 1024;
+  EXPECT_NO_THROW(cache->Put(id, graph_tile_ptr{new TestGraphTile(id, dense_size)}, dense_size));
+  EXPECT_TRUE(cache->Contains(id));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -1,6 +1,8 @@
 #include "midgard/gridded_data.h"
 #include "midgard/pointll.h"
+#include <cmath>
 #include <limits>
+#include <random>
 //#include <iostream>
 
 #include "test.h"
@@ -78,6 +80,61 @@ TEST(GriddedData, Basic) {
   */
 }
 
+TEST(GriddedData, CrossedCells) {
+  // rows of every length around the vector widths with values on both sides of the contour
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<int> distribution(0, 20);
+  for (size_t count = 0; count < 40; ++count) {
+    std::vector<float> bottom(count + 1), top(count + 1);
+    for (size_t i = 0; i <= count; ++i) {
+      bottom[i] = distribution(generator);
+      top[i] = distribution(generator);
+    }
+    top[count / 2] = std::numeric_limits<float>::max();
+    for (float value : {-1.f, 0.f, 5.f, 10.f, 19.5f, 20.f, 30.f}) {
+      std::vector<uint32_t> expected;
+      for (size_t i = 0; i < count; ++i) {
+        auto dmin = std::min(std::min(bottom[i], bottom[i + 1]), std::min(top[i], top[i + 1]));
+        auto dmax = std::max(std::max(bottom[i], bottom[i + 1]), std::max(top[i], top[i + 1]));
+        if (dmin <= value && value <= dmax) {
+          expected.push_back(i);
+        }
+      }
+      std::vector<uint32_t> cells(count);
+      cells.resize(crossed_cells(bottom.data(), top.data(), count, value, cells.data()));
+      EXPECT_EQ(cells, expected) << "count " << count << " value " << value;
+    }
+  }
+}
+
+TEST(GriddedData, Concurrency) {
+  // two metrics with bumps so that there are several rings per contour
+  GriddedData<2> g({-7, -7, 7, 7}, 0.25, {std::numeric_limits<float>::max(), 1000000.f});
+  Tiles<PointLL> t({-7, -7, 7, 7}, 0.25);
+  for (int i = 0; i < t.nrows() * t.ncolumns(); ++i) {
+    auto b = t.Base(i);
+    float d = PointLL(0, 0).Distance(b);
+    g.SetIfLessThan(i, {d / 10.f + 5000.f * std::sin(b.first * 2.f), d});
+  }
+
+  for (bool rings_only : {false, true}) {
+    std::vector<GriddedData<2>::contour_interval_t> intervals{
+        {0, 20000, "time", ""}, {0, 40000, "time", ""}, {1, 300000, "distance", ""},
+        {0, 60000, "time", ""}, {1, 600000, "distance", ""},
+    };
+    auto expected = g.GenerateContours(intervals, rings_only, 0.f, kOptimalGeneralization);
+    for (uint32_t concurrency : {2, 3, 8}) {
+      auto contours =
+          g.GenerateContours(intervals, rings_only, 0.f, kOptimalGeneralization, concurrency);
+      ASSERT_EQ(contours.size(), intervals.size());
+      EXPECT_EQ(contours, expected) << "concurrency " << concurrency;
+    }
+    for (const auto& collection : expected) {
+      EXPECT_FALSE(collection.empty());
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
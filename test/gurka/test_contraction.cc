@@ -0,0 +1,177 @@
+#include "gurka.h"
+#include "baldr/contractiontile.h"
+#include "mjolnir/contractionbuilder.h"
+#include "sif/costfactory.h"
+#include "test.h"
+#include "thor/contractionhierarchy.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class ContractionTest : public ::testing::Test {
+protected:
+  // the same graph with and without the contraction hierarchy
+  static gurka::map map;
+  static gurka::map plain_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A-1-2B----C-3--D
+      |    |    |    |
+      E----F----G----H
+      |    |    |    |
+      I----J----K----L
+    )";
+
+    const gurka::ways ways = {{"AB", {{"highway", "primary"}}},
+                              {"BC", {{"highway", "primary"}}},
+                              {"CD", {{"highway", "primary"}}},
+                              {"EF", {{"highway", "residential"}}},
+                              {"FG", {{"highway", "residential"}, {"oneway", "yes"}}},
+                              {"GH", {{"highway", "residential"}}},
+                              {"IJ", {{"highway", "secondary"}}},
+                              {"JK", {{"highway", "secondary"}, {"access", "destination"}}},
+                              {"KL", {{"highway", "secondary"}}},
+                              {"AE", {{"highway", "tertiary"}}},
+                              {"EI", {{"highway", "tertiary"}}},
+                              {"BF", {{"highway", "residential"}}},
+                              {"FJ", {{"highway", "residential"}}},
+                              {"CG", {{"highway", "residential"}}},
+                              {"GK", {{"highway", "residential"}}},
+                              {"DH", {{"highway", "unclassified"}}},
+                              {"HL", {{"highway", "unclassified"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/contraction_hierarchy",
+                            {{"mjolnir.concurrency", "1"},
+                             {"mjolnir.contraction_dir", "test/data/contraction_hierarchy/ch"}});
+    mjolnir::ContractionBuilder::Build(map.config);
+
+    plain_map = map;
+    plain_map.config.put("mjolnir.contraction_dir", "");
+  }
+};
+
+gurka::map ContractionTest::map = {};
+gurka::map ContractionTest::plain_map = {};
+
+TEST_F(ContractionTest, RoutesMatchBidirectionalAStar) {
+  const std::vector<std::string> nodes = {"A", "B", "C", "D", "E", "F",
+                                          "G", "H", "I", "J", "K", "L"};
+  size_t answered = 0;
+  for (const auto& from : nodes) {
+    for (const auto& to : nodes) {
+      if (from == to) {
+        continue;
+      }
+      auto result = gurka::do_action(Options::route, map, {from, to}, "auto");
+      auto expected = gurka::do_action(Options::route, plain_map, {from, to}, "auto");
+      const auto& leg = result.directions().routes(0).legs(0);
+      const auto& expected_leg = expected.directions().routes(0).legs(0);
+      EXPECT_NEAR(leg.summary().time(), expected_leg.summary().time(), 1.0) << from << to;
+      EXPECT_NEAR(leg.summary().length(), expected_leg.summary().length(), 0.001) << from << to;
+      answered += result.trip().routes(0).legs(0).algorithms(0) == "contraction_hierarchy";
+    }
+  }
+  EXPECT_GT(answered, 0);
+}
+
+TEST_F(ContractionTest, MidEdgeRoutesMatchBidirectionalAStar) {
+  const std::vector<std::pair<std::string, std::string>> pairs = {{"1", "3"}, {"3", "1"},
+                                                                  {"1", "J"}, {"K", "2"},
+                                                                  {"2", "H"}, {"E", "3"}};
+  size_t answered = 0;
+  for (const auto& pair : pairs) {
+    auto result = gurka::do_action(Options::route, map, {pair.first, pair.second}, "auto");
+    auto expected = gurka::do_action(Options::route, plain_map, {pair.first, pair.second}, "auto");
+    const auto& leg = result.directions().routes(0).legs(0);
+    const auto& expected_leg = expected.directions().routes(0).legs(0);
+    EXPECT_NEAR(leg.summary().time(), expected_leg.summary().time(), 1.0)
+        << pair.first << pair.second;
+    EXPECT_NEAR(leg.summary().length(), expected_leg.summary().length(), 0.001)
+        << pair.first << pair.second;
+    answered += result.trip().routes(0).legs(0).algorithms(0) == "contraction_hierarchy";
+  }
+  EXPECT_GT(answered, 0);
+}
+
+TEST_F(ContractionTest, SameEdgeLeftToBidirectionalAStar) {
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  thor::ContractionHierarchy contraction_hierarchy;
+  contraction_hierarchy.set_contraction_reader(
+      std::make_shared<baldr::ContractionReader>(map.config.get<std::string>(
+                                                     "mjolnir.contraction_dir"),
+                                                 1024 * 1024));
+
+  // the origin and the destination of the first two are on AB. whichever comes first the path
+  // along the edge is not searched for in the hierarchy, where it would take a detour. the last
+  // one is on two different edges which the hierarchy does answer
+  const std::vector<std::pair<std::string, std::string>> pairs = {{"1", "2"},
+                                                                  {"2", "1"},
+                                                                  {"1", "3"}};
+  for (const auto& pair : pairs) {
+    auto result = gurka::do_action(Options::route, map, {pair.first, pair.second}, "auto");
+    auto expected = gurka::do_action(Options::route, plain_map, {pair.first, pair.second}, "auto");
+    EXPECT_NEAR(result.directions().routes(0).legs(0).summary().length(),
+                expected.directions().routes(0).legs(0).summary().length(), 0.001)
+        << pair.first << pair.second;
+
+    // routes on a single edge are given to another algorithm up front, so ask it directly
+    auto origin = result.options().locations(0);
+    auto dest = result.options().locations(1);
+    sif::TravelMode mode;
+    auto mode_costing = sif::CostFactory().CreateModeCosting(result.options(), mode);
+    contraction_hierarchy.Clear();
+    auto paths = contraction_hierarchy.GetBestPath(origin, dest, reader, mode_costing, mode,
+                                                   result.options());
+    EXPECT_EQ(paths.empty(), pair.second != "3") << pair.first << pair.second;
+  }
+}
+
+TEST_F(ContractionTest, RestrictedPathFallsBack) {
+  // the cheapest path takes the destination only edge JK, which the hierarchy leaves to
+  // bidirectional A*
+  auto result = gurka::do_action(Options::route, map, {"I", "L"}, "auto");
+  auto expected = gurka::do_action(Options::route, plain_map, {"I", "L"}, "auto");
+  gurka::assert::raw::expect_path(result, gurka::detail::get_paths(expected).front());
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+}
+
+TEST_F(ContractionTest, CostingOptionsFallBack) {
+  auto result = gurka::do_action(Options::route, map, {"A", "L"}, "auto",
+                                 {{"/costing_options/auto/use_highways", "0.1"}});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+
+  result = gurka::do_action(Options::route, map, {"A", "L"}, "auto");
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "contraction_hierarchy");
+}
+
+TEST_F(ContractionTest, MatrixMatchesCostMatrix) {
+  const std::vector<std::string> sources = {"A", "E", "F", "D"};
+  const std::vector<std::string> targets = {"D", "H", "G", "A"};
+  std::string response, expected_response;
+  gurka::do_action(Options::sources_to_targets, map, sources, targets, "auto", {}, {}, &response);
+  gurka::do_action(Options::sources_to_targets, plain_map, sources, targets, "auto", {}, {},
+                   &expected_response);
+
+  rapidjson::Document doc, expected_doc;
+  doc.Parse(response.c_str());
+  expected_doc.Parse(expected_response.c_str());
+  const auto& rows = doc["sources_to_targets"].GetArray();
+  const auto& expected_rows = expected_doc["sources_to_targets"].GetArray();
+  ASSERT_EQ(rows.Size(), expected_rows.Size());
+  for (rapidjson::SizeType i = 0; i < rows.Size(); ++i) {
+    const auto& row = rows[i].GetArray();
+    const auto& expected_row = expected_rows[i].GetArray();
+    ASSERT_EQ(row.Size(), expected_row.Size());
+    for (rapidjson::SizeType j = 0; j < row.Size(); ++j) {
+      EXPECT_NEAR(row[j]["time"].GetFloat(), expected_row[j]["time"].GetFloat(), 1.0)
+          << sources[i] << targets[j];
+      EXPECT_NEAR(row[j]["distance"].GetFloat(), expected_row[j]["distance"].GetFloat(), 0.01)
+          << sources[i] << targets[j];
+    }
+  }
+}
@@ -0,0 +1,142 @@
+#include "gurka.h"
+#include "mjolnir/overlaybuilder.h"
+#include "sif/dynamiccost.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class OverlayTest : public ::testing::Test {
+protected:
+  // the same graph with and without the overlay, its blocks are 15km wide so that it
+  // spreads over several cells of every overlay level
+  static gurka::map map;
+  static gurka::map plain_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 3000;
+
+    const std::string ascii_map = R"(
+      A----B----C----D----E
+      |    |    |    |    |
+      F----G----H----I----J
+      |    |    |    |    |
+      K----L----M----N----O
+      |    |    |    |    |
+      P----Q----R----S----T
+    )";
+
+    const gurka::ways ways = {{"ABCDE", {{"highway", "primary"}}},
+                              {"FGHIJ", {{"highway", "residential"}}},
+                              {"KLMNO", {{"highway", "secondary"}, {"toll", "yes"}}},
+                              {"PQRST", {{"highway", "tertiary"}}},
+                              {"AFKP", {{"highway", "tertiary"}}},
+                              {"BGLQ", {{"highway", "residential"}}},
+                              {"CHMR", {{"highway", "motorway"}, {"oneway", "yes"}}},
+                              {"DINS", {{"highway", "residential"}}},
+                              {"EJOT", {{"highway", "unclassified"}}},
+                              {"GH", {{"highway", "residential"}, {"access", "destination"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/overlay",
+                            {{"mjolnir.concurrency", "1"},
+                             {"mjolnir.overlay_dir", "test/data/overlay/overlay"}});
+    mjolnir::OverlayBuilder::Build(map.config);
+
+    plain_map = map;
+    plain_map.config.put("mjolnir.overlay_dir", "");
+  }
+};
+
+gurka::map OverlayTest::map = {};
+gurka::map OverlayTest::plain_map = {};
+
+TEST_F(OverlayTest, RoutesMatchBidirectionalAStar) {
+  const std::vector<std::string> nodes = {"A", "C", "E", "H", "K", "O", "P", "R", "T"};
+  const std::vector<std::pair<std::string, std::unordered_map<std::string, std::string>>> costings =
+      {{"auto", {{"/costing_options/auto/use_tolls", "0"}}},
+       {"auto", {{"/costing_options/auto/use_highways", "0.2"}}},
+       {"bicycle", {}}};
+  size_t answered = 0;
+  for (const auto& costing : costings) {
+    for (const auto& from : nodes) {
+      for (const auto& to : nodes) {
+        if (from == to) {
+          continue;
+        }
+        auto result = gurka::do_action(Options::route, map, {from, to}, costing.first,
+                                       costing.second);
+        auto expected = gurka::do_action(Options::route, plain_map, {from, to}, costing.first,
+                                         costing.second);
+        const auto& leg = result.directions().routes(0).legs(0);
+        const auto& expected_leg = expected.directions().routes(0).legs(0);
+        EXPECT_NEAR(leg.summary().time(), expected_leg.summary().time(), 1.0)
+            << costing.first << from << to;
+        EXPECT_NEAR(leg.summary().length(), expected_leg.summary().length(), 0.01)
+            << costing.first << from << to;
+        answered +=
+            result.trip().routes(0).legs(0).algorithms(0) == "customizable_route_planning";
+      }
+    }
+  }
+  EXPECT_GT(answered, 0);
+}
+
+TEST_F(OverlayTest, MatrixMatchesCostMatrix) {
+  const std::vector<std::string> sources = {"A", "K", "E", "P"};
+  const std::vector<std::string> targets = {"T", "O", "C", "A"};
+  const std::unordered_map<std::string, std::string> options = {
+      {"/costing_options/auto/use_tolls", "0"}};
+  std::string response, expected_response;
+  gurka::do_action(Options::sources_to_targets, map, sources, targets, "auto", options, {},
+                   &response);
+  gurka::do_action(Options::sources_to_targets, plain_map, sources, targets, "auto", options, {},
+                   &expected_response);
+
+  rapidjson::Document doc, expected_doc;
+  doc.Parse(response.c_str());
+  expected_doc.Parse(expected_response.c_str());
+  const auto& rows = doc["sources_to_targets"].GetArray();
+  const auto& expected_rows = expected_doc["sources_to_targets"].GetArray();
+  ASSERT_EQ(rows.Size(), expected_rows.Size());
+  for (rapidjson::SizeType i = 0; i < rows.Size(); ++i) {
+    const auto& row = rows[i].GetArray();
+    const auto& expected_row = expected_rows[i].GetArray();
+    ASSERT_EQ(row.Size(), expected_row.Size());
+    for (rapidjson::SizeType j = 0; j < row.Size(); ++j) {
+      EXPECT_NEAR(row[j]["time"].GetFloat(), expected_row[j]["time"].GetFloat(), 1.0)
+          << sources[i] << targets[j];
+      EXPECT_NEAR(row[j]["distance"].GetFloat(), expected_row[j]["distance"].GetFloat(), 0.01)
+          << sources[i] << targets[j];
+    }
+  }
+}
+
+TEST_F(OverlayTest, RestrictedEdgeKeepsPath) {
+  // the destination only edge GH is on the shortest path, paths through it are left to
+  // bidirectional A*
+  const std::unordered_map<std::string, std::string> options = {
+      {"/costing_options/auto/use_tolls", "0"}};
+  auto result = gurka::do_action(Options::route, map, {"F", "I"}, "auto", options);
+  auto expected = gurka::do_action(Options::route, plain_map, {"F", "I"}, "auto", options);
+  gurka::assert::raw::expect_path(result, gurka::detail::get_paths(expected).front());
+}
+
+TEST(Overlay, CostingKey) {
+  rapidjson::Document doc;
+  doc.Parse(R"({"costing_options":{"auto":{"use_tolls":0}}})");
+  Options options, same_options, other_options;
+  sif::ParseCosting(doc, "/costing_options", options);
+  sif::ParseCosting(doc, "/costing_options", same_options);
+  doc.Parse(R"({"costing_options":{"auto":{"use_tolls":1}}})");
+  sif::ParseCosting(doc, "/costing_options", other_options);
+
+  const auto& costing = options.costings().find(Costing::auto_)->second;
+  EXPECT_EQ(sif::CostingKey(costing),
+            sif::CostingKey(same_options.costings().find(Costing::auto_)->second));
+  EXPECT_NE(sif::CostingKey(costing),
+            sif::CostingKey(other_options.costings().find(Costing::auto_)->second));
+  EXPECT_NE(sif::CostingKey(costing),
+            sif::CostingKey(options.costings().find(Costing::truck)->second));
+}
@@ -1,5 +1,8 @@
 #include "gurka.h"
+#include "baldr/rapidjson_utils.h"
 #include "loki/reach.h"
+#include "loki/search.h"
+#include "mjolnir/reachbuilder.h"
 #include "sif/costfactory.h"
 #include "sif/dynamiccost.h"
 #include "test.h"
@@ -46,6 +49,15 @@ void close_bidir_edge(baldr::GraphReader& reader,
   close_dir_edge(reader, tile, index, current, edge_name, start_node, closure_map);
   close_dir_edge(reader, tile, index, current, edge_name, end_node, closure_map);
 }
+
+// Creates a costing with the options a request without costing options gets
+sif::cost_ptr_t default_costing(const Costing::Type type) {
+  rapidjson::Document doc;
+  doc.SetObject();
+  Costing costing;
+  sif::ParseCosting(doc, "/costing_options/" + Costing_Enum_Name(type), &costing, type);
+  return sif::CostFactory().Create(costing);
+}
 } // namespace
 
 class TestReach : public ::testing::Test {
@@ -231,3 +243,78 @@ TEST_F(TestReach, DISABLED_ReachWithClosures2) {
   EXPECT_EQ(reach.inbound, 3);
   EXPECT_EQ(reach.outbound, 3);
 }
+
+TEST(StoredReach, MatchesOnlineReach) {
+  const std::string ascii_map = R"(
+      A---B---C---D
+      |   |       |
+      E---F       G---H---I
+
+      J---K---L
+     )";
+
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}}},
+                            {"BC", {{"highway", "primary"}}},
+                            {"CD", {{"highway", "primary"}}},
+                            {"AE", {{"highway", "primary"}}},
+                            {"BF", {{"highway", "primary"}}},
+                            {"EF", {{"highway", "primary"}}},
+                            {"DG", {{"highway", "primary"}, {"oneway", "yes"}}},
+                            {"GH", {{"highway", "footway"}}},
+                            {"HI", {{"highway", "cycleway"}}},
+                            {"JK", {{"highway", "residential"}}},
+                            {"KL", {{"highway", "residential"}}}};
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/stored_reach",
+                               {{"mjolnir.concurrency", "1"}, {"mjolnir.max_edge_reach", "5"}});
+  mjolnir::ReachBuilder::Build(map.config);
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+
+  // every edge stores the reach the online expansion finds up to the cap
+  loki::Reach reach_checker;
+  const Costing::Type types[] = {Costing::auto_, Costing::pedestrian, Costing::bicycle};
+  size_t edge_count = 0;
+  for (const auto& tile_id : reader->GetTileSet()) {
+    auto tile = reader->GetGraphTile(tile_id);
+    ASSERT_EQ(tile->max_edge_reach(), 5);
+    for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i, ++edge_count) {
+      const auto* edge = tile->directededge(i);
+      const auto* edge_reach = tile->edge_reach(i);
+      ASSERT_NE(edge_reach, nullptr);
+      for (size_t mode = 0; mode < baldr::kReachModeCount; ++mode) {
+        auto costing = default_costing(types[mode]);
+        if (!costing->Allowed(edge, tile, sif::kDisallowShortcut))
+          continue;
+        auto reach = reach_checker(edge, tile_id + i, 5, *reader, costing);
+        EXPECT_EQ(edge_reach->outbound[mode], std::min(reach.outbound, 5u));
+        EXPECT_EQ(edge_reach->inbound[mode], std::min(reach.inbound, 5u));
+      }
+    }
+  }
+  EXPECT_GT(edge_count, 0);
+
+  // loki finds the same candidates with and without the stored reach, even when more reach is
+  // asked for than was stored
+  for (auto minimum_reachability : {0u, 3u, 5u, 8u}) {
+    std::vector<baldr::Location> locations;
+    for (const auto& node : {"A", "C", "H", "K"}) {
+      locations.emplace_back(map.nodes[node], baldr::Location::StopType::BREAK,
+                             minimum_reachability, minimum_reachability);
+    }
+    auto costing = default_costing(Costing::auto_);
+    auto online = loki::Search(locations, *reader, costing, false);
+    auto stored = loki::Search(locations, *reader, costing, true);
+    ASSERT_EQ(online.size(), stored.size());
+    for (const auto& location : locations) {
+      const auto& online_edges = online.at(location).edges;
+      const auto& stored_edges = stored.at(location).edges;
+      ASSERT_EQ(online_edges.size(), stored_edges.size());
+      for (size_t i = 0; i < online_edges.size(); ++i) {
+        EXPECT_EQ(online_edges[i].id, stored_edges[i].id);
+        EXPECT_EQ(online_edges[i].outbound_reach, stored_edges[i].outbound_reach);
+        EXPECT_EQ(online_edges[i].inbound_reach, stored_edges[i].inbound_reach);
+      }
+    }
+  }
+}
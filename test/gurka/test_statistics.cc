@@ -0,0 +1,97 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class Statistics : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+      A----B----C
+           |
+           D----E
+    )";
+    const gurka::ways ways = {
+        {"ABC", {{"highway", "primary"}}},
+        {"BDE", {{"highway", "residential"}}},
+    };
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_statistics");
+  }
+
+  // checks that the statistics the workers record made it into the response
+  static void check_statistics(const rapidjson::Value& statistics) {
+    ASSERT_TRUE(statistics.IsObject());
+
+    // one span per worker and one per phase we timed inside of them
+    for (const auto* key :
+         {"route.info.loki.latency_ms", "route.info.loki.search.latency_ms",
+          "route.info.thor.latency_ms", "route.info.thor.path_algorithm.latency_ms",
+          "route.info.thor.triplegbuilder.latency_ms",
+          "route.info.odin.maneuversbuilder.latency_ms", "route.info.odin.narrative.latency_ms"}) {
+      ASSERT_TRUE(statistics.HasMember(key)) << key;
+      EXPECT_GE(statistics[key].GetDouble(), 0.0) << key;
+    }
+
+    // the counters are the deltas over the request
+    EXPECT_GT(statistics["route.info.thor.labels_created"].GetDouble(), 0.0);
+    EXPECT_GT(statistics["route.info.loki.tile_cache_hits"].GetDouble() +
+                  statistics["route.info.loki.tile_cache_misses"].GetDouble(),
+              0.0);
+    EXPECT_TRUE(statistics.HasMember("route.info.thor.tile_cache_hits"));
+    EXPECT_TRUE(statistics.HasMember("route.info.thor.tile_cache_misses"));
+  }
+};
+
+gurka::map Statistics::map = {};
+
+TEST_F(Statistics, ValhallaFormat) {
+  std::string json;
+  auto api =
+      gurka::do_action(Options::route, map, {"A", "E"}, "auto", {{"/statistics", "1"}}, {}, &json);
+
+  rapidjson::Document response;
+  response.Parse(json.c_str());
+  ASSERT_FALSE(response.HasParseError());
+  ASSERT_TRUE(response["trip"].HasMember("statistics"));
+  check_statistics(response["trip"]["statistics"]);
+
+  // the serialized values are the ones we recorded in the request
+  bool found = false;
+  for (const auto& stat : api.info().statistics()) {
+    if (stat.key() == "route.info.thor.labels_created") {
+      EXPECT_EQ(stat.type(), count);
+      EXPECT_EQ(stat.value(), response["trip"]["statistics"][stat.key().c_str()].GetDouble());
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST_F(Statistics, OsrmFormat) {
+  std::string json;
+  gurka::do_action(Options::route, map, {"A", "E"}, "auto",
+                   {{"/statistics", "1"}, {"/format", "osrm"}}, {}, &json);
+
+  rapidjson::Document response;
+  response.Parse(json.c_str());
+  ASSERT_FALSE(response.HasParseError());
+  ASSERT_TRUE(response.HasMember("statistics"));
+  check_statistics(response["statistics"]);
+}
+
+TEST_F(Statistics, NotRequested) {
+  std::string json;
+  auto api = gurka::do_action(Options::route, map, {"A", "E"}, "auto", {}, {}, &json);
+
+  // we still record them for statsd but we dont return them
+  EXPECT_GT(api.info().statistics_size(), 0);
+
+  rapidjson::Document response;
+  response.Parse(json.c_str());
+  ASSERT_FALSE(response.HasParseError());
+  EXPECT_FALSE(response["trip"].HasMember("statistics"));
+  EXPECT_FALSE(response.HasMember("statistics"));
+}
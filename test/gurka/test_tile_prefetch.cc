@@ -0,0 +1,120 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class TilePrefetchTest : public ::testing::Test {
+protected:
+  // the blocks are 15km wide so that the graph spreads over several local tiles
+  static gurka::map map;
+  static gurka::map prefetch_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 3000;
+
+    const std::string ascii_map = R"(
+      A----B----C----D----E
+      |    |    |    |    |
+      F----G----H----I----J
+      |    |    |    |    |
+      K----L----M----N----O
+    )";
+
+    const gurka::ways ways = {{"ABCDE", {{"highway", "primary"}}},
+                              {"FGHIJ", {{"highway", "residential"}}},
+                              {"KLMNO", {{"highway", "secondary"}}},
+                              {"AFK", {{"highway", "tertiary"}}},
+                              {"BGL", {{"highway", "residential"}}},
+                              {"CHM", {{"highway", "motorway"}}},
+                              {"DIN", {{"highway", "residential"}}},
+                              {"EJO", {{"highway", "unclassified"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/tile_prefetch");
+
+    prefetch_map = map;
+    prefetch_map.config.put("mjolnir.prefetch_threads", 2);
+  }
+};
+
+gurka::map TilePrefetchTest::map = {};
+gurka::map TilePrefetchTest::prefetch_map = {};
+
+TEST_F(TilePrefetchTest, PrefetchedTilesMatch) {
+  baldr::GraphReader reader(prefetch_map.config.get_child("mjolnir"));
+  baldr::GraphReader plain_reader(map.config.get_child("mjolnir"));
+  const auto tiles = plain_reader.GetTileSet();
+  ASSERT_GT(tiles.size(), 1);
+
+  for (const auto& tile_id : tiles) {
+    reader.Prefetch(tile_id);
+  }
+  // tiles already queued are not queued again
+  for (const auto& tile_id : tiles) {
+    reader.Prefetch(tile_id);
+  }
+  EXPECT_EQ(reader.tile_counters().prefetch_requests.load(), tiles.size());
+
+  for (const auto& tile_id : tiles) {
+    auto tile = reader.GetGraphTile(tile_id);
+    auto plain_tile = plain_reader.GetGraphTile(tile_id);
+    ASSERT_NE(tile, nullptr);
+    ASSERT_EQ(tile->header()->end_offset(), plain_tile->header()->end_offset());
+    EXPECT_EQ(memcmp(tile->header(), plain_tile->header(), tile->header()->end_offset()), 0);
+  }
+  const auto& counters = reader.tile_counters();
+  EXPECT_EQ(counters.cache_misses.load(), tiles.size());
+  EXPECT_EQ(counters.prefetch_hits.load() + counters.prefetch_misses.load(), tiles.size());
+
+  // once they are in the cache they are not queued anymore
+  for (const auto& tile_id : tiles) {
+    reader.Prefetch(tile_id);
+  }
+  EXPECT_EQ(reader.tile_counters().prefetch_requests.load(), tiles.size());
+}
+
+TEST_F(TilePrefetchTest, PrefetchTowardTarget) {
+  baldr::GraphReader reader(prefetch_map.config.get_child("mjolnir"));
+  const auto& a = map.nodes.at("A");
+  const auto& e = map.nodes.at("E");
+  const auto level = baldr::TileHierarchy::levels().back().level;
+  const auto tile_a = baldr::TileHierarchy::GetGraphId(a, level);
+  const auto& tiling = baldr::TileHierarchy::get_tiling(level);
+  const baldr::GraphId east_of_a(tiling.RightNeighbor(tile_a.tileid()), level, 0);
+  ASSERT_TRUE(reader.DoesTileExist(east_of_a));
+
+  // the tile east of A lies toward E, the tile of A itself is not queued
+  reader.Prefetch(tile_a, a, e);
+  EXPECT_GT(reader.tile_counters().prefetch_requests.load(), 0);
+  ASSERT_NE(reader.GetGraphTile(east_of_a), nullptr);
+  const auto& counters = reader.tile_counters();
+  EXPECT_EQ(counters.prefetch_hits.load() + counters.prefetch_misses.load(), 1);
+
+  // without prefetch threads nothing is queued
+  baldr::GraphReader plain_reader(map.config.get_child("mjolnir"));
+  plain_reader.Prefetch(tile_a, a, e);
+  EXPECT_EQ(plain_reader.tile_counters().prefetch_requests.load(), 0);
+}
+
+TEST_F(TilePrefetchTest, RoutesAndMatrixUnchanged) {
+  const std::vector<std::string> nodes = {"A", "E", "K", "O", "H"};
+  for (const auto& from : nodes) {
+    for (const auto& to : nodes) {
+      if (from == to) {
+        continue;
+      }
+      auto result = gurka::do_action(Options::route, prefetch_map, {from, to}, "auto");
+      auto expected = gurka::do_action(Options::route, map, {from, to}, "auto");
+      gurka::assert::raw::expect_path(result, gurka::detail::get_paths(expected).front());
+    }
+  }
+
+  std::string response, expected_response;
+  gurka::do_action(Options::sources_to_targets, prefetch_map, {"A", "K"}, {"E", "O"}, "auto", {},
+                   {}, &response);
+  gurka::do_action(Options::sources_to_targets, map, {"A", "K"}, {"E", "O"}, "auto", {}, {},
+                   &expected_response);
+  EXPECT_EQ(response, expected_response);
+}
@@ -1,8 +1,11 @@
 #include "gurka.h"
+#include "meili/map_matcher_factory.h"
 #include "midgard/encoded.h"
 #include "midgard/util.h"
+#include "sif/costfactory.h"
 #include "test.h"
 #include <gtest/gtest.h>
+#include <numeric>
 
 using namespace valhalla;
 
@@ -116,3 +119,76 @@ TEST(Standalone, InterpolatedPoints) {
   ASSERT_EQ(result_doc["matched_points"][4]["edge_index"].GetInt(), 1);
   ASSERT_EQ(result_doc["matched_points"][5]["edge_index"].GetInt(), 1);
 }
+
+TEST(Standalone, StreamingMatch) {
+  const std::string ascii_map = R"(
+    A-1-2-3-B-4-5-6-C
+            |       |
+            7       8
+            |       |
+    D-------E-a-b-c-F-d-e-f-G
+  )";
+
+  const gurka::ways ways = {{"ABC", {{"highway", "primary"}}},
+                            {"BE", {{"highway", "primary"}}},
+                            {"CF", {{"highway", "primary"}}},
+                            {"DEFG", {{"highway", "primary"}}}};
+
+  const double gridsize = 20;
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/streaming_match");
+  const std::vector<std::string> trace = {"A", "1", "2", "3", "B", "7", "E", "a",
+                                          "b", "c", "F", "d", "e", "f", "G"};
+
+  // match the whole trace at once and then in windows of a few points
+  std::string whole_json, streamed_json;
+  auto whole = gurka::do_action(valhalla::Options::trace_attributes, map, trace, "auto", {}, {},
+                                &whole_json, "via");
+  map.config.put("meili.default.streaming_window", 4);
+  auto streamed = gurka::do_action(valhalla::Options::trace_attributes, map, trace, "auto", {}, {},
+                                   &streamed_json, "via");
+  gurka::assert::raw::expect_path(whole, {"ABC", "BE", "DEFG", "DEFG"});
+  gurka::assert::raw::expect_path(streamed, {"ABC", "BE", "DEFG", "DEFG"});
+
+  // every point ends up at the same place
+  rapidjson::Document whole_doc, streamed_doc;
+  whole_doc.Parse(whole_json);
+  streamed_doc.Parse(streamed_json);
+  const auto& whole_points = whole_doc["matched_points"];
+  const auto& streamed_points = streamed_doc["matched_points"];
+  ASSERT_EQ(whole_points.Size(), trace.size());
+  ASSERT_EQ(streamed_points.Size(), trace.size());
+  for (rapidjson::SizeType i = 0; i < streamed_points.Size(); ++i) {
+    EXPECT_EQ(std::string(streamed_points[i]["type"].GetString()),
+              whole_points[i]["type"].GetString());
+    EXPECT_EQ(streamed_points[i]["edge_index"].GetInt(), whole_points[i]["edge_index"].GetInt());
+    EXPECT_NEAR(streamed_points[i]["distance_along_edge"].GetDouble(),
+                whole_points[i]["distance_along_edge"].GetDouble(), 1e-3);
+  }
+
+  // the matcher commits the trace a window at a time
+  Options options;
+  const rapidjson::Document doc;
+  sif::ParseCosting(doc, "/costing_options", options);
+  options.set_costing_type(Costing::auto_);
+  meili::MapMatcherFactory factory(map.config,
+                                   test::make_clean_graphreader(map.config.get_child("mjolnir")));
+  std::unique_ptr<meili::MapMatcher> matcher(factory.Create(options));
+  std::vector<meili::Measurement> measurements;
+  for (const auto& name : trace) {
+    measurements.emplace_back(layout.at(name), 5.f, 50.f);
+  }
+  std::vector<size_t> commits;
+  const auto matched =
+      matcher->StreamingMatch(measurements,
+                              [&commits](std::vector<meili::MatchResult>::const_iterator begin,
+                                         std::vector<meili::MatchResult>::const_iterator end) {
+                                commits.push_back(end - begin);
+                              });
+  EXPECT_GT(commits.size(), 1);
+  EXPECT_EQ(std::accumulate(commits.begin(), commits.end(), size_t(0)), trace.size());
+  ASSERT_EQ(matched.results.size(), trace.size());
+  for (const auto& result : matched.results) {
+    EXPECT_EQ(result.GetType(), meili::MatchResult::Type::kMatched);
+  }
+}
@@ -0,0 +1,176 @@
+#include "gurka.h"
+#include "test.h"
+
+#include "baldr/graphreader.h"
+#include "baldr/trafficsnapshot.h"
+#include "loki/search.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+// Publishes a generation in which the edge has a live speed
+uint32_t
+publish_speed(const std::string& snapshot_file, const baldr::GraphId& edge_id, uint32_t kph) {
+  baldr::TrafficSnapshot snapshot(snapshot_file, false);
+  const uint32_t generation = snapshot.Prepare();
+  auto* speed = snapshot.speed(generation, edge_id);
+  speed->breakpoint1 = 255;
+  speed->overall_encoded_speed = kph >> 1;
+  speed->encoded_speed1 = kph >> 1;
+  snapshot.Publish(generation);
+  return generation;
+}
+
+uint32_t live_speed(baldr::GraphReader& reader, const baldr::GraphId& edge_id) {
+  auto tile = reader.GetGraphTile(edge_id);
+  const auto& speed = tile->trafficspeed(tile->directededge(edge_id));
+  return speed.speed_valid() ? speed.get_overall_speed() : 0;
+}
+} // namespace
+
+class TrafficSnapshotTest : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static std::string snapshot_file;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+      A----B----C
+      |         |
+      D---------E
+    )";
+
+    const gurka::ways ways = {{"ABC", {{"highway", "primary"}}},
+                              {"AD", {{"highway", "primary"}}},
+                              {"DE", {{"highway", "primary"}}},
+                              {"CE", {{"highway", "primary"}}}};
+
+    const std::string tile_dir = "test/data/traffic_snapshot";
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, tile_dir);
+
+    map.config.put("mjolnir.traffic_extract", tile_dir + "/traffic.tar");
+    test::build_live_traffic_data(map.config);
+    snapshot_file = tile_dir + "/traffic.snapshot";
+    baldr::TrafficSnapshot::Create(tile_dir + "/traffic.tar", snapshot_file);
+    map.config.put("mjolnir.traffic_snapshot", snapshot_file);
+  }
+};
+
+gurka::map TrafficSnapshotTest::map = {};
+std::string TrafficSnapshotTest::snapshot_file;
+
+TEST_F(TrafficSnapshotTest, PinnedGenerationIsKept) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  ASSERT_TRUE(reader->HasLiveTraffic());
+  const auto edge_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "A", "B"));
+  const uint32_t pinned = reader->PinTrafficSnapshot();
+  EXPECT_GT(pinned, 0);
+  const uint32_t before = live_speed(*reader, edge_id);
+
+  // the request which is running keeps reading the generation it started with
+  const uint32_t generation = publish_speed(snapshot_file, edge_id, 40);
+  EXPECT_EQ(generation, pinned + 1);
+  EXPECT_EQ(reader->PinTrafficSnapshot(), pinned);
+  EXPECT_EQ(live_speed(*reader, edge_id), before);
+
+  // the next one reads the new generation
+  reader->UnpinTrafficSnapshot();
+  EXPECT_EQ(live_speed(*reader, edge_id), 40);
+  EXPECT_EQ(reader->PinTrafficSnapshot(), generation);
+
+  // the speeds which are not written are carried over to the next generation
+  reader->UnpinTrafficSnapshot();
+  const auto other_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "D", "E"));
+  publish_speed(snapshot_file, other_id, 20);
+  reader->UnpinTrafficSnapshot();
+  EXPECT_EQ(live_speed(*reader, edge_id), 40);
+  EXPECT_EQ(live_speed(*reader, other_id), 20);
+}
+
+TEST_F(TrafficSnapshotTest, SharedCacheKeepsGenerations) {
+  auto config = map.config.get_child("mjolnir");
+  config.put("global_synchronized_cache", true);
+  auto running = test::make_clean_graphreader(config);
+  auto starting = test::make_clean_graphreader(config);
+  const auto edge_id = std::get<0>(gurka::findEdgeByNodes(*running, map.nodes, "B", "C"));
+  const uint32_t before = live_speed(*running, edge_id);
+
+  publish_speed(snapshot_file, edge_id, 60);
+
+  // the tile the new request caches is not handed to the request which is still running
+  EXPECT_EQ(live_speed(*starting, edge_id), 60);
+  EXPECT_EQ(live_speed(*running, edge_id), before);
+  EXPECT_NE(running->GetGraphTile(edge_id), starting->GetGraphTile(edge_id));
+  running->UnpinTrafficSnapshot();
+  EXPECT_EQ(live_speed(*running, edge_id), 60);
+}
+
+TEST_F(TrafficSnapshotTest, NewGenerationKeepsCache) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  const auto edge_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "A", "D"));
+  const auto cached = reader->GetGraphTile(edge_id);
+  reader->UnpinTrafficSnapshot();
+  const uint64_t misses = reader->tile_counters().cache_misses.load();
+
+  // the cached tile is not thrown away, only the new traffic is attached to its graph data
+  publish_speed(snapshot_file, edge_id, 30);
+  EXPECT_EQ(live_speed(*reader, edge_id), 30);
+  EXPECT_EQ(reader->tile_counters().cache_misses.load(), misses);
+  const auto reattached = reader->GetGraphTile(edge_id);
+  EXPECT_NE(reattached, cached);
+  EXPECT_EQ(reattached->header(), cached->header());
+}
+
+TEST_F(TrafficSnapshotTest, PublishedGenerationReplacesCachedTile) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  const auto edge_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "C", "E"));
+  const auto original = reader->GetGraphTile(edge_id);
+  reader->UnpinTrafficSnapshot();
+
+  // after each publish the first request attaches the new traffic and the later ones get that
+  // tile back from the cache instead of building their own
+  baldr::graph_tile_ptr previous = original;
+  for (uint32_t speed : {25, 35}) {
+    publish_speed(snapshot_file, edge_id, speed);
+    EXPECT_EQ(live_speed(*reader, edge_id), speed);
+    const auto reattached = reader->GetGraphTile(edge_id);
+    reader->UnpinTrafficSnapshot();
+    EXPECT_NE(reattached, previous);
+    EXPECT_EQ(reattached->header(), original->header());
+
+    EXPECT_EQ(reader->GetGraphTile(edge_id), reattached);
+    EXPECT_EQ(live_speed(*reader, edge_id), speed);
+    reader->UnpinTrafficSnapshot();
+    previous = reattached;
+  }
+}
+
+TEST_F(TrafficSnapshotTest, SearchWorkersKeepGeneration) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  const auto edge_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "E", "D"));
+  reader->PinTrafficSnapshot();
+  const uint32_t before = live_speed(*reader, edge_id);
+  publish_speed(snapshot_file, edge_id, 90);
+
+  // every thread reads the generation the request has pinned, the next request the new one
+  loki::SearchWorkers workers(map.config.get_child("mjolnir"), 3);
+  for (uint32_t expected : {before, 90u}) {
+    std::vector<uint32_t> speeds(8, 0);
+    workers.Run(speeds.size(), *reader,
+                [&](const uint32_t index, baldr::GraphReader& thread_reader, const size_t) {
+                  speeds[index] = live_speed(thread_reader, edge_id);
+                });
+    for (auto speed : speeds) {
+      EXPECT_EQ(speed, expected);
+    }
+    workers.Cleanup();
+    reader->UnpinTrafficSnapshot();
+  }
+}
+
+TEST(TrafficSnapshot, RejectsOtherFiles) {
+  EXPECT_THROW(baldr::TrafficSnapshot("test/data/does_not_exist.snapshot"), std::runtime_error);
+}
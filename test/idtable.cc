@@ -1,7 +1,9 @@
 #include "../src/mjolnir/idtable.h"
+#include "filesystem.h"
 
 #include <cstdint>
 #include <cstdlib>
+#include <set>
 #include <unordered_set>
 
 #include <gtest/gtest.h>
@@ -58,6 +60,67 @@ TEST(UnorderedIdTable, SerializeDeserialize) {
   EXPECT_EQ(a, b);
 }
 
+TEST(CompactIdTable, FindRankSelect) {
+  // sparse ids spread over a large universe, like osm node ids referenced by ways
+  std::set<uint64_t> ids;
+  for (uint64_t i = 0; i < kTableSize; ++i) {
+    ids.insert((static_cast<uint64_t>(rand()) << 20) ^ static_cast<uint64_t>(rand()));
+  }
+  const uint64_t universe = *ids.rbegin() + 1;
+
+  // duplicates are skipped
+  CompactIdTable::Writer writer("compact.bin", ids.size(), universe);
+  for (auto id : ids) {
+    writer.add(id);
+    writer.add(id);
+  }
+  writer.finish();
+
+  {
+    CompactIdTable t("compact.bin");
+    ASSERT_EQ(t.size(), ids.size());
+    uint64_t index = 0;
+    for (auto id : ids) {
+      uint64_t found;
+      EXPECT_TRUE(t.find(id, found));
+      EXPECT_EQ(found, index);
+      EXPECT_EQ(t.select(index), id);
+      // the neighbours are only in there if they were added
+      EXPECT_EQ(t.get(id + 1), ids.count(id + 1) == 1);
+      EXPECT_EQ(t.rank(id + 1), index + 1);
+      ++index;
+    }
+    EXPECT_FALSE(t.get(universe));
+    EXPECT_EQ(t.rank(universe), ids.size());
+  }
+  // unmapped so we can clean it up
+  filesystem::remove("compact.bin");
+}
+
+TEST(CompactIdTable, Dense) {
+  // every id, no low bits at all
+  CompactIdTable::Writer writer("compact.bin", kTableSize, kTableSize);
+  for (uint64_t i = 0; i < kTableSize; ++i) {
+    writer.add(i);
+  }
+  writer.finish();
+
+  {
+    CompactIdTable t("compact.bin");
+    for (uint64_t i = 0; i < kTableSize; ++i) {
+      EXPECT_EQ(t.rank(i), i);
+      EXPECT_EQ(t.select(i), i);
+    }
+  }
+  filesystem::remove("compact.bin");
+
+  // ids must be increasing
+  CompactIdTable::Writer bad("compact.bin", 2, 10);
+  bad.add(5);
+  EXPECT_THROW(bad.add(4), std::runtime_error);
+  EXPECT_THROW(bad.add(10), std::runtime_error);
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,11 +1,15 @@
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "baldr/graphreader.h"
+#include "baldr/json.h"
 #include "baldr/rapidjson_utils.h"
 #include "loki/worker.h"
 #include "thor/worker.h"
+#include "tyr/serializers.h"
 
 #include "gurka/gurka.h"
 #include "test.h"
@@ -264,6 +268,142 @@ TEST(Isochrones, test_max_reserved_labels_count) {
   isochrone.Clear();
 }
 
+// The isochrone serializer as it was before it streamed, building a json DOM first
+std::string serialize_dom(const Api& request,
+                          const std::vector<GriddedData<2>::contour_interval_t>& intervals,
+                          const GriddedData<2>::contours_t& contours,
+                          bool polygons,
+                          bool show_locations) {
+  using rgba_t = std::tuple<float, float, float>;
+  auto features = json::array({});
+  for (size_t contour_index = 0; contour_index < intervals.size(); ++contour_index) {
+    const auto& interval = intervals[contour_index];
+    std::stringstream hex;
+    if (!std::get<3>(interval).empty()) {
+      hex << "#" << std::get<3>(interval);
+    } else {
+      auto h = contour_index * (150.f / intervals.size());
+      auto c = .5f;
+      auto x = c * (1 - std::abs(std::fmod(h / 60.f, 2.f) - 1));
+      auto m = .25f;
+      rgba_t color = h < 60 ? rgba_t{m + c, m + x, m}
+                            : (h < 120 ? rgba_t{m + x, m + c, m} : rgba_t{m, m + c, m + x});
+      hex << "#" << std::hex << static_cast<int>(std::get<0>(color) * 255 + .5f) << std::hex
+          << static_cast<int>(std::get<1>(color) * 255 + .5f) << std::hex
+          << static_cast<int>(std::get<2>(color) * 255 + .5f);
+    }
+    for (const auto& feature : contours[contour_index]) {
+      auto geom = json::array({});
+      for (const auto& contour : feature) {
+        auto coords = json::array({});
+        for (const auto& coord : contour) {
+          coords->push_back(
+              json::array({json::fixed_t{coord.first, 6}, json::fixed_t{coord.second, 6}}));
+        }
+        if (polygons) {
+          geom->emplace_back(coords);
+        } else {
+          geom = coords;
+        }
+      }
+      features->emplace_back(json::map({
+          {"type", std::string("Feature")},
+          {"geometry", json::map({
+                           {"type", std::string(polygons ? "Polygon" : "LineString")},
+                           {"coordinates", geom},
+                       })},
+          {"properties", json::map({
+                             {"metric", std::get<2>(interval)},
+                             {"contour", json::float_t{std::get<1>(interval)}},
+                             {"color", hex.str()},
+                             {"fill", hex.str()},
+                             {"fillColor", hex.str()},
+                             {"opacity", json::fixed_t{.33f, 2}},
+                             {"fill-opacity", json::fixed_t{.33f, 2}},
+                             {"fillOpacity", json::fixed_t{.33f, 2}},
+                         })},
+      }));
+    }
+  }
+  if (show_locations) {
+    uint64_t idx = 0;
+    for (const auto& location : request.options().locations()) {
+      auto snapped = json::array({});
+      std::unordered_set<PointLL> snapped_points;
+      for (const auto& path_edge : location.correlation().edges()) {
+        PointLL ll(path_edge.ll().lng(), path_edge.ll().lat());
+        if (snapped_points.insert(ll).second) {
+          snapped->push_back(json::array({json::fixed_t{ll.lng(), 6}, json::fixed_t{ll.lat(), 6}}));
+        }
+      }
+      features->emplace_back(json::map(
+          {{"type", std::string("Feature")},
+           {"properties", json::map({{"type", std::string("snapped")}, {"location_index", idx}})},
+           {"geometry",
+            json::map({{"type", std::string("MultiPoint")}, {"coordinates", snapped}})}}));
+      auto input = json::array(
+          {json::fixed_t{location.ll().lng(), 6}, json::fixed_t{location.ll().lat(), 6}});
+      features->emplace_back(json::map(
+          {{"type", std::string("Feature")},
+           {"properties", json::map({{"type", std::string("input")}, {"location_index", idx}})},
+           {"geometry", json::map({{"type", std::string("Point")}, {"coordinates", input}})}}));
+      ++idx;
+    }
+  }
+
+  auto feature_collection = json::map({
+      {"type", std::string("FeatureCollection")},
+      {"features", features},
+  });
+  if (request.options().has_id_case()) {
+    feature_collection->emplace("id", request.options().id());
+  }
+  if (request.info().warnings_size() >= 1) {
+    feature_collection->emplace("warnings", serializeWarnings(request));
+  }
+
+  std::stringstream ss;
+  ss << *feature_collection;
+  return ss.str();
+}
+
+TEST(Isochrones, SerializerMatchesDom) {
+  Api request;
+  request.mutable_options()->set_id("iso/\"chrone\"");
+  for (const auto& ll : {PointLL{5.1079374, 52.0887754}, PointLL{5.11, 52.09}}) {
+    auto* location = request.mutable_options()->add_locations();
+    location->mutable_ll()->set_lng(ll.lng());
+    location->mutable_ll()->set_lat(ll.lat());
+    // the same point twice is only written once
+    for (int i = 0; i < 2; ++i) {
+      auto* edge = location->mutable_correlation()->add_edges();
+      edge->mutable_ll()->set_lng(ll.lng() + 0.0001);
+      edge->mutable_ll()->set_lat(ll.lat() - 0.0001);
+    }
+  }
+
+  // one interval with its own color and two that get a computed one
+  std::vector<GriddedData<2>::contour_interval_t> intervals{
+      {0, 5.f, "time", "ff/000"}, {1, 10.5f, "time", ""}, {2, 1.234567f, "distance", ""}};
+  GriddedData<2>::contours_t contours(intervals.size());
+  for (size_t i = 0; i < contours.size(); ++i) {
+    GriddedData<2>::contour_t ring;
+    for (int p = 0; p < 5; ++p) {
+      ring.emplace_back(5.1 + 0.0123456789 * p * (i + 1), 52.09 - 0.00987654321 * p);
+    }
+    contours[i].push_back({ring, ring});
+    contours[i].push_back({});
+  }
+
+  for (bool polygons : {true, false}) {
+    for (bool show_locations : {true, false}) {
+      EXPECT_EQ(serializeIsochrones(request, intervals, contours, polygons, show_locations),
+                serialize_dom(request, intervals, contours, polygons, show_locations))
+          << "polygons " << polygons << " show_locations " << show_locations;
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -2,6 +2,8 @@
 #include "baldr/rapidjson_utils.h"
 
 #include <cstdint>
+#include <sstream>
+#include <string>
 
 #include "test.h"
 
@@ -74,6 +76,33 @@ TEST(JSON, Serialize) {
   EXPECT_EQ(res, ans) << "Wrong json";
 }
 
+TEST(JSON, InsertionOrder) {
+  using namespace valhalla::baldr;
+  auto map = json::map({{"z", uint64_t(1)}, {"a", uint64_t(2)}, {"z", uint64_t(3)}});
+  map->emplace("m", nullptr);
+  map->emplace("a", uint64_t(4));
+  std::stringstream result;
+  result << *map;
+  // keys come out in the order they were first inserted and the first value is kept
+  EXPECT_EQ(result.str(), R"({"z":1,"a":2,"m":null})");
+}
+
+TEST(JSON, StreamingWriterEscapesLikeDom) {
+  using namespace valhalla::baldr;
+  const std::string text("a/b \"c\" \\ \b\f\n\r\t\x01\x1f\x7f \xc3\xa9");
+  std::stringstream dom;
+  dom << *json::map({{"text", text}, {"array", json::array({text})}});
+
+  rapidjson::writer_wrapper_t writer(0, true);
+  writer.start_object();
+  writer("text", text);
+  writer.start_array("array");
+  writer(text);
+  writer.end_array();
+  writer.end_object();
+  EXPECT_EQ(std::string(writer.get_buffer(), writer.get_length()), dom.str());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
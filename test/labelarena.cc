@@ -0,0 +1,113 @@
+#include "thor/labelarena.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+struct simple_label {
+  float c;
+  float sortcost() const {
+    return c;
+  }
+};
+
+using arena_t = LabelArena<simple_label>;
+
+// Runs a fake search of the given size with storage from the arena of this thread
+void Search(std::vector<simple_label>& labels,
+            DoubleBucketQueue<simple_label>& queue,
+            const uint32_t count,
+            const size_t max_reserved = 1000000) {
+  auto& arena = arena_t::get();
+  arena.acquire(labels, queue, 100);
+  queue.reuse(0, 1000, 1, &labels);
+  for (uint32_t i = 0; i < count; ++i) {
+    labels.push_back({static_cast<float>(i % 1000)});
+    queue.add(i);
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    EXPECT_NE(queue.pop(), kInvalidLabel);
+  }
+  arena.release(labels, queue, max_reserved);
+  EXPECT_EQ(labels.capacity(), 0);
+}
+
+TEST(LabelArena, SharedBetweenSearches) {
+  std::thread([]() {
+    std::vector<simple_label> labels1, labels2;
+    DoubleBucketQueue<simple_label> queue1, queue2;
+
+    // The first search allocates, the second one reuses its storage
+    Search(labels1, queue1, 5000);
+    auto stats = arena_t::get().stats();
+    EXPECT_EQ(stats.acquired, 1);
+    EXPECT_EQ(stats.reused, 0);
+    EXPECT_EQ(stats.high_water_mark, 5000);
+    EXPECT_GE(stats.retained_bytes, 5000 * sizeof(simple_label));
+
+    Search(labels2, queue2, 4000);
+    stats = arena_t::get().stats();
+    EXPECT_EQ(stats.acquired, 2);
+    EXPECT_EQ(stats.reused, 1);
+    EXPECT_EQ(stats.trimmed, 0);
+
+    // Releasing storage which was not acquired again does nothing
+    arena_t::get().release(labels1, queue1, 1000000);
+    EXPECT_EQ(arena_t::get().stats().high_water_mark, stats.high_water_mark);
+  }).join();
+}
+
+TEST(LabelArena, HighWaterMarkDecays) {
+  std::thread([]() {
+    std::vector<simple_label> labels;
+    DoubleBucketQueue<simple_label> queue;
+
+    // One large search followed by small ones. The storage of the large one is freed once the
+    // high water mark has decayed enough
+    Search(labels, queue, 100000);
+    const auto large = arena_t::get().stats();
+    EXPECT_GE(large.retained_bytes, 100000 * sizeof(simple_label));
+
+    for (int i = 0; i < 50; ++i) {
+      Search(labels, queue, 1000);
+    }
+    const auto small = arena_t::get().stats();
+    EXPECT_GE(small.trimmed, 1);
+    EXPECT_LT(small.high_water_mark, 2000);
+    EXPECT_LT(small.retained_bytes, large.retained_bytes / 10);
+    EXPECT_GT(small.retained_bytes, 0);
+  }).join();
+}
+
+TEST(LabelArena, MaxReserved) {
+  std::thread([]() {
+    std::vector<simple_label> labels;
+    DoubleBucketQueue<simple_label> queue;
+
+    // Nothing is kept above the max reserved labels count or when it is 0
+    Search(labels, queue, 5000, 1000);
+    EXPECT_EQ(arena_t::get().stats().retained_bytes, 0);
+    Search(labels, queue, 500, 0);
+    EXPECT_EQ(arena_t::get().stats().retained_bytes, 0);
+    Search(labels, queue, 500, 1000);
+    EXPECT_GT(arena_t::get().stats().retained_bytes, 0);
+
+    arena_t::get().clear();
+    EXPECT_EQ(arena_t::get().stats().retained_bytes, 0);
+  }).join();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
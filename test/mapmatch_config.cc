@@ -24,6 +24,7 @@ const auto fake_config = test::json_to_pt(R"({
       "max_search_radius": 500,
       "search_radius": 10,
       "sigma_z": 5.1,
+      "streaming_window": 50,
       "turn_penalty_factor": 100
     }
   })");
@@ -60,6 +61,9 @@ TEST(MapmatchConfig, check_read_all_params) {
   const auto& routing = config.routing;
   EXPECT_EQ(routing.interpolation_distance_meters, 5.f);
   EXPECT_FALSE(routing.is_interpolation_distance_customizable);
+
+  // check streaming params
+  EXPECT_EQ(config.streaming.window, 50);
 }
 
 TEST(MapmatchConfig, validate_candidate_search_params) {
@@ -124,6 +128,17 @@ TEST(MapmatchConfig, validate_routing_params) {
   EXPECT_THROW(config.Read(pt), std::exception);
 }
 
+TEST(MapmatchConfig, validate_streaming_params) {
+  valhalla::meili::Config config;
+
+  auto pt = fake_config;
+  pt.put<size_t>("default.streaming_window", 0);
+  EXPECT_NO_THROW(config.Read(pt));
+
+  pt.put<size_t>("default.streaming_window", 1);
+  EXPECT_THROW(config.Read(pt), std::exception);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -4,12 +4,16 @@
 #include <string>
 #include <vector>
 
+#include "baldr/json.h"
 #include "loki/worker.h"
 #include "midgard/logging.h"
+#include "proto_conversions.h"
 #include "sif/dynamiccost.h"
+#include "thor/bucketmatrix.h"
 #include "thor/costmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
+#include "tyr/serializers.h"
 
 using namespace valhalla;
 using namespace valhalla::thor;
@@ -248,6 +252,24 @@ TEST(Matrix, test_matrix) {
         << "result " + std::to_string(i) +
                "'s time is not equal to the expected value for TimeDistMatrix";
   }
+
+  // the buckets have to find the same connections, also when the matrix is reused
+  BucketMatrix bucket_matrix;
+  for (int run = 0; run < 2; ++run) {
+    results = bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(),
+                                           reader, mode_costing, sif::TravelMode::kDrive, 400000.0);
+    bucket_matrix.clear();
+    ASSERT_EQ(results.size(), matrix_answers.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << "result " + std::to_string(i) + "'s distance is not equal to" +
+                 " the expected value for BucketMatrix";
+
+      EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+          << "result " + std::to_string(i) +
+                 "'s time is not equal to the expected value for BucketMatrix";
+    }
+  }
 }
 
 TEST(Matrix, test_timedistancematrix_results_sequence) {
@@ -391,6 +413,184 @@ TEST(Matrix, partial_matrix) {
   EXPECT_EQ(found, 2) << " partial result did not find 2 results as expected";
 }
 
+TEST(Matrix, costmatrix_concurrency) {
+  // a grid of locations so that every pass has enough of them to run on the worker threads
+  std::string locations;
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      locations += (locations.empty() ? "" : ",") + std::string("{\"lat\":") +
+                   std::to_string(52.092 + y * 0.006) +
+                   ",\"lon\":" + std::to_string(5.07 + x * 0.01) + "}";
+    }
+  }
+  const auto grid_request = "{\"sources\":[" + locations + "],\"targets\":[" + locations +
+                            "],\"costing\":\"auto\"}";
+
+  loki_worker_t loki_worker(config);
+  Api request;
+  ParseApi(grid_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  thor_worker_t::adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] =
+      CreateSimpleCost(request.options().costings().find(request.options().costing_type())->second);
+
+  CostMatrix serial;
+  auto expected = serial.SourceToTarget(request.options().sources(), request.options().targets(),
+                                        reader, mode_costing, sif::TravelMode::kDrive, 400000.0);
+
+  // the results have to be the same no matter how many threads ran the searches
+  for (uint32_t concurrency : {2, 3, 8}) {
+    boost::property_tree::ptree thor_config;
+    thor_config.put("costmatrix_concurrency", concurrency);
+    CostMatrix parallel(thor_config);
+    for (int run = 0; run < 2; ++run) {
+      auto results =
+          parallel.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                                  mode_costing, sif::TravelMode::kDrive, 400000.0);
+      parallel.clear();
+      ASSERT_EQ(results.size(), expected.size());
+      for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].time, expected[i].time)
+            << "time of result " << i << " differs with " << concurrency << " threads";
+        EXPECT_EQ(results[i].dist, expected[i].dist)
+            << "distance of result " << i << " differs with " << concurrency << " threads";
+      }
+    }
+  }
+}
+
+// The matrix serializers as they were before they streamed, building a json DOM first
+std::string serialize_dom(const Api& request,
+                          const std::vector<TimeDistance>& tds,
+                          double distance_scale) {
+  const auto& options = request.options();
+  auto json = json::map({});
+  if (options.format() == Options::osrm) {
+    auto waypoints = [](const google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
+      auto waypoints = json::array({});
+      for (const auto& location : locations) {
+        if (location.correlation().edges_size() == 0) {
+          waypoints->emplace_back(static_cast<std::nullptr_t>(nullptr));
+          continue;
+        }
+        const auto& edge = location.correlation().edges(0);
+        waypoints->emplace_back(json::map({
+            {"location",
+             json::array({json::fixed_t{edge.ll().lng(), 6}, json::fixed_t{edge.ll().lat(), 6}})},
+            {"name", edge.names_size() ? edge.names(0) : std::string()},
+            {"distance", json::fixed_t{to_ll(location.ll()).Distance(to_ll(edge.ll())), 3}},
+        }));
+      }
+      return waypoints;
+    };
+    json->emplace("code", std::string("Ok"));
+    json->emplace("sources", waypoints(options.sources()));
+    json->emplace("destinations", waypoints(options.targets()));
+    auto durations = json::array({});
+    auto distances = json::array({});
+    for (int source = 0; source < options.sources_size(); ++source) {
+      auto time = json::array({});
+      auto distance = json::array({});
+      for (int target = 0; target < options.targets_size(); ++target) {
+        const auto& td = tds[source * options.targets_size() + target];
+        if (td.time != kMaxCost) {
+          time->emplace_back(static_cast<uint64_t>(td.time));
+          distance->emplace_back(json::fixed_t{td.dist * distance_scale, 3});
+        } else {
+          time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+          distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+        }
+      }
+      durations->emplace_back(time);
+      distances->emplace_back(distance);
+    }
+    json->emplace("durations", durations);
+    json->emplace("distances", distances);
+  } else {
+    auto locations = [](const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated) {
+      auto locations = json::array({});
+      for (const auto& location : correlated) {
+        locations->emplace_back(json::map({{"lat", json::fixed_t{location.ll().lat(), 6}},
+                                           {"lon", json::fixed_t{location.ll().lng(), 6}}}));
+      }
+      return locations;
+    };
+    auto matrix = json::array({});
+    for (int source = 0; source < options.sources_size(); ++source) {
+      auto row = json::array({});
+      for (int target = 0; target < options.targets_size(); ++target) {
+        const auto& td = tds[source * options.targets_size() + target];
+        auto cell = json::map({{"from_index", static_cast<uint64_t>(source)},
+                               {"to_index", static_cast<uint64_t>(target)}});
+        if (td.time != kMaxCost) {
+          cell->emplace("time", static_cast<uint64_t>(td.time));
+          cell->emplace("distance", json::fixed_t{td.dist * distance_scale, 3});
+          if (!td.date_time.empty()) {
+            cell->emplace("date_time", td.date_time);
+          }
+        } else {
+          cell->emplace("time", static_cast<std::nullptr_t>(nullptr));
+          cell->emplace("distance", static_cast<std::nullptr_t>(nullptr));
+        }
+        row->emplace_back(cell);
+      }
+      matrix->emplace_back(row);
+    }
+    json->emplace("sources_to_targets", matrix);
+    json->emplace("units", Options_Units_Enum_Name(options.units()));
+    json->emplace("targets", json::array({locations(options.targets())}));
+    json->emplace("sources", json::array({locations(options.sources())}));
+    if (options.has_id_case()) {
+      json->emplace("id", options.id());
+    }
+    if (request.info().warnings_size() >= 1) {
+      json->emplace("warnings", serializeWarnings(request));
+    }
+  }
+
+  std::stringstream ss;
+  ss << *json;
+  return ss.str();
+}
+
+TEST(Matrix, serializer_matches_dom) {
+  loki_worker_t loki_worker(config);
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  thor_worker_t::adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] =
+      CreateSimpleCost(request.options().costings().find(request.options().costing_type())->second);
+  CostMatrix cost_matrix;
+  auto results = cost_matrix.SourceToTarget(request.options().sources(),
+                                            request.options().targets(), reader, mode_costing,
+                                            sif::TravelMode::kDrive, 400000.0);
+
+  // an unreachable pair and strings which need escaping
+  results[1].time = kMaxCost;
+  results[2].date_time = "2024-01-01T08:00";
+  request.mutable_options()->set_id("matrix/\"1\"");
+  auto* edge =
+      request.mutable_options()->mutable_sources(0)->mutable_correlation()->mutable_edges(0);
+  edge->clear_names();
+  edge->add_names("Oude/gracht \"Zuid\"\x7f");
+
+  for (auto format : {Options::osrm, Options::json}) {
+    request.mutable_options()->set_format(format);
+    for (double distance_scale : {1.0, 0.621371}) {
+      EXPECT_EQ(serializeMatrix(request, results, distance_scale),
+                serialize_dom(request, results, distance_scale))
+          << "format " << Options_Format_Enum_Name(format);
+    }
+  }
+}
+
 int main(int argc, char* argv[]) {
   logging::Configure({{"type", ""}}); // silence logs
   testing::InitGoogleTest(&argc, argv);
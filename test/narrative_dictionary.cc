@@ -1,7 +1,11 @@
 #include <map>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <boost/algorithm/string/replace.hpp>
+
 #include "midgard/logging.h"
 #include "odin/narrative_dictionary.h"
 #include "odin/util.h"
@@ -1338,6 +1342,76 @@ TEST(NarrativeDictionary, test_en_US_approach_verbal_alert) {
   validate(us_customary_lengths, kExpectedUsCustomaryLengths);
 }
 
+// Whether a value of the given type can be set on the values of a phrase
+template <typename T, typename = void> struct can_set : std::false_type {};
+template <typename T>
+struct can_set<T,
+               std::void_t<decltype(std::declval<PhraseValues&>().Set(kStreetNamesTag,
+                                                                      std::declval<T>()))>>
+    : std::true_type {};
+
+TEST(NarrativeDictionary, test_phrase_template) {
+  // Every tag as a value of its own so that the slots can be told apart
+  const std::vector<PhraseTag> tags =
+      {kCardinalDirectionTag, kRelativeDirectionTag, kOrdinalValueTag, kStreetNamesTag,
+       kPreviousStreetNamesTag, kBeginStreetNamesTag, kCrossStreetNamesTag,
+       kRoundaboutExitStreetNamesTag, kRoundaboutExitBeginStreetNamesTag, kRampExitNumbersVisualTag,
+       kLengthTag, kDestinationTag, kCurrentVerbalCueTag, kNextVerbalCueTag, kKilometersTag,
+       kMetersTag, kMilesTag, kTenthsOfMilesTag, kFeetTag, kNumberSignTag, kBranchSignTag,
+       kTowardSignTag, kNameSignTag, kJunctionNameTag, kFerryLabelTag, kTransitPlatformTag,
+       kStationLabelTag, kTimeTag, kTransitNameTag, kTransitHeadSignTag, kTransitPlatformCountTag,
+       kTransitPlatformCountLabelTag, kLevelTag};
+  ASSERT_EQ(tags.size(), kPhraseTagCount);
+
+  // Only every other tag gets a value, the rest are left in the phrase
+  PhraseValues values;
+  std::vector<std::string> tag_values;
+  for (size_t i = 0; i < tags.size(); i += 2) {
+    tag_values.push_back("[" + std::to_string(tags[i].slot) + "]");
+  }
+  for (size_t i = 0; i < tags.size(); i += 2) {
+    values.Set(tags[i], tag_values[i / 2]);
+  }
+
+  // The compiled phrases of every locale format to what replacing the tags one by one does
+  std::string instruction;
+  for (const auto& locale : get_locales()) {
+    const auto& dictionary = *locale.second;
+    const std::vector<const PhraseSet*> subsets =
+        {&dictionary.start_verbal_subset, &dictionary.destination_verbal_subset,
+         &dictionary.becomes_verbal_subset, &dictionary.continue_verbal_subset,
+         &dictionary.turn_subset, &dictionary.uturn_verbal_subset, &dictionary.exit_subset,
+         &dictionary.keep_to_stay_on_verbal_subset, &dictionary.enter_roundabout_subset,
+         &dictionary.exit_roundabout_verbal_subset, &dictionary.enter_ferry_subset,
+         &dictionary.transit_connection_start_subset, &dictionary.depart_subset,
+         &dictionary.transit_subset, &dictionary.post_transition_transit_verbal_subset,
+         &dictionary.verbal_multi_cue_subset, &dictionary.approach_verbal_alert_subset,
+         &dictionary.elevator_subset};
+    for (const auto* subset : subsets) {
+      ASSERT_EQ(subset->templates.size(), subset->phrases.size()) << locale.first;
+      for (const auto& phrase : subset->phrases) {
+        std::string expected = phrase.second;
+        for (size_t i = 0; i < tags.size(); i += 2) {
+          boost::replace_all(expected, tags[i].text, tag_values[i / 2]);
+        }
+        subset->templates.at(phrase.first).Format(instruction, values);
+        EXPECT_EQ(instruction, expected) << locale.first << " " << phrase.second;
+      }
+    }
+  }
+
+  // Temporaries are moved into the values, const ones can not be so they are not accepted
+  static_assert(can_set<std::string&&>::value, "temporaries are kept");
+  static_assert(!can_set<const std::string&&>::value, "const temporaries would dangle");
+  static_assert(!std::is_copy_constructible<PhraseValues>::value, "values point into themselves");
+
+  // Text which only looks like a tag is kept as it is
+  PhraseTemplate phrase("<<STREET_NAMES> <UNKNOWN> <LEVEL");
+  values.Set(kStreetNamesTag, std::string("Main Street"));
+  phrase.Format(instruction, values);
+  EXPECT_EQ(instruction, "<Main Street <UNKNOWN> <LEVEL");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
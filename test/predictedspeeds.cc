@@ -254,6 +254,79 @@ TEST(PredictedSpeeds, test_compress_decompress_accuracy) {
   EXPECT_LE(max_diff, 2.f) << "Low decompression accuracy"; // <= 2 KPH
 }
 
+TEST(PredictedSpeeds, test_decompress_whole_week) {
+  std::array<float, kBucketsPerWeek> speeds;
+  for (uint32_t i = 0; i < kBucketsPerWeek; ++i)
+    speeds[i] = roundf(40.f + 20.f * cos(i / 30.f));
+  auto compressed_speeds = compress_speed_buckets(speeds.data());
+
+  // decoding the whole week at once has to give the values of the single buckets
+  std::array<float, kBucketsPerWeek> week;
+  decompress_speed_buckets(compressed_speeds.data(), week.data());
+  for (uint32_t i = 0; i < kBucketsPerWeek; ++i)
+    EXPECT_NEAR(week[i], decompress_speed_bucket(compressed_speeds.data(), i), 1e-3f)
+        << "Bucket " << i << " differs from the single bucket value";
+}
+
+TEST(PredictedSpeeds, test_decompress_matches_scalar_order) {
+  // the vectorized kernels sum the terms in another order than the plain loop did, which may
+  // only change the speeds by float rounding. With 200 terms that stays well below 1e-3 kph
+  constexpr float kTolerance = 1e-3f;
+  constexpr float kPiBucketConstant = 3.14159265f / 2016.0f;
+  constexpr float k1OverSqrt2 = 0.707106781f;
+  constexpr float kSpeedNormalization = 0.031497039f;
+
+  for (float amplitude : {5.f, 20.f, 60.f}) {
+    std::array<float, kBucketsPerWeek> speeds;
+    for (uint32_t i = 0; i < kBucketsPerWeek; ++i)
+      speeds[i] = roundf(amplitude + 1.f + amplitude * sin(i / 17.f) * cos(i / 300.f));
+    auto coefficients = compress_speed_buckets(speeds.data());
+
+    for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
+      // the DCT-III as the scalar decoder summed it, one coefficient after the other
+      float expected = coefficients[0] * k1OverSqrt2;
+      for (uint32_t c = 1; c < kCoefficientCount; ++c)
+        expected += coefficients[c] * cosf(kPiBucketConstant * (bucket + 0.5f) * c);
+      expected *= kSpeedNormalization;
+
+      EXPECT_NEAR(decompress_speed_bucket(coefficients.data(), bucket), expected, kTolerance)
+          << "Bucket " << bucket << " with amplitude " << amplitude;
+    }
+  }
+}
+
+TEST(PredictedSpeeds, test_speed_cache) {
+  // two edges with different profiles
+  std::array<float, kBucketsPerWeek> speeds;
+  std::vector<int16_t> profiles;
+  for (uint32_t edge = 0; edge < 2; ++edge) {
+    for (uint32_t i = 0; i < kBucketsPerWeek; ++i)
+      speeds[i] = roundf(30.f + (edge + 1) * 10.f * sin(i / 20.f));
+    auto compressed_speeds = compress_speed_buckets(speeds.data());
+    profiles.insert(profiles.end(), compressed_speeds.begin(), compressed_speeds.end());
+  }
+  uint32_t indexes[] = {0, kCoefficientCount};
+
+  PredictedSpeeds uncached;
+  uncached.set_offset(indexes);
+  uncached.set_profiles(profiles.data());
+
+  // the cache is sized by the two profiles, so the edges and buckets keep evicting each other
+  PredictedSpeeds cached;
+  cached.set_offset(indexes);
+  cached.set_profiles(profiles.data());
+  cached.set_cache_size(4096, 2);
+
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t secs = 0; secs < kSecondsPerWeek; secs += 7 * 60) {
+      for (uint32_t edge = 0; edge < 2; ++edge) {
+        ASSERT_EQ(cached.speed(edge, secs), uncached.speed(edge, secs))
+            << "Cached speed differs for edge " << edge << " at " << secs;
+      }
+    }
+  }
+}
+
 struct EncoderDecoderTest : public ::testing::Test {
   EncoderDecoderTest() {
     // fill in coefficients
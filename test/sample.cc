@@ -9,6 +9,7 @@
 #include <fstream>
 #include <list>
 #include <lz4frame.h>
+#include <thread>
 
 #include "test.h"
 
@@ -118,6 +119,34 @@ TEST(Sample, getlz4) {
   _get("test/data/samplelz4");
 };
 
+TEST(Sample, get_all_concurrent) {
+  // postings alternate between a tile we have and one we dont, results must stay in order
+  skadi::sample s("test/data/samplegz");
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 200; ++i) {
+    postings.emplace_back(-76.537011, 40.723872 + i * 0.001);
+    postings.emplace_back(10.5, 10.5 + i * 0.001);
+  }
+  std::vector<double> expected;
+  for (const auto& p : postings)
+    expected.push_back(s.get(p));
+
+  // many threads asking at once must all see the same heights
+  std::vector<std::thread> threads;
+  std::vector<std::vector<double>> results(8);
+  for (auto& result : results)
+    threads.emplace_back([&s, &postings, &result]() { result = s.get_all(postings); });
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& result : results) {
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(result[i], expected[i]) << "Wrong height at posting " << i;
+      EXPECT_EQ(result[i] == skadi::get_no_data_value(), i % 2 == 1);
+    }
+  }
+}
+
 struct testable_sample_t : public skadi::sample {
   testable_sample_t(const std::string& dir) : sample(dir) {
     {
@@ -249,6 +278,50 @@ TEST(Sample, store) {
   filesystem::remove("test/data/sample/N00/N00E005.hgt.gz");
 }
 
+TEST(Sample, replace_compressed) {
+  // a tile of the same height everywhere
+  auto make_tile = [](int16_t height) {
+    return std::vector<int16_t>(3601 * 3601, ((height & 0xFF) << 8) | ((height >> 8) & 0xFF));
+  };
+
+  // start with an lz4 tile
+  auto tile = make_tile(100);
+  std::vector<char> lz4_buffer(tile.size() * sizeof(int16_t), 0);
+  auto lz4_bytes = LZ4F_compressFrame(lz4_buffer.data(), lz4_buffer.size(), tile.data(),
+                                      tile.size() * sizeof(int16_t), nullptr);
+  ASSERT_FALSE(LZ4F_isError(lz4_bytes));
+  {
+    std::ofstream file("test/data/sample/N00/N00E007.hgt.lz4", std::ios::binary | std::ios::trunc);
+    file.write(lz4_buffer.data(), lz4_bytes);
+  }
+  testable_sample_t s("test/data/sample");
+  EXPECT_NEAR(s.get(std::make_pair(7.5, 0.5)), 100, 0.1);
+
+  // replace it with a gzipped tile of a different height
+  tile = make_tile(200);
+  auto src_func = [&tile](z_stream& s) -> int {
+    s.next_in = static_cast<Byte*>(static_cast<void*>(tile.data()));
+    s.avail_in = static_cast<unsigned int>(tile.size() * sizeof(int16_t));
+    return Z_FINISH;
+  };
+  std::vector<char> gz, dst_buffer(13000, 0);
+  auto dst_func = [&dst_buffer, &gz](z_stream& s) -> void {
+    gz.insert(gz.end(), dst_buffer.data(), dst_buffer.data() + (s.total_out - gz.size()));
+    if (s.avail_in > 0) {
+      s.next_out = static_cast<Byte*>(static_cast<void*>(dst_buffer.data()));
+      s.avail_out = dst_buffer.size();
+    }
+  };
+  ASSERT_TRUE(baldr::deflate(src_func, dst_func));
+  EXPECT_TRUE(s.store("/N00/N00E007.hgt.gz", gz));
+
+  // the tile unpacked from the old file must not be used anymore
+  EXPECT_NEAR(s.get(std::make_pair(7.5, 0.5)), 200, 0.1);
+
+  filesystem::remove("test/data/sample/N00/N00E007.hgt.lz4");
+  filesystem::remove("test/data/sample/N00/N00E007.hgt.gz");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -456,6 +456,52 @@ TEST(Search, test_search_cutoff) {
   search(x, 2, 0);
 }
 
+void expect_same_edges(const std::vector<PathLocation::PathEdge>& edges,
+                       const std::vector<PathLocation::PathEdge>& expected) {
+  ASSERT_EQ(edges.size(), expected.size());
+  for (size_t i = 0; i < edges.size(); ++i) {
+    EXPECT_EQ(edges[i].id, expected[i].id);
+    EXPECT_EQ(edges[i].percent_along, expected[i].percent_along);
+    EXPECT_EQ(edges[i].projected, expected[i].projected);
+    EXPECT_EQ(edges[i].distance, expected[i].distance);
+    EXPECT_EQ(edges[i].sos, expected[i].sos);
+    EXPECT_EQ(edges[i].outbound_reach, expected[i].outbound_reach);
+    EXPECT_EQ(edges[i].inbound_reach, expected[i].inbound_reach);
+  }
+}
+
+TEST(Search, test_parallel_search_matches_serial) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  valhalla::baldr::GraphReader reader(conf);
+  const auto costing = create_costing();
+
+  // enough locations sharing the bin around c that the projections are spread over the threads
+  std::vector<Location> locations;
+  for (int i = 0; i < 16; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      Location location({.001 + i * .003, .001 + j * .003}, Location::StopType::BREAK, i % 4, j % 4,
+                        (i + j) % 3 * 500);
+      location.street_side_max_distance_ = 5000;
+      locations.push_back(location);
+    }
+  }
+  locations.back().heading_ = 90;
+
+  const auto expected = Search(locations, reader, costing);
+  ASSERT_FALSE(expected.empty());
+  SearchWorkers workers(conf, 4);
+  for (int run = 0; run < 2; ++run) {
+    const auto results = Search(locations, reader, costing, false, &workers);
+    ASSERT_EQ(results.size(), expected.size());
+    for (const auto& result : results) {
+      const auto& expected_result = expected.at(result.first);
+      expect_same_edges(result.second.edges, expected_result.edges);
+      expect_same_edges(result.second.filtered_edges, expected_result.filtered_edges);
+    }
+  }
+}
+
 } // namespace
 
 // Setup and tearown will be called only once for the entire suite121
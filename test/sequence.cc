@@ -1,5 +1,7 @@
 #include "midgard/sequence.h"
+#include <algorithm>
 #include <cstdint>
+#include <random>
 
 #include "test.h"
 
@@ -70,6 +72,57 @@ TEST(Sequence, Iterator) {
   EXPECT_EQ(i.position(), 0) << "Pre-decrement operator wasn't right";
 }
 
+TEST(Sequence, ParallelSort) {
+  // random ids with plenty of duplicates
+  std::mt19937_64 generator(17);
+  std::vector<osm_node> nodes(10000);
+  for (auto& node : nodes) {
+    node.id = generator() % 5000;
+    node.attributes = static_cast<uint32_t>(generator());
+  }
+  std::vector<uint64_t> expected;
+  for (const auto& node : nodes) {
+    expected.push_back(node.id);
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // one run, a few runs and lots of small runs on one or more threads with either sort
+  for (size_t buffer_size : {100000, 3000, 7}) {
+    for (size_t concurrency : {1, 2, 5}) {
+      for (bool by_key : {false, true}) {
+        {
+          sequence<osm_node> sequence("parallel.nd", true);
+          for (const auto& node : nodes) {
+            sequence.push_back(node);
+          }
+          if (by_key) {
+            sequence.sort_by_key([](const osm_node& n) { return n.id; }, buffer_size, concurrency);
+          } else {
+            sequence.sort([](const osm_node& a, const osm_node& b) { return a.id < b.id; },
+                          buffer_size, concurrency);
+          }
+        }
+        sequence<osm_node> sorted("parallel.nd", false);
+        ASSERT_EQ(sorted.size(), nodes.size());
+        std::vector<std::pair<uint64_t, uint32_t>> got, want;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+          osm_node node = *sorted[i];
+          ASSERT_EQ(node.id, expected[i]) << "Wrong node at " << i << " with buffer_size "
+                                          << buffer_size << " and concurrency " << concurrency;
+          got.emplace_back(node.id, node.attributes);
+        }
+        // nothing was lost or duplicated
+        for (const auto& node : nodes) {
+          want.emplace_back(node.id, node.attributes);
+        }
+        std::sort(got.begin(), got.end());
+        std::sort(want.begin(), want.end());
+        EXPECT_EQ(got, want);
+      }
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,127 @@
+#include "mjolnir/taskpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+TEST(TaskPool, EveryTaskRunsOnce) {
+  TaskPool pool(4);
+  for (size_t task_count : {0, 1, 3, 4, 1000}) {
+    std::vector<std::atomic<int>> done(task_count);
+    std::atomic<size_t> workers(0);
+    auto stats = pool.Run("test", task_count, [&done, &workers](TaskPool::Worker& worker) {
+      ++workers;
+      size_t task;
+      while (worker.next(task)) {
+        ++done[task];
+      }
+    });
+    EXPECT_EQ(stats.tasks, task_count);
+    EXPECT_EQ(workers.load(), pool.concurrency());
+    for (const auto& d : done) {
+      EXPECT_EQ(d.load(), 1);
+    }
+  }
+}
+
+TEST(TaskPool, SkewedTasksAreStolen) {
+  TaskPool pool(4);
+  // all the slow tasks land in the range of the first worker
+  std::vector<std::atomic<int>> done(40);
+  std::vector<std::atomic<size_t>> ran_on(40);
+  auto stats = pool.Run("skewed", done.size(), [&done, &ran_on](TaskPool::Worker& worker) {
+    size_t task;
+    while (worker.next(task)) {
+      if (task < 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      ran_on[task] = worker.id();
+      ++done[task];
+    }
+  });
+
+  for (const auto& d : done) {
+    EXPECT_EQ(d.load(), 1);
+  }
+  EXPECT_GT(stats.steals, 0);
+  size_t stolen = 0;
+  for (size_t task = 0; task < 10; ++task) {
+    stolen += ran_on[task] != 0;
+  }
+  EXPECT_GT(stolen, 0);
+  EXPECT_GE(stats.slowest_task_seconds, 0.02);
+  EXPECT_LT(stats.slowest_task, 10);
+}
+
+TEST(TaskPool, ExceptionIsRethrown) {
+  TaskPool pool(3);
+  std::atomic<size_t> done(0);
+  EXPECT_THROW(pool.Run("failing", 100,
+                        [&done](TaskPool::Worker& worker) {
+                          size_t task;
+                          while (worker.next(task)) {
+                            if (task == 50) {
+                              throw std::runtime_error("bad tile");
+                            }
+                            ++done;
+                          }
+                        }),
+               std::runtime_error);
+  EXPECT_LT(done.load(), 100);
+
+  // the pool is still usable afterwards
+  done = 0;
+  pool.Run("recovered", 100, [&done](TaskPool::Worker& worker) {
+    size_t task;
+    while (worker.next(task)) {
+      ++done;
+    }
+  });
+  EXPECT_EQ(done.load(), 100);
+}
+
+TEST(TaskPool, BatchStatsAccumulate) {
+  TaskPool pool(2);
+  TaskStats total;
+  for (size_t batch = 0; batch < 3; ++batch) {
+    total += pool.Run("", 10, [](TaskPool::Worker& worker) {
+      size_t task;
+      while (worker.next(task)) {
+      }
+    });
+  }
+  EXPECT_EQ(total.tasks, 30);
+  EXPECT_GE(total.busiest_seconds, total.idlest_seconds);
+
+  // the busiest and idlest thread are picked from the per thread totals
+  ASSERT_EQ(total.thread_seconds.size(), 2);
+  EXPECT_EQ(total.busiest_seconds,
+            std::max(total.thread_seconds.front(), total.thread_seconds.back()));
+  EXPECT_EQ(total.idlest_seconds,
+            std::min(total.thread_seconds.front(), total.thread_seconds.back()));
+}
+
+TEST(TaskPool, SharedPoolFollowsConfig) {
+  boost::property_tree::ptree pt;
+  pt.put("mjolnir.concurrency", 2);
+  EXPECT_EQ(TaskPool::get(pt).concurrency(), 2);
+  EXPECT_EQ(&TaskPool::get(pt), &TaskPool::get(pt.get_child("mjolnir")));
+  pt.put("mjolnir.concurrency", 3);
+  EXPECT_EQ(TaskPool::get(pt).concurrency(), 3);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
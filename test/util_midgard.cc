@@ -6,6 +6,7 @@
 #include "midgard/util.h"
 #include <cmath>
 #include <cstdlib>
+#include <limits>
 #include <random>
 
 #include <list>
@@ -781,6 +782,60 @@ TEST(UtilMidgard, PolygonArea) {
   }
 }
 
+TEST(UtilMidgard, ProjectorClosest) {
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> offset(-.01, .01);
+  for (int i = 0; i < 1000; ++i) {
+    const PointLL ll(5.1 + offset(generator), 52.1 + offset(generator));
+    projector_t project(ll);
+    // shapes of every length the vectorized loops leave some segments of, with repeated points
+    std::vector<PointLL> shape;
+    for (size_t j = 0; j < i % 13; ++j) {
+      if (j > 0 && j % 4 == 3) {
+        shape.push_back(shape.back());
+      } else {
+        shape.emplace_back(5.1 + offset(generator), 52.1 + offset(generator));
+      }
+    }
+
+    double expected_sq_distance = std::numeric_limits<double>::max();
+    for (size_t j = 0; j + 1 < shape.size(); ++j) {
+      expected_sq_distance =
+          std::min(expected_sq_distance,
+                   project.approx.DistanceSquared(project(shape[j], shape[j + 1])));
+    }
+
+    PointLL point;
+    double sq_distance = std::numeric_limits<double>::max();
+    size_t index = 0;
+    EXPECT_EQ(project.closest(shape, point, sq_distance, index), shape.size() > 1);
+    // contracting the arithmetic into fused multiply adds may change the last bits, which can
+    // tip a tie at a repeated point to either of its segments
+    if (shape.size() > 1) {
+      EXPECT_NEAR(sq_distance, expected_sq_distance, expected_sq_distance * 1e-12);
+      EXPECT_NEAR(project.approx.DistanceSquared(project(shape[index], shape[index + 1])),
+                  expected_sq_distance, expected_sq_distance * 1e-12);
+      EXPECT_NEAR(project.approx.DistanceSquared(point), sq_distance, sq_distance * 1e-12);
+    }
+  }
+
+  // of equally close projections the first one is kept
+  projector_t project({5.1, 52.1});
+  const std::vector<PointLL> shape(9, PointLL{5.2, 52.2});
+  PointLL point;
+  double sq_distance = std::numeric_limits<double>::max();
+  size_t index = 10;
+  ASSERT_TRUE(project.closest(shape, point, sq_distance, index));
+  EXPECT_EQ(index, 0);
+  EXPECT_EQ(point, shape.front());
+
+  // and nothing changes unless a projection is closer than the one passed in
+  const auto closest = sq_distance;
+  EXPECT_FALSE(project.closest(shape, point, sq_distance, index));
+  EXPECT_EQ(sq_distance, closest);
+  EXPECT_EQ(index, 0);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
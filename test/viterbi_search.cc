@@ -351,6 +351,44 @@ private:
   std::vector<Column> columns_;
 };
 
+void test_search_reachable(const std::vector<Column>& columns) {
+  NaiveViterbiSearch<false> na;
+  ViterbiSearch vs;
+  for (IViterbiSearch* search : std::vector<IViterbiSearch*>{&na, &vs}) {
+    search->set_emission_cost_model(EmissionCostModel(columns));
+    search->set_transition_cost_model(TransitionCostModel(columns));
+    AddColumns(*search, columns);
+  }
+  vs.SearchReachable();
+  if (columns.empty()) {
+    return;
+  }
+
+  // Not only the winner but every state of the last time has its optimal cost and predecessor
+  const StateId::Time time = columns.size() - 1;
+  na.SearchWinner(time);
+  for (uint32_t idx = 0; idx < columns.back().size(); ++idx) {
+    const StateId stateid(time, idx);
+    EXPECT_EQ(na.AccumulatedCost(stateid), vs.AccumulatedCost(stateid))
+        << "cost of " << time << "/" << idx << " should be optimal";
+    EXPECT_EQ(na.Predecessor(stateid).IsValid(), vs.Predecessor(stateid).IsValid());
+  }
+}
+
+TEST(ViterbiSearch, TestSearchReachable) {
+  for (const size_t column_length : {1, 2, 10, 1000}) {
+    const auto& columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(0, 50),
+        // emission costs
+        std::uniform_int_distribution<int>(0, 100),
+        generate_column_counts(column_length,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(1, 20)));
+    test_search_reachable(columns);
+  }
+}
+
 struct PathWithCost : std::pair<std::vector<StateId>, float> {
   using std::pair<std::vector<StateId>, float>::pair;
   const std::vector<StateId>& path() const {
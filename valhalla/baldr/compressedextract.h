@@ -0,0 +1,128 @@
+#ifndef VALHALLA_BALDR_COMPRESSEDEXTRACT_H_
+#define VALHALLA_BALDR_COMPRESSEDEXTRACT_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+// Marks the beginning of a compressed extract so it can be told apart from a tar
+constexpr char kCompressedExtractMagic[8] = {'V', 'A', 'L', 'H', 'L', 'Z', '4', '\0'};
+constexpr uint32_t kCompressedExtractVersion = 1;
+
+// LZ4 only looks back 64KB so a larger dictionary would not be used
+constexpr uint32_t kMaxCompressedExtractDictionary = 65536;
+
+/**
+ * Header at the beginning of a compressed extract. The file is laid out as the header,
+ * the index of the tiles sorted by tile id, the dictionary and then one LZ4 block per
+ * tile which is compressed on its own against the dictionary.
+ */
+struct compressed_extract_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t tile_count;
+  uint32_t dictionary_size;
+  uint32_t spare;
+};
+
+/**
+ * Index entry of a tile within a compressed extract.
+ */
+struct compressed_tile_entry_t {
+  uint64_t offset;          // byte offset of the block from the beginning of the file
+  uint32_t tile_id;         // just level and tileindex hence fitting in 32bits
+  uint32_t compressed_size; // size of the block in bytes
+  uint32_t size;            // size of the tile in bytes
+  uint32_t spare;
+};
+
+/**
+ * Memory mapped extract of graph tiles compressed one by one, so that a single tile can be
+ * decompressed when it is first needed without touching the rest of the file. All the tiles
+ * are compressed against one dictionary sampled from the tiles themselves, which brings
+ * back most of what compressing them separately loses.
+ */
+class CompressedExtract {
+public:
+  /**
+   * Maps a compressed extract.
+   * @param  file_name  Path to the extract.
+   * Throws if the file is not a compressed extract of a supported version.
+   */
+  explicit CompressedExtract(const std::string& file_name);
+
+  /**
+   * Tells whether a file starts like a compressed extract.
+   */
+  static bool IsCompressedExtract(const std::string& file_name);
+
+  /**
+   * Compresses the tiles of a tile directory into an extract.
+   * @param  tile_dir         Directory of the tiles, plain or gzipped.
+   * @param  tiles            Ids of the tiles to put in the extract.
+   * @param  file_name        Path of the extract to write.
+   * @param  dictionary_size  Bytes sampled from the tiles for the dictionary.
+   * @param  level            LZ4 HC compression level.
+   * @return Returns the number of tiles written.
+   */
+  static size_t Build(const std::string& tile_dir,
+                      const std::unordered_set<GraphId>& tiles,
+                      const std::string& file_name,
+                      const uint32_t dictionary_size = kMaxCompressedExtractDictionary,
+                      const int level = 9);
+
+  /**
+   * Finds the index entry of a tile.
+   * @return Returns nullptr if the extract does not hold the tile.
+   */
+  const compressed_tile_entry_t* Find(const GraphId& graphid) const;
+
+  /**
+   * Decompresses a tile. Safe to call from several threads at once.
+   * @return Returns an empty vector if the extract does not hold the tile or its block is
+   *         corrupt.
+   */
+  std::vector<char> Decompress(const GraphId& graphid) const;
+
+  /**
+   * Gets the compressed block of a tile.
+   */
+  char* block(const compressed_tile_entry_t& entry) const {
+    return memmap_.get() + entry.offset;
+  }
+
+  const compressed_tile_entry_t* begin() const {
+    return entries_;
+  }
+
+  const compressed_tile_entry_t* end() const {
+    return entries_ + header_->tile_count;
+  }
+
+  size_t size() const {
+    return header_->tile_count;
+  }
+
+  const std::string& file_name() const {
+    return file_name_;
+  }
+
+protected:
+  std::string file_name_;
+  midgard::mem_map<char> memmap_;
+  const compressed_extract_header_t* header_;
+  const compressed_tile_entry_t* entries_;
+  const char* dictionary_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_COMPRESSEDEXTRACT_H_
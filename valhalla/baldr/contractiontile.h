@@ -0,0 +1,167 @@
+#ifndef VALHALLA_BALDR_CONTRACTIONTILE_H_
+#define VALHALLA_BALDR_CONTRACTIONTILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+
+namespace valhalla {
+namespace baldr {
+
+// File name suffix of the contraction tiles
+const std::string SUFFIX_CONTRACTION = ".ch";
+
+// Rank of the directed edges which are not part of the contraction hierarchy
+constexpr uint32_t kInvalidRank = 0xffffffff;
+
+// The arc (or one of the arcs it is a shortcut of) turns onto an edge with a complex
+// restriction, an access restriction or destination only access. The default costing
+// has no say about these without knowing the rest of the path or the time so paths
+// using such arcs have to be computed by the regular path algorithms.
+constexpr uint8_t kContractionArcRestricted = 1;
+
+/**
+ * Leads a contraction tile. A contraction tile holds the part of a contraction hierarchy
+ * built for the default auto costing which belongs to the directed edges of one graph
+ * tile, see mjolnir::ContractionBuilder.
+ */
+struct ContractionTileHeader {
+  uint64_t graphid;    // Graph tile the contraction tile belongs to
+  uint64_t dataset_id; // Dataset id of the graph tile it was built from
+  uint32_t edgecount;  // Number of directed edges of the graph tile
+  uint32_t arccount;   // Number of arcs
+};
+
+/**
+ * The hierarchy nodes are the directed edges of the graph and the arcs connect an edge
+ * to the edges it can turn onto. An arc costs the turn plus the whole edge it leads to.
+ * One node record is stored per directed edge of the graph tile, in the same order as
+ * the directed edges. The arcs of a node are stored one after the other, upward arcs
+ * first: upward arcs lead from the node to higher ranked nodes, downward arcs lead from
+ * higher ranked nodes to the node and hold the node they come from as their target.
+ */
+struct ContractionNode {
+  uint32_t rank;       // Position in the contraction order, kInvalidRank if not contracted
+  uint32_t arc_index;  // Index of the first arc of the node
+  uint32_t up_count;   // Number of upward arcs
+  uint32_t down_count; // Number of downward arcs
+};
+
+/**
+ * An arc of the contraction hierarchy. Shortcuts skip a contracted node, the middle, and
+ * are unpacked through the arcs of the middle node.
+ */
+struct ContractionArc {
+  GraphId target; // Node the arc leads to (upward) or comes from (downward)
+  GraphId middle; // Contracted node of a shortcut, invalid for an original arc
+  float cost;     // Cost of the turn and of the edge the arc leads to
+  float secs;     // Elapsed time of the same
+  uint32_t length;
+  uint8_t flags;
+  uint8_t spare[3];
+};
+
+/**
+ * A contraction tile read from disk.
+ */
+class ContractionTile {
+public:
+  /**
+   * Reads the contraction tile of a graph tile.
+   * @param  dir      Directory the contraction tiles are stored in.
+   * @param  graphid  Graph tile to read the contraction tile of.
+   * @return Returns nullptr if there is no valid contraction tile.
+   */
+  static std::shared_ptr<const ContractionTile> Create(const std::string& dir,
+                                                       const GraphId& graphid);
+
+  /**
+   * Creates a contraction tile from its raw bytes. Throws if the bytes do not hold a
+   * complete contraction tile.
+   * @param  data  Contents of a contraction tile file.
+   */
+  explicit ContractionTile(std::vector<char>&& data);
+
+  const ContractionTileHeader* header() const {
+    return header_;
+  }
+
+  /**
+   * Gets the hierarchy node of a directed edge.
+   * @param  idx  Index of the directed edge within the tile.
+   */
+  const ContractionNode* node(const uint32_t idx) const {
+    return idx < header_->edgecount ? nodes_ + idx : nullptr;
+  }
+
+  /**
+   * Gets the upward arcs of a node, use with node->up_count.
+   */
+  const ContractionArc* up(const ContractionNode* node) const {
+    return arcs_ + node->arc_index;
+  }
+
+  /**
+   * Gets the downward arcs of a node, use with node->down_count.
+   */
+  const ContractionArc* down(const ContractionNode* node) const {
+    return arcs_ + node->arc_index + node->up_count;
+  }
+
+  /**
+   * Returns the number of bytes of the tile.
+   */
+  size_t size() const {
+    return data_.size();
+  }
+
+protected:
+  std::vector<char> data_;
+  const ContractionTileHeader* header_;
+  const ContractionNode* nodes_;
+  const ContractionArc* arcs_;
+};
+
+/**
+ * Reads and caches the contraction tiles of a graph. Not thread safe, like the graph
+ * reader every thread needs its own.
+ */
+class ContractionReader {
+public:
+  /**
+   * @param  dir              Directory the contraction tiles are stored in.
+   * @param  max_cache_size   Bytes of tiles cached before the cache is cleared.
+   */
+  ContractionReader(const std::string& dir, const size_t max_cache_size);
+
+  /**
+   * Gets the contraction tile of a graph tile. Contraction tiles built from another
+   * dataset than the graph tile are not used.
+   * @param  graphid      Any id within the graph tile.
+   * @param  graphreader  Graph reader the graph tile is read from.
+   * @return Returns nullptr if there is no usable contraction tile.
+   */
+  std::shared_ptr<const ContractionTile> GetTile(const GraphId& graphid, GraphReader& graphreader);
+
+  /**
+   * Clears the cache if it holds more than its maximum size. Tiles still used by a
+   * query are kept alive by their shared pointers.
+   */
+  void Trim();
+
+protected:
+  std::string dir_;
+  size_t max_cache_size_;
+  size_t cache_size_;
+  std::unordered_map<uint64_t, std::shared_ptr<const ContractionTile>> cache_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_CONTRACTIONTILE_H_
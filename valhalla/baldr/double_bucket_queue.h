@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdint>
 #include <valhalla/baldr/graphconstants.h>
+#include <valhalla/baldr/radix_heap.h>
 #include <valhalla/midgard/util.h>
 #include <vector>
 
@@ -14,12 +15,22 @@ namespace baldr {
 using bucket_t = std::vector<uint32_t>;
 using buckets_t = std::vector<bucket_t>;
 
+// Priority queue used by the adjacency lists of the path algorithms
+enum class QueuePolicy : uint8_t {
+  kDoubleBucket = 0, // Fixed cost range buckets with an overflow bucket
+  kRadixHeap = 1     // Monotone radix heap, no cost range to tune
+};
+
 /**
  * Double Bucket Queue - a form of priority queue. Contains a bucket sort
  * implementation for performance. An "overflow" bucket is maintained to allow
  * reduced memory use. Costs outside the current bucket "range" get placed
  * into the overflow bucket and are moved into the low-level buckets as
  * needed. Each bucket stores label indexes into external data.
+ *
+ * When set up with QueuePolicy::kRadixHeap the queue hands all operations to
+ * a RadixHeap instead and the bucket range and size are not used. Costs far
+ * outside the range then do not have to go through the overflow bucket.
  */
 template <typename label_t> class DoubleBucketQueue final {
 public:
@@ -62,12 +73,15 @@ public:
    * @param bucketsize Bucket size (range of costs within same bucket).
    *                   Must be an integer value.
    * @param labelcontainer  Container of labels with sortcosts.
+   * @param policy     Priority queue implementation to use.
    */
   void reuse(const float mincost,
              const float range,
              const uint32_t bucketsize,
-             const std::vector<label_t>* labelcontainer) {
+             const std::vector<label_t>* labelcontainer,
+             const QueuePolicy policy = QueuePolicy::kDoubleBucket) {
     labelcontainer_ = labelcontainer;
+    policy_ = policy;
     // We need at least a bucketsize of 1 or more
     if (bucketsize < 1) {
       throw std::runtime_error("Bucketsize must be 1 or greater");
@@ -89,6 +103,13 @@ public:
     // Set the maximum cost (above this goes into the overflow bucket)
     maxcost_ = mincost_ + bucketrange_;
 
+    // The radix heap needs no low-level buckets
+    if (policy_ == QueuePolicy::kRadixHeap) {
+      radixheap_.reuse(bucketsize_, labelcontainer);
+      currentbucket_ = buckets_.end();
+      return;
+    }
+
     // Allocate the low-level buckets
     const size_t bucketcount = (range / bucketsize_) + 1;
     buckets_.resize(bucketcount);
@@ -102,6 +123,8 @@ public:
    * memory.
    */
   void clear() {
+    radixheap_.clear();
+
     // Empty the overflow bucket and each bucket
     overflowbucket_.clear();
     while (currentbucket_ != buckets_.end()) {
@@ -122,6 +145,10 @@ public:
    * @param   label  Label index to add to the queue.
    */
   void add(const uint32_t label) {
+    if (policy_ == QueuePolicy::kRadixHeap) {
+      radixheap_.add(label);
+      return;
+    }
     get_bucket((*labelcontainer_)[label].sortcost()).push_back(label);
   }
 
@@ -133,6 +160,11 @@ public:
    * @param  newcost      New sort cost.
    */
   void decrease(const uint32_t label, const float newcost) {
+    if (policy_ == QueuePolicy::kRadixHeap) {
+      radixheap_.decrease(label, newcost);
+      return;
+    }
+
     // Get the buckets of the previous and new costs. Nothing needs to be done
     // if old cost and the new cost are in the same buckets.
     bucket_t& prevbucket = get_bucket((*labelcontainer_)[label].sortcost());
@@ -150,6 +182,10 @@ public:
    *          kInvalidLabel if the buckets are empty.
    */
   uint32_t pop() {
+    if (policy_ == QueuePolicy::kRadixHeap) {
+      return radixheap_.pop();
+    }
+
     if (empty()) {
       // No labels found in the low-level buckets.
       if (overflowbucket_.empty()) {
@@ -174,6 +210,38 @@ public:
     return label;
   }
 
+  /**
+   * Returns the number of label indexes the low-level and overflow buckets
+   * can hold without allocating.
+   * @return  Returns the total capacity of the buckets.
+   */
+  size_t capacity() const {
+    size_t count = overflowbucket_.capacity() + radixheap_.capacity();
+    for (const auto& bucket : buckets_) {
+      count += bucket.capacity();
+    }
+    return count;
+  }
+
+  /**
+   * Returns the number of bytes held by the buckets.
+   * @return  Returns the memory used by the queue.
+   */
+  size_t memory_size() const {
+    return buckets_.capacity() * sizeof(bucket_t) + capacity() * sizeof(uint32_t);
+  }
+
+  /**
+   * Deallocates the memory of all buckets. The queue has to be emptied (call
+   * `clear`) before and set up again (call `reuse`) before it is used.
+   */
+  void shrink_to_fit() {
+    buckets_t().swap(buckets_);
+    bucket_t().swap(overflowbucket_);
+    currentbucket_ = buckets_.begin();
+    radixheap_.shrink_to_fit();
+  }
+
 private:
   float bucketrange_; // Total range of costs in lower level buckets
   float bucketsize_;  // Bucket size (range of costs in same bucket)
@@ -194,6 +262,10 @@ private:
   // Access to a container of labels to get cost given the label index.
   const std::vector<label_t>* labelcontainer_;
 
+  // Priority queue implementation in use and the radix heap used by kRadixHeap
+  QueuePolicy policy_;
+  RadixHeap<label_t> radixheap_;
+
   /**
    * Returns the bucket given the cost.
    * @param  cost  Cost.
@@ -0,0 +1,48 @@
+#ifndef VALHALLA_BALDR_EDGEREACH_H_
+#define VALHALLA_BALDR_EDGEREACH_H_
+
+#include <array>
+#include <cstdint>
+
+#include <valhalla/proto/options.pb.h>
+
+namespace valhalla {
+namespace baldr {
+
+// Number of mode classes reach is stored for. They are indexed the same way as the travel modes:
+// 0 is the default auto costing, 1 the default pedestrian and 2 the default bicycle costing.
+constexpr uint32_t kReachModeCount = 3;
+
+// Costings reach is stored for, indexed by their travel mode
+constexpr std::array<Costing::Type, kReachModeCount> kReachCostings = {Costing::auto_,
+                                                                       Costing::pedestrian,
+                                                                       Costing::bicycle};
+
+// Largest reach which fits into the edge reach section
+constexpr uint32_t kMaxStoredReach = 255;
+
+/**
+ * Leads the edge reach section of a tile.
+ */
+struct EdgeReachHeader {
+  // Maximum reach the reaches were computed up to. A stored reach equal to this
+  // means the edge reaches at least this many nodes.
+  uint8_t max_reach;
+  uint8_t spare[3];
+};
+
+/**
+ * Reach of a directed edge precomputed when building the tiles. For every mode
+ * class it holds how many nodes can be reached from the edge (outbound) and how
+ * many nodes can reach the edge (inbound), see loki::Reach. One record is stored
+ * per directed edge of the tile, in the same order as the directed edges.
+ */
+struct EdgeReach {
+  uint8_t outbound[kReachModeCount];
+  uint8_t inbound[kReachModeCount];
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_EDGEREACH_H_
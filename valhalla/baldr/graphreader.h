@@ -1,19 +1,25 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <valhalla/baldr/compressedextract.h>
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 #include <valhalla/baldr/tilegetter.h>
 #include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/baldr/trafficsnapshot.h>
 
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/pointll.h>
@@ -68,6 +74,17 @@ public:
    */
   virtual graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) = 0;
 
+  /**
+   * Replaces a cached tile with another one of the same data, e.g. with newer live traffic, if
+   * the cache still holds the expected one. The entry keeps its size.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  virtual graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) = 0;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -126,6 +143,16 @@ public:
    */
   graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
 
+  /**
+   * Replaces a cached tile if the cache still holds the expected one.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) override;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -209,6 +236,16 @@ public:
    */
   graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
 
+  /**
+   * Replaces a cached tile if the cache still holds the expected one.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) override;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -284,6 +321,16 @@ public:
    */
   graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t tile_size) override;
 
+  /**
+   * Replaces a cached tile if the cache still holds the expected one.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) override;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -352,6 +399,145 @@ protected:
   size_t max_cache_size_;
 };
 
+/**
+ * Tile cache split into independently locked shards keyed by tile id. Lookups only take a shared
+ * lock on a single shard and mark the entry as recently used with a relaxed atomic flag so that
+ * concurrent readers of resident tiles do not serialize on each other. Each shard accounts for its
+ * own share of the memory limit and evicts using the CLOCK approximation of LRU.
+ * Copies of the cache share the same underlying shards.
+ * It is thread-safe.
+ */
+class ShardedTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size     maximum size of the cache
+   * @param mem_control  strategy our cache will use to control its memory
+   * @param shard_count  number of shards, rounded up to a power of 2
+   */
+  ShardedTileCache(size_t max_size,
+                   TileCacheLRU::MemoryLimitControl mem_control,
+                   size_t shard_count);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache. If another thread already cached the same tile the
+   * existing one is kept and returned instead.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Replaces a cached tile if the cache still holds the expected one.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Does its best to reduce the cache size to remove overcommitted state.
+   *  Some implementations may simply clear the entire cache
+   */
+  void Trim() override;
+
+  /**
+   * @return the number of shards the cache is split into
+   */
+  size_t ShardCount() const {
+    return shards_->size();
+  }
+
+protected:
+  struct Entry {
+    Entry(graph_tile_ptr tile_, size_t size_) : tile(std::move(tile_)), size(size_), referenced(true) {
+    }
+    graph_tile_ptr tile;
+    size_t size;
+    // set on every access, cleared when the clock hand passes over the entry
+    mutable std::atomic<bool> referenced;
+  };
+
+  struct Shard {
+    // readers take it shared, anything touching the map or the ring takes it exclusive
+    mutable std::shared_timed_mutex mutex;
+    std::unordered_map<uint64_t, Entry> cache;
+    // ring of tile ids in insertion order that the clock hand sweeps over
+    std::list<uint64_t> clock;
+    std::list<uint64_t>::iterator hand = clock.end();
+    // the current size of this shard in bytes
+    size_t cache_size = 0;
+  };
+
+  /**
+   * @param graphid  the graphid of the tile
+   * @return the shard responsible for the given tile
+   */
+  Shard& GetShard(const GraphId& graphid) const {
+    // fibonacci hashing spreads neighbouring tile ids across the shards
+    return (*shards_)[((graphid.Tile_Base().value * 11400714819323198485ull) >> 32) & shard_mask_];
+  }
+
+  /**
+   * Evict entries of the shard until it can hold required_size more bytes within its budget.
+   * The shard must be exclusively locked by the caller.
+   *
+   * @param  shard           the shard to evict from
+   * @param  required_size   size in bytes that should be free in the shard
+   */
+  void TrimToFit(Shard& shard, size_t required_size);
+
+  // The shards, shared between copies of the cache
+  std::shared_ptr<std::vector<Shard>> shards_;
+
+  // Mask applied to the hashed tile id to get the shard index
+  uint64_t shard_mask_;
+
+  // Determines how we deal with the memory limit
+  TileCacheLRU::MemoryLimitControl mem_control_;
+
+  // The current cache size in bytes, summed over all shards
+  std::shared_ptr<std::atomic<size_t>> cache_size_;
+
+  // The max cache size in bytes for the whole cache and for each shard
+  size_t max_cache_size_;
+  size_t max_shard_size_;
+};
+
 /**
  * TileCache wrapper synchronized using external mutex.
  * It is thread-safe.
@@ -385,6 +571,16 @@ public:
    */
   graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
 
+  /**
+   * Replaces a cached tile if the cache still holds the expected one.
+   * @param graphid   the graphid of the tile
+   * @param expected  the tile the cache is expected to hold
+   * @param tile      the tile to hold instead
+   * @return the tile the cache holds afterwards, nullptr if it holds none
+   */
+  graph_tile_ptr
+  Replace(const GraphId& graphid, const graph_tile_ptr& expected, graph_tile_ptr tile) override;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -446,7 +642,7 @@ public:
                        std::unique_ptr<tile_getter_t>&& tile_getter = nullptr,
                        bool traffic_readonly = true);
 
-  virtual ~GraphReader() = default;
+  virtual ~GraphReader();
 
   virtual void SetInterrupt(const tile_getter_t::interrupt_t* interrupt) {
     if (tile_getter_) {
@@ -464,9 +660,30 @@ public:
    * Test if traffic tiles exist.   *
    */
   bool HasLiveTraffic() {
-    return !tile_extract_->traffic_tiles.empty();
+    return !tile_extract_->traffic_tiles.empty() || tile_extract_->traffic_snapshot;
   }
 
+  /**
+   * Pins the generation of the traffic snapshot the tiles are read with, so that a request does
+   * not mix the speeds of two generations. The first tile requested pins the generation which
+   * is current at that time if none is pinned yet.
+   * @return Returns the pinned generation, 0 without a traffic snapshot.
+   */
+  uint32_t PinTrafficSnapshot();
+
+  /**
+   * Pins the given generation of the traffic snapshot, e.g. the one another reader of the same
+   * request has pinned, in place of the one pinned so far.
+   * @param generation  the generation to read the tiles with
+   */
+  void PinTrafficSnapshot(const uint32_t generation);
+
+  /**
+   * Releases the pinned generation once a request is done, the next request pins the generation
+   * which is current then.
+   */
+  void UnpinTrafficSnapshot();
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -538,6 +755,46 @@ public:
     return cache_->OverCommitted();
   }
 
+  /**
+   * Running totals of the tile requests of this reader. They are atomic since a reader can be
+   * used from several threads, e.g. by the worker threads of a matrix.
+   */
+  struct tile_counters_t {
+    std::atomic<uint64_t> cache_hits{0};        // tiles found in the cache
+    std::atomic<uint64_t> cache_misses{0};      // tiles that had to be loaded (or not found)
+    std::atomic<uint64_t> prefetch_requests{0}; // tiles queued for loading in the background
+    std::atomic<uint64_t> prefetch_hits{0};     // misses served by a tile loaded in the background
+    std::atomic<uint64_t> prefetch_misses{0};   // misses loaded on the spot while prefetching
+  };
+
+  /**
+   * Returns how many of the tiles requested so far were found in the cache and how many
+   * were not
+   * @return the tile request counters
+   */
+  const tile_counters_t& tile_counters() const {
+    return tile_counters_;
+  }
+
+  /**
+   * Queues a tile to be loaded in the background, so that it is already loaded when it is
+   * first requested. Does nothing unless prefetch_threads is configured.
+   * @param  graphid  Graph id within the tile.
+   */
+  void Prefetch(const GraphId& graphid);
+
+  /**
+   * Queues the tiles a search is about to need while it expands in a tile: the tiles ahead
+   * of a position toward the target of the search, or all the neighbours of the tile if
+   * there is no target. Cheap enough to call every time a search enters another tile.
+   * @param  graphid  Graph id within the tile the search expands in.
+   * @param  ll       Position the search expands from.
+   * @param  target   Position the search heads for, invalid if there is none.
+   */
+  void Prefetch(const GraphId& graphid,
+                const midgard::PointLL& ll,
+                const midgard::PointLL& target = midgard::PointLL());
+
   /**
    * Convenience method to get an opposing directed edge.
    * @param  edgeid  Graph Id of the directed edge.
@@ -891,6 +1148,8 @@ public:
     static std::string empty_str;
     if (tile_extract_->tiles.empty())
       return empty_str;
+    if (tile_extract_->compressed)
+      return tile_extract_->compressed->file_name();
     return tile_extract_->archive->tar_file;
   }
 
@@ -941,14 +1200,18 @@ public:
   IncidentResult GetIncidents(const GraphId& edge_id, graph_tile_ptr& tile);
 
 protected:
-  // (Tar) extract of tiles - the contents are empty if not being used
+  // (Tar or compressed) extract of tiles - the contents are empty if not being used
   struct tile_extract_t {
     tile_extract_t(const boost::property_tree::ptree& pt, bool traffic_readonly = true);
     // TODO: dont remove constness, and actually make graphtile read only?
+    // For a compressed extract these are the compressed blocks of the tiles
     std::unordered_map<uint64_t, std::pair<char*, size_t>> tiles;
     std::unordered_map<uint64_t, std::pair<char*, size_t>> traffic_tiles;
     std::shared_ptr<midgard::tar> archive;
+    std::shared_ptr<CompressedExtract> compressed;
     std::shared_ptr<midgard::tar> traffic_archive;
+    // Double buffered live traffic, used instead of the traffic_tiles when configured
+    std::shared_ptr<TrafficSnapshot> traffic_snapshot;
     uint64_t checksum;
   };
   std::shared_ptr<const tile_extract_t> tile_extract_;
@@ -963,12 +1226,40 @@ protected:
   const size_t max_concurrent_users_;
   const std::string tile_url_;
 
+  // Number of decoded predicted speeds each tile keeps
+  const uint32_t speed_cache_size_;
+
   std::mutex _404s_lock;
   std::unordered_set<GraphId> _404s;
 
   std::unique_ptr<TileCache> cache_;
 
   bool enable_incidents_;
+
+  tile_counters_t tile_counters_;
+
+  // The generation of the traffic snapshot the tiles are read with, and the tiles given its
+  // traffic for this request only because the cache holds them with a newer generation
+  bool traffic_pinned_ = false;
+  uint32_t traffic_generation_ = 0;
+  std::unordered_map<GraphId, graph_tile_ptr> pinned_tiles_;
+
+  // Gets a tile with the traffic of the pinned generation, the cached one if it was read with it.
+  // Cached tiles older than the published generation are replaced in the cache
+  graph_tile_ptr GetPinnedTile(const GraphId& base, graph_tile_ptr tile);
+
+  // Loads a tile without the cache, from wherever the tiles are kept, with the live traffic of a
+  // generation of the traffic snapshot. Safe to call from the prefetch threads.
+  graph_tile_ptr
+  LoadGraphTile(const GraphId& base, size_t& size, const uint32_t traffic_generation = 0);
+
+  // Gets the live traffic of a tile, from the buffer of a generation if there is a snapshot
+  std::unique_ptr<const GraphMemory> LoadTrafficTile(const GraphId& base,
+                                                     const uint32_t traffic_generation) const;
+
+  // Background threads loading the queued tiles, null unless prefetch_threads is configured
+  struct tile_prefetcher_t;
+  std::unique_ptr<tile_prefetcher_t> prefetcher_;
 };
 
 // Given the Location relation, return the full metadata
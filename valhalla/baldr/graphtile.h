@@ -6,6 +6,7 @@
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/datetime.h>
 #include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/edgereach.h>
 #include <valhalla/baldr/edgeinfo.h>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/graphid.h>
@@ -59,11 +60,14 @@ public:
    * into memory.
    * @param  tile_dir   Tile directory.
    * @param  graphid    GraphId (tileid and level)
+   * @param  traffic_memory  Live traffic data of the tile (optional).
+   * @param  speed_cache_size  Number of decoded predicted speeds to cache, 0 for none.
    * @return nullptr if the tile could not be loaded. may throw
    */
   static graph_tile_ptr Create(const std::string& tile_dir,
                                const GraphId& graphid,
-                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr);
+                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr,
+                               const uint32_t speed_cache_size = 0);
 
   /**
    * Constructs with a given the graph Id, pointer to the tile data, and the
@@ -79,23 +83,27 @@ public:
    * @param  graphid  Tile Id.
    * @param  ptr      Pointer to the start of the tile's data.
    * @param  size     Size in bytes of the tile data.
+   * @param  speed_cache_size  Number of decoded predicted speeds to cache, 0 for none.
    */
   static graph_tile_ptr Create(const GraphId& graphid,
                                std::unique_ptr<const GraphMemory>&& memory,
-                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr);
+                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr,
+                               const uint32_t speed_cache_size = 0);
 
   /**
    * Constructs a tile given a url for the tile using curl
    * @param  tile_url URL of tile
    * @param  graphid Tile Id
    * @param  tile_getter object that will handle tile downloading
+   * @param  speed_cache_size  Number of decoded predicted speeds to cache, 0 for none.
    * @return whether or not the tile could be cached to disk
    */
 
   static graph_tile_ptr CacheTileURL(const std::string& tile_url,
                                      const GraphId& graphid,
                                      tile_getter_t* tile_getter,
-                                     const std::string& cache_location);
+                                     const std::string& cache_location,
+                                     const uint32_t speed_cache_size = 0);
 
   /**
    * Construct a tile given a url for the tile using curl
@@ -605,6 +613,30 @@ public:
    */
   std::vector<LaneConnectivity> GetLaneConnectivity(const uint32_t idx) const;
 
+  /**
+   * Get the reach precomputed for a directed edge.
+   * @param  idx  Index of the directed edge within the tile.
+   * @return  Returns the reach of the edge, nullptr if the tile has no edge reach data.
+   */
+  const EdgeReach* edge_reach(const uint32_t idx) const {
+    if (edge_reach_ == nullptr) {
+      return nullptr;
+    }
+    if (idx < header_->directededgecount()) {
+      return &edge_reach_[idx];
+    }
+    throw std::runtime_error("GraphTile EdgeReach index out of bounds");
+  }
+
+  /**
+   * Get the maximum reach the edge reach data was computed up to. Edges whose
+   * stored reach equals it may have a larger reach.
+   * @return  Returns the maximum stored reach, 0 if the tile has no edge reach data.
+   */
+  uint32_t max_edge_reach() const {
+    return edge_reach_header_ ? edge_reach_header_->max_reach : 0;
+  }
+
   /**
    * Convenience method for use with costing to get the speed for an edge given the directed
    * edge and a time (seconds since start of the week). If the current speed of the edge
@@ -783,6 +815,14 @@ public:
     return traffic_tile;
   }
 
+  /**
+   * Gets the memory holding the data of the tile.
+   * @return  Returns the memory of the tile.
+   */
+  const GraphMemory* memory() const {
+    return memory_.get();
+  }
+
 protected:
   // Graph tile memory. A Graph tile owns its memory.
   std::unique_ptr<const GraphMemory> memory_;
@@ -872,6 +912,10 @@ protected:
   // Predicted speeds
   PredictedSpeeds predictedspeeds_;
 
+  // Precomputed reach of the directed edges (nullptr if the tile has none)
+  EdgeReachHeader* edge_reach_header_{};
+  EdgeReach* edge_reach_{};
+
   // Map of stop one stops in this tile.
   std::unordered_map<std::string, GraphId> stop_one_stops;
 
@@ -901,10 +945,12 @@ protected:
    * @param  graphid  Tile Id.
    * @param  ptr      Pointer to the start of the tile's data.
    * @param  size     Size in bytes of the tile data.
+   * @param  speed_cache_size  Number of decoded predicted speeds to cache, 0 for none.
    */
   GraphTile(const GraphId& graphid,
             std::unique_ptr<const GraphMemory> memory,
-            std::unique_ptr<const GraphMemory> traffic_memory = nullptr);
+            std::unique_ptr<const GraphMemory> traffic_memory = nullptr,
+            const uint32_t speed_cache_size = 0);
 
   /**
    * Constructor given the graph Id, pointer to the tile data, and the
@@ -936,10 +982,13 @@ protected:
   /** Decrompresses tile bytes into the internal graphtile byte buffer
    * @param  graphid     the id of the tile to be decompressed
    * @param  compressed  the compressed bytes
+   * @param  speed_cache_size  Number of decoded predicted speeds to cache, 0 for none.
    * @return a pointer to a graphtile if it  has been successfully initialized with
    *         the uncompressed data, or nullptr
    */
-  static graph_tile_ptr DecompressTile(const GraphId& graphid, const std::vector<char>& compressed);
+  static graph_tile_ptr DecompressTile(const GraphId& graphid,
+                                       const std::vector<char>& compressed,
+                                       const uint32_t speed_cache_size = 0);
 };
 
 } // namespace baldr
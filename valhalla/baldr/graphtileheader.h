@@ -17,7 +17,7 @@ namespace baldr {
 // something to the tile simply subtract one from this number and add it
 // just before the empty_slots_ array below. NOTE that it can ONLY be an
 // offset in bytes and NOT a bitfield or union or anything of that sort
-constexpr size_t kEmptySlots = 11;
+constexpr size_t kEmptySlots = 10;
 
 // Maximum size of the version string (stored as a fixed size
 // character array so the GraphTileHeader size remains fixed).
@@ -573,6 +573,22 @@ public:
     predictedspeeds_offset_ = offset;
   }
 
+  /**
+   * Gets the offset to the edge reach data.
+   * @return  Returns the offset (bytes) to edge reach data, 0 if the tile has none.
+   */
+  uint32_t edge_reach_offset() const {
+    return edge_reach_offset_;
+  }
+
+  /**
+   * Sets the offset to the edge reach data within the tile.
+   * @param offset Offset to edge reach data within the tile, 0 if there is none.
+   */
+  void set_edge_reach_offset(const uint32_t offset) {
+    edge_reach_offset_ = offset;
+  }
+
   /**
    * Get the offset to the end of the tile
    * @return the number of bytes in the tile, unless the last slot is used
@@ -687,6 +703,9 @@ protected:
   // GraphTile data size in bytes
   uint32_t tile_size_;
 
+  // Offset to the beginning of the edge reach data (0 if the tile has none)
+  uint32_t edge_reach_offset_;
+
   // Marks the end of this version of the tile with the rest of the slots
   // being available for growth. If you want to use one of the empty slots,
   // simply add a uint32_t some_offset_; just above empty_slots_ and decrease
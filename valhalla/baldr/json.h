@@ -1,6 +1,7 @@
 #ifndef VALHALLA_BALDR_JSON_H_
 #define VALHALLA_BALDR_JSON_H_
 
+#include <algorithm>
 #include <boost/variant.hpp>
 #include <cctype>
 #include <cinttypes>
@@ -12,7 +13,9 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace valhalla {
@@ -55,13 +58,91 @@ using Value = boost::variant<std::string,
                              ArrayPtr,
                              RawJSON>;
 
-// the map value type in json
-class Jmap : public std::unordered_map<std::string, Value> {
+// the map value type in json, keys are written in the order they were first inserted so that the
+// output is the same from run to run and can be reproduced by a streaming writer. the keys are
+// also hashed so that wide objects do not make every insert a linear scan
+class Jmap {
 public:
-  // just specialize unordered_map
-  using std::unordered_map<std::string, Value>::unordered_map;
+  using key_type = std::string;
+  using mapped_type = Value;
+  using value_type = std::pair<std::string, Value>;
+  using iterator = std::vector<value_type>::iterator;
+  using const_iterator = std::vector<value_type>::const_iterator;
+
+  Jmap() = default;
+  Jmap(std::initializer_list<value_type> list) {
+    reserve(list.size());
+    for (const auto& key_value : list) {
+      emplace(key_value.first, key_value.second);
+    }
+  }
+
+  // like a map this keeps the existing value if the key is already there
+  template <class K, class V> std::pair<iterator, bool> emplace(K&& key, V&& value) {
+    std::string name(std::forward<K>(key));
+    auto indexed = index_.emplace(name, items_.size());
+    if (!indexed.second) {
+      return {items_.begin() + indexed.first->second, false};
+    }
+    items_.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(name)),
+                        std::forward_as_tuple(std::forward<V>(value)));
+    return {items_.end() - 1, true};
+  }
+
+  iterator find(const std::string& key) {
+    auto indexed = index_.find(key);
+    return indexed == index_.end() ? items_.end() : items_.begin() + indexed->second;
+  }
+
+  const_iterator find(const std::string& key) const {
+    auto indexed = index_.find(key);
+    return indexed == index_.end() ? items_.end() : items_.begin() + indexed->second;
+  }
+
+  size_t count(const std::string& key) const {
+    return index_.count(key);
+  }
+
+  Value& operator[](const std::string& key) {
+    return emplace(key, nullptr).first->second;
+  }
+
+  void reserve(size_t size) {
+    items_.reserve(size);
+    index_.reserve(size);
+  }
+
+  size_t size() const {
+    return items_.size();
+  }
+
+  bool empty() const {
+    return items_.empty();
+  }
+
+  iterator begin() {
+    return items_.begin();
+  }
+
+  iterator end() {
+    return items_.end();
+  }
+
+  const_iterator begin() const {
+    return items_.begin();
+  }
+
+  const_iterator end() const {
+    return items_.end();
+  }
+
   // and be able to spit out text
   friend std::ostream& operator<<(std::ostream&, const Jmap&);
+
+private:
+  // the members in the order they were inserted and where to find each of them by its key
+  std::vector<value_type> items_;
+  std::unordered_map<std::string, size_t> index_;
 };
 
 // the array value type in json
@@ -0,0 +1,162 @@
+#ifndef VALHALLA_BALDR_OVERLAYCELL_H_
+#define VALHALLA_BALDR_OVERLAYCELL_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace baldr {
+
+// File name suffix of the overlay cells
+const std::string SUFFIX_OVERLAY = ".ovl";
+
+// Number of levels of the overlay partition. The cells of level 1 are the tiles of the
+// local graph level, the cells of level 2 the arterial tiles and the cells of level 3 the
+// highway tiles, so every cell is made of the cells one level below it.
+constexpr uint32_t kOverlayLevels = 3;
+
+// Index of a directed edge which is not an entry or exit of a cell
+constexpr uint32_t kInvalidBoundary = 0xffffffff;
+
+/**
+ * Gets the cell of an overlay level a position is in. Cells are identified by the base
+ * graph id of the tile covering them, the overlay level is kOverlayLevels less the graph
+ * level of the tile. The cells of the upper levels are derived from the local tile so
+ * they always nest.
+ * @param  ll     Position, usually of a graph node.
+ * @param  level  Overlay level, from 1 to kOverlayLevels.
+ * @return Returns an invalid id if the position is outside of the tiling.
+ */
+GraphId OverlayCellId(const midgard::PointLL& ll, const uint32_t level);
+
+/**
+ * Gets the highest overlay level at which two positions are in different cells.
+ * @return Returns 0 if they are in the same cell at every level.
+ */
+uint32_t OverlayBoundaryLevel(const midgard::PointLL& a, const midgard::PointLL& b);
+
+/**
+ * Leads an overlay cell. An overlay cell lists the boundary edges of one cell of the
+ * multi-level partition built by mjolnir::OverlayBuilder: the directed edges entering the
+ * cell, which start at a node outside of it and end at a node inside, and the directed
+ * edges leaving it. The costs between them depend on the costing and are computed when a
+ * query needs them, see thor::OverlayCustomization.
+ */
+struct OverlayCellHeader {
+  uint64_t cellid;     // Base graph id of the tile covering the cell
+  uint64_t dataset_id; // Dataset id of the graph tiles it was built from
+  uint32_t entrycount; // Number of directed edges entering the cell
+  uint32_t exitcount;  // Number of directed edges leaving the cell
+};
+
+/**
+ * An overlay cell read from disk. The entries and exits are sorted graph ids.
+ */
+class OverlayCell {
+public:
+  /**
+   * Reads an overlay cell.
+   * @param  dir     Directory the overlay cells are stored in.
+   * @param  cellid  Cell to read.
+   * @return Returns nullptr if there is no valid overlay cell.
+   */
+  static std::shared_ptr<const OverlayCell> Create(const std::string& dir, const GraphId& cellid);
+
+  /**
+   * Creates an overlay cell from its raw bytes. Throws if the bytes do not hold a
+   * complete overlay cell.
+   * @param  data  Contents of an overlay cell file.
+   */
+  explicit OverlayCell(std::vector<char>&& data);
+
+  const OverlayCellHeader* header() const {
+    return header_;
+  }
+
+  uint32_t entry_count() const {
+    return header_->entrycount;
+  }
+
+  uint32_t exit_count() const {
+    return header_->exitcount;
+  }
+
+  GraphId entry(const uint32_t idx) const {
+    return GraphId(entries_[idx]);
+  }
+
+  GraphId exit(const uint32_t idx) const {
+    return GraphId(exits_[idx]);
+  }
+
+  /**
+   * Gets the index of a directed edge among the entries of the cell.
+   * @return Returns kInvalidBoundary if the edge does not enter the cell.
+   */
+  uint32_t EntryIndex(const GraphId& edgeid) const;
+
+  /**
+   * Gets the index of a directed edge among the exits of the cell.
+   * @return Returns kInvalidBoundary if the edge does not leave the cell.
+   */
+  uint32_t ExitIndex(const GraphId& edgeid) const;
+
+  /**
+   * Returns the number of bytes of the cell.
+   */
+  size_t size() const {
+    return data_.size();
+  }
+
+protected:
+  std::vector<char> data_;
+  const OverlayCellHeader* header_;
+  const uint64_t* entries_;
+  const uint64_t* exits_;
+};
+
+/**
+ * Reads and caches the overlay cells of a graph. Not thread safe, like the graph reader
+ * every thread needs its own.
+ */
+class OverlayReader {
+public:
+  /**
+   * @param  dir              Directory the overlay cells are stored in.
+   * @param  max_cache_size   Bytes of cells cached before the cache is cleared.
+   */
+  OverlayReader(const std::string& dir, const size_t max_cache_size);
+
+  /**
+   * Gets an overlay cell. Cells built from another dataset than the graph tiles of their
+   * boundary edges are not used.
+   * @param  cellid       Cell to get.
+   * @param  graphreader  Graph reader the graph tiles are read from.
+   * @return Returns nullptr if there is no usable overlay cell.
+   */
+  std::shared_ptr<const OverlayCell> GetCell(const GraphId& cellid, GraphReader& graphreader);
+
+  /**
+   * Clears the cache if it holds more than its maximum size. Cells still used by a
+   * query are kept alive by their shared pointers.
+   */
+  void Trim();
+
+protected:
+  std::string dir_;
+  size_t max_cache_size_;
+  size_t cache_size_;
+  std::unordered_map<uint64_t, std::shared_ptr<const OverlayCell>> cache_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_OVERLAYCELL_H_
@@ -1,7 +1,11 @@
 #ifndef VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 #define VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
 #include <valhalla/midgard/util.h>
 
 namespace valhalla {
@@ -33,6 +37,13 @@ std::array<int16_t, kCoefficientCount> compress_speed_buckets(const float* speed
  */
 float decompress_speed_bucket(const int16_t* coefficients, uint32_t bucket_idx);
 
+/**
+ * Recover the speed values of all the buckets of the week (apply DCT-III transform)
+ * @param coefficients  Transformed speed buckets (must be 200 values).
+ * @param speeds        Speed values (in KPH) for each bucket (must hold 2016 values).
+ */
+void decompress_speed_buckets(const int16_t* coefficients, float* speeds);
+
 /**
  * Pack transformed speed values into base64-encoded string.
  * @param coefficients  Array of transformed speed buckets (must be 200 values).
@@ -55,7 +66,26 @@ public:
   /**
    * Constructor.
    */
-  PredictedSpeeds() : offset_(nullptr), profiles_(nullptr) {
+  PredictedSpeeds() : offset_(nullptr), profiles_(nullptr), cache_bits_(0), cache_(nullptr) {
+  }
+
+  PredictedSpeeds(PredictedSpeeds&& other) noexcept
+      : offset_(other.offset_), profiles_(other.profiles_), cache_bits_(other.cache_bits_),
+        cache_(other.cache_.exchange(nullptr)) {
+  }
+
+  PredictedSpeeds& operator=(PredictedSpeeds&& other) noexcept {
+    if (this != &other) {
+      offset_ = other.offset_;
+      profiles_ = other.profiles_;
+      cache_bits_ = other.cache_bits_;
+      delete[] cache_.exchange(other.cache_.exchange(nullptr));
+    }
+    return *this;
+  }
+
+  ~PredictedSpeeds() {
+    delete[] cache_.load(std::memory_order_relaxed);
   }
 
   /**
@@ -75,6 +105,29 @@ public:
     profiles_ = profiles;
   }
 
+  /**
+   * Keep the most recently decoded speeds in a cache so that the edges and buckets used
+   * over and over (e.g. by every time dependent request around rush hour) are only decoded
+   * once. The cache is direct mapped and lock free so all the threads sharing the tile can
+   * use it, colliding entries simply replace each other. It is only allocated once the first
+   * speed is asked for, so tiles that never serve time dependent requests don't pay for it.
+   * @param  entries        Most cached speeds (rounded up to a power of 2), 0 disables it.
+   * @param  profile_count  Number of speed profiles in the tile. A tile with few of them gets
+   *                        a cache of about that many entries.
+   */
+  void set_cache_size(const uint32_t entries, const uint32_t profile_count = ~0u) {
+    delete[] cache_.exchange(nullptr);
+    const uint32_t size = std::min(entries, profile_count);
+    if (size == 0) {
+      cache_bits_ = 0;
+      return;
+    }
+    cache_bits_ = 1;
+    while (cache_bits_ < 31 && (1u << cache_bits_) < size) {
+      ++cache_bits_;
+    }
+  }
+
   /**
    * Get the speed given the edge Id and the seconds of the week.
    * @param  idx  Directed edge index.
@@ -86,14 +139,59 @@ public:
     // offset is valid. If there is no predicted speed profile this method will not be called due
     // to DirectedEdge::has_predicted_speed being false.
     const int16_t* coefficients = profiles_ + offset_[idx];
-
-    return decompress_speed_bucket(coefficients, seconds_of_week / kSpeedBucketSizeSeconds);
+    const uint32_t bucket = seconds_of_week / kSpeedBucketSizeSeconds;
+    if (cache_bits_ == 0) {
+      return decompress_speed_bucket(coefficients, bucket);
+    }
+    std::atomic<uint64_t>* cache = cache_.load(std::memory_order_acquire);
+    if (cache == nullptr) {
+      cache = allocate_cache();
+    }
+
+    // The edge index (21 bits) and the bucket (11 bits) make up the key of a cache entry
+    // and the bits of the speed its value, so an entry is read and written in one go
+    const uint32_t key = (idx << 11) | bucket;
+    std::atomic<uint64_t>& slot = cache[(key * 0x9E3779B1u) >> (32 - cache_bits_)];
+    uint64_t entry = slot.load(std::memory_order_relaxed);
+    uint32_t value;
+    float speed;
+    if (static_cast<uint32_t>(entry >> 32) == key) {
+      value = static_cast<uint32_t>(entry);
+      std::memcpy(&speed, &value, sizeof(speed));
+      return speed;
+    }
+
+    speed = decompress_speed_bucket(coefficients, bucket);
+    std::memcpy(&value, &speed, sizeof(speed));
+    slot.store((static_cast<uint64_t>(key) << 32) | value, std::memory_order_relaxed);
+    return speed;
   }
 
 protected:
+  // Key of an empty cache entry, buckets only go up to kBucketsPerWeek - 1
+  static constexpr uint64_t kEmptyEntry = ~0ull;
+
+  // Allocates the cache on first use. Threads racing to do so keep the first one published.
+  std::atomic<uint64_t>* allocate_cache() const {
+    const uint32_t size = 1u << cache_bits_;
+    auto* cache = new std::atomic<uint64_t>[size];
+    for (uint32_t i = 0; i < size; ++i) {
+      cache[i].store(kEmptyEntry, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t>* expected = nullptr;
+    if (!cache_.compare_exchange_strong(expected, cache, std::memory_order_acq_rel)) {
+      delete[] cache;
+      return expected;
+    }
+    return cache;
+  }
+
   const uint32_t* offset_;  // Offset into the array of compressed speed profiles
                             // for each directed edge
   const int16_t* profiles_; // Compressed speed profiles
+
+  uint32_t cache_bits_; // Log2 of the number of cached speeds, 0 without a cache
+  mutable std::atomic<std::atomic<uint64_t>*> cache_; // Decoded speeds (optional)
 };
 
 } // namespace baldr
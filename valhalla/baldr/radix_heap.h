@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <valhalla/baldr/graphconstants.h>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Radix Heap - a monotone priority queue. Label indexes are kept in buckets
+ * based on the highest bit in which the key of their cost differs from the key
+ * of the last cost popped. Popping only scans and redistributes the first
+ * non-empty bucket so it needs no cost range to be tuned, and costs far above
+ * the current one never have to be moved more than 32 times.
+ *
+ * The key of a cost is the cost divided by the bucket size, so like in the
+ * double bucket queue costs within the same bucket size come out in no
+ * particular order. A cost lower than the last one popped is placed in the
+ * current bucket so it comes out next. Keys are stored next to the label
+ * indexes so moving labels between buckets does not touch the labels, and the
+ * position of every label within its bucket is kept so decreasing its cost
+ * does not have to search the bucket.
+ */
+template <typename label_t> class RadixHeap final {
+public:
+  /**
+   * Default c-tor creates empty object that needs to be initialized with `reuse` method
+   */
+  RadixHeap() : last_(0), inv_(1.f), labelcontainer_(nullptr) {
+  }
+
+  RadixHeap(RadixHeap&&) = default;
+  RadixHeap& operator=(RadixHeap&&) = default;
+  RadixHeap(const RadixHeap&) = delete;
+  RadixHeap& operator=(const RadixHeap&) = delete;
+
+  /**
+   * Sets the label container the heap gets costs from. Before calling this
+   * method the heap has to be emptied (call `clear`).
+   * @param bucketsize      Range of costs within the same key. Must be greater than 0.
+   * @param labelcontainer  Container of labels with sortcosts.
+   */
+  void reuse(const float bucketsize, const std::vector<label_t>* labelcontainer) {
+    labelcontainer_ = labelcontainer;
+    inv_ = 1.f / bucketsize;
+    last_ = 0;
+  }
+
+  /**
+   * Clear all labels from the buckets. The memory of the buckets is kept.
+   */
+  void clear() {
+    for (auto& bucket : buckets_) {
+      bucket.clear();
+    }
+    last_ = 0;
+  }
+
+  /**
+   * Adds a label index to the heap.
+   * @param   label  Label index to add to the heap.
+   */
+  void add(const uint32_t label) {
+    const uint32_t k = key((*labelcontainer_)[label].sortcost());
+    push(index(k), {k, label});
+  }
+
+  /**
+   * The specified label index now has a smaller cost. Moves it to the bucket of
+   * the new cost. Has to be called before the cost of the label is changed.
+   * @param  label        Label index to reorder.
+   * @param  newcost      New sort cost.
+   */
+  void decrease(const uint32_t label, const float newcost) {
+    const uint32_t newkey = key(newcost);
+    const uint32_t previndex = index(key((*labelcontainer_)[label].sortcost()));
+    const uint32_t newindex = index(newkey);
+    if (previndex != newindex) {
+      remove(previndex, positions_[label]);
+      push(newindex, {newkey, label});
+    } else {
+      // Keep the key up to date since it is used when the bucket is redistributed
+      buckets_[previndex][positions_[label]].key = newkey;
+    }
+  }
+
+  /**
+   * Removes the lowest cost label index from the heap.
+   * @return  Returns the label index of the lowest cost label. Returns
+   *          kInvalidLabel if the heap is empty.
+   */
+  uint32_t pop() {
+    if (buckets_[0].empty()) {
+      // Find the first non-empty bucket
+      auto bucket = std::find_if(buckets_.begin() + 1, buckets_.end(),
+                                 [](const bucket_t& b) { return !b.empty(); });
+      if (bucket == buckets_.end()) {
+        return baldr::kInvalidLabel;
+      }
+
+      // Its lowest key becomes the last key, which moves all its labels to
+      // lower buckets and at least one of them to the current bucket
+      last_ = std::numeric_limits<uint32_t>::max();
+      for (const auto& e : *bucket) {
+        last_ = std::min(last_, e.key);
+      }
+      for (const auto& e : *bucket) {
+        push(index(e.key), e);
+      }
+      bucket->clear();
+    }
+
+    // Return label from the current bucket
+    const uint32_t label = buckets_[0].back().label;
+    buckets_[0].pop_back();
+    return label;
+  }
+
+  /**
+   * Returns the number of label indexes the buckets can hold without allocating.
+   * Every label index takes two 32 bit words, its key and the index, and one
+   * more for its position.
+   * @return  Returns the total capacity of the buckets.
+   */
+  size_t capacity() const {
+    size_t count = positions_.capacity();
+    for (const auto& bucket : buckets_) {
+      count += bucket.capacity() * 2;
+    }
+    return count;
+  }
+
+  /**
+   * Deallocates the memory of all buckets. The heap has to be emptied (call
+   * `clear`) before.
+   */
+  void shrink_to_fit() {
+    for (auto& bucket : buckets_) {
+      bucket_t().swap(bucket);
+    }
+    std::vector<uint32_t>().swap(positions_);
+  }
+
+private:
+  // One bucket for the last key and one for every bit in which a key can differ from it
+  static constexpr size_t kBucketCount = 33;
+  // Keys at or above this are clamped to the largest key
+  static constexpr float kMaxKey = 4294967040.f;
+
+  // A label index and the key of its cost
+  struct entry_t {
+    uint32_t key;
+    uint32_t label;
+  };
+  using bucket_t = std::vector<entry_t>;
+
+  // Key of the last cost popped
+  uint32_t last_;
+
+  // 1 / bucket size
+  float inv_;
+
+  // Bucket i > 0 holds the labels whose key first differs from last_ at bit i - 1
+  std::array<bucket_t, kBucketCount> buckets_;
+
+  // Position of every label index within its bucket
+  std::vector<uint32_t> positions_;
+
+  // Access to a container of labels to get cost given the label index.
+  const std::vector<label_t>* labelcontainer_;
+
+  /**
+   * Appends a label index to a bucket and remembers where it is.
+   * @param  i  Index of the bucket.
+   * @param  e  Label index and the key of its cost.
+   */
+  void push(const uint32_t i, const entry_t& e) {
+    if (e.label >= positions_.size()) {
+      positions_.resize(e.label + 1);
+    }
+    positions_[e.label] = static_cast<uint32_t>(buckets_[i].size());
+    buckets_[i].push_back(e);
+  }
+
+  /**
+   * Removes a label index from a bucket by moving the last one into its place.
+   * @param  i    Index of the bucket.
+   * @param  pos  Position of the label index within the bucket.
+   */
+  void remove(const uint32_t i, const uint32_t pos) {
+    auto& bucket = buckets_[i];
+    bucket[pos] = bucket.back();
+    positions_[bucket[pos].label] = pos;
+    bucket.pop_back();
+  }
+
+  /**
+   * Returns the key of a cost. Negative costs map to 0 and costs too large for
+   * a key to the largest key.
+   * @param  cost  Cost.
+   * @return Returns the number of bucket sizes within the cost.
+   */
+  uint32_t key(const float cost) const {
+    const float k = cost * inv_;
+    if (!(k > 0.f)) {
+      return 0;
+    }
+    return k < kMaxKey ? static_cast<uint32_t>(k) : std::numeric_limits<uint32_t>::max();
+  }
+
+  /**
+   * Returns the index of the bucket of a key.
+   * @param  k  Key of a cost.
+   * @return Returns 0 if the key is not above the last key, otherwise 1 + the
+   *         highest bit in which the key differs from the last key.
+   */
+  uint32_t index(const uint32_t k) const {
+    if (k <= last_) {
+      return 0;
+    }
+    uint32_t diff = k ^ last_;
+    uint32_t n = 1;
+    for (uint32_t shift = 16; shift > 0; shift >>= 1) {
+      if (diff >> shift) {
+        diff >>= shift;
+        n += shift;
+      }
+    }
+    return n;
+  }
+};
+
+} // namespace baldr
+} // namespace valhalla
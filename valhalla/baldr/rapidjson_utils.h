@@ -1,6 +1,11 @@
 #ifndef VALHALLA_BALDR_RAPIDJSON_UTILS_H_
 #define VALHALLA_BALDR_RAPIDJSON_UTILS_H_
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <istream>
 #include <locale>
@@ -282,19 +287,46 @@ class writer_wrapper_t {
 protected:
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<decltype(buffer)> writer;
+  bool dom_escaping_;
+  std::string escaped_;
 
 public:
-  writer_wrapper_t(size_t reservation = 0) : buffer(), writer(buffer) {
+  /**
+   * Constructor.
+   * @param reservation   initial size of the output buffer in bytes
+   * @param dom_escaping  escape strings exactly like baldr::json does, see set_dom_escaping
+   */
+  writer_wrapper_t(size_t reservation = 0, bool dom_escaping = false)
+      : buffer(), writer(buffer), dom_escaping_(dom_escaping) {
     if (reservation != 0)
       buffer.Reserve(reservation);
   }
 
+  /**
+   * Rapidjson escapes strings a little differently than the baldr::json DOM, which also escapes
+   * '/' and DEL. Serializers that replaced a json DOM turn this on so their output stays byte
+   * for byte the same.
+   * @param dom_escaping  whether to escape strings like baldr::json
+   */
+  inline void set_dom_escaping(bool dom_escaping) {
+    dom_escaping_ = dom_escaping;
+  }
+
+  inline bool dom_escaping() const {
+    return dom_escaping_;
+  }
+
   inline void start_object() {
     writer.StartObject();
   }
 
   inline void start_object(const char* name) {
-    writer.String(name);
+    string(name);
+    writer.StartObject();
+  }
+
+  inline void start_object(const std::string& name) {
+    string(name);
     writer.StartObject();
   }
 
@@ -303,7 +335,12 @@ public:
   }
 
   inline void start_array(const char* name) {
-    writer.String(name);
+    string(name);
+    writer.StartArray();
+  }
+
+  inline void start_array(const std::string& name) {
+    string(name);
     writer.StartArray();
   }
 
@@ -319,86 +356,137 @@ public:
     return buffer.GetString();
   }
 
+  inline size_t get_length() const {
+    return buffer.GetSize();
+  }
+
+  /**
+   * Forgets the document written so far so that the writer and its buffer can be reused for the
+   * next one without allocating again. A buffer that grew beyond max_capacity is released rather
+   * than kept around by long lived (e.g. thread local) writers.
+   * @param max_capacity  largest buffer size in bytes worth keeping for the next document
+   */
+  inline void clear(size_t max_capacity = 1 << 20) {
+    const bool shrink = buffer.GetSize() > max_capacity;
+    buffer.Clear();
+    if (shrink)
+      buffer.ShrinkToFit();
+    writer.Reset(buffer);
+    // a precision set for the previous document must not truncate numbers in the next one
+    writer.SetMaxDecimalPlaces(decltype(writer)::kDefaultMaxDecimalPlaces);
+  }
+
   inline void set_precision(int precision) {
     writer.SetMaxDecimalPlaces(precision);
   }
 
   inline void operator()(const char* key, const char* value) {
-    writer.String(key);
-    writer.String(value);
+    string(key);
+    string(value);
   }
 
   inline void operator()(const char* key, const std::string& value) {
-    writer.String(key);
-    writer.String(value);
+    string(key);
+    string(value);
   }
 
   inline void operator()(const char* key, const double value) {
-    writer.String(key);
+    string(key);
     writer.Double(value);
   }
 
   inline void operator()(const char* key, const uint64_t value) {
-    writer.String(key);
+    string(key);
     writer.Uint64(value);
   }
 
   inline void operator()(const char* key, const int64_t value) {
-    writer.String(key);
+    string(key);
     writer.Int64(value);
   }
 
   inline void operator()(const char* key, const bool value) {
-    writer.String(key);
+    string(key);
     writer.Bool(value);
   }
 
   inline void operator()(const char* key, const std::nullptr_t) {
-    writer.String(key);
+    string(key);
     writer.Null();
   }
 
   inline void operator()(const std::string& key, const char* value) {
-    writer.String(key);
-    writer.String(value);
+    string(key);
+    string(value);
   }
 
   inline void operator()(const std::string& key, const std::string& value) {
-    writer.String(key);
-    writer.String(value);
+    string(key);
+    string(value);
   }
 
   inline void operator()(const std::string& key, const double value) {
-    writer.String(key);
+    string(key);
     writer.Double(value);
   }
 
   inline void operator()(const std::string& key, const uint64_t value) {
-    writer.String(key);
+    string(key);
     writer.Uint64(value);
   }
 
   inline void operator()(const std::string& key, const int64_t value) {
-    writer.String(key);
+    string(key);
     writer.Int64(value);
   }
 
   inline void operator()(const std::string& key, const bool value) {
-    writer.String(key);
+    string(key);
     writer.Bool(value);
   }
 
   inline void operator()(const std::string& key, const std::nullptr_t) {
-    writer.String(key);
+    string(key);
     writer.Null();
   }
 
+  /**
+   * Writes a number with exactly precision decimal places, rounded rather than truncated like
+   * set_precision does. The text is the same as that of baldr::json::fixed_t, non finite values
+   * are written as strings.
+   */
+  inline void fixed(const double value, const int precision) {
+    format("%.*f", value, precision);
+  }
+
+  inline void fixed(const char* key, const double value, const int precision) {
+    string(key);
+    format("%.*f", value, precision);
+  }
+
+  inline void fixed(const std::string& key, const double value, const int precision) {
+    string(key);
+    format("%.*f", value, precision);
+  }
+
+  /**
+   * Writes a number with 6 significant digits, the same text as that of baldr::json::float_t
+   */
+  inline void significant(const double value) {
+    format("%.*g", value, 6);
+  }
+
+  inline void significant(const char* key, const double value) {
+    string(key);
+    format("%.*g", value, 6);
+  }
+
   inline void operator()(const char* value) {
-    writer.String(value);
+    string(value);
   }
 
   inline void operator()(const std::string& value) {
-    writer.String(value);
+    string(value);
   }
 
   inline void operator()(const double value) {
@@ -421,6 +509,88 @@ public:
   inline void operator()(const std::nullptr_t) {
     writer.Null();
   }
+
+protected:
+  inline void string(const char* value) {
+    string(value, std::strlen(value));
+  }
+
+  inline void string(const std::string& value) {
+    string(value.data(), value.size());
+  }
+
+  // writes a string value or key, only strings needing the extra escapes are escaped by hand
+  inline void string(const char* value, size_t length) {
+    const char* end = value + length;
+    if (!dom_escaping_ ||
+        std::find_if(value, end, [](char c) { return c == '/' || c == 0x7f; }) == end) {
+      writer.String(value, length);
+      return;
+    }
+
+    // same escapes as baldr::json::OstreamVisitor
+    static const char hex[] = "0123456789ABCDEF";
+    escaped_.clear();
+    escaped_.push_back('"');
+    for (const char* c = value; c != end; ++c) {
+      switch (*c) {
+        case '\\':
+          escaped_.append("\\\\");
+          break;
+        case '"':
+          escaped_.append("\\\"");
+          break;
+        case '/':
+          escaped_.append("\\/");
+          break;
+        case '\b':
+          escaped_.append("\\b");
+          break;
+        case '\f':
+          escaped_.append("\\f");
+          break;
+        case '\n':
+          escaped_.append("\\n");
+          break;
+        case '\r':
+          escaped_.append("\\r");
+          break;
+        case '\t':
+          escaped_.append("\\t");
+          break;
+        default:
+          if (std::iscntrl(static_cast<unsigned char>(*c))) {
+            escaped_.append("\\u00");
+            escaped_.push_back(hex[static_cast<unsigned char>(*c) >> 4]);
+            escaped_.push_back(hex[static_cast<unsigned char>(*c) & 0xf]);
+          } else {
+            escaped_.push_back(*c);
+          }
+          break;
+      }
+    }
+    escaped_.push_back('"');
+    writer.RawValue(escaped_.data(), escaped_.size(), rapidjson::kStringType);
+  }
+
+  // formats a double with printf, which is what iostreams do under the hood
+  inline void format(const char* fmt, const double value, const int precision) {
+    char text[64];
+    int length = std::snprintf(text, sizeof(text), fmt, precision, value);
+    if (length < 0)
+      throw std::runtime_error("Could not format number");
+    std::string large;
+    const char* begin = text;
+    if (static_cast<size_t>(length) >= sizeof(text)) {
+      large.resize(length + 1);
+      std::snprintf(&large[0], large.size(), fmt, precision, value);
+      begin = large.data();
+    }
+    if (std::isfinite(value))
+      writer.RawValue(begin, length, rapidjson::kNumberType);
+    else
+      string(begin, length);
+  }
 };
 
 } // namespace rapidjson
@@ -0,0 +1,129 @@
+#ifndef VALHALLA_BALDR_TRAFFICSNAPSHOT_H_
+#define VALHALLA_BALDR_TRAFFICSNAPSHOT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/traffictile.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+// Marks the beginning of the control file of a traffic snapshot
+constexpr char kTrafficSnapshotMagic[8] = {'V', 'A', 'L', 'H', 'T', 'R', 'F', '\0'};
+constexpr uint32_t kTrafficSnapshotVersion = 1;
+
+/**
+ * Control file of a traffic snapshot. The speeds are kept in two traffic extracts next to it,
+ * named after it with the suffixes .0 and .1, and the generation tells which of them is active:
+ * the buffer of a generation is generation & 1. Generation 0 is never published.
+ */
+struct traffic_snapshot_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t generation; // only accessed atomically, it is swapped while the services run
+  uint64_t published;  // seconds since epoch the generation was published
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "The generation is accessed atomically in place");
+
+/**
+ * Double buffered live traffic. The speeds of the next generation are written into the idle
+ * buffer while the services read the active one, then the generation is swapped in one atomic
+ * store. A request which keeps reading the generation it started with never sees speeds of two
+ * generations, as long as it does not outlast the time the buffer it reads stays idle.
+ */
+class TrafficSnapshot {
+public:
+  // A memory mapped traffic extract and where its tiles are
+  struct buffer_t {
+    std::shared_ptr<midgard::tar> archive;
+    std::unordered_map<uint64_t, std::pair<char*, size_t>> tiles;
+  };
+
+  /**
+   * Maps the control file and both buffers of a snapshot.
+   * @param  file_name  Path to the control file.
+   * @param  readonly   Whether the buffers are mapped read only.
+   * Throws if the control file or one of the buffers cannot be loaded.
+   */
+  explicit TrafficSnapshot(const std::string& file_name, bool readonly = true);
+
+  /**
+   * Creates a snapshot out of a traffic extract, which is copied into both buffers. The
+   * speeds of the extract are published as generation 1.
+   * @param  traffic_extract  Path to the traffic extract.
+   * @param  file_name        Path of the control file to write.
+   */
+  static void Create(const std::string& traffic_extract, const std::string& file_name);
+
+  /**
+   * Gets the path of the buffer holding the speeds of a generation.
+   */
+  static std::string BufferName(const std::string& file_name, const uint32_t generation) {
+    return file_name + "." + std::to_string(generation & 1);
+  }
+
+  /**
+   * Gets the generation which is currently published.
+   */
+  uint32_t generation() const {
+    return generation_->load(std::memory_order_acquire);
+  }
+
+  /**
+   * Gets the seconds since epoch the current generation was published.
+   */
+  uint64_t published() const {
+    return header_->published;
+  }
+
+  /**
+   * Gets the buffer holding the speeds of a generation.
+   */
+  const buffer_t& buffer(const uint32_t generation) const {
+    return buffers_[generation & 1];
+  }
+
+  /**
+   * Fills the idle buffer with the speeds of the published generation and stamps its tiles
+   * with the next generation, which readers do not see until it is published.
+   * @param  reset  Clears the speeds rather than copying them.
+   * @return Returns the next generation.
+   */
+  uint32_t Prepare(const bool reset = false);
+
+  /**
+   * Gets the speed of an edge in the buffer of a generation, so that it can be written.
+   * @return Returns nullptr if the buffer has no speed for the edge.
+   */
+  TrafficSpeed* speed(const uint32_t generation, const GraphId& edge_id) const;
+
+  /**
+   * Publishes a generation prepared before, the requests which start afterward read it.
+   */
+  void Publish(const uint32_t generation);
+
+  const std::string& file_name() const {
+    return file_name_;
+  }
+
+protected:
+  std::string file_name_;
+  midgard::mem_map<char> memmap_;
+  traffic_snapshot_header_t* header_;
+  std::atomic<uint32_t>* generation_;
+  buffer_t buffers_[2];
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TRAFFICSNAPSHOT_H_
@@ -187,7 +187,7 @@ struct TrafficTileHeader {
   uint64_t last_update; // seconds since epoch
   uint32_t directed_edge_count;
   uint32_t traffic_tile_version;
-  uint32_t spare2;
+  uint32_t generation; // generation of the traffic snapshot, 0 outside of a snapshot
   uint32_t spare3;
 };
 
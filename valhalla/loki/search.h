@@ -8,11 +8,90 @@
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/sif/dynamiccost.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
 
 namespace valhalla {
 namespace loki {
 
+/**
+ * Threads which share the work of a search for many locations. The calling thread takes part
+ * and reads the tiles through the reader of the search, the others through readers of their own
+ * since GraphReader is not thread-safe. Those readers share the process wide sharded tile cache
+ * so the threads do not multiply the memory of the cache, a warning is logged if the mjolnir
+ * config asks for another one.
+ */
+class SearchWorkers {
+public:
+  // the index of the step, the reader of the thread running it and the index of the thread
+  using step_t = std::function<void(const uint32_t, baldr::GraphReader&, const size_t)>;
+
+  /**
+   * @param config       the mjolnir config the readers of the threads are made from
+   * @param concurrency  the number of threads, including the calling one
+   */
+  SearchWorkers(const boost::property_tree::ptree& config, const uint32_t concurrency);
+  ~SearchWorkers();
+
+  SearchWorkers(const SearchWorkers&) = delete;
+  SearchWorkers& operator=(const SearchWorkers&) = delete;
+
+  /**
+   * Gets the number of threads, including the calling one.
+   */
+  size_t size() const {
+    return threads_.size() + 1;
+  }
+
+  /**
+   * Runs step for every index in [0, count) and returns once they are all done. The readers of
+   * the threads are pinned to the traffic generation of the reader of the calling thread. The
+   * first exception thrown by a step is rethrown.
+   * @param count   the number of steps
+   * @param reader  the reader of the calling thread
+   * @param step    the step to run
+   */
+  void Run(const uint32_t count, baldr::GraphReader& reader, const step_t& step);
+
+  /**
+   * Passes the interrupt of the request on to the readers of the threads.
+   */
+  void SetInterrupt(const baldr::tile_getter_t::interrupt_t* interrupt);
+
+  /**
+   * Unpins the traffic generation of the readers of the threads once the request is done and
+   * trims their caches if they hold too much.
+   */
+  void Cleanup();
+
+private:
+  void Loop(const size_t id);
+  void Work(const size_t id);
+
+  std::vector<std::unique_ptr<baldr::GraphReader>> readers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable done_;
+  const step_t* step_ = nullptr;
+  baldr::GraphReader* reader_ = nullptr;
+  uint32_t count_ = 0;
+  std::atomic<uint32_t> next_{0};
+  uint64_t pass_ = 0;
+  size_t running_ = 0;
+  bool shutdown_ = false;
+  std::exception_ptr error_;
+};
+
 /**
  * Find an location within the route network given an input location
  * same tiled route data and a search strategy
@@ -22,13 +101,20 @@ namespace loki {
  * proper cache
  * @param costing        a costing object by which we can determine which portions of the graph are
  *                       accessable and therefor potential candidates
+ * @param use_edge_reach whether the edge reach stored in the tiles may be used instead of
+ *                       expanding the graph. Only valid if the costing has the default options of
+ *                       its mode, which the stored reach was computed with
+ * @param workers        threads to share the projections of large bins and the correlation of
+ *                       the locations with, the results are the same as without them
  * @return pathLocations the correlated data with in the tile that matches the inputs. If a
  * projection is not found, it will not have any entry in the returned value.
  */
 std::unordered_map<baldr::Location, baldr::PathLocation>
 Search(const std::vector<baldr::Location>& locations,
        baldr::GraphReader& reader,
-       const std::shared_ptr<sif::DynamicCost>& costing);
+       const std::shared_ptr<sif::DynamicCost>& costing,
+       const bool use_edge_reach = false,
+       SearchWorkers* workers = nullptr);
 
 } // namespace loki
 } // namespace valhalla
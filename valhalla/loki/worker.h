@@ -11,6 +11,7 @@
 #include <valhalla/baldr/location.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/baldr/rapidjson_utils.h>
+#include <valhalla/loki/search.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/proto/options.pb.h>
 #include <valhalla/sif/costfactory.h>
@@ -54,6 +55,8 @@ protected:
   void parse_trace(Api& request);
   void parse_costing(Api& request, bool allow_none = false);
   void locations_from_shape(Api& request);
+  std::unordered_map<baldr::Location, baldr::PathLocation>
+  search(Api& request, const std::vector<baldr::Location>& locations);
 
   void init_locate(Api& request);
   void init_route(Api& request);
@@ -68,6 +71,8 @@ protected:
   sif::cost_ptr_t costing;
   std::shared_ptr<baldr::GraphReader> reader;
   std::shared_ptr<baldr::connectivity_map_t> connectivity_map;
+  // Threads sharing the searches for many locations when search_concurrency is more than 1
+  std::unique_ptr<SearchWorkers> search_workers;
   std::unordered_set<Options::Action> actions;
   std::string action_str;
   std::unordered_map<std::string, size_t> max_locations;
@@ -79,6 +84,10 @@ protected:
   float max_exclude_polygons_length;
   unsigned int max_reachability;
   unsigned int default_reachability;
+  // Whether the edge reach stored in the tiles may be used and whether the costing of the
+  // current request has the default options it was computed with
+  bool use_edge_reach;
+  bool edge_reach_usable;
   unsigned int max_radius;
   unsigned int default_radius;
   unsigned int default_heading_tolerance;
@@ -108,6 +117,10 @@ private:
   std::string service_name() const override {
     return "loki";
   }
+  std::vector<std::pair<std::string, uint64_t>> counters() const override {
+    return {{"tile_cache_hits", reader->tile_counters().cache_hits.load()},
+            {"tile_cache_misses", reader->tile_counters().cache_misses.load()}};
+  }
 };
 } // namespace loki
 } // namespace valhalla
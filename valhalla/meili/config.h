@@ -66,10 +66,19 @@ struct Config {
     void Read(const boost::property_tree::ptree& params);
   };
 
+  struct Streaming {
+    // number of measurements matched at once when a trace is matched in a sliding window; 0
+    // matches the whole trace at once
+    size_t window = 0;
+
+    void Read(const boost::property_tree::ptree& params);
+  };
+
   CandidateSearch candidate_search{};
   TransitionCost transition_cost{};
   EmissionCost emission_cost{};
   Routing routing{};
+  Streaming streaming{};
 };
 
 } // namespace meili
@@ -2,6 +2,7 @@
 #ifndef MMP_MAP_MATCHER_H_
 #define MMP_MAP_MATCHER_H_
 
+#include <functional>
 #include <unordered_set>
 #include <vector>
 
@@ -69,6 +70,24 @@ public:
   std::vector<MatchResults> OfflineMatch(const std::vector<Measurement>& measurements,
                                          uint32_t k = 1);
 
+  // Receives the match results which a window committed, in the order of the measurements
+  using commit_callback_t = std::function<void(std::vector<MatchResult>::const_iterator begin,
+                                               std::vector<MatchResult>::const_iterator end)>;
+
+  /**
+   * Matches the trace in a window of config().streaming.window measurements which slides along
+   * it, so that only the states of one window are kept at a time. Once the best paths to all the
+   * states of the last measurement of the window go through the same state, everything up to it
+   * is decided: it is committed and the next window starts from that state. If they never meet
+   * the first half of the window is committed anyway.
+   * @param measurements  the trace to match
+   * @param commit        optionally called with the results of every window once committed
+   * @return the best path through the whole trace, the state ids of its results only tell
+   *         whether they were matched since the windows they refer to are gone
+   */
+  MatchResults StreamingMatch(const std::vector<Measurement>& measurements,
+                              const commit_callback_t& commit = nullptr);
+
   /**
    * Set a callback that will throw when the map-matching should be aborted
    * @param interrupt_callback  the function to periodically call to see if we should abort
@@ -80,9 +99,16 @@ public:
 
 private:
   std::unordered_map<StateId::Time, std::vector<Measurement>>
-  AppendMeasurements(const std::vector<Measurement>& measurements);
+  AppendMeasurements(const std::vector<Measurement>& measurements,
+                     const baldr::PathLocation* first_candidate = nullptr);
+
+  StateId::Time AppendMeasurement(const Measurement& measurement,
+                                  const float sq_max_search_radius,
+                                  const baldr::PathLocation* candidate = nullptr);
+
+  double SearchPath(std::vector<StateId>& state_ids, bool& found_discontinuity);
 
-  StateId::Time AppendMeasurement(const Measurement& measurement, const float sq_max_search_radius);
+  StateId::Time FindDecidedTime(bool& after_break);
 
   void RemoveRedundancies(const std::vector<StateId>& result,
                           const std::vector<MatchResult>& results);
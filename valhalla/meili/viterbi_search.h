@@ -165,10 +165,19 @@ public:
   StateId Predecessor(const StateId& stateid) const override;
   double AccumulatedCost(const StateId& stateid) const override;
 
+  /**
+   * Searches the winner at the last time and then keeps scanning until every state which can be
+   * reached has its best predecessor and accumulated cost, rather than only the ones the winner
+   * needed. States added afterward must be preceded by ClearSearch.
+   */
+  void SearchReachable();
+
 private:
   // Initialize labels from a column and push them into priority queue
   void InitQueue(const std::vector<StateId>& column);
   void AddSuccessorsToQueue(const StateId& stateid);
+  // Remember the label as optimal and remove its state from the unreached ones
+  void Scan(const StateLabel& label);
   StateId::Time IterativeSearch(StateId::Time target, bool request_new_start);
   constexpr static bool IsInvalidCost(double cost);
 
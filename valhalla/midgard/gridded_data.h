@@ -3,10 +3,14 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <limits>
-#include <list>
-#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/polyline2.h>
 #include <valhalla/midgard/tiles.h>
@@ -20,6 +24,25 @@ namespace midgard {
 // compute an optimal generalization factor when creating contours.
 constexpr float kOptimalGeneralization = std::numeric_limits<float>::max();
 
+/**
+ * Finds the cells of a row of a grid which a contour value passes through, that is the cells
+ * whose lowest corner is at most the value and whose highest corner is at least the value.
+ * The corners of cell i are bottom[i], bottom[i + 1], top[i] and top[i + 1]. The cells are
+ * classified several at a time with SSE2 or AVX2 when they are available.
+ * @param  bottom  values along the bottom of the row, count + 1 of them
+ * @param  top     values along the top of the row, count + 1 of them
+ * @param  count   number of cells in the row
+ * @param  value   the contour value
+ * @param  cells   receives the indices of the cells the value passes through in increasing
+ *                 order, there has to be room for count of them
+ * @return the number of cells the value passes through
+ */
+size_t crossed_cells(const float* bottom,
+                     const float* top,
+                     const size_t count,
+                     const float value,
+                     uint32_t* cells);
+
 /**
  * Class to store data in a gridded/tiled data structure. Contains methods
  * to mark each tile with data using a compare operator.
@@ -61,9 +84,9 @@ public:
     }
   }
 
-  using contour_t = std::list<PointLL>;
-  using feature_t = std::list<contour_t>;
-  using contours_t = std::vector<std::list<feature_t>>;
+  using contour_t = std::vector<PointLL>;
+  using feature_t = std::vector<contour_t>;
+  using contours_t = std::vector<std::vector<feature_t>>;
   // dimension, value (seconds/meters), name (time/distance), color
   using contour_interval_t = std::tuple<size_t, float, std::string, std::string>;
   /**
@@ -83,16 +106,103 @@ public:
    * @param generalize           Generalization factor in meters. A special value
    *                             kOptimalGeneralization will let the method choose
    *                             an optimal generalization factor based on grid size.
+   * @param concurrency          number of threads the intervals are spread over, every
+   *                             interval is traced on its own so this does not change the result
    *
    * @return contour line geometries with the larger intervals first (for rendering purposes)
    */
   contours_t GenerateContours(std::vector<contour_interval_t>& intervals,
                               const bool rings_only = false,
                               const float denoise = 1.f,
-                              const float generalize = 200.f) const {
+                              const float generalize = 200.f,
+                              const uint32_t concurrency = 1) const {
     // sort the contours first on the metric index then on the values with the bigger contours first
     std::sort(intervals.begin(), intervals.end(), std::greater<>());
 
+    // If the generalization value equals kOptimalGeneralization then set
+    // the generalization factor to 1/4 of the grid size
+    float gen_factor = generalize;
+    if (generalize == kOptimalGeneralization) {
+      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
+    }
+
+    // lay the values of each metric we need out contiguously, so the cells of a row can be
+    // classified several at a time
+    std::array<std::vector<float>, dimensions_t> metric_values;
+    for (const auto& interval : intervals) {
+      const size_t metric_index = std::get<0>(interval);
+      auto& values = metric_values[metric_index];
+      if (values.empty()) {
+        values.resize(data_.size());
+        for (size_t i = 0; i < data_.size(); ++i) {
+          values[i] = data_[i][metric_index];
+        }
+      }
+    }
+
+    // every interval is traced on its own
+    contours_t contours(intervals.size());
+    auto trace = [&](const size_t i) {
+      const size_t metric_index = std::get<0>(intervals[i]);
+      contours[i] = GenerateContour(metric_values[metric_index], max_value_[metric_index],
+                                    std::get<1>(intervals[i]), rings_only, denoise, gen_factor);
+    };
+    const size_t threads = std::min<size_t>(std::max(concurrency, 1u), intervals.size());
+    if (threads <= 1) {
+      for (size_t i = 0; i < intervals.size(); ++i) {
+        trace(i);
+      }
+      return contours;
+    }
+
+    // hand the intervals out to the threads, keeping the first failure
+    std::atomic<size_t> next{0};
+    std::mutex error_lock;
+    std::exception_ptr error;
+    auto work = [&]() {
+      try {
+        for (size_t i = next++; i < intervals.size(); i = next++) {
+          trace(i);
+        }
+      } catch (...) {
+        next = intervals.size();
+        std::lock_guard<std::mutex> lock(error_lock);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return contours;
+  }
+
+protected:
+  /**
+   * Traces the contour lines of a single interval and cleans them up.
+   * @param values         the values of the metric of the interval, one per tile
+   * @param max_value      the value of tiles which were never reached
+   * @param contour_value  the value at which the contour lines occur
+   * @param rings_only     only include geometry of contours that are polygonal
+   * @param denoise        see GenerateContours
+   * @param gen_factor     generalization factor in meters
+   * @return the features of the interval
+   */
+  std::vector<feature_t> GenerateContour(const std::vector<float>& values,
+                                         const float max_value,
+                                         const float contour_value,
+                                         const bool rings_only,
+                                         const float denoise,
+                                         const float gen_factor) const {
     // Values at tile corners and center (0 element is center)
     int sh[5];
     typename PointLL::first_type s[5]; // Values at the tile corners and center
@@ -110,10 +220,8 @@ public:
 
     // In the tight loop below, we need to decide where a contour intersects the triangles that make
     // up the given tile. this works out to a number of discrete cases which we lookup using the table
-    // below. based on the case we perform the appropriate intersection. to avoid branching we store
-    // the intersection operation for each case in an array and perform the correct one by calling the
-    // function stored in the array
-    int case_table[3][3][3] = {
+    // below. based on the case we perform the appropriate intersection
+    static constexpr int case_table[3][3][3] = {
         {{0, 0, 8}, {0, 2, 5}, {7, 6, 9}},
         {{0, 3, 4}, {1, 0, 1}, {4, 3, 0}},
         {{9, 6, 7}, {5, 2, 0}, {8, 0, 0}},
@@ -135,281 +243,282 @@ public:
     // "A linear ring MUST follow the right-hand rule with respect to the area it
     // bounds, i.e., exterior rings are counterclockwise, and holes are clockwise."  (c)
     // (c) https://tools.ietf.org/html/rfc7946#section-3.1.6
-    bool swap_table[3][3][3] = {
+    static constexpr bool swap_table[3][3][3] = {
         {{false, false, true}, {false, true, true}, {true, false, false}},
         {{false, true, false}, {true, false, false}, {true, false, false}},
         {{true, true, false}, {false, false, false}, {false, false, false}},
     };
-    std::array<std::function<void()>, 10> cases{
-        [&]() {},
-        // Line between vertices 1 and 2
-        [&]() {
-          from_pt = tile_corners[m1];
-          to_pt = tile_corners[m2];
-        },
-        // Line between vertices 2 and 3
-        [&]() {
-          from_pt = tile_corners[m2];
-          to_pt = tile_corners[m3];
-        },
-        // Line between vertices 3 and 1
-        [&]() {
-          from_pt = tile_corners[m3];
-          to_pt = tile_corners[m1];
-        },
-        // Line between vertex 1 and side 2-3
-        [&]() {
-          from_pt = tile_corners[m1];
-          to_pt = intersect(m2, m3);
-        },
-        // Line between vertex 2 and side 3-1
-        [&]() {
-          from_pt = tile_corners[m2];
-          to_pt = intersect(m3, m1);
-        },
-        // Line between vertex 3 and side 1-2
-        [&]() {
-          from_pt = tile_corners[m3];
-          to_pt = intersect(m1, m2);
-        },
-        // Line between sides 1-2 and 2-3
-        [&]() {
-          from_pt = intersect(m1, m2);
-          to_pt = intersect(m2, m3);
-        },
-        // Line between sides 2-3 and 3-1
-        [&]() {
-          from_pt = intersect(m2, m3);
-          to_pt = intersect(m3, m1);
-        },
-        // Line between sides 3-1 and 1-2
-        [&]() {
-          from_pt = intersect(m3, m1);
-          to_pt = intersect(m1, m2);
-        },
-    };
 
-    // which metrics do we need contours for
-    auto _ = std::make_pair(intervals.cbegin(), intervals.cend());
-    std::vector<decltype(_)> metrics{std::move(_)};
-    for (auto interval = intervals.cbegin(); interval != intervals.cend(); ++interval) {
-      if (std::get<0>(*interval) != std::get<0>(*metrics.back().first)) {
-        metrics.back().second = interval;
-        metrics.emplace_back(interval, intervals.cend());
-      }
-    }
-
-    // we need something to hold each iso-line
-    contours_t contours(intervals.size(), std::list<feature_t>{feature_t{}});
+    // The lines are chained together from the segments as they are found. The points of all
+    // the lines share one pool where every point links to the one after it on its line, so
+    // lines are extended at either end and joined without moving any points
+    struct line_t {
+      uint32_t first;
+      uint32_t last;
+      uint32_t size;
+      bool merged;
+    };
+    constexpr uint32_t kNoPoint = std::numeric_limits<uint32_t>::max();
+    std::vector<PointLL> points;
+    std::vector<uint32_t> next_point;
+    std::vector<line_t> lines;
+    auto add_point = [&points, &next_point](const PointLL& pt, const uint32_t next) {
+      points.push_back(pt);
+      next_point.push_back(next);
+      return static_cast<uint32_t>(points.size() - 1);
+    };
 
-    // and something to find them quickly
-    using contour_lookup_t = std::map<PointLL, typename feature_t::iterator>;
     // store begins and ends of the segments separately not to loose segment orientation
-    std::vector<contour_lookup_t> begin_lookups(intervals.size());
-    std::vector<contour_lookup_t> end_lookups(intervals.size());
-    // TODO: preallocate the lookups for each interval
-
-    // For each metric we tracked
-    for (const auto& metric : metrics) {
-      size_t metric_index = std::get<0>(*metric.first);
-
-      // For each cell, skipping the outer rim since its out of bounds
-      for (int row = 1; row < this->nrows_ - 1; ++row) {
-        for (int col = 1; col < this->ncolumns_ - 1; ++col) {
-          int tileid = this->TileId(col, row);
-          auto cell1 = data_[tileid][metric_index];
-          auto cell2 = data_[tileid + this->ncolumns_][metric_index];     // TileId(col,   row+1)];
-          auto cell3 = data_[tileid + 1][metric_index];                   // TileId(col+1, row)];
-          auto cell4 = data_[tileid + this->ncolumns_ + 1][metric_index]; // TileId(col+1, row+1)];
-          auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
-          auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
-
-          // Continue if outside the range of contour values for this metric_index
-          if (dmax < std::get<1>(*std::prev(metric.second)) || dmin > std::get<1>(*metric.first)) {
+    using contour_lookup_t = std::unordered_map<PointLL, uint32_t>;
+    contour_lookup_t begin_lookup;
+    contour_lookup_t end_lookup;
+
+    // For each row of cells, skipping the outer rim since its out of bounds
+    const int cells_per_row = this->ncolumns_ - 2;
+    std::vector<uint32_t> cells(std::max(cells_per_row, 0));
+    for (int row = 1; row < this->nrows_ - 1 && cells_per_row > 0; ++row) {
+      // find the cells this contour value passes through
+      const float* bottom = values.data() + this->TileId(1, row);
+      const size_t count =
+          crossed_cells(bottom, bottom + this->ncolumns_, cells_per_row, contour_value, cells.data());
+
+      for (size_t cell = 0; cell < count; ++cell) {
+        int tileid = this->TileId(static_cast<int>(cells[cell]) + 1, row);
+        for (int m = 4; m > 0; m--) {
+          int newtileid = tileid + tile_inc[m - 1];
+          // Make sure the tile corner value is not set to the max_value
+          // (messes up the intersect method). Set a value slightly above
+          // the contour (e.g. 1 minute higher).
+          // TODO - the value 1 is a bit of a hack.
+          float nd = values[newtileid];
+          s[m] = nd < max_value ? nd - contour_value : 1.0f;
+          tile_corners[m] = this->Base(newtileid);
+          sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
+        }
+        s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+        tile_corners[0] = this->Center(tileid);
+        sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
+
+        /*
+         Note: at this stage the relative heights of the corners and the
+         centre are in the h array, and the corresponding coordinates are
+         in the xh and yh arrays. The centre of the box is indexed by 0
+         and the 4 corners by 1 to 4 as shown below.
+         Each triangle is then indexed by the parameter m, and the 3
+         vertices of each triangle are indexed by parameters m1,m2,and m3.
+         It is assumed that the centre of the box is always vertex 2
+         though this is important only when all 3 vertices lie exactly on
+         the same contour level, in which case only the side of the box
+         is drawn.
+            vertex 4 +-------------------+ vertex 3
+                     | \               / |
+                     |   \    m-3    /   |
+                     |     \       /     |
+                     |       \   /       |
+                     |  m=2    X   m=2   |       the centre is vertex 0
+                     |       /   \       |
+                     |     /       \     |
+                     |   /    m=1    \   |
+                     | /               \ |
+            vertex 1 +-------------------+ vertex 2
+        */
+
+        // Scan each triangle in the box
+        for (int m = 1; m <= 4; m++) {
+          // figure out which intersection we need to do
+          m1 = m;
+          m2 = 0;
+          m3 = (m != 4) ? m + 1 : 1;
+          int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+          bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+
+          // do the intersection
+          switch (case_index) {
+            // there is no intersection of this triangle
+            case 0:
+              continue;
+            // Line between vertices 1 and 2
+            case 1:
+              from_pt = tile_corners[m1];
+              to_pt = tile_corners[m2];
+              break;
+            // Line between vertices 2 and 3
+            case 2:
+              from_pt = tile_corners[m2];
+              to_pt = tile_corners[m3];
+              break;
+            // Line between vertices 3 and 1
+            case 3:
+              from_pt = tile_corners[m3];
+              to_pt = tile_corners[m1];
+              break;
+            // Line between vertex 1 and side 2-3
+            case 4:
+              from_pt = tile_corners[m1];
+              to_pt = intersect(m2, m3);
+              break;
+            // Line between vertex 2 and side 3-1
+            case 5:
+              from_pt = tile_corners[m2];
+              to_pt = intersect(m3, m1);
+              break;
+            // Line between vertex 3 and side 1-2
+            case 6:
+              from_pt = tile_corners[m3];
+              to_pt = intersect(m1, m2);
+              break;
+            // Line between sides 1-2 and 2-3
+            case 7:
+              from_pt = intersect(m1, m2);
+              to_pt = intersect(m2, m3);
+              break;
+            // Line between sides 2-3 and 3-1
+            case 8:
+              from_pt = intersect(m2, m3);
+              to_pt = intersect(m3, m1);
+              break;
+            // Line between sides 3-1 and 1-2
+            default:
+              from_pt = intersect(m3, m1);
+              to_pt = intersect(m1, m2);
+              break;
+          }
+
+          // this isnt a segment..
+          if (from_pt == to_pt) {
             continue;
           }
+          if (swap_points) {
+            std::swap(from_pt, to_pt);
+          }
 
-          // For each requested contour value
-          for (size_t i = 0; i < intervals.size(); ++i) {
-            // some setup to process this contour
-            auto& begin_lookup = begin_lookups[i];
-            auto& end_lookup = end_lookups[i];
-            auto& contour = contours[i];
-            auto contour_value = std::get<1>(intervals[i]);
-
-            // we skip this contour if its interested in a different metric_index or its value
-            // would not intersect this cell
-            if (std::get<0>(intervals[i]) != metric_index || contour_value < dmin ||
-                contour_value > dmax) {
+          // see if we have anything to connect this segment to
+          auto end_lookup_it = end_lookup.find(from_pt);
+          auto begin_lookup_it = begin_lookup.find(to_pt);
+
+          if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
+            // we want to merge two records
+            //   first_segment                               second_segment
+            // (... ------> from_pt) + (from_pt, to_pt) + (to_pt ------> ...)
+            auto first_segment = end_lookup_it->second;
+            auto second_segment = begin_lookup_it->second;
+            end_lookup.erase(end_lookup_it);
+            begin_lookup.erase(begin_lookup_it);
+
+            // this segment is now a ring
+            auto& first = lines[first_segment];
+            if (first_segment == second_segment) {
+              const auto ring_end = add_point(points[first.first], kNoPoint);
+              next_point[first.last] = ring_end;
+              first.last = ring_end;
+              ++first.size;
               continue;
             }
 
-            for (int m = 4; m > 0; m--) {
-              int newtileid = tileid + tile_inc[m - 1];
-              // Make sure the tile corner value is not set to the max_value
-              // (messes up the intersect method). Set a value slightly above
-              // the contour (e.g. 1 minute higher).
-              // TODO - the value 1 is a bit of a hack.
-              float nd = data_[newtileid][metric_index];
-              s[m] = nd < max_value_[metric_index] ? nd - contour_value : 1.0f;
-              tile_corners[m] = this->Base(newtileid);
-              sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
-            }
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-            sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
-
-            /*
-             Note: at this stage the relative heights of the corners and the
-             centre are in the h array, and the corresponding coordinates are
-             in the xh and yh arrays. The centre of the box is indexed by 0
-             and the 4 corners by 1 to 4 as shown below.
-             Each triangle is then indexed by the parameter m, and the 3
-             vertices of each triangle are indexed by parameters m1,m2,and m3.
-             It is assumed that the centre of the box is always vertex 2
-             though this is important only when all 3 vertices lie exactly on
-             the same contour level, in which case only the side of the box
-             is drawn.
-                vertex 4 +-------------------+ vertex 3
-                         | \               / |
-                         |   \    m-3    /   |
-                         |     \       /     |
-                         |       \   /       |
-                         |  m=2    X   m=2   |       the centre is vertex 0
-                         |       /   \       |
-                         |     /       \     |
-                         |   /    m=1    \   |
-                         | /               \ |
-                vertex 1 +-------------------+ vertex 2
-            */
-
-            // Scan each triangle in the box
-            for (int m = 1; m <= 4; m++) {
-              // figure out which intersection we need to do
-              m1 = m;
-              m2 = 0;
-              m3 = (m != 4) ? m + 1 : 1;
-              int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-              bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-
-              // there is no intersection of this triangle
-              if (case_index == 0) {
-                continue;
-              }
-
-              // do the intersection, assigns to pt1 and pt2 inside lambdas defined above
-              cases[case_index]();
-
-              // this isnt a segment..
-              if (from_pt == to_pt) {
-                continue;
-              }
-              if (swap_points) {
-                std::swap(from_pt, to_pt);
-              }
-
-              // see if we have anything to connect this segment to
-              typename contour_lookup_t::iterator end_lookup_it = end_lookup.find(from_pt);
-              typename contour_lookup_t::iterator begin_lookup_it = begin_lookup.find(to_pt);
-
-              if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
-                // we want to merge two records
-                //   first_segment                               second_segment
-                // (... ------> from_pt) + (from_pt, to_pt) + (to_pt ------> ...)
-                auto first_segment = end_lookup_it->second;
-                auto second_segment = begin_lookup_it->second;
-                end_lookup.erase(end_lookup_it);
-                begin_lookup.erase(begin_lookup_it);
-
-                // this segment is now a ring
-                if (first_segment == second_segment) {
-                  first_segment->push_back(first_segment->front());
-                  continue;
-                }
-
-                end_lookup[second_segment->back()] = first_segment;
-                first_segment->splice(first_segment->end(), *second_segment);
-                contour.front().erase(second_segment);
-              } else if (end_lookup_it != end_lookup.end()) {
-                // (... ------> from_pt) + (from_pt, to_pt)
-                end_lookup_it->second->push_back(to_pt);
-                end_lookup.emplace(to_pt, end_lookup_it->second);
-                end_lookup.erase(end_lookup_it);
-              } else if (begin_lookup_it != begin_lookup.end()) {
-                // (from_pt, to_pt) + (to_pt ------> ...)
-                begin_lookup_it->second->push_front(from_pt);
-                begin_lookup.emplace(from_pt, begin_lookup_it->second);
-                begin_lookup.erase(begin_lookup_it);
-              } else {
-                // this is an orphan segment for now
-                contour.front().push_front(contour_t{from_pt, to_pt});
-                begin_lookup.emplace(from_pt, contour.front().begin());
-                end_lookup.emplace(to_pt, contour.front().begin());
-              }
-            }
-          } // Each contour
-        }   // Each tile col
-      }     // Each tile row
-    }       // Each dimension of the grid
-
-    // If the generalization value equals kOptimalGeneralization then set
-    // the generalization factor to 1/4 of the grid size
-    float gen_factor = generalize;
-    if (generalize == kOptimalGeneralization) {
-      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
-    }
-
-    // some info about the area the image covers
-    auto c = this->TileBounds().Center();
-    auto h = this->tilesize_ / 2;
-    // for each contour
-    for (auto& collection : contours) {
-      auto& contour = collection.front();
+            auto& second = lines[second_segment];
+            end_lookup[points[second.last]] = first_segment;
+            next_point[first.last] = second.first;
+            first.last = second.last;
+            first.size += second.size;
+            second.merged = true;
+          } else if (end_lookup_it != end_lookup.end()) {
+            // (... ------> from_pt) + (from_pt, to_pt)
+            const auto segment = end_lookup_it->second;
+            auto& line = lines[segment];
+            const auto last = add_point(to_pt, kNoPoint);
+            next_point[line.last] = last;
+            line.last = last;
+            ++line.size;
+            end_lookup.erase(end_lookup_it);
+            end_lookup.emplace(to_pt, segment);
+          } else if (begin_lookup_it != begin_lookup.end()) {
+            // (from_pt, to_pt) + (to_pt ------> ...)
+            const auto segment = begin_lookup_it->second;
+            auto& line = lines[segment];
+            line.first = add_point(from_pt, line.first);
+            ++line.size;
+            begin_lookup.erase(begin_lookup_it);
+            begin_lookup.emplace(from_pt, segment);
+          } else {
+            // this is an orphan segment for now
+            const auto last = add_point(to_pt, kNoPoint);
+            lines.push_back({add_point(from_pt, last), last, 2, false});
+            begin_lookup.emplace(from_pt, static_cast<uint32_t>(lines.size() - 1));
+            end_lookup.emplace(to_pt, static_cast<uint32_t>(lines.size() - 1));
+          }
+        }
+      } // Each crossed cell
+    }   // Each row of cells
+
+    // copy the lines out of the pool, the most recently started ones first
+    feature_t contour;
+    contour.reserve(lines.size());
+    for (auto line = lines.crbegin(); line != lines.crend(); ++line) {
+      if (line->merged) {
+        continue;
+      }
+      contour_t geometry;
+      geometry.reserve(line->size);
+      for (auto pt = line->first; pt != kNoPoint; pt = next_point[pt]) {
+        geometry.push_back(points[pt]);
+      }
       // they only wanted rings
-      if (rings_only) {
-        contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+      if (!rings_only || geometry.front() == geometry.back()) {
+        contour.emplace_back(std::move(geometry));
       }
-      // sort them by area (maybe length would be sufficient?) biggest first
-      std::unordered_map<const contour_t*, typename PointLL::first_type> cache(contour.size());
-      std::for_each(contour.cbegin(), contour.cend(),
-                    [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
-      contour.sort([&cache](const contour_t& a, const contour_t& b) {
-        return std::abs(cache[&a]) > std::abs(cache[&b]);
-      });
-
-      // they only want the most significant ones!
-      if (denoise > 0.f) {
-        contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
-          return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
-        });
+    }
+    points.clear();
+    next_point.clear();
+
+    // sort them by area (maybe length would be sufficient?) biggest first
+    std::vector<std::pair<typename PointLL::first_type, contour_t>> by_area;
+    by_area.reserve(contour.size());
+    for (auto& line : contour) {
+      by_area.emplace_back(std::abs(polygon_area(line)), std::move(line));
+    }
+    std::stable_sort(by_area.begin(), by_area.end(),
+                     [](const std::pair<typename PointLL::first_type, contour_t>& a,
+                        const std::pair<typename PointLL::first_type, contour_t>& b) {
+                       return a.first > b.first;
+                     });
+
+    // they only want the most significant ones!
+    contour.clear();
+    for (auto& line : by_area) {
+      if (denoise > 0.f && line.first / by_area.front().first < denoise) {
+        continue;
       }
       // clean up the lines
-      for (auto& line : contour) {
-        if (gen_factor > 0.f) {
-          Polyline2<PointLL>::Generalize(line, gen_factor, {}, /* avoid_self_intersections */ true);
-        }
-        // sampling the bottom left corner means everything is skewed, so unskew it
-        for (auto& coord : line) {
-          coord.first += h;
-          coord.second += h;
-        }
+      if (gen_factor > 0.f) {
+        Polyline2<PointLL>::Generalize(line.second, gen_factor, {},
+                                       /* avoid_self_intersections */ true);
       }
       // remove points and lines
-      contour.remove_if([](const contour_t& line) { return line.size() < 4; });
-
-      // if they just wanted linestrings we need only one per feature
-      if (!rings_only) {
-        for (auto& linestring : contour) {
-          collection.push_back({std::move(linestring)});
-        }
-        collection.pop_front();
+      if (line.second.size() < 4) {
+        continue;
+      }
+      // sampling the bottom left corner means everything is skewed, so unskew it
+      auto h = this->tilesize_ / 2;
+      for (auto& coord : line.second) {
+        coord.first += h;
+        coord.second += h;
       }
+      contour.emplace_back(std::move(line.second));
     }
 
-    return contours;
+    // if they just wanted linestrings we need only one per feature
+    std::vector<feature_t> collection;
+    if (rings_only) {
+      collection.emplace_back(std::move(contour));
+    } else {
+      collection.reserve(contour.size());
+      for (auto& linestring : contour) {
+        collection.push_back({std::move(linestring)});
+      }
+    }
+    return collection;
   }
 
-protected:
   value_type max_value_;         // Maximum value stored in the tile
   std::vector<value_type> data_; // Data value within each tile
 };
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -13,9 +15,11 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -325,72 +329,30 @@ public:
     return npos;
   }
 
-  // sort the file based on the predicate, and outputs to output_seq
+  // sort the file based on the predicate
   //
-  // Strategy is to first sort sub-ranges of length buffer_size in place.
-  // These should all fit in memory. Then, merge the sub-ranges into the
-  // output sequence via priority queue.
+  // Strategy is to first sort sub-ranges (runs) of length buffer_size in place.
+  // These should all fit in memory. Then, merge the runs into a temporary file
+  // via priority queue. With more than one thread the runs are sorted concurrently
+  // (and the file is split in at least one run per thread) and the merge is split
+  // by key ranges: each thread merges the part of every run that falls in its range
+  // into its own slice of the output. Each thread has a run in memory at a time.
   void sort(const std::function<bool(const T&, const T&)>& predicate,
-            size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
-    flush();
-    // if no elements we are done
-    if (memmap.size() == 0) {
-      return;
-    }
-
-    // If there wont be any merging we may as well take the simple approach
-    if (buffer_size > memmap.size() + write_buffer.size()) {
-      std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
-      return;
-    }
-
-    auto tmp_path = filesystem::path(file_name).replace_filename(
-        filesystem::path(file_name).filename().string() + ".tmp");
-    {
-      // we need a temporary sequence to merge the sorted subsections into
-      sequence<T> output_seq(tmp_path.string(), true);
-
-      // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
-      // Pq keeps track of element and its index.
-      auto cmp = [&predicate](const std::pair<T, size_t>& a, std::pair<T, size_t>& b) {
-        return predicate(b.first, a.first);
-      };
-      std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)> pq(
-          cmp);
-
-      // Sort the subsections
-      for (size_t i = 0; i < memmap.size(); i += buffer_size) {
-        std::sort(static_cast<T*>(memmap) + i,
-                  static_cast<T*>(memmap) + std::min(memmap.size(), i + buffer_size), predicate);
-        pq.emplace(*at(i), i);
-      }
-
-      // Perform the merge
-      while (!pq.empty()) {
-        auto tmp = pq.top();
-        pq.pop();
-        output_seq.push_back(tmp.first);
-        size_t new_idx = tmp.second + 1;
-        if (new_idx % buffer_size != 0 && new_idx < memmap.size()) {
-          pq.emplace(*at(new_idx), new_idx);
-        }
-      }
-      output_seq.flush();
-    }
-
-    // Forget about this file for a second so we can swap in the temp file
-    file.reset();
-    memmap.unmap();
-
-    // Move the sorted result back into place
-    filesystem::remove(file_name);
-    filesystem::rename(tmp_path, file_name);
+            size_t buffer_size = kSortBufferSize,
+            size_t concurrency = 1) {
+    sort_runs(
+        [&predicate](T* begin, T* end) { std::sort(begin, end, predicate); }, predicate,
+        buffer_size, concurrency);
+  }
 
-    // Reload the sequence
-    sequence<T> reloaded(file_name, false);
-    std::swap(file, reloaded.file);
-    std::swap(memmap, reloaded.memmap);
-    return;
+  // sort the file based on an integer key, same as above but the runs are radix sorted
+  // which is faster than comparison sorting when there are many elements per run
+  void sort_by_key(const std::function<uint64_t(const T&)>& key,
+                   size_t buffer_size = kSortBufferSize,
+                   size_t concurrency = 1) {
+    sort_runs([&key](T* begin, T* end) { radix_sort(begin, end, key); },
+              [&key](const T& a, const T& b) { return key(a) < key(b); }, buffer_size,
+              concurrency);
   }
 
   // perform an volatile operation on all the items of this sequence
@@ -586,7 +548,214 @@ public:
     return iterator(this, memmap.size() + write_buffer.size());
   }
 
+  // the default number of elements per sorted run, 512MB worth
+  static constexpr size_t kSortBufferSize = 1024 * 1024 * 512 / sizeof(T);
+
 protected:
+  using run_t = std::pair<size_t, size_t>;
+
+  // runs work(i) for every i in [0, count) on the given number of threads and rethrows the
+  // first exception on the calling thread
+  static void parallel_for(size_t count, size_t threads, const std::function<void(size_t)>& work) {
+    threads = std::max(static_cast<size_t>(1), std::min(threads, count));
+    if (threads == 1) {
+      for (size_t i = 0; i < count; ++i) {
+        work(i);
+      }
+      return;
+    }
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+      pool.emplace_back([&]() {
+        try {
+          for (size_t i = next++; i < count; i = next++) {
+            work(i);
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          next = count;
+        }
+      });
+    }
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // least significant digit radix sort of the range by the key, 11 bits at a time. digits in
+  // which all the keys are the same are skipped so small keys only take a few passes. the keys
+  // are sorted along with the index of their element and the elements are then moved into place
+  // by following the cycles of that permutation, so no copy of the range is needed
+  static void radix_sort(T* begin, T* end, const std::function<uint64_t(const T&)>& key) {
+    constexpr size_t kDigitBits = 11;
+    constexpr size_t kRadix = size_t(1) << kDigitBits;
+    size_t count = end - begin;
+    if (count < 2) {
+      return;
+    }
+    std::vector<std::pair<uint64_t, size_t>> keys(count), swap(count);
+    for (size_t i = 0; i < count; ++i) {
+      keys[i] = {key(begin[i]), i};
+    }
+    std::vector<size_t> histogram(kRadix + 1);
+    for (size_t shift = 0; shift < 64; shift += kDigitBits) {
+      std::fill(histogram.begin(), histogram.end(), 0);
+      for (const auto& k : keys) {
+        ++histogram[((k.first >> shift) & (kRadix - 1)) + 1];
+      }
+      if (std::find(histogram.begin() + 1, histogram.end(), count) != histogram.end()) {
+        continue;
+      }
+      for (size_t i = 1; i <= kRadix; ++i) {
+        histogram[i] += histogram[i - 1];
+      }
+      for (const auto& k : keys) {
+        swap[histogram[(k.first >> shift) & (kRadix - 1)]++] = k;
+      }
+      keys.swap(swap);
+    }
+    swap = std::vector<std::pair<uint64_t, size_t>>();
+    // keys[i].second is where the element for position i comes from, once a position has its
+    // element we point it at itself so each cycle is only walked once
+    for (size_t i = 0; i < count; ++i) {
+      if (keys[i].second == i) {
+        continue;
+      }
+      T first = std::move(begin[i]);
+      size_t j = i;
+      while (keys[j].second != i) {
+        auto from = keys[j].second;
+        begin[j] = std::move(begin[from]);
+        keys[j].second = j;
+        j = from;
+      }
+      begin[j] = std::move(first);
+      keys[j].second = j;
+    }
+  }
+
+  // sorts the runs with sort_run and merges them into a temporary file that replaces this one
+  void sort_runs(const std::function<void(T*, T*)>& sort_run,
+                 const std::function<bool(const T&, const T&)>& predicate,
+                 size_t buffer_size,
+                 size_t concurrency) {
+    flush();
+    // if no elements we are done
+    if (memmap.size() == 0) {
+      return;
+    }
+    T* data = static_cast<T*>(memmap);
+    concurrency = std::max(static_cast<size_t>(1), concurrency);
+
+    // If there wont be any merging we may as well take the simple approach
+    if (concurrency == 1 && buffer_size > memmap.size()) {
+      sort_run(data, data + memmap.size());
+      return;
+    }
+
+    // Sort the runs, at least one per thread so that they all have something to do
+    buffer_size = std::max(static_cast<size_t>(1),
+                           std::min(buffer_size, (memmap.size() + concurrency - 1) / concurrency));
+    std::vector<run_t> runs;
+    for (size_t i = 0; i < memmap.size(); i += buffer_size) {
+      runs.emplace_back(i, std::min(memmap.size(), i + buffer_size));
+    }
+    parallel_for(runs.size(), concurrency,
+                 [&](size_t r) { sort_run(data + runs[r].first, data + runs[r].second); });
+    if (runs.size() == 1) {
+      return;
+    }
+
+    // Split the merge into key ranges, one per thread, using splitters sampled from the runs.
+    // For each range we know where it starts in each run and where it goes in the output
+    std::vector<std::vector<run_t>> parts(1, runs);
+    if (concurrency > 1) {
+      std::vector<T> samples;
+      for (const auto& run : runs) {
+        size_t step = std::max(static_cast<size_t>(1), (run.second - run.first) / (concurrency * 32));
+        for (size_t i = run.first; i < run.second; i += step) {
+          samples.push_back(data[i]);
+        }
+      }
+      std::sort(samples.begin(), samples.end(), predicate);
+      parts.assign(concurrency, runs);
+      for (size_t p = 1; p < concurrency; ++p) {
+        const T& splitter = samples[p * samples.size() / concurrency];
+        for (size_t r = 0; r < runs.size(); ++r) {
+          size_t split = std::lower_bound(data + parts[p - 1][r].first, data + runs[r].second,
+                                          splitter, predicate) -
+                         data;
+          parts[p - 1][r].second = split;
+          parts[p][r].first = split;
+        }
+      }
+    }
+
+    auto tmp_path = filesystem::path(file_name).replace_filename(
+        filesystem::path(file_name).filename().string() + ".tmp");
+    {
+      // we need a temporary file to merge the sorted runs into
+      mem_map<T> output;
+      output.create(tmp_path.string(), memmap.size());
+      std::vector<size_t> offsets(parts.size(), 0);
+      for (size_t p = 1; p < parts.size(); ++p) {
+        offsets[p] = offsets[p - 1];
+        for (const auto& run : parts[p - 1]) {
+          offsets[p] += run.second - run.first;
+        }
+      }
+
+      // Perform the merge of each key range
+      parallel_for(parts.size(), concurrency, [&](size_t p) {
+        // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
+        // Pq keeps track of element and the run it came from
+        auto cmp = [&predicate](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+          return predicate(b.first, a.first);
+        };
+        std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)>
+            pq(cmp);
+        auto& cursors = parts[p];
+        for (size_t r = 0; r < cursors.size(); ++r) {
+          if (cursors[r].first < cursors[r].second) {
+            pq.emplace(data[cursors[r].first++], r);
+          }
+        }
+        T* out = static_cast<T*>(output) + offsets[p];
+        while (!pq.empty()) {
+          auto tmp = pq.top();
+          pq.pop();
+          *out++ = tmp.first;
+          auto& cursor = cursors[tmp.second];
+          if (cursor.first < cursor.second) {
+            pq.emplace(data[cursor.first++], tmp.second);
+          }
+        }
+      });
+    }
+
+    // Forget about this file for a second so we can swap in the temp file
+    file.reset();
+    memmap.unmap();
+
+    // Move the sorted result back into place
+    filesystem::remove(file_name);
+    filesystem::rename(tmp_path, file_name);
+
+    // Reload the sequence
+    sequence<T> reloaded(file_name, false);
+    std::swap(file, reloaded.file);
+    std::swap(memmap, reloaded.memmap);
+  }
+
   std::shared_ptr<std::fstream> file;
   std::string file_name;
   std::vector<T> write_buffer;
@@ -615,6 +615,22 @@ struct projector_t {
     return {u.first + bx * scale, u.second + by * scale};
   }
 
+  /**
+   * Projects onto every segment of a shape, several segments at a time where the instruction set
+   * allows it, and keeps the projection if it is closer than the one passed in. Of projections
+   * which are equally close the one on the first segment is kept, like testing the segments in
+   * order with the operator above does.
+   * @param shape        the shape to project onto
+   * @param point        the closest projection so far, updated if a closer one is found
+   * @param sq_distance  its squared distance in meters, updated along with it
+   * @param index        the index of the segment it lies on, updated along with it
+   * @return true if a closer projection was found
+   */
+  bool closest(const std::vector<PointLL>& shape,
+               PointLL& point,
+               double& sq_distance,
+               size_t& index) const;
+
   // critical data
   double lon_scale;
   double lat;
@@ -0,0 +1,29 @@
+#ifndef VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
+#define VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build a contraction hierarchy of the whole graph for the default auto
+ * costing. The hierarchy is stored as contraction tiles, one per graph tile, in their
+ * own directory so that thor can answer default auto routes and matrices with a few
+ * thousand settled edges instead of a full bidirectional A* search.
+ */
+class ContractionBuilder {
+public:
+  /**
+   * Contracts the directed edges the default auto costing can use, one at a time in
+   * the order of how few shortcuts they need, and writes the contraction tiles to
+   * mjolnir.contraction_dir. Nothing is done if it is not set.
+   * @param pt  Property tree containing the build configuration
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
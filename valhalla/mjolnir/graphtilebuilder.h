@@ -14,6 +14,7 @@
 #include <utility>
 
 #include <valhalla/baldr/admin.h>
+#include <valhalla/baldr/edgereach.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 #include <valhalla/baldr/graphtileheader.h>
@@ -65,6 +66,13 @@ public:
    */
   void StoreTileData();
 
+  /**
+   * Output the tile to file below another base directory than the one it was read from. Lets a
+   * stage rewrite tiles while other threads still need to read the original ones.
+   * @param  tile_dir  Base directory path to write the tile into
+   */
+  void StoreTileData(const std::string& tile_dir);
+
   /**
    * Update a graph tile with new nodes and directed edges. Assumes no new
    * nodes or edges are added. Attributes within existing nodes and edges
@@ -485,6 +493,14 @@ public:
    */
   void UpdatePredictedSpeeds(const std::vector<DirectedEdge>& directededges);
 
+  /**
+   * Updates a tile with the reach of its directed edges. Replaces the edge reach
+   * data of the tile if it has some already, otherwise appends it to the tile.
+   * @param  max_reach  Maximum reach the reaches were computed up to.
+   * @param  reaches    Reach of every directed edge of the tile.
+   */
+  void UpdateEdgeReach(const uint32_t max_reach, const std::vector<EdgeReach>& reaches);
+
 protected:
   struct EdgeTupleHasher {
     std::size_t operator()(const edge_tuple& k) const {
@@ -31,14 +31,24 @@
 #ifndef __OSMPBFPARSER__
 #define __OSMPBFPARSER__
 
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 // this describes the low-level blob storage
 #include <valhalla/proto/fileformat.pb.h>
 // this describes the high-level OSM objects
 #include <valhalla/proto/osmformat.pb.h>
 
+namespace valhalla {
+namespace mjolnir {
+class TaskPool;
+}
+} // namespace valhalla
+
 // extend the protobuf osmpbf namespace
 namespace OSMPBF {
 
@@ -75,6 +85,21 @@ struct Callback {
   virtual void
   relation_callback(const uint64_t osmid, const Tags& tags, const std::vector<Member>& members) = 0;
   virtual void changeset_callback(const uint64_t changeset_id) = 0;
+
+  // when parsing on a pool these are called from the pool threads while the blocks are decoded,
+  // before the objects are handed to the callbacks above in file order. they let the consumer
+  // rewrite the tags concurrently, thread is the index of the pool thread doing the work so that
+  // per thread state (like a lua state) can be kept
+  virtual void way_transform(const size_t /*thread*/,
+                             const uint64_t /*osmid*/,
+                             Tags& /*tags*/,
+                             const std::vector<uint64_t>& /*nodes*/) {
+  }
+  virtual void relation_transform(const size_t /*thread*/,
+                                  const uint64_t /*osmid*/,
+                                  Tags& /*tags*/,
+                                  const std::vector<Member>& /*members*/) {
+  }
 };
 
 // the parser used to get data out of the osmpbf file
@@ -83,6 +108,12 @@ public:
   Parser() = delete;
   // parse the pbf file for the things you are interested in
   static void parse(std::ifstream& file, const Interest interest, Callback& callback);
+  // parse the pbf file decoding batches of blocks on the pool, the callbacks are still called in
+  // file order and from the calling thread so the result is the same as the above
+  static void parse(std::ifstream& file,
+                    const Interest interest,
+                    Callback& callback,
+                    valhalla::mjolnir::TaskPool& pool);
   // clean up protobuf library level memory, this will make protobuf unusable after its called
   static void free();
 };
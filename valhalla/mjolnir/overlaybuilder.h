@@ -0,0 +1,29 @@
+#ifndef VALHALLA_MJOLNIR_OVERLAYBUILDER_H
+#define VALHALLA_MJOLNIR_OVERLAYBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build the multi-level partition thor customizes for any costing to answer
+ * routes and matrices over an overlay of cell cliques, see thor::OverlayCustomization.
+ * The cells are the graph tiles of the local, arterial and highway levels, covering the
+ * nodes of every level by their position, so only the boundary edges between them are
+ * stored, one overlay cell per tile in their own directory.
+ */
+class OverlayBuilder {
+public:
+  /**
+   * Finds the directed edges entering and leaving the cells of every overlay level and
+   * writes the overlay cells to mjolnir.overlay_dir. Nothing is done if it is not set.
+   * @param pt  Property tree containing the build configuration
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_OVERLAYBUILDER_H
@@ -0,0 +1,28 @@
+#ifndef VALHALLA_MJOLNIR_REACHBUILDER_H
+#define VALHALLA_MJOLNIR_REACHBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to precompute the reach of the directed edges and store it in the
+ * graph tiles so that loki does not have to expand the graph for every edge
+ * candidate of a request.
+ */
+class ReachBuilder {
+public:
+  /**
+   * Computes the inbound and outbound reach of every directed edge for the
+   * default auto, pedestrian and bicycle costings, up to mjolnir.max_edge_reach
+   * nodes, and adds it to the tiles. Nothing is done if it is 0.
+   * @param pt  Property tree containing the build configuration
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_REACHBUILDER_H
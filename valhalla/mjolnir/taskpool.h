@@ -0,0 +1,182 @@
+#ifndef VALHALLA_MJOLNIR_TASKPOOL_H
+#define VALHALLA_MJOLNIR_TASKPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Summary of one run of a TaskPool, logged when the run completes.
+ */
+struct TaskStats {
+  size_t tasks = 0;           // number of tasks that were run
+  size_t steals = 0;          // number of times a worker took tasks from another worker
+  double seconds = 0;         // wall time of the whole run
+  double busiest_seconds = 0; // time the busiest worker spent on tasks
+  double idlest_seconds = 0;  // time the least busy worker spent on tasks
+  double slowest_task_seconds = 0;
+  size_t slowest_task = 0;
+  std::vector<double> thread_seconds; // time each worker spent on tasks, indexed by worker id
+
+  /**
+   * Accumulates the statistics of another run, used by stages that run their tiles in batches.
+   * Busy time is summed per worker so the busiest and idlest thread describe the whole stage.
+   * The slowest task of the other run keeps its index within that run.
+   */
+  TaskStats& operator+=(const TaskStats& other);
+
+  /**
+   * Logs a one line summary of the run(s).
+   * @param name  name of the stage
+   * @param concurrency  number of threads the tasks ran on
+   */
+  void Log(const std::string& name, size_t concurrency) const;
+};
+
+/**
+ * Work-stealing pool of threads shared by the build stages. A run splits the task indices
+ * [0, task_count) into one contiguous range per worker so neighbouring tiles stay on the same
+ * thread. A worker that drains its range steals the back half of the range of another worker,
+ * so a few expensive tiles no longer keep one thread busy long after the others are done.
+ *
+ * Stages usually have expensive per thread setup (opening sequences, databases, readers) so the
+ * work function is called once per worker and pulls task indices with Worker::next() until there
+ * are none left. The time between two calls to next() is accounted to the task that was handed
+ * out by the first one. If a worker throws, the remaining tasks are skipped and the first
+ * exception is rethrown from Run on the calling thread.
+ *
+ * Runs must not be nested, a work function cannot submit to the pool that is running it.
+ */
+class TaskPool {
+public:
+  class Worker;
+  using work_t = std::function<void(Worker&)>;
+
+  /**
+   * Constructor.
+   * @param concurrency  number of worker threads, at least 1
+   */
+  explicit TaskPool(size_t concurrency);
+
+  /**
+   * Stops and joins the worker threads.
+   */
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  /**
+   * Returns the pool shared by all the build stages of this process. It is sized by
+   * mjolnir.concurrency and defaults to the number of cores.
+   * @param pt  Property tree containing the mjolnir configuration (or the mjolnir child itself)
+   */
+  static TaskPool& get(const boost::property_tree::ptree& pt);
+
+  /**
+   * @return the number of worker threads
+   */
+  size_t concurrency() const {
+    return workers_.size();
+  }
+
+  /**
+   * Runs work on every worker and blocks until all task_count tasks have been done.
+   * @param name        name of the stage, used when logging the run statistics. Nothing is
+   *                    logged when empty so that the caller can accumulate and log batches itself
+   * @param task_count  number of tasks the workers will pull with Worker::next()
+   * @param work        called once on each worker thread
+   * @return statistics about the run
+   */
+  TaskStats Run(const std::string& name, size_t task_count, const work_t& work);
+
+  /**
+   * Handle through which a work function pulls its tasks.
+   */
+  class Worker {
+  public:
+    /**
+     * Gets the next task to work on, stealing from other workers once the own range is empty.
+     * @param task  set to the index of the task to do
+     * @return false when there is nothing left to do or another worker failed
+     */
+    bool next(size_t& task);
+
+    /**
+     * @return the index of this worker, in [0, concurrency)
+     */
+    size_t id() const {
+      return id_;
+    }
+
+  protected:
+    friend class TaskPool;
+    using clock_t = std::chrono::steady_clock;
+
+    Worker(TaskPool& pool, size_t id) : pool_(pool), id_(id) {
+    }
+
+    // closes the timing of the task handed out last
+    void finish_task();
+
+    TaskPool& pool_;
+    size_t id_;
+
+    // remaining range of task indices owned by this worker
+    std::mutex mutex_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+
+    // timing of the task currently worked on
+    bool in_task_ = false;
+    size_t task_ = 0;
+    clock_t::time_point task_start_;
+
+    // per run statistics, only touched by the owning thread
+    size_t steals_ = 0;
+    double busy_seconds_ = 0;
+    double slowest_seconds_ = 0;
+    size_t slowest_task_ = 0;
+  };
+
+protected:
+  // body of each worker thread
+  void loop(size_t id);
+
+  // tries to move part of another workers range over to the thief
+  bool steal(Worker& thief, size_t& task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // hands the current run to the workers and signals its completion
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+  const work_t* work_ = nullptr;
+  uint64_t run_ = 0;
+  size_t running_ = 0;
+  bool shutdown_ = false;
+
+  // the first failure of the current run
+  std::exception_ptr error_;
+  std::atomic<bool> failed_{false};
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_TASKPOOL_H
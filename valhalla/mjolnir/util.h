@@ -40,7 +40,10 @@ enum class BuildStage : int8_t {
   kRestrictions = 12,
   kElevation = 13,
   kValidate = 14,
-  kCleanup = 15
+  kReach = 15,
+  kContraction = 16,
+  kOverlay = 17,
+  kCleanup = 18
 };
 
 constexpr uint8_t kMinor = 1;
@@ -65,6 +68,9 @@ inline BuildStage string_to_buildstage(const std::string& s) {
        {"restrictions", BuildStage::kRestrictions},
        {"elevation", BuildStage::kElevation},
        {"validate", BuildStage::kValidate},
+       {"reach", BuildStage::kReach},
+       {"contraction", BuildStage::kContraction},
+       {"overlay", BuildStage::kOverlay},
        {"cleanup", BuildStage::kCleanup}};
 
   auto i = stringToBuildStage.find(s);
@@ -89,6 +95,9 @@ inline std::string to_string(BuildStage stg) {
        {static_cast<int8_t>(BuildStage::kRestrictions), "restrictions"},
        {static_cast<int8_t>(BuildStage::kElevation), "elevation"},
        {static_cast<int8_t>(BuildStage::kValidate), "validate"},
+       {static_cast<int8_t>(BuildStage::kReach), "reach"},
+       {static_cast<int8_t>(BuildStage::kContraction), "contraction"},
+       {static_cast<int8_t>(BuildStage::kOverlay), "overlay"},
        {static_cast<int8_t>(BuildStage::kCleanup), "cleanup"}};
 
   auto i = BuildStageStrings.find(static_cast<int8_t>(stg));
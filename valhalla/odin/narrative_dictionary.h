@@ -1,6 +1,8 @@
 #ifndef VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 #define VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 
+#include <array>
+#include <cstdint>
 #include <locale>
 #include <string>
 #include <unordered_map>
@@ -8,6 +10,18 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+namespace valhalla {
+namespace odin {
+
+// A tag within a phrase along with the slot its value takes when the phrase is formatted
+struct PhraseTag {
+  const char* text;
+  uint8_t slot;
+};
+
+} // namespace odin
+} // namespace valhalla
+
 namespace {
 
 // Subset keys
@@ -123,48 +137,124 @@ constexpr auto kQuarterMileIndex = 3;
 constexpr auto kFeetIndex = 4;
 constexpr auto kSmallFeetIndex = 5;
 
-// Phrase tags
-constexpr auto kCardinalDirectionTag = "<CARDINAL_DIRECTION>";
-constexpr auto kRelativeDirectionTag = "<RELATIVE_DIRECTION>";
-constexpr auto kOrdinalValueTag = "<ORDINAL_VALUE>";
-constexpr auto kStreetNamesTag = "<STREET_NAMES>";
-constexpr auto kPreviousStreetNamesTag = "<PREVIOUS_STREET_NAMES>";
-constexpr auto kBeginStreetNamesTag = "<BEGIN_STREET_NAMES>";
-constexpr auto kCrossStreetNamesTag = "<CROSS_STREET_NAMES>";
-constexpr auto kRoundaboutExitStreetNamesTag = "<ROUNDABOUT_EXIT_STREET_NAMES>";
-constexpr auto kRoundaboutExitBeginStreetNamesTag = "<ROUNDABOUT_EXIT_BEGIN_STREET_NAMES>";
-constexpr auto kRampExitNumbersVisualTag = "<EXIT_NUMBERS>";
-constexpr auto kLengthTag = "<LENGTH>";
-constexpr auto kDestinationTag = "<DESTINATION>";
-constexpr auto kCurrentVerbalCueTag = "<CURRENT_VERBAL_CUE>";
-constexpr auto kNextVerbalCueTag = "<NEXT_VERBAL_CUE>";
-constexpr auto kKilometersTag = "<KILOMETERS>";
-constexpr auto kMetersTag = "<METERS>";
-constexpr auto kMilesTag = "<MILES>";
-constexpr auto kTenthsOfMilesTag = "<TENTHS_OF_MILE>";
-constexpr auto kFeetTag = "<FEET>";
-constexpr auto kNumberSignTag = "<NUMBER_SIGN>";
-constexpr auto kBranchSignTag = "<BRANCH_SIGN>";
-constexpr auto kTowardSignTag = "<TOWARD_SIGN>";
-constexpr auto kNameSignTag = "<NAME_SIGN>";
-constexpr auto kJunctionNameTag = "<JUNCTION_NAME>";
-constexpr auto kFerryLabelTag = "<FERRY_LABEL>";
-constexpr auto kTransitPlatformTag = "<TRANSIT_STOP>";
-constexpr auto kStationLabelTag = "<STATION_LABEL>";
-constexpr auto kTimeTag = "<TIME>";
-constexpr auto kTransitNameTag = "<TRANSIT_NAME>";
-constexpr auto kTransitHeadSignTag = "<TRANSIT_HEADSIGN>";
-constexpr auto kTransitPlatformCountTag = "<TRANSIT_STOP_COUNT>";
-constexpr auto kTransitPlatformCountLabelTag = "<TRANSIT_STOP_COUNT_LABEL>";
-constexpr auto kLevelTag = "<LEVEL>";
+using valhalla::odin::PhraseTag;
+
+// Phrase tags, each with its own slot
+constexpr PhraseTag kCardinalDirectionTag{"<CARDINAL_DIRECTION>", 0};
+constexpr PhraseTag kRelativeDirectionTag{"<RELATIVE_DIRECTION>", 1};
+constexpr PhraseTag kOrdinalValueTag{"<ORDINAL_VALUE>", 2};
+constexpr PhraseTag kStreetNamesTag{"<STREET_NAMES>", 3};
+constexpr PhraseTag kPreviousStreetNamesTag{"<PREVIOUS_STREET_NAMES>", 4};
+constexpr PhraseTag kBeginStreetNamesTag{"<BEGIN_STREET_NAMES>", 5};
+constexpr PhraseTag kCrossStreetNamesTag{"<CROSS_STREET_NAMES>", 6};
+constexpr PhraseTag kRoundaboutExitStreetNamesTag{"<ROUNDABOUT_EXIT_STREET_NAMES>", 7};
+constexpr PhraseTag kRoundaboutExitBeginStreetNamesTag{"<ROUNDABOUT_EXIT_BEGIN_STREET_NAMES>", 8};
+constexpr PhraseTag kRampExitNumbersVisualTag{"<EXIT_NUMBERS>", 9};
+constexpr PhraseTag kLengthTag{"<LENGTH>", 10};
+constexpr PhraseTag kDestinationTag{"<DESTINATION>", 11};
+constexpr PhraseTag kCurrentVerbalCueTag{"<CURRENT_VERBAL_CUE>", 12};
+constexpr PhraseTag kNextVerbalCueTag{"<NEXT_VERBAL_CUE>", 13};
+constexpr PhraseTag kKilometersTag{"<KILOMETERS>", 14};
+constexpr PhraseTag kMetersTag{"<METERS>", 15};
+constexpr PhraseTag kMilesTag{"<MILES>", 16};
+constexpr PhraseTag kTenthsOfMilesTag{"<TENTHS_OF_MILE>", 17};
+constexpr PhraseTag kFeetTag{"<FEET>", 18};
+constexpr PhraseTag kNumberSignTag{"<NUMBER_SIGN>", 19};
+constexpr PhraseTag kBranchSignTag{"<BRANCH_SIGN>", 20};
+constexpr PhraseTag kTowardSignTag{"<TOWARD_SIGN>", 21};
+constexpr PhraseTag kNameSignTag{"<NAME_SIGN>", 22};
+constexpr PhraseTag kJunctionNameTag{"<JUNCTION_NAME>", 23};
+constexpr PhraseTag kFerryLabelTag{"<FERRY_LABEL>", 24};
+constexpr PhraseTag kTransitPlatformTag{"<TRANSIT_STOP>", 25};
+constexpr PhraseTag kStationLabelTag{"<STATION_LABEL>", 26};
+constexpr PhraseTag kTimeTag{"<TIME>", 27};
+constexpr PhraseTag kTransitNameTag{"<TRANSIT_NAME>", 28};
+constexpr PhraseTag kTransitHeadSignTag{"<TRANSIT_HEADSIGN>", 29};
+constexpr PhraseTag kTransitPlatformCountTag{"<TRANSIT_STOP_COUNT>", 30};
+constexpr PhraseTag kTransitPlatformCountLabelTag{"<TRANSIT_STOP_COUNT_LABEL>", 31};
+constexpr PhraseTag kLevelTag{"<LEVEL>", 32};
+constexpr uint8_t kPhraseTagCount = 33;
 
 } // namespace
 
 namespace valhalla {
 namespace odin {
 
+/**
+ * Values of the tags of a phrase, indexed by the slot of their tag. A value passed as an
+ * lvalue is only pointed to and has to outlive the formatting of the phrase, temporaries
+ * are moved in and kept. The values point into the object itself so it can not be copied.
+ */
+class PhraseValues {
+public:
+  PhraseValues() = default;
+  PhraseValues(const PhraseValues&) = delete;
+  PhraseValues& operator=(const PhraseValues&) = delete;
+
+  void Set(const PhraseTag& tag, const std::string& value) {
+    values_[tag.slot] = &value;
+  }
+
+  void Set(const PhraseTag& tag, std::string&& value) {
+    owned_[tag.slot] = std::move(value);
+    values_[tag.slot] = &owned_[tag.slot];
+  }
+
+  // A const temporary can not be moved in and would be gone before it is formatted
+  void Set(const PhraseTag& tag, const std::string&& value) = delete;
+
+  const std::string* Get(const uint8_t slot) const {
+    return values_[slot];
+  }
+
+protected:
+  std::array<const std::string*, kPhraseTagCount> values_{};
+  std::array<std::string, kPhraseTagCount> owned_;
+};
+
+/**
+ * A phrase split once into its literal text and the slots of its tags, so that forming an
+ * instruction is a single pass of appends instead of a search and replace per tag.
+ */
+class PhraseTemplate {
+public:
+  PhraseTemplate() = default;
+
+  /**
+   * Compiles a phrase.
+   * @param  phrase  The phrase with its tags, for example "Turn <RELATIVE_DIRECTION>."
+   */
+  explicit PhraseTemplate(const std::string& phrase);
+
+  /**
+   * Formats the phrase into the given string. Tags which were not given a value are left
+   * as they are, the same as when they were not replaced.
+   * @param  out     The string to hold the formatted phrase, its previous contents are cleared.
+   * @param  values  Values of the tags.
+   */
+  void Format(std::string& out, const PhraseValues& values) const;
+
+  const std::string& phrase() const {
+    return phrase_;
+  }
+
+protected:
+  // A piece of the phrase, either literal text or a tag
+  struct Segment {
+    uint32_t offset;
+    uint32_t length;
+    uint8_t slot;
+  };
+  static constexpr uint8_t kLiteral = 0xff;
+
+  std::string phrase_;
+  std::vector<Segment> segments_;
+};
+
 struct PhraseSet {
   std::unordered_map<std::string, std::string> phrases;
+  // The phrases compiled when the dictionary is loaded
+  std::unordered_map<std::string, PhraseTemplate> templates;
 };
 
 struct StartSubset : PhraseSet {
@@ -1219,6 +1219,23 @@ void ParseCosting(const rapidjson::Document& doc,
                   Costing* costing,
                   Costing::Type costing_type = static_cast<Costing::Type>(Costing::Type_ARRAYSIZE));
 
+/**
+ * Checks whether a costing has the options a request without any costing options gets.
+ * Data precomputed for a costing when building the tiles only holds for these options.
+ * @param costing  the parsed costing of a request
+ * @return true if all of its options are the default ones
+ */
+bool IsDefaultCosting(const Costing& costing);
+
+/**
+ * Serializes the type and the options of a costing. Data derived from a costing at request
+ * time can be cached by it and reused by the requests with the same options. The key is the
+ * whole serialized costing rather than a hash of it so two costings never share an entry.
+ * @param costing  the parsed costing of a request
+ * @return the key of the costing
+ */
+std::string CostingKey(const Costing& costing);
+
 } // namespace sif
 
 } // namespace valhalla
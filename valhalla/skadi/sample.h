@@ -48,7 +48,8 @@ public:
   template <class coord_t> double get(const coord_t& coord);
 
   /**
-   * @brief Get multiple samples from the datasource
+   * @brief Get multiple samples from the datasource. The postings are grouped by tile so that
+   *        each tile is looked up once, no matter the order of the postings
    * @param coords  the list of postings at which to sample the datasource
    */
   template <class coords_t> std::vector<double> get_all(const coords_t& coords);
@@ -101,7 +102,6 @@ private:
    */
   void cache_initialisation(const std::string& source_path);
 
-  std::mutex cache_lck;
   std::string url_;
   std::unique_ptr<baldr::tile_getter_t> remote_loader_;
   // This parameter is used only in tests
@@ -66,6 +66,10 @@ public:
     return "a*_bike_share_station";
   }
 
+  virtual size_t label_count() const override {
+    return edgelabels_.size();
+  }
+
   /**
    * Clear the temporary information generated during path construction.
    */
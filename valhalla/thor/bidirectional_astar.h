@@ -79,6 +79,10 @@ public:
     return "bidirectional_a*";
   }
 
+  virtual size_t label_count() const override {
+    return edgelabels_forward_.size() + edgelabels_reverse_.size();
+  }
+
   /**
    * Clear the temporary information generated during path construction.
    */
@@ -107,6 +111,12 @@ protected:
   AStarHeuristic astarheuristic_forward_;
   AStarHeuristic astarheuristic_reverse_;
 
+  // Where each search heads for and the last tile it queued the tiles ahead of
+  midgard::PointLL prefetch_target_forward_;
+  midgard::PointLL prefetch_target_reverse_;
+  baldr::GraphId prefetch_tile_forward_;
+  baldr::GraphId prefetch_tile_reverse_;
+
   // Vector of edge labels (requires access by index).
   std::vector<sif::BDEdgeLabel> edgelabels_forward_;
   std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
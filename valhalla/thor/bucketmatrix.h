@@ -0,0 +1,200 @@
+#ifndef VALHALLA_THOR_BUCKETMATRIX_H_
+#define VALHALLA_THOR_BUCKETMATRIX_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/common.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+#include <valhalla/thor/costmatrix.h>
+#include <valhalla/thor/edgestatus.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Class to compute time + distance matrices among locations with buckets. Every target
+ * runs a single backward search that leaves a bucket entry, the target and its cost to
+ * the target, on the edges it reaches. Every source then runs a single forward search
+ * which scans the buckets of the edges it reaches. The backward searches only go about
+ * half way (based on the straight line distance to the sources) so the forward searches
+ * can stop as soon as no bucket can improve any of the connections found so far. This
+ * takes S + T searches of roughly half the radius instead of the S full searches of
+ * TimeDistanceMatrix.
+ */
+class BucketMatrix {
+public:
+  /**
+   * Default constructor. Most internal values are set when a query is made so
+   * the constructor mainly just sets some internals to a default empty value.
+   */
+  BucketMatrix();
+  ~BucketMatrix();
+
+  /**
+   * Forms a time distance matrix from the set of source locations
+   * to the set of target locations.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @return time/distance from all sources to all targets
+   */
+  std::vector<TimeDistance>
+  SourceToTarget(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                 baldr::GraphReader& graphreader,
+                 const sif::mode_costing_t& mode_costing,
+                 const sif::TravelMode mode,
+                 const float max_matrix_distance);
+
+  /**
+   * Clear the temporary information generated during time+distance
+   * matrix construction.
+   */
+  void clear();
+
+  /**
+   * Sets the priority queue implementation used by the adjacency lists.
+   * @param  policy  Queue policy to use from the next query on.
+   */
+  void set_queue_policy(const baldr::QueuePolicy policy) {
+    queue_policy_ = policy;
+  }
+
+protected:
+  // An entry in the bucket of an edge reached by a backward search. Holds the cost and
+  // distance from the end of the opposing (forward) edge to the target, including the
+  // turn onto the next edge.
+  struct BucketEntry {
+    uint32_t target;
+    uint32_t distance;
+    sif::Cost cost;
+  };
+
+  // Access mode used by the costing method
+  uint32_t access_mode_;
+
+  // Current travel mode
+  sif::TravelMode mode_;
+
+  // Current costing mode
+  std::shared_ptr<sif::DynamicCost> costing_;
+
+  // The cost threshold being used for the currently executing query
+  float current_cost_threshold_;
+
+  // Number of source and target locations
+  uint32_t source_count_;
+  uint32_t target_count_;
+
+  // Cost up to which the backward search of each target settled all edges
+  std::vector<float> target_radius_;
+
+  // Edge labels, adjacency list and edge status of the search being run. They are
+  // reused from one search to the next.
+  std::vector<sif::BDEdgeLabel> edgelabels_;
+  baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_;
+  EdgeStatus edgestatus_;
+
+  // Priority queue implementation used by the adjacency lists
+  baldr::QueuePolicy queue_policy_;
+
+  // Best connection found so far for each source and target pair, source major
+  std::vector<BestCandidate> best_connection_;
+
+  /**
+   * Get the cost threshold based on the current mode and the max arc-length distance
+   * for that mode.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   */
+  float GetCostThreshold(const float max_matrix_distance) const;
+
+  /**
+   * Get the cost up to which the backward search of a target should run. This is half
+   * of the estimated cost to the farthest source so both sides do about the same work.
+   * @param  target   Target location.
+   * @param  sources  List of source locations.
+   */
+  float GetTargetRadius(const valhalla::Location& target,
+                        const google::protobuf::RepeatedPtrField<valhalla::Location>& sources) const;
+
+  /**
+   * Set the connections where source and target are on the same edge with the source
+   * before the target. The searches do not connect these since they meet on edges.
+   * @param  sources  List of source locations.
+   * @param  targets  List of target locations.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void SetTrivialConnections(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                             const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                             baldr::GraphReader& graphreader);
+
+  /**
+   * Run the backward search of a target, filling the buckets of the edges it reaches.
+   * @param  index        Index of the target location.
+   * @param  target       Target location.
+   * @param  radius       Cost up to which the search settles edges.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void BackwardSearch(const uint32_t index,
+                      const valhalla::Location& target,
+                      const float radius,
+                      baldr::GraphReader& graphreader);
+
+  /**
+   * Run the forward search of a source, scanning the buckets of the edges it reaches.
+   * @param  index        Index of the source location.
+   * @param  source       Source location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void ForwardSearch(const uint32_t index,
+                     const valhalla::Location& source,
+                     baldr::GraphReader& graphreader);
+
+  /**
+   * Update the connections of a source with the buckets of an edge reached by its
+   * forward search.
+   * @param  source  Source index.
+   * @param  label   Edge label of the forward search.
+   * @return true if a connection improved.
+   */
+  bool ScanBucket(const uint32_t source, const sif::BDEdgeLabel& label);
+
+  /**
+   * Get the cost the forward search of a source has to reach before no bucket it has
+   * not seen yet can improve any of its connections.
+   * @param  source  Source index.
+   */
+  float GetStopCost(const uint32_t source) const;
+
+  /**
+   * Add the bucket entry of an edge reached by the backward search of a target.
+   * @param  target  Target index.
+   * @param  label   Edge label of the backward search.
+   */
+  void AddBucketEntry(const uint32_t target, const sif::BDEdgeLabel& label);
+
+  /**
+   * Reset the search state between two searches.
+   */
+  void reset();
+
+private:
+  class Buckets;
+
+  // Bucket entries of the edges reached by the backward searches
+  std::unique_ptr<Buckets> buckets_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_BUCKETMATRIX_H_
@@ -0,0 +1,172 @@
+#ifndef VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
+#define VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/contractiontile.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/pathinfo.h>
+
+#include <robin_hood.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Search over the upward (forward) or downward (backward) arcs of a contraction
+ * hierarchy. Only arcs to higher ranked nodes are followed so the search settles every
+ * node it can reach, which is a small part of the graph, and the costs of the nodes the
+ * forward search from the origin and the backward search from the destination both
+ * settle add up to the costs of the paths between them. The cheapest of these is the
+ * cheapest path.
+ */
+class ContractionSearch {
+public:
+  struct Label {
+    baldr::GraphId node;
+    baldr::GraphId middle; // Middle of the arc the label was reached through
+    float cost;
+    float secs;
+    float length;
+    uint32_t predecessor; // Label the arc comes from, kInvalidLabel at the origin
+    bool restricted;      // The path to the label has a restricted arc
+  };
+
+  /**
+   * Clears the labels to start a new search.
+   */
+  void Clear();
+
+  /**
+   * Adds a node the search starts from.
+   * @param  node    Hierarchy node, a directed edge.
+   * @param  cost    Cost of the node.
+   * @param  secs    Elapsed time of the node.
+   * @param  length  Length of the node.
+   */
+  void Add(const baldr::GraphId& node, const float cost, const float secs, const float length);
+
+  /**
+   * Adds the candidate edges of a location the search starts from. The forward search
+   * starts with the part of the edges after the origin, the backward search takes the
+   * part after the destination off the edges since the arcs cost whole edges.
+   * @param  forward      Whether the location is an origin, otherwise a destination.
+   * @param  location     Origin or destination location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing      Costing the hierarchy was built with.
+   */
+  void AddLocation(const bool forward,
+                   const valhalla::Location& location,
+                   baldr::GraphReader& graphreader,
+                   const sif::DynamicCost& costing);
+
+  /**
+   * Settles every node the search can reach.
+   * @param  forward       Whether to follow the upward arcs, otherwise the downward ones.
+   * @param  graphreader   Graph reader for accessing routing graph.
+   * @param  contraction   Contraction reader for accessing the hierarchy.
+   * @return Returns false if a contraction tile is missing so the search may be wrong.
+   */
+  bool Run(const bool forward, baldr::GraphReader& graphreader, baldr::ContractionReader& contraction);
+
+  /**
+   * Finds the label of a node.
+   * @return Returns nullptr if the search did not reach the node.
+   */
+  const Label* Find(const baldr::GraphId& node) const {
+    auto found = index_.find(node.value);
+    return found == index_.end() ? nullptr : &labels_[found->second];
+  }
+
+  const std::vector<Label>& labels() const {
+    return labels_;
+  }
+
+  /**
+   * Appends the directed edges of the path between the start of the search and a label,
+   * with shortcuts unpacked, to a list of edges. For a forward search these are the
+   * edges from the start node up to and including the label node, for a backward search
+   * the edges after the label node up to and including the start node.
+   * @return Returns false if a shortcut could not be unpacked.
+   */
+  bool AppendPath(const bool forward,
+                  const Label& label,
+                  baldr::GraphReader& graphreader,
+                  baldr::ContractionReader& contraction,
+                  std::vector<baldr::GraphId>& edges) const;
+
+protected:
+  std::vector<Label> labels_;
+  robin_hood::unordered_map<uint64_t, uint32_t> index_;
+};
+
+/**
+ * Unpacks the arc from one hierarchy node to another, appending the directed edges
+ * after the first node up to and including the second one.
+ * @return Returns false if an arc of a shortcut is missing.
+ */
+bool UnpackArc(const baldr::GraphId& from,
+               const baldr::GraphId& to,
+               const baldr::GraphId& middle,
+               baldr::GraphReader& graphreader,
+               baldr::ContractionReader& contraction,
+               std::vector<baldr::GraphId>& edges);
+
+/**
+ * Path algorithm answering routes of the default auto costing from the contraction
+ * hierarchy built by mjolnir::ContractionBuilder. It returns no path when it cannot
+ * answer the request exactly, when the cheapest path goes through restricted arcs or
+ * the hierarchy is incomplete, so the caller has to fall back to the other algorithms.
+ */
+class ContractionHierarchy : public PathAlgorithm {
+public:
+  explicit ContractionHierarchy(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Form path between an origin and destination location using the contraction
+   * hierarchy. The costing has to be the default auto costing.
+   * @return Returns the path edges, empty if the hierarchy cannot answer.
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const sif::mode_costing_t& mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  const char* name() const override {
+    return "contraction_hierarchy";
+  }
+
+  size_t label_count() const override {
+    return forward_.labels().size() + backward_.labels().size();
+  }
+
+  void Clear() override;
+
+  /**
+   * Sets the contraction tiles to search.
+   */
+  void set_contraction_reader(const std::shared_ptr<baldr::ContractionReader>& contraction) {
+    contraction_ = contraction;
+  }
+
+protected:
+  std::shared_ptr<baldr::ContractionReader> contraction_;
+  ContractionSearch forward_;
+  ContractionSearch backward_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
@@ -0,0 +1,87 @@
+#ifndef VALHALLA_THOR_CONTRACTIONMATRIX_H_
+#define VALHALLA_THOR_CONTRACTIONMATRIX_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/contractiontile.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/common.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/contractionhierarchy.h>
+#include <valhalla/thor/costmatrix.h>
+
+#include <robin_hood.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Class to compute time + distance matrices of the default auto costing from the
+ * contraction hierarchy built by mjolnir::ContractionBuilder. Every target runs a
+ * backward search over the downward arcs which leaves a bucket entry on every node it
+ * settles, then every source runs a forward search over the upward arcs which scans the
+ * buckets of the nodes it settles. The searches settle every node they can reach but
+ * these are only a small part of the graph.
+ */
+class ContractionMatrix {
+public:
+  ContractionMatrix() = default;
+
+  /**
+   * Forms a time distance matrix from the set of source locations to the set of target
+   * locations. The costing has to be the default auto costing.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @return time/distance from all sources to all targets, empty if the hierarchy cannot
+   *         answer one of the connections
+   */
+  std::vector<TimeDistance>
+  SourceToTarget(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                 baldr::GraphReader& graphreader,
+                 const sif::mode_costing_t& mode_costing,
+                 const sif::TravelMode mode);
+
+  /**
+   * Clear the temporary information generated during time+distance
+   * matrix construction.
+   */
+  void clear();
+
+  /**
+   * Sets the contraction tiles to search.
+   */
+  void set_contraction_reader(const std::shared_ptr<baldr::ContractionReader>& contraction) {
+    contraction_ = contraction;
+  }
+
+protected:
+  // An entry in the bucket of a node settled by the backward search of a target
+  struct BucketEntry {
+    uint32_t target;
+    ContractionSearch::Label label;
+  };
+
+  // The best connection found so far for a source and target pair
+  struct Connection {
+    float cost;
+    float secs;
+    float length;
+    bool restricted;
+  };
+
+  std::shared_ptr<baldr::ContractionReader> contraction_;
+  ContractionSearch search_;
+  robin_hood::unordered_map<uint64_t, std::vector<BucketEntry>> buckets_;
+  std::vector<Connection> connections_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CONTRACTIONMATRIX_H_
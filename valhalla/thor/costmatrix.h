@@ -2,12 +2,15 @@
 #define VALHALLA_THOR_COSTMATRIX_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <utility>
 #include <vector>
 
+#include <boost/property_tree/ptree.hpp>
+
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
@@ -15,6 +18,7 @@
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/labelarena.h>
 
 namespace valhalla {
 namespace thor {
@@ -93,10 +97,13 @@ struct BestCandidate {
 class CostMatrix {
 public:
   /**
-   * Default constructor. Most internal values are set when a query is made so
+   * Constructor. Most internal values are set when a query is made so
    * the constructor mainly just sets some internals to a default empty value.
+   * @param  config  Thor configuration. costmatrix_concurrency sets the number of threads
+   *                 the searches of a matrix are spread over (defaults to 1, no extra threads).
+   *                 The results do not depend on the number of threads.
    */
-  CostMatrix();
+  CostMatrix(const boost::property_tree::ptree& config = {});
   ~CostMatrix();
 
   /**
@@ -124,7 +131,17 @@ public:
    */
   void clear();
 
+  /**
+   * Sets the priority queue implementation used by the adjacency lists.
+   * @param  policy  Queue policy to use from the next query on.
+   */
+  void set_queue_policy(const baldr::QueuePolicy policy) {
+    queue_policy_ = policy;
+  }
+
 protected:
+  class TileSource;
+
   // Access mode used by the costing method
   uint32_t access_mode_;
 
@@ -161,9 +178,28 @@ protected:
   std::vector<std::vector<sif::BDEdgeLabel>> target_edgelabel_;
   std::vector<EdgeStatus> target_edgestatus_;
 
+  // Priority queue implementation used by the adjacency lists
+  baldr::QueuePolicy queue_policy_;
+
   // List of best connections found so far
   std::vector<BestCandidate> best_connection_;
 
+  // Status updates for the locations on the other side of a connection, queued by each
+  // search as (location index, threshold) and applied in location order once all searches
+  // of a pass are done so the outcome does not depend on which thread ran which search
+  std::vector<std::vector<std::pair<uint32_t, int>>> pending_status_;
+
+  // Edges reached by each backward search during the current pass, added to the target map
+  // in target order once the pass is done
+  std::vector<std::vector<baldr::GraphId>> target_reached_;
+
+  // Number of threads used to run the searches of a pass
+  uint32_t concurrency_;
+
+  // Most edge labels of a search whose storage is kept in the label arena, 0 when
+  // clear_reserved_memory is set
+  uint32_t max_reserved_labels_count_;
+
   /**
    * Get the cost threshold based on the current mode and the max arc-length distance
    * for that mode.
@@ -182,11 +218,11 @@ protected:
 
   /**
    * Iterate the forward search from the source/origin location.
-   * @param  index        Index of the source location.
-   * @param  n            Iteration counter.
-   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  index  Index of the source location.
+   * @param  n      Iteration counter.
+   * @param  tiles  Access to the graph tiles for the thread running the search.
    */
-  void ForwardSearch(const uint32_t index, const uint32_t n, baldr::GraphReader& graphreader);
+  void ForwardSearch(const uint32_t index, const uint32_t n, TileSource& tiles);
 
   /**
    * Check if the edge on the forward search connects to a reached edge
@@ -198,18 +234,32 @@ protected:
   void CheckForwardConnections(const uint32_t source, const sif::BDEdgeLabel& pred, const uint32_t n);
 
   /**
-   * Update status when a connection is found.
-   * @param  source  Source index
-   * @param  target  Target index
+   * Update status when a connection is found. The status of the location whose
+   * search found the connection is updated right away, the update of the other
+   * location is queued until the current pass is done.
+   * @param  source   Source index
+   * @param  target   Target index
+   * @param  forward  True if the forward search of the source found the connection.
    */
-  void UpdateStatus(const uint32_t source, const uint32_t target);
+  void UpdateStatus(const uint32_t source, const uint32_t target, const bool forward);
 
   /**
    * Iterate the backward search from the target/destination location.
-   * @param  index        Index of the target location.
+   * @param  index  Index of the target location.
+   * @param  tiles  Access to the graph tiles for the thread running the search.
+   */
+  void BackwardSearch(const uint32_t index, TileSource& tiles);
+
+  /**
+   * Runs one step of the search of every location on one side of the matrix,
+   * on the worker threads if there are enough locations to make it worthwhile.
+   * @param  count        Number of locations.
    * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  step         Called with the index of each location.
    */
-  void BackwardSearch(const uint32_t index, baldr::GraphReader& graphreader);
+  void RunPass(const uint32_t count,
+               baldr::GraphReader& graphreader,
+               const std::function<void(const uint32_t, TileSource&)>& step);
 
   /**
    * Sets the source/origin locations. Search expands forward from these
@@ -255,9 +305,13 @@ protected:
 
 private:
   class TargetMap;
+  class Workers;
 
   // Mark each target edge with a list of target indexes that have reached it
   std::unique_ptr<TargetMap> targets_;
+
+  // Threads running the passes when costmatrix_concurrency is more than 1
+  std::unique_ptr<Workers> workers_;
 };
 
 } // namespace thor
@@ -76,6 +76,14 @@ public:
     expansion_callback_ = expansion_callback;
   }
 
+  /**
+   * Sets the priority queue implementation used by the adjacency lists.
+   * @param  policy  Queue policy to use from the next query on.
+   */
+  void set_queue_policy(const baldr::QueuePolicy policy) {
+    queue_policy_ = policy;
+  }
+
 protected:
   /**
    * Compute the best first graph traversal from a list of origin locations
@@ -149,6 +157,9 @@ protected:
   baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_;
   baldr::DoubleBucketQueue<sif::MMEdgeLabel> mmadjacencylist_;
 
+  // Priority queue implementation used by the adjacency lists
+  baldr::QueuePolicy queue_policy_;
+
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_;
 
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
+#include <vector>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 
@@ -50,37 +54,44 @@ struct EdgeStatusInfo {
  * edges within arrays for each tile. This allows the path algorithms to get
  * a pointer to the first edge status and iterate that pointer over sequential
  * edges. This reduces the number of map lookups.
+ *
+ * The per tile arrays are kept in a dense list of slots which outlives clear(). Each slot is
+ * stamped with the generation it was last used in, so clearing only bumps the generation and a
+ * slot is wiped lazily the first time its tile is touched again. Since expansion mostly touches
+ * edges of the same tile in a row, the last looked up tile is cached to skip the hash lookup.
  */
 class EdgeStatus {
 public:
+  // Default number of EdgeStatusInfo entries kept allocated across clear()
+  static constexpr size_t kDefaultMaxRetained = 1 << 22;
+
   /**
-   * Default constructor.
+   * Constructor.
+   * @param max_retained  number of status entries that may stay allocated between searches. If more
+   *                      than this many are allocated when clearing, all arrays are freed instead.
    */
-  EdgeStatus() = default;
+  explicit EdgeStatus(size_t max_retained = kDefaultMaxRetained)
+      : generation_(1), retained_(0), max_retained_(max_retained), last_key_(0),
+        last_tile_(nullptr) {
+  }
 
-  // in order no to delete objects twice in destructor we should explicitly
-  // forbid copying
   EdgeStatus(const EdgeStatus&) = delete;
   EdgeStatus& operator=(const EdgeStatus&) = delete;
   EdgeStatus(EdgeStatus&&) = default;
   EdgeStatus& operator=(EdgeStatus&&) = default;
 
   /**
-   * Destructor. Delete any allocated EdgeStatusInfo arrays.
-   */
-  ~EdgeStatus() {
-    clear();
-  }
-
-  /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Clear the status of all edges. The EdgeStatusInfo arrays are kept for the next search unless
+   * more than max_retained entries are allocated or the generation counter wraps around.
    */
   void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto& iter : edgestatus_) {
-      delete[] iter.second;
+    last_tile_ = nullptr;
+    if (retained_ > max_retained_ || ++generation_ == 0) {
+      slot_index_.clear();
+      slots_.clear();
+      retained_ = 0;
+      generation_ = 1;
     }
-    edgestatus_.clear();
   }
 
   /**
@@ -98,16 +109,7 @@ public:
            const graph_tile_ptr& tile,
            const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    Acquire(edgeid.tile_value() | SHIFT_path_id(path_id), tile)[edgeid.id()] = {set, index};
   }
 
   /**
@@ -120,9 +122,9 @@ public:
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
+    auto* edges = Find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    if (edges != nullptr) {
+      edges[edgeid.id()].set_ = static_cast<uint32_t>(set);
     } else {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
@@ -134,11 +136,12 @@ public:
    * @param  path_id     Identifies which path the edge status belongs to when tracking multiple paths
    *                     valid ids are from 0 to 127 (since we only have 7 bits free)
    * @return  Returns edge status info.
+   * Only reads, so several threads may call it as long as nothing modifies the status.
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid, const uint8_t path_id = 0) const {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const auto* edges = Find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    return edges == nullptr ? EdgeStatusInfo() : edges[edgeid.id()];
   }
 
   /**
@@ -154,23 +157,89 @@ public:
   EdgeStatusInfo*
   GetPtr(const baldr::GraphId& edgeid, const graph_tile_ptr& tile, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
+    return &Acquire(edgeid.tile_value() | SHIFT_path_id(path_id), tile)[edgeid.id()];
+  }
+
+private:
+  // The status of all directed edges of one tile for one path id
+  struct TileStatus {
+    uint32_t generation;
+    uint32_t count;
+    std::unique_ptr<EdgeStatusInfo[]> edges;
+  };
+
+  /**
+   * Find the status array of a tile if it was touched in the current generation. Does not
+   * update the most recently looked up tile so that it is safe for concurrent readers.
+   * @param  key  tile value or'd with the shifted path id
+   * @return the status array or nullptr if the tile has not been touched yet
+   */
+  EdgeStatusInfo* Find(const uint32_t key) const {
+    if (last_tile_ != nullptr && last_key_ == key) {
+      return last_tile_;
+    }
+    const auto p = slot_index_.find(key);
+    if (p == slot_index_.end() || slots_[p->second].generation != generation_) {
+      return nullptr;
+    }
+    return slots_[p->second].edges.get();
+  }
+
+  /**
+   * Find the status array of a tile, getting it ready for the current generation if needed.
+   * @param  key   tile value or'd with the shifted path id
+   * @param  tile  Graph tile used to size the array
+   * @return the status array
+   */
+  EdgeStatusInfo* Acquire(const uint32_t key, const graph_tile_ptr& tile) {
+    auto* edges = Find(key);
+    if (edges != nullptr) {
+      last_key_ = key;
+      return last_tile_ = edges;
+    }
+
+    // Tile has no slot yet. Add an array of EdgeStatusInfo, sized to
+    // the number of directed edges in the specified tile.
+    const uint32_t count = tile->header()->directededgecount();
+    auto inserted = slot_index_.emplace(key, slots_.size());
+    if (inserted.second) {
+      slots_.push_back({generation_, count, std::unique_ptr<EdgeStatusInfo[]>(
+                                                new EdgeStatusInfo[count])});
+      retained_ += count;
     } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
+      // Slot is left over from a previous search, wipe it. Tiles can change underneath us when
+      // the tile set is reloaded so resize if the edge count does not match
+      auto& slot = slots_[inserted.first->second];
+      if (slot.count != count) {
+        retained_ = retained_ - slot.count + count;
+        slot.edges.reset(new EdgeStatusInfo[count]);
+        slot.count = count;
+      } else {
+        std::fill(slot.edges.get(), slot.edges.get() + count, EdgeStatusInfo());
+      }
+      slot.generation = generation_;
     }
+
+    last_key_ = key;
+    return last_tile_ = slots_[inserted.first->second].edges.get();
   }
 
-private:
-  // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
-  // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  // Tile keys (level and tile Id or'd with the shifted path id) to their index in slots_
+  std::unordered_map<uint32_t, uint32_t> slot_index_;
+
+  // Status arrays of every tile touched since they were last freed
+  std::vector<TileStatus> slots_;
+
+  // Generation of the current search, slots stamped with a different one are stale
+  uint32_t generation_;
+
+  // Number of EdgeStatusInfo entries currently allocated and how many we may keep
+  size_t retained_;
+  size_t max_retained_;
+
+  // The most recently looked up tile
+  uint32_t last_key_;
+  EdgeStatusInfo* last_tile_;
 };
 
 } // namespace thor
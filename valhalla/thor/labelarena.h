@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/double_bucket_queue.h>
+
+namespace valhalla {
+namespace thor {
+
+// Memory statistics of a label arena
+struct arena_stats_t {
+  size_t retained_bytes;  // Bytes held by the storage kept in the arena
+  size_t high_water_mark; // Decayed high water mark of the labels used by a search
+  uint64_t acquired;      // Number of times a search took storage from the arena
+  uint64_t reused;        // Number of those that got storage kept from an earlier search
+  uint64_t trimmed;       // Number of times storage above the high water mark was freed
+};
+
+/**
+ * Per thread pool of edge label and adjacency list storage shared by the path algorithms.
+ * A search takes a label container and its adjacency list from the arena when it starts and
+ * hands them back when it is cleared, so all the algorithms running on a thread reuse the same
+ * memory rather than each of them keeping its own reservation.
+ *
+ * How much memory is kept follows a high water mark of the labels used by recent searches. The
+ * mark decays a bit on every release, so the storage of an unusually large search is freed once
+ * the searches after it stop needing it instead of staying allocated for the life of the thread.
+ * The max reserved labels count of the algorithm still caps what may be kept.
+ */
+template <typename label_t> class LabelArena {
+public:
+  // Most sets of storage the arena keeps at once
+  static constexpr size_t kMaxPooled = 8;
+  // Fraction of the high water mark kept on every release
+  static constexpr float kDecay = 0.875f;
+  // Room kept above the high water mark. Containers grow geometrically so their capacity may
+  // be up to twice what was used, and storage of slightly bigger searches should not be freed
+  // and allocated again all the time
+  static constexpr float kHeadroom = 2.f;
+
+  /**
+   * Returns the arena of the calling thread.
+   * @return the label arena of this thread
+   */
+  static LabelArena& get() {
+    thread_local LabelArena arena;
+    return arena;
+  }
+
+  LabelArena(const LabelArena&) = delete;
+  LabelArena& operator=(const LabelArena&) = delete;
+
+  /**
+   * Gives storage to a search about to start. If the labels have no storage of their own, the
+   * labels and the queue are swapped with storage kept from an earlier search. The queue still
+   * has to be set up (call `reuse`) afterwards.
+   * @param labels       Label container of the search.
+   * @param queue        Adjacency list of the search.
+   * @param reservation  Number of labels to reserve space for.
+   */
+  void acquire(std::vector<label_t>& labels,
+               baldr::DoubleBucketQueue<label_t>& queue,
+               const size_t reservation) {
+    ++stats_.acquired;
+    if (labels.capacity() == 0 && !pool_.empty()) {
+      labels.swap(pool_.back().labels);
+      std::swap(queue, pool_.back().queue);
+      pool_.pop_back();
+      ++stats_.reused;
+    }
+    labels.reserve(reservation);
+  }
+
+  /**
+   * Takes back the storage of a finished search. The labels and queue are left empty and
+   * without storage. Storage beyond the decayed high water mark or beyond the max reserved
+   * labels count is freed, the rest is kept for the next search.
+   * @param labels        Label container of the search.
+   * @param queue         Adjacency list of the search.
+   * @param max_reserved  Most labels whose storage may be kept. 0 frees everything.
+   */
+  void release(std::vector<label_t>& labels,
+               baldr::DoubleBucketQueue<label_t>& queue,
+               const size_t max_reserved) {
+    // Nothing to do for algorithms which did not run since they were last cleared
+    if (labels.capacity() == 0) {
+      queue.clear();
+      return;
+    }
+
+    high_water_mark_ = std::max(static_cast<float>(labels.size()), high_water_mark_ * kDecay);
+    const size_t limit =
+        std::min(max_reserved, static_cast<size_t>(high_water_mark_ * kHeadroom));
+
+    labels.clear();
+    queue.clear();
+    if (labels.capacity() > limit || queue.capacity() > limit) {
+      std::vector<label_t>().swap(labels);
+      queue.shrink_to_fit();
+      ++stats_.trimmed;
+    }
+
+    // Keep the storage if there is any and the arena has room for it
+    if (labels.capacity() > 0 && pool_.size() < kMaxPooled) {
+      slot_t slot;
+      slot.labels.swap(labels);
+      std::swap(slot.queue, queue);
+      pool_.emplace_back(std::move(slot));
+    } else {
+      std::vector<label_t>().swap(labels);
+      queue.shrink_to_fit();
+    }
+  }
+
+  /**
+   * Frees all the storage kept in the arena.
+   */
+  void clear() {
+    pool_.clear();
+    pool_.shrink_to_fit();
+    high_water_mark_ = 0.f;
+  }
+
+  /**
+   * Returns the memory statistics of the arena.
+   * @return the arena statistics
+   */
+  arena_stats_t stats() const {
+    arena_stats_t stats = stats_;
+    stats.retained_bytes = 0;
+    for (const auto& slot : pool_) {
+      stats.retained_bytes += slot.labels.capacity() * sizeof(label_t) + slot.queue.memory_size();
+    }
+    stats.high_water_mark = static_cast<size_t>(high_water_mark_);
+    return stats;
+  }
+
+protected:
+  LabelArena() : high_water_mark_(0.f), stats_{} {
+  }
+
+  // Storage of one search
+  struct slot_t {
+    std::vector<label_t> labels;
+    baldr::DoubleBucketQueue<label_t> queue;
+  };
+
+  std::vector<slot_t> pool_;
+  float high_water_mark_;
+  arena_stats_t stats_;
+};
+
+} // namespace thor
+} // namespace valhalla
@@ -68,6 +68,10 @@ public:
     return "Multimodal";
   }
 
+  virtual size_t label_count() const override {
+    return edgelabels_.size();
+  }
+
   /**
    * Clear the temporary information generated during path construction.
    */
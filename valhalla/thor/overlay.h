@@ -0,0 +1,282 @@
+#ifndef VALHALLA_THOR_OVERLAY_H_
+#define VALHALLA_THOR_OVERLAY_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/overlaycell.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/proto/common.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+
+#include <robin_hood.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Cost of the cheapest path from an entry to an exit of a cell which stays inside of it.
+ * Like the arcs of the contraction hierarchy it holds the turns and whole edges after
+ * the entry up to and including the exit.
+ */
+struct CliqueArc {
+  float cost;
+  float secs;
+  float length;
+  bool restricted; // The path turns onto an edge the costing cannot tell alone
+};
+
+/**
+ * The arcs between all entries and exits of a cell for one costing.
+ */
+struct Clique {
+  std::shared_ptr<const baldr::OverlayCell> cell;
+  std::vector<CliqueArc> arcs;            // exit_count arcs per entry, cost max if none
+  std::vector<midgard::PointLL> exit_lls; // Positions of the end nodes of the exits
+};
+
+/**
+ * Dijkstra search over directed edges. A label is reached either through a turn of the
+ * graph or through a clique arc of a cell, which the customization unpacks again.
+ */
+class OverlaySearch {
+public:
+  struct Label {
+    baldr::GraphId edge;
+    midgard::PointLL ll;  // Position of the end node of the edge
+    baldr::GraphId cell;  // Cell of the clique arc the label was reached through
+    float cost;
+    float secs;
+    float length;
+    uint32_t predecessor; // kInvalidLabel at the start of the search
+    bool restricted;      // The path to the label has a restricted turn
+  };
+
+  /**
+   * Clears the labels to start a new search.
+   */
+  void Clear();
+
+  /**
+   * Adds a directed edge the search starts from.
+   */
+  void Add(const baldr::GraphId& edge,
+           const midgard::PointLL& ll,
+           const float cost,
+           const float secs,
+           const float length);
+
+  /**
+   * Settles the cheapest label not settled yet.
+   * @return Returns kInvalidLabel when there is none left.
+   */
+  uint32_t Next();
+
+  /**
+   * Expands a label through the turns of the graph, the same way the path algorithms
+   * expand a label with nothing known about the path before its edge.
+   */
+  void ExpandGraph(const uint32_t idx,
+                   baldr::GraphReader& graphreader,
+                   const sif::DynamicCost& costing);
+
+  /**
+   * Expands a label through the arcs of a clique.
+   * @return Returns false if the edge of the label does not enter the cell.
+   */
+  bool ExpandClique(const uint32_t idx, const Clique& clique);
+
+  const Label& label(const uint32_t idx) const {
+    return labels_[idx];
+  }
+
+  /**
+   * Finds the label of a directed edge.
+   * @return Returns nullptr if the search did not reach the edge.
+   */
+  const Label* Find(const baldr::GraphId& edge) const {
+    auto found = index_.find(edge.value);
+    return found == index_.end() ? nullptr : &labels_[found->second];
+  }
+
+  size_t size() const {
+    return labels_.size();
+  }
+
+protected:
+  void Relax(const uint32_t pred,
+             const baldr::GraphId& edge,
+             const midgard::PointLL& ll,
+             const baldr::GraphId& cell,
+             const float cost,
+             const float secs,
+             const float length,
+             const bool restricted);
+
+  using entry_t = std::pair<float, uint32_t>;
+  std::vector<Label> labels_;
+  robin_hood::unordered_map<uint64_t, uint32_t> index_;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue_;
+};
+
+/**
+ * The cliques of the overlay cells customized for one costing. Customizing a cell runs a
+ * search from each of its entries which stays inside of it, over the graph for the cells
+ * of level 1 and over the cliques of its cells one level below for the upper levels. The
+ * cells are customized the first time a query needs them so that repeated requests with
+ * the same costing options only pay for it once. Not thread safe.
+ */
+class OverlayCustomization {
+public:
+  /**
+   * Gets the clique of a cell, customizing it and the cells below it if needed.
+   * @return Returns nullptr if the cell or one of the cells below it is missing.
+   */
+  const Clique* GetClique(const baldr::GraphId& cellid,
+                          baldr::GraphReader& graphreader,
+                          baldr::OverlayReader& overlay,
+                          const sif::DynamicCost& costing);
+
+  /**
+   * Unpacks a clique arc, appending the directed edges after the entry up to and
+   * including the exit.
+   * @return Returns false if the path of the arc cannot be found again.
+   */
+  bool Unpack(const baldr::GraphId& cellid,
+              const baldr::GraphId& entry,
+              const midgard::PointLL& entry_ll,
+              const baldr::GraphId& exit,
+              baldr::GraphReader& graphreader,
+              baldr::OverlayReader& overlay,
+              const sif::DynamicCost& costing,
+              std::vector<baldr::GraphId>& edges);
+
+  /**
+   * Returns the number of bytes of the cliques.
+   */
+  size_t size() const {
+    return size_;
+  }
+
+protected:
+  // Searches the inside of a cell from one of its entries, until the target is settled
+  // if one is given
+  bool CellSearch(OverlaySearch& search,
+                  const baldr::GraphId& cellid,
+                  const baldr::GraphId& entry,
+                  const midgard::PointLL& entry_ll,
+                  const baldr::GraphId& target,
+                  baldr::GraphReader& graphreader,
+                  baldr::OverlayReader& overlay,
+                  const sif::DynamicCost& costing);
+
+  std::unordered_map<uint64_t, Clique> cliques_;
+  size_t size_ = 0;
+};
+
+/**
+ * Multi-level Dijkstra search over the customized overlay from one origin to any number
+ * of destinations. An edge is expanded through the turns of the graph while it ends in a
+ * cell of level 1 holding an origin or a destination. Otherwise it is expanded through the
+ * clique of the highest level cell which it enters and which holds none of them, so the
+ * search skips over the inside of all the cells away from the locations.
+ */
+class OverlayQuery {
+public:
+  // The best path found from the origin to a destination
+  struct Connection {
+    float cost;
+    float secs;
+    float length;
+    uint32_t label; // Label of the last edge, kInvalidLabel if not found
+    bool restricted;
+  };
+
+  /**
+   * Clears the origin and the destinations.
+   */
+  void Clear();
+
+  /**
+   * Clears the origin and the search to start from another one.
+   */
+  void ClearOrigin();
+
+  /**
+   * Sets the candidate edges of the origin the search starts from.
+   */
+  void AddOrigin(const valhalla::Location& location,
+                 baldr::GraphReader& graphreader,
+                 const sif::DynamicCost& costing);
+
+  /**
+   * Adds a destination, the connections are in the order the destinations are added.
+   */
+  void AddDestination(const valhalla::Location& location,
+                      baldr::GraphReader& graphreader,
+                      const sif::DynamicCost& costing);
+
+  /**
+   * Searches until the best connections to all destinations are known.
+   * @return Returns false if the overlay cannot answer, because a cell is missing or a
+   *         destination is before the origin on the same edge.
+   */
+  bool Run(baldr::GraphReader& graphreader,
+           baldr::OverlayReader& overlay,
+           OverlayCustomization& customization,
+           const sif::DynamicCost& costing);
+
+  const std::vector<Connection>& connections() const {
+    return connections_;
+  }
+
+  size_t label_count() const {
+    return search_.size();
+  }
+
+  /**
+   * Appends the directed edges of the path of a connection, with the clique arcs
+   * unpacked, to a list of edges.
+   * @return Returns false if a clique arc could not be unpacked.
+   */
+  bool AppendPath(const Connection& connection,
+                  baldr::GraphReader& graphreader,
+                  baldr::OverlayReader& overlay,
+                  OverlayCustomization& customization,
+                  const sif::DynamicCost& costing,
+                  std::vector<baldr::GraphId>& edges) const;
+
+protected:
+  // The part of a destination edge after the destination
+  struct DestinationEdge {
+    uint32_t index;
+    float percent_along;
+    float cost;
+    float secs;
+    float length;
+    float distance;
+  };
+
+  // Highest level at which a position is in none of the cells of the locations
+  uint32_t QueryLevel(const midgard::PointLL& ll) const;
+
+  OverlaySearch search_;
+  std::unordered_map<uint64_t, float> origin_edges_;
+  std::unordered_map<uint64_t, std::vector<DestinationEdge>> destination_edges_;
+  std::unordered_set<uint64_t> origin_cells_;
+  std::unordered_set<uint64_t> destination_cells_;
+  std::vector<Connection> connections_;
+  float max_reduction_ = 0.0f;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_OVERLAY_H_
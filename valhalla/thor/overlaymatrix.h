@@ -0,0 +1,75 @@
+#ifndef VALHALLA_THOR_OVERLAYMATRIX_H_
+#define VALHALLA_THOR_OVERLAYMATRIX_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/overlaycell.h>
+#include <valhalla/proto/common.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/costmatrix.h>
+#include <valhalla/thor/overlay.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Class to compute time + distance matrices of any costing from the overlay partition
+ * built by mjolnir::OverlayBuilder, customized for the costing options of the request.
+ * Every source runs one search over the overlay which stops once the best connections to
+ * all targets are known.
+ */
+class OverlayMatrix {
+public:
+  OverlayMatrix() = default;
+
+  /**
+   * Forms a time distance matrix from the set of source locations to the set of target
+   * locations. The customization has to be the one of the costing options of the request.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @return time/distance from all sources to all targets, empty if the overlay cannot
+   *         answer one of the connections
+   */
+  std::vector<TimeDistance>
+  SourceToTarget(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                 baldr::GraphReader& graphreader,
+                 const sif::mode_costing_t& mode_costing,
+                 const sif::TravelMode mode);
+
+  /**
+   * Clear the temporary information generated during time+distance
+   * matrix construction.
+   */
+  void clear();
+
+  /**
+   * Sets the overlay cells to search.
+   */
+  void set_overlay_reader(const std::shared_ptr<baldr::OverlayReader>& overlay) {
+    overlay_ = overlay;
+  }
+
+  /**
+   * Sets the customization of the costing options of the next request.
+   */
+  void set_customization(const std::shared_ptr<OverlayCustomization>& customization) {
+    customization_ = customization;
+  }
+
+protected:
+  std::shared_ptr<baldr::OverlayReader> overlay_;
+  std::shared_ptr<OverlayCustomization> customization_;
+  OverlayQuery query_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_OVERLAYMATRIX_H_
@@ -0,0 +1,79 @@
+#ifndef VALHALLA_THOR_OVERLAYROUTE_H_
+#define VALHALLA_THOR_OVERLAYROUTE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/overlaycell.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/overlay.h>
+#include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/pathinfo.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Path algorithm answering routes of any costing from the overlay partition built by
+ * mjolnir::OverlayBuilder, customized for the costing options of the request. It
+ * returns no path when it cannot answer the request exactly, when the cheapest path
+ * goes through restricted turns or a cell is missing, so the caller has to fall back to
+ * the other algorithms.
+ */
+class OverlayRoute : public PathAlgorithm {
+public:
+  explicit OverlayRoute(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Form path between an origin and destination location using the customized overlay.
+   * The customization has to be the one of the costing options of the request.
+   * @return Returns the path edges, empty if the overlay cannot answer.
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const sif::mode_costing_t& mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  const char* name() const override {
+    return "customizable_route_planning";
+  }
+
+  size_t label_count() const override {
+    return label_count_;
+  }
+
+  void Clear() override;
+
+  /**
+   * Sets the overlay cells to search.
+   */
+  void set_overlay_reader(const std::shared_ptr<baldr::OverlayReader>& overlay) {
+    overlay_ = overlay;
+  }
+
+  /**
+   * Sets the customization of the costing options of the next request.
+   */
+  void set_customization(const std::shared_ptr<OverlayCustomization>& customization) {
+    customization_ = customization;
+  }
+
+protected:
+  std::shared_ptr<baldr::OverlayReader> overlay_;
+  std::shared_ptr<OverlayCustomization> customization_;
+  OverlayQuery query_;
+  size_t label_count_ = 0;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_OVERLAYROUTE_H_
@@ -7,12 +7,14 @@
 #include <utility>
 #include <vector>
 
+#include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/labelarena.h>
 #include <valhalla/thor/pathinfo.h>
 
 namespace valhalla {
@@ -35,7 +37,8 @@ public:
   PathAlgorithm(uint32_t max_reserved_labels_count, bool clear_reserved_memory)
       : interrupt(nullptr), has_ferry_(false), not_thru_pruning_(true), expansion_callback_(),
         max_reserved_labels_count_(max_reserved_labels_count),
-        clear_reserved_memory_(clear_reserved_memory) {
+        clear_reserved_memory_(clear_reserved_memory),
+        queue_policy_(baldr::QueuePolicy::kDoubleBucket) {
   }
 
   PathAlgorithm(const PathAlgorithm&) = delete;
@@ -72,6 +75,12 @@ public:
    */
   virtual const char* name() const = 0;
 
+  /**
+   * Returns the number of edge labels the last path computation created
+   * @return the number of edge labels
+   */
+  virtual size_t label_count() const = 0;
+
   /**
    * Clear the temporary information generated during path construction.
    */
@@ -132,6 +141,14 @@ public:
     expansion_callback_ = expansion_callback;
   }
 
+  /**
+   * Sets the priority queue implementation used by the adjacency lists.
+   * @param  policy  Queue policy to use from the next query on.
+   */
+  void set_queue_policy(const baldr::QueuePolicy policy) {
+    queue_policy_ = policy;
+  }
+
 protected:
   const std::function<void()>* interrupt;
 
@@ -145,11 +162,15 @@ protected:
   // when doing timezone differencing a timezone cache speeds up the computation
   baldr::DateTime::tz_sys_info_cache_t tz_cache_;
 
+  // most edge labels whose storage is kept in the label arena between searches
   uint32_t max_reserved_labels_count_;
 
   // if `true` clean reserved memory for edge labels
   bool clear_reserved_memory_;
 
+  // Priority queue implementation used by the adjacency lists
+  baldr::QueuePolicy queue_policy_;
+
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
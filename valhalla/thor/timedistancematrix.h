@@ -81,6 +81,14 @@ public:
     dest_edges_.clear();
   };
 
+  /**
+   * Sets the priority queue implementation used by the adjacency lists.
+   * @param  policy  Queue policy to use from the next query on.
+   */
+  void set_queue_policy(const baldr::QueuePolicy policy) {
+    queue_policy_ = policy;
+  }
+
 protected:
   // Number of destinations that have been found and settled (least cost path
   // computed).
@@ -105,6 +113,9 @@ protected:
   // Adjacency list - approximate double bucket sort
   baldr::DoubleBucketQueue<sif::EdgeLabel> adjacencylist_;
 
+  // Priority queue implementation used by the adjacency lists
+  baldr::QueuePolicy queue_policy_;
+
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_;
 
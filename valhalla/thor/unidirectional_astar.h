@@ -73,6 +73,10 @@ public:
     }
   }
 
+  virtual size_t label_count() const override {
+    return edgelabels_.size();
+  }
+
   /**
    * Set a maximum label count. The path algorithm terminates if this
    * is exceeded.
@@ -21,10 +21,15 @@
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/astar_bss.h>
 #include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/bucketmatrix.h>
 #include <valhalla/thor/centroid.h>
+#include <valhalla/thor/contractionhierarchy.h>
+#include <valhalla/thor/contractionmatrix.h>
 #include <valhalla/thor/costmatrix.h>
 #include <valhalla/thor/isochrone.h>
 #include <valhalla/thor/multimodal.h>
+#include <valhalla/thor/overlaymatrix.h>
+#include <valhalla/thor/overlayroute.h>
 #include <valhalla/thor/timedistancebssmatrix.h>
 #include <valhalla/thor/timedistancematrix.h>
 #include <valhalla/thor/triplegbuilder.h>
@@ -41,7 +46,12 @@ void run_service(const boost::property_tree::ptree& config);
 
 class thor_worker_t : public service_worker_t {
 public:
-  enum SOURCE_TO_TARGET_ALGORITHM { SELECT_OPTIMAL = 0, COST_MATRIX = 1, TIME_DISTANCE_MATRIX = 2 };
+  enum SOURCE_TO_TARGET_ALGORITHM {
+    SELECT_OPTIMAL = 0,
+    COST_MATRIX = 1,
+    TIME_DISTANCE_MATRIX = 2,
+    BUCKET_MATRIX = 3
+  };
   thor_worker_t(const boost::property_tree::ptree& config,
                 const std::shared_ptr<baldr::GraphReader>& graph_reader = {});
   virtual ~thor_worker_t();
@@ -77,7 +87,7 @@ protected:
                                                     Location& origin,
                                                     Location& destination,
                                                     const std::string& costing,
-                                                    const Options& options);
+                                                    Api& api);
   void log_admin(const TripLeg&);
   thor::PathAlgorithm* get_path_algorithm(const std::string& routetype,
                                           const Location& origin,
@@ -97,6 +107,26 @@ protected:
   void path_depart_at(Api& api, const std::string& costing);
   void parse_measurements(const Api& request);
   std::string parse_costing(const Api& request);
+  void set_queue_policy(const Options::Action action);
+  /**
+   * Whether the contraction hierarchy can answer the request. It only holds for the
+   * default auto costing without live traffic.
+   * @param options  The options of the request
+   */
+  bool contraction_usable(const Options& options) const;
+  /**
+   * Whether the overlay can answer the request. It holds for the costings of the
+   * bidirectional searches without live traffic.
+   * @param options  The options of the request
+   */
+  bool overlay_usable(const Options& options) const;
+  /**
+   * Gets the overlay customization of the costing options of a request, an empty one the
+   * first time they are seen. Customizations are cached by the full sif::CostingKey string of the
+   * costing, so that two different options never share one.
+   * @param options  The options of the request
+   */
+  std::shared_ptr<OverlayCustomization> get_customization(const Options& options);
 
   void build_route(
       const std::deque<std::pair<std::vector<PathInfo>, std::vector<const meili::EdgeSegment*>>>&
@@ -123,18 +153,30 @@ protected:
   MultiModalPathAlgorithm multi_modal_astar;
   TimeDepForward timedep_forward;
   TimeDepReverse timedep_reverse;
+  ContractionHierarchy contraction_hierarchy;
+  OverlayRoute overlay_route;
 
   // Time distance matrix
   CostMatrix costmatrix_;
   TimeDistanceMatrix time_distance_matrix_;
+  BucketMatrix bucket_matrix_;
   TimeDistanceBSSMatrix time_distance_bss_matrix_;
+  ContractionMatrix contraction_matrix_;
+  OverlayMatrix overlay_matrix_;
 
   Isochrone isochrone_gen;
   std::shared_ptr<meili::MapMatcher> matcher;
   float max_timedep_distance;
   std::unordered_map<std::string, float> max_matrix_distance;
   SOURCE_TO_TARGET_ALGORITHM source_to_target_algorithm;
+  std::unordered_map<Options::Action, baldr::QueuePolicy, std::hash<int>> queue_policies;
   std::shared_ptr<baldr::GraphReader> reader;
+  std::shared_ptr<baldr::ContractionReader> contraction_reader;
+  std::shared_ptr<baldr::OverlayReader> overlay_reader;
+  std::unordered_map<std::string, std::shared_ptr<OverlayCustomization>> customizations;
+  size_t max_customizations;
+  size_t max_customization_size;
+  uint32_t contour_concurrency;
   meili::MapMatcherFactory matcher_factory;
   baldr::AttributesController controller;
   Centroid centroid_gen;
@@ -143,6 +185,10 @@ private:
   std::string service_name() const override {
     return "thor";
   }
+  std::vector<std::pair<std::string, uint64_t>> counters() const override {
+    return {{"tile_cache_hits", reader->tile_counters().cache_hits.load()},
+            {"tile_cache_misses", reader->tile_counters().cache_misses.load()}};
+  }
 };
 
 } // namespace thor
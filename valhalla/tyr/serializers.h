@@ -124,6 +124,7 @@ std::string serializePbf(Api& request);
  */
 void serializeWarnings(const valhalla::Api& api, rapidjson::writer_wrapper_t& writer);
 baldr::json::ArrayPtr serializeWarnings(const valhalla::Api& api);
+void serializeStatistics(const valhalla::Api& api, rapidjson::writer_wrapper_t& writer);
 } // namespace tyr
 } // namespace valhalla
 
@@ -133,19 +134,21 @@ namespace osrm {
  * Serialize a location into a osrm waypoint
  * http://project-osrm.org/docs/v5.5.1/api/#waypoint-object
  */
-valhalla::baldr::json::MapPtr
-waypoint(const valhalla::Location& location, bool is_tracepoint = false, bool is_optimized = false);
+void waypoint(const valhalla::Location& location,
+              rapidjson::writer_wrapper_t& writer,
+              bool is_tracepoint = false,
+              bool is_optimized = false);
 
 /*
- * Serialize locations into osrm waypoints
+ * Serialize locations into osrm waypoints, the caller opens and closes the array
  */
-valhalla::baldr::json::ArrayPtr
-waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
-          bool tracepoints = false);
-valhalla::baldr::json::ArrayPtr waypoints(const valhalla::Trip& locations);
-valhalla::baldr::json::ArrayPtr intermediate_waypoints(const valhalla::TripLeg& leg);
+void waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               rapidjson::writer_wrapper_t& writer,
+               bool tracepoints = false);
+void waypoints(const valhalla::Trip& locations, rapidjson::writer_wrapper_t& writer);
+void intermediate_waypoints(const valhalla::TripLeg& leg, rapidjson::writer_wrapper_t& writer);
 
-void serializeIncidentProperties(rapidjson::Writer<rapidjson::StringBuffer>& writer,
+void serializeIncidentProperties(rapidjson::writer_wrapper_t& writer,
                                  const valhalla::IncidentsTile::Metadata& incident_metadata,
                                  const int begin_shape_index,
                                  const int end_shape_index,
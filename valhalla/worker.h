@@ -1,6 +1,8 @@
 #ifndef __VALHALLA_SERVICE_H__
 #define __VALHALLA_SERVICE_H__
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <valhalla/baldr/json.h>
 #include <valhalla/baldr/rapidjson_utils.h>
@@ -78,6 +80,31 @@ std::string serialize_error(const valhalla_exception_t& exception, Api& options)
 // function to add warnings to proto info object
 void add_warning(valhalla::Api& api, unsigned code);
 
+/**
+ * Adds a statistic to the proto info object. If the request already has a statistic with the
+ * same key, e.g. the timing of a phase that runs once per leg, the value is added to it instead.
+ * This is not synchronized, a request is only ever worked on by one thread at a time. What has to
+ * be safe to read from any thread are the counters the stats are taken from, see counters().
+ *
+ * @param api    The request object where we store the statistic
+ * @param key    The key of the statistic, of the form action.worker_name.metric
+ * @param value  The value of the statistic
+ * @param type   The type of the statistic
+ */
+void add_statistic(Api& api, const std::string& key, double value, StatisticType type);
+
+/**
+ * Used to measure the time it takes to do one phase of an action (e.g. the path algorithm of a
+ * route) in a stage of the pipeline. The time is recorded as action.info.worker_name.phase.latency_ms
+ *
+ * @param api          The request object where we store the timing information
+ * @param worker_name  The name of the stage of the pipeline doing the work
+ * @param phase        The name of the phase
+ * @return an object whose destructor records the elapsed time since construction as a stat
+ */
+midgard::Finally<std::function<void()>>
+measure_phase_time(Api& api, const std::string& worker_name, const std::string& phase);
+
 #ifdef HAVE_HTTP
 prime_server::worker_t::result_t serialize_error(const valhalla_exception_t& exception,
                                                  prime_server::http_request_info_t& request_info,
@@ -154,6 +181,33 @@ protected:
    */
   midgard::Finally<std::function<void()>> measure_scope_time(Api& api) const;
 
+  /**
+   * Used to measure the time it takes to do one phase of an action in the current stage of the
+   * pipeline, see measure_phase_time
+   *
+   * @param api    The request object where we store the timing information
+   * @param phase  The name of the phase
+   * @return an object whose destructor records the elapsed time since construction as a stat
+   */
+  midgard::Finally<std::function<void()>> measure_scope_time(Api& api,
+                                                             const std::string& phase) const;
+
+  /**
+   * Adds to a count stat of the current stage of the pipeline, action.info.worker_name.metric
+   *
+   * @param api     The request object where we store the count
+   * @param metric  The name of the counter
+   * @param value   How much to add to the count
+   */
+  void add_count(Api& api, const std::string& metric, double value) const;
+
+  /**
+   * Returns the running totals of the counters the worker keeps, e.g. how many tiles its graph
+   * reader found in its cache. measure_scope_time records how much each of them went up as a
+   * count stat of the action.
+   */
+  virtual std::vector<std::pair<std::string, uint64_t>> counters() const;
+
   /**
    * Signals the start of the worker, sends statsd message if so configured
    */